@@ -45,6 +45,12 @@ if(NOT ANDROID)
 			target_include_directories(qagame PUBLIC ${SQLITE3_INCLUDE_DIR})
 		endif()
 
+		# database thread (g_db_worker.c)
+		if(NOT WIN32)
+			find_package(Threads REQUIRED)
+			target_link_libraries(qagame Threads::Threads)
+		endif()
+
 		FILE(GLOB LUASQL_SRC
 			"src/luasql/luasql.c"
 			"src/luasql/luasql.h"
@@ -13,7 +13,7 @@
 #
 # SQLITE3_INCLUDE_DIRS - where to find sqlite3.h, etc.
 # SQLITE3_LIBRARIES    - List of libraries when using sqlite.
-# SQLITE3_FOUND	       - True if sqlite found.
+# SQLITE3_FOUND	       - True if sqlite (3.24.0 or later) found.
 
 # Look for the header file.
 FIND_PATH(SQLITE3_INCLUDE_DIR NAMES sqlite3.h)
@@ -30,6 +30,14 @@ IF(SQLITE3_INCLUDE_DIR AND EXISTS "${SQLITE3_INCLUDE_DIR}/sqlite3.h")
 	UNSET(sqlite3_version_str)
 ENDIF()
 
+# The upserts (INSERT ... ON CONFLICT DO UPDATE) of the game database need at least 3.24.0,
+# older libraries fail at configure time instead of when the statements are prepared
+SET(SQLITE3_MIN_VERSION "3.24.0")
+IF(NOT SQLite3_FIND_VERSION OR SQLite3_FIND_VERSION VERSION_LESS SQLITE3_MIN_VERSION)
+	SET(SQLite3_FIND_VERSION ${SQLITE3_MIN_VERSION})
+	SET(SQLite3_FIND_VERSION_EXACT FALSE)
+ENDIF()
+
 # handle the QUIETLY and REQUIRED arguments and set SQLITE3_FOUND to TRUE if
 # all listed variables are TRUE
 INCLUDE(${CMAKE_ROOT}/Modules/FindPackageHandleStandardArgs.cmake)
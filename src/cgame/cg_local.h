@@ -3747,9 +3747,11 @@ void trap_R_Finish(void);
 qboolean trap_GetValue(char *value, int valueSize, const char *key);
 void trap_SysFlashWindow(int state);
 void trap_CommandComplete(const char *value);
+int trap_Cvar_Changes(int *sequence, int *changes, int maxChanges);
 extern int dll_com_trapGetValue;
 extern int dll_trap_SysFlashWindow;
 extern int dll_trap_CommandComplete;
+extern int dll_trap_CvarChanges;
 
 bg_playerclass_t *CG_PlayerClassForClientinfo(clientInfo_t *ci, centity_t *cent);
 
@@ -46,6 +46,7 @@ extern qboolean  g_waitingForKey;
 int dll_com_trapGetValue;
 int dll_trap_SysFlashWindow;
 int dll_trap_CommandComplete;
+int dll_trap_CvarChanges;
 
 /**
  * @brief This is the only way control passes into the module.
@@ -641,6 +642,7 @@ static cvarTable_t cvarTable[] =
 
 static const unsigned int cvarTableSize = sizeof(cvarTable) / sizeof(cvarTable[0]);
 static qboolean           cvarsLoaded   = qfalse;
+static int                cvarChanges   = -1;   ///< change sequence of trap_Cvar_Changes(), -1 updates all cvars
 void CG_setClientFlags(void);
 
 /**
@@ -654,6 +656,8 @@ void CG_RegisterCvars(void)
 
 	CG_Printf("%d client cvars in use\n", cvarTableSize);
 
+	cvarChanges = -1;
+
 	trap_Cvar_Set("cg_letterbox", "0");   // force this for people who might have it in their cfg
 
 	// custom fonts, register here since these are ETL-specific features
@@ -707,15 +711,20 @@ void CG_UpdateCvars(void)
 	unsigned int i;
 	qboolean     fSetFlags = qfalse;
 	cvarTable_t  *cv;
+	int          changes[MAX_CVAR_CHANGES];
+	int          numChanges;
 
 	if (!cvarsLoaded)
 	{
 		return;
 	}
 
-	for (i = 0, cv = cvarTable ; i < cvarTableSize ; i++, cv++)
+	// only the cvars the engine reports as changed need an update
+	numChanges = trap_Cvar_Changes(&cvarChanges, changes, MAX_CVAR_CHANGES);
+
+	for (i = 0, cv = cvarTable ; i < cvarTableSize && numChanges ; i++, cv++)
 	{
-		if (cv->vmCvar)
+		if (cv->vmCvar && Q_CvarChanged(cv->vmCvar, changes, numChanges))
 		{
 			trap_Cvar_Update(cv->vmCvar);
 			if (cv->modificationCount != cv->vmCvar->modificationCount)
@@ -773,6 +782,7 @@ void CG_UpdateCvars(void)
 						// wait for the next frame, otherwise the hud load
 						// will erase the forced value
 						cv->modificationCount = -1;
+						cvarChanges           = -1;
 					}
 					else
 					{
@@ -2705,6 +2715,7 @@ static ID_INLINE void CG_SetupExtensions(void)
 
 		CG_SetupExtensionTrap(value, MAX_CVAR_VALUE_STRING, &dll_trap_SysFlashWindow, "trap_SysFlashWindow_Legacy");
 		CG_SetupExtensionTrap(value, MAX_CVAR_VALUE_STRING, &dll_trap_CommandComplete, "trap_CommandComplete_Legacy");
+		CG_SetupExtensionTrap(value, MAX_CVAR_VALUE_STRING, &dll_trap_CvarChanges, "trap_CvarChanges_Legacy");
 	}
 }
 
@@ -282,6 +282,8 @@ typedef enum
 
 	CG_COMMAND_COMPLETE,
 
+	CG_CVAR_CHANGES,            ///< ( int *sequence, int *handles, int maxHandles );
+
 } cgameImport_t;
 
 /**
@@ -1954,3 +1954,21 @@ void trap_CommandComplete(const char *value)
 		SystemCall(dll_trap_CommandComplete, value);
 	}
 }
+
+/**
+ * @brief Extension listing the cvars changed since the last call, so that
+ * CG_UpdateCvars() only has to update those
+ * @param[in,out] sequence
+ * @param[out] changes Handles of the changed cvars
+ * @param[in] maxChanges
+ * @return Number of changed cvars, -1 if all cvars have to be updated
+ */
+int trap_Cvar_Changes(int *sequence, int *changes, int maxChanges)
+{
+	if (dll_trap_CvarChanges)
+	{
+		return SystemCall(dll_trap_CvarChanges, sequence, changes, maxChanges);
+	}
+
+	return -1;
+}
@@ -44,6 +44,7 @@ static ext_trap_keys_t cg_extensionTraps[] =
 {
 	{ "trap_SysFlashWindow_Legacy",  CG_SYS_FLASH_WINDOW, qfalse },
 	{ "trap_CommandComplete_Legacy", CG_COMMAND_COMPLETE, qfalse },
+	{ "trap_CvarChanges_Legacy",     CG_CVAR_CHANGES,     qfalse },
 	{ NULL,                          -1,                  qfalse }
 };
 
@@ -1043,6 +1044,9 @@ intptr_t CL_CgameSystemCalls(intptr_t *args)
 		Field_CompleteModSuggestion(VMA(1));
 		return 0;
 
+	case CG_CVAR_CHANGES:
+		return Cvar_Changes(VMA(1), VMA(2), args[3]);
+
 	default:
 		Com_Error(ERR_DROP, "Bad cgame system trap: %ld", (long int) args[0]);
 		break;
@@ -42,8 +42,14 @@
 
 extern botlib_export_t *botlib_export;
 
-#define TRAP_EXTENSIONS_LIST NULL
+#define TRAP_EXTENSIONS_LIST ui_extensionTraps
 #include "../qcommon/vm_ext.h"
+
+static ext_trap_keys_t ui_extensionTraps[] =
+{
+	{ "trap_CvarChanges_Legacy", UI_CVAR_CHANGES, qfalse },
+	{ NULL,                      -1,              qfalse }
+};
 #include "json.h"
 
 vm_t *uivm;
@@ -1362,6 +1368,8 @@ intptr_t CL_UISystemCalls(intptr_t *args)
 		return 0;
 	case UI_TRAP_GETVALUE:
 		return VM_Ext_GetValue(VMA(1), args[2], VMA(3));
+	case UI_CVAR_CHANGES:
+		return Cvar_Changes(VMA(1), VMA(2), args[3]);
 	default:
 		Com_Error(ERR_DROP, "Bad UI system trap: %ld", (long int) args[0]);
 	}
@@ -46,6 +46,8 @@
 
 extern cvar_t *db_mode;     // 0 - disabled, 1 - sqlite3 memory db, 2 - sqlite3 file db
 extern cvar_t *db_uri;
+extern cvar_t *db_backupInterval; // seconds between incremental backups of the memory db, 0 - disabled
+extern cvar_t *db_backupPages;    // pages an incremental backup copies per frame
 
 extern sqlite3  *db;        // our sqlite3 database
 extern qboolean isDBActive; // general flag for active dbms (db_mode is latched)
@@ -57,10 +59,14 @@ qboolean DB_CheckUpdates(void);
 int DB_LoadOrSaveDb(sqlite3 *, const char *, int);
 // int DB_BackupDB(const char *, void *));
 qboolean DB_SaveMemDB(void); // use in code
+void DB_BackupFrame(void);
+void DB_BackupAbort(void);
+void DB_BackupStatus(void);
 
 int DB_Callback(void *, int, char **, char **);
 
 void DB_SaveMemDB_f(void); // console command to store memory db at any time to disk
+void DB_BackupStatus_f(void);
 void DB_ExecSQLCommand_f(void);
 
 #endif // INCLUDE_DB_SQL_H
@@ -100,3 +100,23 @@ void DB_SaveMemDB_f(void)
 		Com_Printf("saveDB: can't save database.\n");
 	}
 }
+
+/**
+ * @brief prints the progress and timing of the incremental memory db backups
+ */
+void DB_BackupStatus_f(void)
+{
+	if (!db || db_mode->integer == 0)
+	{
+		Com_Printf("saveDBStatus: db not available or disabled!\n");
+		return;
+	}
+
+	if (db_mode->integer != 1)
+	{
+		Com_Printf("saveDBStatus: command only available for memory DBMS\n");
+		return;
+	}
+
+	DB_BackupStatus();
+}
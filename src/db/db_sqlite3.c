@@ -40,10 +40,43 @@
 // FIXME: - move cvars to qcommon?
 cvar_t *db_mode;
 cvar_t *db_uri;
+cvar_t *db_backupInterval;
+cvar_t *db_backupPages;
 
 sqlite3  *db = NULL;
 qboolean isDBActive;
 
+/**
+ * @struct dbBackup_s
+ * @brief Incremental copy of the memory database to disk, see DB_BackupFrame()
+ */
+static struct dbBackup_s
+{
+	sqlite3 *file;                      ///< connection to the database file
+	sqlite3_backup *backup;             ///< NULL if no backup is in progress
+	int nextTime;                       ///< Sys_Milliseconds() the next backup starts at
+	int startTime;
+	int frames;                         ///< frames the current backup copied pages in
+	int pages;                          ///< pages copied per frame, raised when the copy restarts
+	int remaining;                      ///< pages left after the last step
+	int restarts;                       ///< times the memory db was changed by another connection
+	int64_t stepTime;                   ///< microseconds spent in sqlite3_backup_step()
+	int64_t maxStepTime;
+
+	// last finished backup
+	qboolean lastOk;
+	int lastEndTime;
+	int lastPages;
+	int lastFrames;
+	int lastRestarts;
+	int lastDuration;                   ///< milliseconds from start to end
+	int64_t lastStepTime;
+	int64_t lastMaxStepTime;
+
+	int completed;
+	int failed;
+} dbBackup;
+
 // Important Note
 // Always create optional feature tables see f.e. rating tables otherwise we can't ensure db integrity for updates
 
@@ -121,6 +154,16 @@ qboolean DB_Init(void)
 	db_mode = Cvar_Get("db_mode", "2", CVAR_ARCHIVE | CVAR_LATCH);
 	db_uri  = Cvar_Get("db_uri", "etl.db", CVAR_ARCHIVE | CVAR_LATCH); // .db extension is must have!
 
+	// memory db only, seconds between backups to disk (0 - only on shutdown and saveDB) and pages copied per frame
+	db_backupInterval = Cvar_Get("db_backupInterval", "300", CVAR_ARCHIVE);
+	db_backupPages    = Cvar_Get("db_backupPages", "64", CVAR_ARCHIVE);
+	Cvar_CheckRange(db_backupPages, 1, 65536, qtrue);
+
+	Com_Memset(&dbBackup, 0, sizeof(dbBackup));
+
+	// the memory db was just loaded from disk, first backup is due an interval later
+	dbBackup.nextTime = msec + db_backupInterval->integer * 1000;
+
 	if (db_mode->integer == 0)
 	{
 		Com_Printf("SQLite3 ETL: DBMS is disabled\n");
@@ -500,10 +543,48 @@ qboolean DB_Create(void)
 	return qtrue;
 }
 
+/**
+ * @brief Builds the path of the database file the memory db is saved to
+ *
+ * @return the path, NULL on failure
+ */
+static char *DB_SavePath(void)
+{
+	char *to_ospath;
+
+	if (!db_uri->string[0])
+	{
+		Com_Printf("... can't save database - empty URI\n");
+		return NULL;
+	}
+
+	if (!COM_CompareExtension(db_uri->string, ".db"))
+	{
+		Com_Printf("... can't save database - invalid filename extension\n");
+		return NULL;
+	}
+
+	// Make sure that we actually have the homepath available so we dont try to create a database file into a nonexisting path
+	to_ospath = FS_BuildOSPath(Cvar_VariableString("fs_homepath"), "", "");
+	if (FS_CreatePath(to_ospath))
+	{
+		Com_Printf("... DB_SaveMemDB failed - can't create path\n");
+		return NULL;
+	}
+
+	to_ospath                        = FS_BuildOSPath(Cvar_VariableString("fs_homepath"), db_uri->string, "");
+	to_ospath[strlen(to_ospath) - 1] = '\0';
+
+	return to_ospath;
+}
+
 /**
  * @brief saves memory db to disk
  *
  * @return qtrue on success
+ *
+ * @note Blocks until the whole database is written, DB_BackupFrame() does the
+ *       same spread over several frames.
  */
 qboolean DB_SaveMemDB(void)
 {
@@ -512,29 +593,16 @@ qboolean DB_SaveMemDB(void)
 		int  result, msec;
 		char *to_ospath;
 
-		if (!db_uri->string[0])
-		{
-			Com_Printf("... can't save database - empty URI\n");
-			return qfalse;
-		}
+		// an incremental backup would hold the file locked
+		DB_BackupAbort();
 
-		if (!COM_CompareExtension(db_uri->string, ".db"))
-		{
-			Com_Printf("... can't save database - invalid filename extension\n");
-			return qfalse;
-		}
+		to_ospath = DB_SavePath();
 
-		// Make sure that we actually have the homepath available so we dont try to create a database file into a nonexisting path
-		to_ospath = FS_BuildOSPath(Cvar_VariableString("fs_homepath"), "", "");
-		if (FS_CreatePath(to_ospath))
+		if (!to_ospath)
 		{
-			Com_Printf("... DB_SaveMemDB failed - can't create path\n");
 			return qfalse;
 		}
 
-		to_ospath                        = FS_BuildOSPath(Cvar_VariableString("fs_homepath"), db_uri->string, "");
-		to_ospath[strlen(to_ospath) - 1] = '\0';
-
 		msec = Sys_Milliseconds();
 
 		result = DB_LoadOrSaveDb(db, to_ospath, 1);
@@ -545,6 +613,9 @@ qboolean DB_SaveMemDB(void)
 			return qfalse;
 		}
 		Com_Printf("SQLite3 in-memory tables saved to disk @[%s] in [%i] ms\n", to_ospath, (Sys_Milliseconds() - msec));
+
+		// the data on disk is current, next backup is due an interval later
+		dbBackup.nextTime = Sys_Milliseconds() + db_backupInterval->integer * 1000;
 	}
 	else
 	{
@@ -553,6 +624,206 @@ qboolean DB_SaveMemDB(void)
 	return qtrue;
 }
 
+/**
+ * @brief Starts an incremental backup of the memory db
+ *
+ * @return qtrue on success
+ */
+static qboolean DB_BackupStart(void)
+{
+	char *to_ospath = DB_SavePath();
+	int  result;
+
+	if (!to_ospath)
+	{
+		return qfalse;
+	}
+
+	result = sqlite3_open_v2(to_ospath, &dbBackup.file, (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE), NULL);
+
+	if (result != SQLITE_OK)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: SQLite3 backup can't open database file - error: %s\n", sqlite3_errstr(result));
+		(void) sqlite3_close(dbBackup.file);
+		dbBackup.file = NULL;
+		return qfalse;
+	}
+
+	dbBackup.backup = sqlite3_backup_init(dbBackup.file, "main", db, "main");
+
+	if (!dbBackup.backup)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: SQLite3 backup can't start - error: %s\n", sqlite3_errmsg(dbBackup.file));
+		(void) sqlite3_close(dbBackup.file);
+		dbBackup.file = NULL;
+		return qfalse;
+	}
+
+	dbBackup.startTime   = Sys_Milliseconds();
+	dbBackup.frames      = 0;
+	dbBackup.pages       = db_backupPages->integer;
+	dbBackup.remaining   = -1;
+	dbBackup.restarts    = 0;
+	dbBackup.stepTime    = 0;
+	dbBackup.maxStepTime = 0;
+
+	return qtrue;
+}
+
+/**
+ * @brief Ends the backup in progress and records its stats
+ *
+ * @param[in] result Result of the last sqlite3_backup_step()
+ */
+static void DB_BackupFinish(int result)
+{
+	int pages = sqlite3_backup_pagecount(dbBackup.backup);
+
+	if (sqlite3_backup_finish(dbBackup.backup) != SQLITE_OK && result == SQLITE_DONE)
+	{
+		result = sqlite3_errcode(dbBackup.file);
+	}
+
+	(void) sqlite3_close(dbBackup.file);
+	dbBackup.backup = NULL;
+	dbBackup.file   = NULL;
+
+	dbBackup.lastOk          = (result == SQLITE_DONE);
+	dbBackup.lastEndTime     = Sys_Milliseconds();
+	dbBackup.lastPages       = pages;
+	dbBackup.lastFrames      = dbBackup.frames;
+	dbBackup.lastRestarts    = dbBackup.restarts;
+	dbBackup.lastDuration    = dbBackup.lastEndTime - dbBackup.startTime;
+	dbBackup.lastStepTime    = dbBackup.stepTime;
+	dbBackup.lastMaxStepTime = dbBackup.maxStepTime;
+
+	if (dbBackup.lastOk)
+	{
+		dbBackup.completed++;
+		Com_DPrintf("SQLite3 in-memory tables backed up to disk: %i pages in %i frames (%i restarts), %i ms total, %.3f ms max per frame\n",
+		            pages, dbBackup.frames, dbBackup.restarts, dbBackup.lastDuration, dbBackup.maxStepTime / 1000.0);
+	}
+	else
+	{
+		dbBackup.failed++;
+		Com_Printf(S_COLOR_YELLOW "WARNING: SQLite3 backup of in-memory tables failed - error: %s\n", sqlite3_errstr(result));
+	}
+
+	dbBackup.nextTime = dbBackup.lastEndTime + db_backupInterval->integer * 1000;
+}
+
+/**
+ * @brief Stops the backup in progress without recording it, the file keeps its previous content
+ */
+void DB_BackupAbort(void)
+{
+	if (!dbBackup.backup)
+	{
+		return;
+	}
+
+	(void) sqlite3_backup_finish(dbBackup.backup);
+	(void) sqlite3_close(dbBackup.file);
+	dbBackup.backup = NULL;
+	dbBackup.file   = NULL;
+}
+
+/**
+ * @brief Saves the memory db to disk every db_backupInterval seconds, copying
+ * at most db_backupPages pages per frame so the server never stalls on it.
+ *
+ * The file is written in a transaction of its own connection, a crash in the
+ * middle of a backup leaves the previous backup intact. If the memory db is
+ * changed by another connection meanwhile (e.g. the game module) SQLite
+ * restarts the copy, the page budget is then doubled so a busy server still
+ * gets its backup done.
+ */
+void DB_BackupFrame(void)
+{
+	int     result;
+	int64_t start, step;
+
+	if (!isDBActive || !db || db_mode->integer != 1)
+	{
+		return;
+	}
+
+	if (!dbBackup.backup)
+	{
+		if (db_backupInterval->integer <= 0 || Sys_Milliseconds() - dbBackup.nextTime < 0)
+		{
+			return;
+		}
+
+		if (!DB_BackupStart())
+		{
+			// try again later
+			dbBackup.failed++;
+			dbBackup.nextTime = Sys_Milliseconds() + db_backupInterval->integer * 1000;
+			return;
+		}
+	}
+
+	start  = Sys_Microseconds();
+	result = sqlite3_backup_step(dbBackup.backup, dbBackup.pages);
+	step   = Sys_Microseconds() - start;
+
+	if (dbBackup.remaining >= 0 && sqlite3_backup_remaining(dbBackup.backup) > dbBackup.remaining)
+	{
+		dbBackup.restarts++;
+		dbBackup.pages = MIN(dbBackup.pages * 2, MAX(sqlite3_backup_pagecount(dbBackup.backup), db_backupPages->integer));
+	}
+	dbBackup.remaining = sqlite3_backup_remaining(dbBackup.backup);
+
+	dbBackup.frames++;
+	dbBackup.stepTime   += step;
+	dbBackup.maxStepTime = MAX(dbBackup.maxStepTime, step);
+
+	// more pages to copy, or the db is locked by a write - carry on next frame
+	if (result == SQLITE_OK || result == SQLITE_BUSY || result == SQLITE_LOCKED)
+	{
+		return;
+	}
+
+	DB_BackupFinish(result);
+}
+
+/**
+ * @brief Prints the progress of the incremental backup and the stats of the last one
+ */
+void DB_BackupStatus(void)
+{
+	int now = Sys_Milliseconds();
+
+	if (db_backupInterval->integer <= 0)
+	{
+		Com_Printf("Incremental backup is disabled (db_backupInterval 0).\n");
+	}
+	else if (dbBackup.backup)
+	{
+		int total = sqlite3_backup_pagecount(dbBackup.backup);
+
+		Com_Printf("Backup in progress: %i of %i pages copied in %i frames (%i restarts, %i pages per frame), %.3f ms max per frame\n",
+		           total - sqlite3_backup_remaining(dbBackup.backup), total, dbBackup.frames, dbBackup.restarts, dbBackup.pages, dbBackup.maxStepTime / 1000.0);
+	}
+	else
+	{
+		Com_Printf("Next backup in %i s, %i pages per frame\n", MAX(0, dbBackup.nextTime - now) / 1000, db_backupPages->integer);
+	}
+
+	Com_Printf("Backups    : %i completed, %i failed\n", dbBackup.completed, dbBackup.failed);
+
+	if (!dbBackup.lastEndTime)
+	{
+		return;
+	}
+
+	Com_Printf("Last backup: %s %i s ago, %i pages in %i frames (%i restarts), %i ms total\n", dbBackup.lastOk ? "completed" : "failed",
+	           (now - dbBackup.lastEndTime) / 1000, dbBackup.lastPages, dbBackup.lastFrames, dbBackup.lastRestarts, dbBackup.lastDuration);
+	Com_Printf("Frame cost : %.3f ms avg, %.3f ms max\n",
+	           dbBackup.lastFrames ? dbBackup.lastStepTime / 1000.0 / dbBackup.lastFrames : 0.0, dbBackup.lastMaxStepTime / 1000.0);
+}
+
 /**
  * @brief Deinits and closes the database properly.
  *
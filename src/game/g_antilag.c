@@ -34,18 +34,121 @@
 
 #include "g_local.h"
 
+#ifdef ETL_SSE
+#include <immintrin.h>
+#endif
+
+/// Reach of the temporary head and leg boxes beyond the body box, see G_BuildHead() and G_BuildLeg()
+#define ANTILAG_BODYPART_REACH 48.f
+
+/// Most markers a client history can hold, see g_antilagMarkers
+#define MAX_ANTILAG_MARKERS 128
+
+/**
+ * @struct antilagState_t
+ * @brief The marker fields which can't be lerped, taken from the marker closest in time
+ */
+typedef struct
+{
+	int eFlags;                         ///< s.eFlags to ps.eFlags
+	int viewheight;                     ///< ps for both
+	int pm_flags;                       ///< ps for both
+
+	// torso markers
+	qhandle_t torsoOldFrameModel;
+	qhandle_t torsoFrameModel;
+	int torsoOldFrame;
+	int torsoFrame;
+	int torsoOldFrameTime;
+	int torsoFrameTime;
+	float torsoYawAngle;
+	float torsoPitchAngle;
+	int torsoYawing;
+	int torsoPitching;
+
+	// leg markers
+	qhandle_t legsOldFrameModel;
+	qhandle_t legsFrameModel;
+	int legsOldFrame;
+	int legsFrame;
+	int legsOldFrameTime;
+	int legsFrameTime;
+	float legsYawAngle;
+	float legsPitchAngle;
+	int legsYawing;
+	qboolean legsPitching;
+} antilagState_t;
+
+/**
+ * @struct antilagHistory_t
+ * @brief Marker ring of one client, each field in an array of its own so the
+ * lookup only walks the times and the lerp only touches the boxes
+ */
+typedef struct
+{
+	int head;                                   ///< index of the newest marker
+	int count;                                  ///< stored markers, the oldest one is count - 1 before head
+	vec3_t absmin, absmax;                      ///< bounds of the client boxes of all markers, see G_HistoricalTrace()
+
+	int time[MAX_ANTILAG_MARKERS];
+	vec4_t box[MAX_ANTILAG_MARKERS][3];         ///< origin, mins and maxs, padded so they are lerped four floats at once
+	vec3_t viewangles[MAX_ANTILAG_MARKERS];     ///< s.apos.trBase to ps.viewangles
+	antilagState_t state[MAX_ANTILAG_MARKERS];
+} antilagHistory_t;
+
+static antilagHistory_t antilagHistory[MAX_CLIENTS];
+static int              antilagDepth = 17;      ///< markers kept per client, g_antilagMarkers at G_InitGame()
+
+/**
+ * @struct antilagStats_t
+ * @brief Rewind counters, printed by the antilag_stats server command
+ */
+typedef struct
+{
+	int traces;                         ///< historical traces and trace groups
+	int clients;                        ///< clients that would be rewound without g_antilagLazy
+	int rewound;                        ///< clients actually rewound
+	int maxRewound;                     ///< most clients rewound by a single trace
+} antilagStats_t;
+
+static antilagStats_t antilagStats;
+
 /**
- * @brief Used below to interpolate between two previous vectors
- * @param[in] start start vector
- * @param[in] end end vector
+ * @brief Used below to interpolate between two marker boxes
+ * @param[in] start box of the older marker
+ * @param[in] end box of the newer marker
  * @param[in] frac fraction with which to interpolate
- * @param[out] result A vector "frac" times the distance between "start" and "end"
+ * @param[out] ent Gets the lerped origin, mins and maxs
  */
-static void TimeShiftLerp(const vec3_t start, const vec3_t end, float frac, vec3_t result)
+static void TimeShiftLerp(const vec4_t *start, const vec4_t *end, float frac, gentity_t *ent)
 {
-	result[0] = start[0] + frac * (end[0] - start[0]);
-	result[1] = start[1] + frac * (end[1] - start[1]);
-	result[2] = start[2] + frac * (end[2] - start[2]);
+#ifdef ETL_SSE
+	__m128 f = _mm_set1_ps(frac);
+	vec4_t result[3];
+	int    i;
+
+	for (i = 0; i < 3; i++)
+	{
+		__m128 a = _mm_loadu_ps(start[i]);
+
+		// start + frac * (end - start), same as the scalar version
+		_mm_storeu_ps(result[i], _mm_add_ps(a, _mm_mul_ps(f, _mm_sub_ps(_mm_loadu_ps(end[i]), a))));
+	}
+
+	VectorCopy(result[0], ent->r.currentOrigin);
+	VectorCopy(result[1], ent->r.mins);
+	VectorCopy(result[2], ent->r.maxs);
+#else
+	vec_t *result[3] = { ent->r.currentOrigin, ent->r.mins, ent->r.maxs };
+	int   i;
+
+	for (i = 0; i < 3; i++)
+	{
+		result[i][0] = start[i][0] + frac * (end[i][0] - start[i][0]);
+		result[i][1] = start[i][1] + frac * (end[i][1] - start[i][1]);
+		result[i][2] = start[i][2] + frac * (end[i][2] - start[i][2]);
+	}
+#endif
 }
 
 /**
@@ -118,63 +221,195 @@ static qboolean G_AntilagSafe(gentity_t *ent)
 	return qtrue;
 }
 
+/**
+ * @brief Clears the histories of all clients and applies g_antilagMarkers
+ */
+void G_InitAntilag(void)
+{
+	antilagDepth = Com_Clamp(2, MAX_ANTILAG_MARKERS, g_antilagMarkers.integer);
+
+	Com_Memset(antilagHistory, 0, sizeof(antilagHistory));
+}
+
+/**
+ * @brief Recomputes the bounds of the client boxes of all markers, any time
+ * the client can be shifted to is inside of them
+ * @param[in,out] h
+ */
+static void G_UpdateMarkerBounds(antilagHistory_t *h)
+{
+	int i, j, k;
+
+	VectorSet(h->absmin, 999999.f, 999999.f, 999999.f);
+	VectorSet(h->absmax, -999999.f, -999999.f, -999999.f);
+
+	for (i = 0, k = h->head; i < h->count; i++, k = (k ? k : antilagDepth) - 1)
+	{
+		for (j = 0; j < 3; j++)
+		{
+			h->absmin[j] = MIN(h->absmin[j], h->box[k][0][j] + h->box[k][1][j]);
+			h->absmax[j] = MAX(h->absmax[j], h->box[k][0][j] + h->box[k][2][j]);
+		}
+	}
+}
+
+/**
+ * @brief Stores the marker fields which can't be lerped
+ * @param[in] ent
+ * @param[in] eFlags
+ * @param[out] state
+ */
+static void G_StoreAntilagState(gentity_t *ent, int eFlags, antilagState_t *state)
+{
+	state->eFlags     = eFlags;
+	state->pm_flags   = ent->client->ps.pm_flags;
+	state->viewheight = ent->client->ps.viewheight;
+
+	// Torso Markers
+	state->torsoOldFrameModel = ent->torsoFrame.oldFrameModel;
+	state->torsoFrameModel    = ent->torsoFrame.frameModel;
+	state->torsoOldFrame      = ent->torsoFrame.oldFrame;
+	state->torsoFrame         = ent->torsoFrame.frame;
+	state->torsoOldFrameTime  = ent->torsoFrame.oldFrameTime;
+	state->torsoFrameTime     = ent->torsoFrame.frameTime;
+	state->torsoYawAngle      = ent->torsoFrame.yawAngle;
+	state->torsoPitchAngle    = ent->torsoFrame.pitchAngle;
+	state->torsoYawing        = ent->torsoFrame.yawing;
+	state->torsoPitching      = ent->torsoFrame.pitching;
+
+	// Legs Markers
+	state->legsOldFrameModel = ent->legsFrame.oldFrameModel;
+	state->legsFrameModel    = ent->legsFrame.frameModel;
+	state->legsOldFrame      = ent->legsFrame.oldFrame;
+	state->legsFrame         = ent->legsFrame.frame;
+	state->legsOldFrameTime  = ent->legsFrame.oldFrameTime;
+	state->legsFrameTime     = ent->legsFrame.frameTime;
+	state->legsYawAngle      = ent->legsFrame.yawAngle;
+	state->legsPitchAngle    = ent->legsFrame.pitchAngle;
+	state->legsYawing        = ent->legsFrame.yawing;
+	state->legsPitching      = ent->legsFrame.pitching;
+}
+
+/**
+ * @brief Sets the marker fields which can't be lerped
+ * @param[in,out] ent
+ * @param[in] state
+ * @param[in] time time stamp of the marker
+ */
+static void G_ApplyAntilagState(gentity_t *ent, const antilagState_t *state, int time)
+{
+	ent->client->ps.eFlags     = state->eFlags;
+	ent->client->ps.pm_flags   = state->pm_flags;
+	ent->client->ps.viewheight = state->viewheight;
+
+	// Torso Markers
+	ent->torsoFrame.oldFrameModel = state->torsoOldFrameModel;
+	ent->torsoFrame.frameModel    = state->torsoFrameModel;
+	ent->torsoFrame.oldFrame      = state->torsoOldFrame;
+	ent->torsoFrame.frame         = state->torsoFrame;
+	ent->torsoFrame.oldFrameTime  = state->torsoOldFrameTime;
+	ent->torsoFrame.frameTime     = state->torsoFrameTime;
+	ent->torsoFrame.yawAngle      = state->torsoYawAngle;
+	ent->torsoFrame.pitchAngle    = state->torsoPitchAngle;
+	ent->torsoFrame.yawing        = state->torsoYawing;
+	ent->torsoFrame.pitching      = state->torsoPitching;
+
+	// Legs Markers
+	ent->legsFrame.oldFrameModel = state->legsOldFrameModel;
+	ent->legsFrame.frameModel    = state->legsFrameModel;
+	ent->legsFrame.oldFrame      = state->legsOldFrame;
+	ent->legsFrame.frame         = state->legsFrame;
+	ent->legsFrame.oldFrameTime  = state->legsOldFrameTime;
+	ent->legsFrame.frameTime     = state->legsFrameTime;
+	ent->legsFrame.yawAngle      = state->legsYawAngle;
+	ent->legsFrame.pitchAngle    = state->legsPitchAngle;
+	ent->legsFrame.yawing        = state->legsYawing;
+	ent->legsFrame.pitching      = state->legsPitching;
+
+	// time stamp for BuildHead/Leg
+	ent->timeShiftTime = time;
+}
+
 /**
  * @brief Store client entity's position and other related data which is required to shift time (B2TF)
  * @param[in,out] ent target client entity
  */
 void G_StoreClientPosition(gentity_t *ent)
 {
-	int top;
+	antilagHistory_t *h;
+	int              top;
 
 	if (!G_AntilagSafe(ent))
 	{
 		return;
 	}
 
-	ent->client->topMarker++;
-	if (ent->client->topMarker >= MAX_CLIENT_MARKERS)
+	h = &antilagHistory[ent->client - level.clients];
+
+	h->head = top = (h->head + 1) % antilagDepth;
+	if (h->count < antilagDepth)
 	{
-		ent->client->topMarker = 0;
+		h->count++;
 	}
 
-	top = ent->client->topMarker;
-
-	VectorCopy(ent->r.mins, ent->client->clientMarkers[top].mins);
-	VectorCopy(ent->r.maxs, ent->client->clientMarkers[top].maxs);
-	VectorCopy(ent->s.pos.trBase, ent->client->clientMarkers[top].origin);
-	ent->client->clientMarkers[top].time = level.time;
+	VectorCopy(ent->s.pos.trBase, h->box[top][0]);
+	VectorCopy(ent->r.mins, h->box[top][1]);
+	VectorCopy(ent->r.maxs, h->box[top][2]);
+	h->time[top] = level.time;
 
 	// store all angles & frame info
+	VectorCopy(ent->s.apos.trBase, h->viewangles[top]);
+	G_StoreAntilagState(ent, ent->s.eFlags, &h->state[top]);
 
-	VectorCopy(ent->s.apos.trBase, ent->client->clientMarkers[top].viewangles);
+	G_UpdateMarkerBounds(h);
+}
 
-	ent->client->clientMarkers[top].eFlags     = ent->s.eFlags;
-	ent->client->clientMarkers[top].pm_flags   = ent->client->ps.pm_flags;
-	ent->client->clientMarkers[top].viewheight = ent->client->ps.viewheight;
+/**
+ * @brief Finds the pair of markers which bound the requested time
+ * @param[in] h
+ * @param[in] time
+ * @param[out] older newest marker at or before time, -1 if time is before the oldest marker
+ * @param[out] newer the marker following it
+ * @return qfalse if time is at or after the newest marker, so there is nothing to shift
+ */
+static qboolean G_FindMarkers(const antilagHistory_t *h, int time, int *older, int *newer)
+{
+	int oldest, lo, hi, mid;
 
-	// Torso Markers
-	ent->client->clientMarkers[top].torsoOldFrameModel = ent->torsoFrame.oldFrameModel;
-	ent->client->clientMarkers[top].torsoFrameModel    = ent->torsoFrame.frameModel;
-	ent->client->clientMarkers[top].torsoOldFrame      = ent->torsoFrame.oldFrame;
-	ent->client->clientMarkers[top].torsoFrame         = ent->torsoFrame.frame;
-	ent->client->clientMarkers[top].torsoOldFrameTime  = ent->torsoFrame.oldFrameTime;
-	ent->client->clientMarkers[top].torsoFrameTime     = ent->torsoFrame.frameTime;
-	ent->client->clientMarkers[top].torsoYawAngle      = ent->torsoFrame.yawAngle;
-	ent->client->clientMarkers[top].torsoPitchAngle    = ent->torsoFrame.pitchAngle;
-	ent->client->clientMarkers[top].torsoYawing        = ent->torsoFrame.yawing;
-	ent->client->clientMarkers[top].torsoPitching      = ent->torsoFrame.pitching;
+	if (!h->count || h->time[h->head] <= time)
+	{
+		return qfalse;
+	}
 
-	// Legs Markers
-	ent->client->clientMarkers[top].legsOldFrameModel = ent->legsFrame.oldFrameModel;
-	ent->client->clientMarkers[top].legsFrameModel    = ent->legsFrame.frameModel;
-	ent->client->clientMarkers[top].legsOldFrame      = ent->legsFrame.oldFrame;
-	ent->client->clientMarkers[top].legsFrame         = ent->legsFrame.frame;
-	ent->client->clientMarkers[top].legsOldFrameTime  = ent->legsFrame.oldFrameTime;
-	ent->client->clientMarkers[top].legsFrameTime     = ent->legsFrame.frameTime;
-	ent->client->clientMarkers[top].legsYawAngle      = ent->legsFrame.yawAngle;
-	ent->client->clientMarkers[top].legsPitchAngle    = ent->legsFrame.pitchAngle;
-	ent->client->clientMarkers[top].legsYawing        = ent->legsFrame.yawing;
-	ent->client->clientMarkers[top].legsPitching      = ent->legsFrame.pitching;
+	oldest = (h->head - h->count + 1 + antilagDepth) % antilagDepth;
+
+	if (h->time[oldest] > time)
+	{
+		*older = -1;
+		*newer = oldest;
+		return qtrue;
+	}
+
+	// the times are increasing from the oldest marker on,
+	// lo always is at or before time and hi after it
+	lo = 0;
+	hi = h->count - 1;
+	while (hi - lo > 1)
+	{
+		mid = (lo + hi) >> 1;
+		if (h->time[(oldest + mid) % antilagDepth] <= time)
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	*older = (oldest + lo) % antilagDepth;
+	*newer = (oldest + hi) % antilagDepth;
+	return qtrue;
 }
 
 /**
@@ -185,7 +420,8 @@ void G_StoreClientPosition(gentity_t *ent)
  */
 static qboolean G_AdjustSingleClientPosition(gentity_t *ent, int time)
 {
-	int i, j;
+	antilagHistory_t *h;
+	int              i, j;
 
 	if (time > level.time)
 	{
@@ -197,25 +433,10 @@ static qboolean G_AdjustSingleClientPosition(gentity_t *ent, int time)
 		return qfalse;
 	}
 
-	// find a pair of markers which bound the requested time
-	i = j = ent->client->topMarker;
-	do
-	{
-		if (ent->client->clientMarkers[i].time <= time)
-		{
-			break;
-		}
+	h = &antilagHistory[ent->client - level.clients];
 
-		j = i;
-		i--;
-		if (i < 0)
-		{
-			i = MAX_CLIENT_MARKERS - 1;
-		}
-	}
-	while (i != ent->client->topMarker);
-
-	if (i == j)     // oops, no valid stored markers
+	// find a pair of markers which bound the requested time
+	if (!G_FindMarkers(h, time, &i, &j))     // oops, no valid stored markers
 	{
 		return qfalse;
 	}
@@ -262,172 +483,37 @@ static qboolean G_AdjustSingleClientPosition(gentity_t *ent, int time)
 
 	// if we haven't wrapped back to the head, we've sandwiched, so
 	// we shift the client's position back to where he was at "time"
-	if (i != ent->client->topMarker)
+	if (i >= 0)
 	{
-		float frac = (float)(time - ent->client->clientMarkers[i].time) /
-		             (float)(ent->client->clientMarkers[j].time - ent->client->clientMarkers[i].time);
+		float frac = (float)(time - h->time[i]) / (float)(h->time[j] - h->time[i]);
+
 		// Using TimeShiftLerp since it follows the client exactly meaning less roundoff error instead of LerpPosition()
-		TimeShiftLerp(
-			ent->client->clientMarkers[i].origin,
-			ent->client->clientMarkers[j].origin,
-			frac,
-			ent->r.currentOrigin);
-		TimeShiftLerp(
-			ent->client->clientMarkers[i].mins,
-			ent->client->clientMarkers[j].mins,
-			frac,
-			ent->r.mins);
-		TimeShiftLerp(
-			ent->client->clientMarkers[i].maxs,
-			ent->client->clientMarkers[j].maxs,
-			frac,
-			ent->r.maxs);
+		TimeShiftLerp(h->box[i], h->box[j], frac, ent);
 
 		// These are for Head / Legs
-		ent->client->ps.viewangles[0] = LerpAngle(
-			ent->client->clientMarkers[i].viewangles[0],
-			ent->client->clientMarkers[j].viewangles[0],
-			frac);
-		ent->client->ps.viewangles[1] = LerpAngle(
-			ent->client->clientMarkers[i].viewangles[1],
-			ent->client->clientMarkers[j].viewangles[1],
-			frac);
-		ent->client->ps.viewangles[2] = LerpAngle(
-			ent->client->clientMarkers[i].viewangles[2],
-			ent->client->clientMarkers[j].viewangles[2],
-			frac);
+		ent->client->ps.viewangles[0] = LerpAngle(h->viewangles[i][0], h->viewangles[j][0], frac);
+		ent->client->ps.viewangles[1] = LerpAngle(h->viewangles[i][1], h->viewangles[j][1], frac);
+		ent->client->ps.viewangles[2] = LerpAngle(h->viewangles[i][2], h->viewangles[j][2], frac);
+
 		// Set the ints to the closest ones in time since you can't lerp them.
-		if ((ent->client->clientMarkers[j].time - time) < (time - ent->client->clientMarkers[i].time))
+		if ((h->time[j] - time) < (time - h->time[i]))
 		{
-			ent->client->ps.eFlags     = ent->client->clientMarkers[j].eFlags;
-			ent->client->ps.pm_flags   = ent->client->clientMarkers[j].pm_flags;
-			ent->client->ps.viewheight = ent->client->clientMarkers[j].viewheight;
-
-			// Torso Markers
-			ent->torsoFrame.oldFrameModel = ent->client->clientMarkers[j].torsoOldFrameModel;
-			ent->torsoFrame.frameModel    = ent->client->clientMarkers[j].torsoFrameModel;
-			ent->torsoFrame.oldFrame      = ent->client->clientMarkers[j].torsoOldFrame;
-			ent->torsoFrame.frame         = ent->client->clientMarkers[j].torsoFrame;
-			ent->torsoFrame.oldFrameTime  = ent->client->clientMarkers[j].torsoOldFrameTime;
-			ent->torsoFrame.frameTime     = ent->client->clientMarkers[j].torsoFrameTime;
-			ent->torsoFrame.yawAngle      = ent->client->clientMarkers[j].torsoYawAngle;
-			ent->torsoFrame.pitchAngle    = ent->client->clientMarkers[j].torsoPitchAngle;
-			ent->torsoFrame.yawing        = ent->client->clientMarkers[j].torsoYawing;
-			ent->torsoFrame.pitching      = ent->client->clientMarkers[j].torsoPitching;
-
-			// Legs Markers
-			ent->legsFrame.oldFrameModel = ent->client->clientMarkers[j].legsOldFrameModel;
-			ent->legsFrame.frameModel    = ent->client->clientMarkers[j].legsFrameModel;
-			ent->legsFrame.oldFrame      = ent->client->clientMarkers[j].legsOldFrame;
-			ent->legsFrame.frame         = ent->client->clientMarkers[j].legsFrame;
-			ent->legsFrame.oldFrameTime  = ent->client->clientMarkers[j].legsOldFrameTime;
-			ent->legsFrame.frameTime     = ent->client->clientMarkers[j].legsFrameTime;
-			ent->legsFrame.yawAngle      = ent->client->clientMarkers[j].legsYawAngle;
-			ent->legsFrame.pitchAngle    = ent->client->clientMarkers[j].legsPitchAngle;
-			ent->legsFrame.yawing        = ent->client->clientMarkers[j].legsYawing;
-			ent->legsFrame.pitching      = ent->client->clientMarkers[j].legsPitching;
-
-			// time stamp for BuildHead/Leg
-			ent->timeShiftTime = ent->client->clientMarkers[j].time;
-
+			G_ApplyAntilagState(ent, &h->state[j], h->time[j]);
 		}
 		else
 		{
-			ent->client->ps.eFlags     = ent->client->clientMarkers[i].eFlags;
-			ent->client->ps.pm_flags   = ent->client->clientMarkers[i].pm_flags;
-			ent->client->ps.viewheight = ent->client->clientMarkers[i].viewheight;
-
-			// Torso Markers
-			ent->torsoFrame.oldFrameModel = ent->client->clientMarkers[i].torsoOldFrameModel;
-			ent->torsoFrame.frameModel    = ent->client->clientMarkers[i].torsoFrameModel;
-			ent->torsoFrame.oldFrame      = ent->client->clientMarkers[i].torsoOldFrame;
-			ent->torsoFrame.frame         = ent->client->clientMarkers[i].torsoFrame;
-			ent->torsoFrame.oldFrameTime  = ent->client->clientMarkers[i].torsoOldFrameTime;
-			ent->torsoFrame.frameTime     = ent->client->clientMarkers[i].torsoFrameTime;
-			ent->torsoFrame.yawAngle      = ent->client->clientMarkers[i].torsoYawAngle;
-			ent->torsoFrame.pitchAngle    = ent->client->clientMarkers[i].torsoPitchAngle;
-			ent->torsoFrame.yawing        = ent->client->clientMarkers[i].torsoYawing;
-			ent->torsoFrame.pitching      = ent->client->clientMarkers[i].torsoPitching;
-
-			// Legs Markers
-			ent->legsFrame.oldFrameModel = ent->client->clientMarkers[i].legsOldFrameModel;
-			ent->legsFrame.frameModel    = ent->client->clientMarkers[i].legsFrameModel;
-			ent->legsFrame.oldFrame      = ent->client->clientMarkers[i].legsOldFrame;
-			ent->legsFrame.frame         = ent->client->clientMarkers[i].legsFrame;
-			ent->legsFrame.oldFrameTime  = ent->client->clientMarkers[i].legsOldFrameTime;
-			ent->legsFrame.frameTime     = ent->client->clientMarkers[i].legsFrameTime;
-			ent->legsFrame.yawAngle      = ent->client->clientMarkers[i].legsYawAngle;
-			ent->legsFrame.pitchAngle    = ent->client->clientMarkers[i].legsPitchAngle;
-			ent->legsFrame.yawing        = ent->client->clientMarkers[i].legsYawing;
-			ent->legsFrame.pitching      = ent->client->clientMarkers[i].legsPitching;
-
-			// time stamp for BuildHead/Leg
-			ent->timeShiftTime = ent->client->clientMarkers[i].time;
-		}
-
-		/* FIXME
-		if ( debugger && debugger->client) {
-		    // print some debugging stuff exactly like what the client does
-		    // it starts with "Rec:" to let you know it backward-reconciled
-		    char msg[2048];
-		    Com_sprintf( msg, sizeof(msg),
-		        "print \"^1Rec: time: %d, j: %d, k: %d, origin: %0.2f %0.2f %0.2f\n"
-		        "^2frac: %0.4f, origin1: %0.2f %0.2f %0.2f, origin2: %0.2f %0.2f %0.2f\n"
-		        "^7level.time: %d, est time: %d, level.time delta: %d, est real ping: %d\n\"",
-		        time, ent->client->clientMarkers[i].time, ent->client->clientMarkers[j].time,
-		        ent->r.currentOrigin[0], ent->r.currentOrigin[1], ent->r.currentOrigin[2],
-		        frac,
-		        ent->client->clientMarkers[i].origin[0],
-		        ent->client->clientMarkers[i].origin[1],
-		        ent->client->clientMarkers[i].origin[2],
-		        ent->client->clientMarkers[j].origin[0],
-		        ent->client->clientMarkers[j].origin[1],
-		        ent->client->clientMarkers[j].origin[2],
-		        level.time, level.time + debugger->client->frameOffset,
-		        level.time - time, level.time + debugger->client->frameOffset - time);
-
-		    trap_SendServerCommand( debugger - g_entities, msg );
+			G_ApplyAntilagState(ent, &h->state[i], h->time[i]);
 		}
-		*/
 	}
 	else
 	{
-		VectorCopy(ent->client->clientMarkers[j].origin, ent->r.currentOrigin);
-		VectorCopy(ent->client->clientMarkers[j].mins, ent->r.mins);
-		VectorCopy(ent->client->clientMarkers[j].maxs, ent->r.maxs);
+		VectorCopy(h->box[j][0], ent->r.currentOrigin);
+		VectorCopy(h->box[j][1], ent->r.mins);
+		VectorCopy(h->box[j][2], ent->r.maxs);
 
 		// BuildHead/Legs uses these
-		VectorCopy(ent->client->clientMarkers[j].viewangles, ent->client->ps.viewangles);
-		ent->client->ps.eFlags     = ent->client->clientMarkers[j].eFlags;
-		ent->client->ps.pm_flags   = ent->client->clientMarkers[j].pm_flags;
-		ent->client->ps.viewheight = ent->client->clientMarkers[j].viewheight;
-
-		// Torso Markers
-		ent->torsoFrame.oldFrameModel = ent->client->clientMarkers[j].torsoOldFrameModel;
-		ent->torsoFrame.frameModel    = ent->client->clientMarkers[j].torsoFrameModel;
-		ent->torsoFrame.oldFrame      = ent->client->clientMarkers[j].torsoOldFrame;
-		ent->torsoFrame.frame         = ent->client->clientMarkers[j].torsoFrame;
-		ent->torsoFrame.oldFrameTime  = ent->client->clientMarkers[j].torsoOldFrameTime;
-		ent->torsoFrame.frameTime     = ent->client->clientMarkers[j].torsoFrameTime;
-		ent->torsoFrame.yawAngle      = ent->client->clientMarkers[j].torsoYawAngle;
-		ent->torsoFrame.pitchAngle    = ent->client->clientMarkers[j].torsoPitchAngle;
-		ent->torsoFrame.yawing        = ent->client->clientMarkers[j].torsoYawing;
-		ent->torsoFrame.pitching      = ent->client->clientMarkers[j].torsoPitching;
-
-		// Legs Markers
-		ent->legsFrame.oldFrameModel = ent->client->clientMarkers[j].legsOldFrameModel;
-		ent->legsFrame.frameModel    = ent->client->clientMarkers[j].legsFrameModel;
-		ent->legsFrame.oldFrame      = ent->client->clientMarkers[j].legsOldFrame;
-		ent->legsFrame.frame         = ent->client->clientMarkers[j].legsFrame;
-		ent->legsFrame.oldFrameTime  = ent->client->clientMarkers[j].legsOldFrameTime;
-		ent->legsFrame.frameTime     = ent->client->clientMarkers[j].legsFrameTime;
-		ent->legsFrame.yawAngle      = ent->client->clientMarkers[j].legsYawAngle;
-		ent->legsFrame.pitchAngle    = ent->client->clientMarkers[j].legsPitchAngle;
-		ent->legsFrame.yawing        = ent->client->clientMarkers[j].legsYawing;
-		ent->legsFrame.pitching      = ent->client->clientMarkers[j].legsPitching;
-
-		// time stamp for BuildHead/Leg
-		ent->timeShiftTime = ent->client->clientMarkers[j].time;
+		VectorCopy(h->viewangles[j], ent->client->ps.viewangles);
+		G_ApplyAntilagState(ent, &h->state[j], h->time[j]);
 	}
 
 	trap_LinkEntity(ent);
@@ -497,15 +583,76 @@ qboolean G_ReAdjustSingleClientPosition(gentity_t *ent)
 	return qfalse;
 }
 
+/**
+ * @brief Tests if a trace can touch a client at any time of its marker history.
+ * The current position is included as clients which aren't shifted stay there.
+ * @param[in] ent client entity
+ * @param[in] start
+ * @param[in] mins may be NULL
+ * @param[in] maxs may be NULL
+ * @param[in] end
+ * @return qfalse if the trace misses the client, its head and legs at all times
+ */
+static qboolean G_AntilagTraceTouches(gentity_t *ent, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end)
+{
+	antilagHistory_t *h = &antilagHistory[ent->client - level.clients];
+	vec3_t           absmin, absmax;
+	float            enter = 0.f, leave = 1.f, d, t1, t2;
+	int              i;
+
+	for (i = 0; i < 3; i++)
+	{
+		// grow the bounds by the trace box, so the trace can be handled as a line
+		absmin[i] = MIN(h->absmin[i], ent->r.currentOrigin[i] + ent->r.mins[i]) - ANTILAG_BODYPART_REACH - (maxs ? maxs[i] : 0.f);
+		absmax[i] = MAX(h->absmax[i], ent->r.currentOrigin[i] + ent->r.maxs[i]) + ANTILAG_BODYPART_REACH - (mins ? mins[i] : 0.f);
+
+		d = end[i] - start[i];
+		if (d == 0.f)
+		{
+			if (start[i] < absmin[i] || start[i] > absmax[i])
+			{
+				return qfalse;
+			}
+			continue;
+		}
+
+		t1 = (absmin[i] - start[i]) / d;
+		t2 = (absmax[i] - start[i]) / d;
+		if (t1 > t2)
+		{
+			d  = t1;
+			t1 = t2;
+			t2 = d;
+		}
+
+		enter = MAX(enter, t1);
+		leave = MIN(leave, t2);
+		if (enter > leave)
+		{
+			return qfalse;
+		}
+	}
+
+	return qtrue;
+}
+
 /**
  * @brief Move ALL clients back to where they were at the specified "time", except for "skip"
+ *
+ * With g_antilagLazy only the clients a trace from start to end can touch
+ * are shifted, the others can't be hit by it at any time anyway.
+ *
  * @param[in] skip Client to skip (the one shooting currently)
  * @param[in] time timestamp which to use
  * @param[in] backwards are we going back or forward in time (are we restoring the original location)
+ * @param[in] start trace start, NULL to shift all clients
+ * @param[in] mins
+ * @param[in] maxs
+ * @param[in] end
  */
-static void G_AdjustClientPositions(gentity_t *skip, int time, qboolean backwards)
+static void G_AdjustClientPositions(gentity_t *skip, int time, qboolean backwards, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end)
 {
-	int       i;
+	int       i, clients = 0, rewound = 0;
 	gentity_t *list;
 
 	for (i = 0; i < level.numConnectedClients; i++, list++)
@@ -520,13 +667,31 @@ static void G_AdjustClientPositions(gentity_t *skip, int time, qboolean backward
 
 		if (backwards)
 		{
-			G_AdjustSingleClientPosition(list, time);
+			clients++;
+
+			if (start && g_antilagLazy.integer && !G_AntilagTraceTouches(list, start, mins, maxs, end))
+			{
+				continue;
+			}
+
+			if (G_AdjustSingleClientPosition(list, time))
+			{
+				rewound++;
+			}
 		}
 		else
 		{
 			G_ReAdjustSingleClientPosition(list);
 		}
 	}
+
+	if (backwards)
+	{
+		antilagStats.traces++;
+		antilagStats.clients   += clients;
+		antilagStats.rewound   += rewound;
+		antilagStats.maxRewound = MAX(antilagStats.maxRewound, rewound);
+	}
 }
 
 /**
@@ -535,62 +700,13 @@ static void G_AdjustClientPositions(gentity_t *skip, int time, qboolean backward
  */
 void G_ResetMarkers(gentity_t *ent)
 {
-	int   i, time;
-	float period = sv_fps.value;
-	int   eFlags;
+	antilagHistory_t *h = &antilagHistory[ent->client - level.clients];
 
-	if (period <= 0.f)
-	{
-		period = 50;
-	}
-	else
-	{
-		period = 1000.f / period;
-	}
-
-	eFlags = ent->client->ps.eFlags;
-	// don't save entity flags that are not allowed for clientMarkers
-	if (eFlags & EF_MOUNTEDTANK)
-	{
-		eFlags &= ~EF_MOUNTEDTANK;
-	}
-
-	ent->client->topMarker = MAX_CLIENT_MARKERS - 1;
-	for (i = MAX_CLIENT_MARKERS - 1, time = level.time; i >= 0; i--, time -= period)
-	{
-		VectorCopy(ent->r.mins, ent->client->clientMarkers[i].mins);
-		VectorCopy(ent->r.maxs, ent->client->clientMarkers[i].maxs);
-		VectorCopy(ent->r.currentOrigin, ent->client->clientMarkers[i].origin);
-		ent->client->clientMarkers[i].time = time;
-		VectorCopy(ent->client->ps.viewangles, ent->client->clientMarkers[i].viewangles);
-		ent->client->clientMarkers[i].eFlags     = eFlags;
-		ent->client->clientMarkers[i].pm_flags   = ent->client->ps.pm_flags;
-		ent->client->clientMarkers[i].viewheight = ent->client->ps.viewheight;
+	// shots from before the first stored marker see the client at the oldest one
+	h->head  = 0;
+	h->count = 0;
+	G_UpdateMarkerBounds(h);
 
-		// Torso Markers
-		ent->client->clientMarkers[i].torsoOldFrameModel = ent->torsoFrame.oldFrameModel;
-		ent->client->clientMarkers[i].torsoFrameModel    = ent->torsoFrame.frameModel;
-		ent->client->clientMarkers[i].torsoOldFrame      = ent->torsoFrame.oldFrame;
-		ent->client->clientMarkers[i].torsoFrame         = ent->torsoFrame.frame;
-		ent->client->clientMarkers[i].torsoOldFrameTime  = ent->torsoFrame.oldFrameTime;
-		ent->client->clientMarkers[i].torsoFrameTime     = ent->torsoFrame.frameTime;
-		ent->client->clientMarkers[i].torsoYawAngle      = ent->torsoFrame.yawAngle;
-		ent->client->clientMarkers[i].torsoPitchAngle    = ent->torsoFrame.pitchAngle;
-		ent->client->clientMarkers[i].torsoYawing        = ent->torsoFrame.yawing;
-		ent->client->clientMarkers[i].torsoPitching      = ent->torsoFrame.pitching;
-
-		// Legs Markers
-		ent->client->clientMarkers[i].legsOldFrameModel = ent->legsFrame.oldFrameModel;
-		ent->client->clientMarkers[i].legsFrameModel    = ent->legsFrame.frameModel;
-		ent->client->clientMarkers[i].legsOldFrame      = ent->legsFrame.oldFrame;
-		ent->client->clientMarkers[i].legsFrame         = ent->legsFrame.frame;
-		ent->client->clientMarkers[i].legsOldFrameTime  = ent->legsFrame.oldFrameTime;
-		ent->client->clientMarkers[i].legsFrameTime     = ent->legsFrame.frameTime;
-		ent->client->clientMarkers[i].legsYawAngle      = ent->legsFrame.yawAngle;
-		ent->client->clientMarkers[i].legsPitchAngle    = ent->legsFrame.pitchAngle;
-		ent->client->clientMarkers[i].legsYawing        = ent->legsFrame.yawing;
-		ent->client->clientMarkers[i].legsPitching      = ent->legsFrame.pitching;
-	}
 	// time stamp for BuildHead/Leg
 	ent->timeShiftTime = 0;
 }
@@ -698,11 +814,11 @@ void G_HistoricalTrace(gentity_t *ent, trace_t *results, const vec3_t start, con
 		return;
 	}
 
-	G_AdjustClientPositions(ent, ent->client->pers.cmd.serverTime, qtrue);
+	G_AdjustClientPositions(ent, ent->client->pers.cmd.serverTime, qtrue, start, mins, maxs, end);
 
 	G_Trace(ent, results, start, mins, maxs, end, passEntityNum, contentmask);
 
-	G_AdjustClientPositions(ent, 0, qfalse);
+	G_AdjustClientPositions(ent, 0, qfalse, NULL, NULL, NULL, NULL);
 }
 
 /**
@@ -716,7 +832,26 @@ void G_HistoricalTraceBegin(gentity_t *ent)
 	{
 		return;
 	}
-	G_AdjustClientPositions(ent, ent->client->pers.cmd.serverTime, qtrue);
+	G_AdjustClientPositions(ent, ent->client->pers.cmd.serverTime, qtrue, NULL, NULL, NULL, NULL);
+}
+
+/**
+ * @brief Same as G_HistoricalTraceBegin() for a group of traces which all
+ * stay within the given one, only the clients it can touch are shifted.
+ * @param[in] ent
+ * @param[in] start
+ * @param[in] mins may be NULL
+ * @param[in] maxs may be NULL
+ * @param[in] end
+ */
+void G_HistoricalTraceBeginSegment(gentity_t *ent, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end)
+{
+	// don't do this with antilag off, or for bots
+	if (!g_antilag.integer || ent->r.svFlags & SVF_BOT)
+	{
+		return;
+	}
+	G_AdjustClientPositions(ent, ent->client->pers.cmd.serverTime, qtrue, start, mins, maxs, end);
 }
 
 /**
@@ -730,7 +865,33 @@ void G_HistoricalTraceEnd(gentity_t *ent)
 	{
 		return;
 	}
-	G_AdjustClientPositions(ent, 0, qfalse);
+	G_AdjustClientPositions(ent, 0, qfalse, NULL, NULL, NULL, NULL);
+}
+
+/**
+ * @brief Prints how many clients the historical traces shifted,
+ * "antilag_stats reset" clears the counters
+ */
+void G_AntilagStats_f(void)
+{
+	char arg[MAX_TOKEN_CHARS];
+
+	if (trap_Argc() > 1)
+	{
+		trap_Argv(1, arg, sizeof(arg));
+		if (!Q_stricmp(arg, "reset"))
+		{
+			Com_Memset(&antilagStats, 0, sizeof(antilagStats));
+			return;
+		}
+	}
+
+	G_Printf("Antilag rewinds (g_antilag %i, g_antilagLazy %i):\n", g_antilag.integer, g_antilagLazy.integer);
+	G_Printf("traces          : %i\n", antilagStats.traces);
+	G_Printf("clients         : %i (%.2f per trace)\n", antilagStats.clients, antilagStats.traces ? (double)antilagStats.clients / antilagStats.traces : 0.0);
+	G_Printf("rewound         : %i (%.2f per trace)\n", antilagStats.rewound, antilagStats.traces ? (double)antilagStats.rewound / antilagStats.traces : 0.0);
+	G_Printf("max per trace   : %i\n", antilagStats.maxRewound);
+	G_Printf("relinks skipped : %.1f%%\n", antilagStats.clients ? 100.0 * (antilagStats.clients - antilagStats.rewound) / antilagStats.clients : 0.0);
 }
 
 static float maxsBackup[MAX_CLIENTS] = { 0 };
@@ -99,6 +99,7 @@ void SP_info_player_deathmatch(gentity_t *ent)
 void SP_info_player_checkpoint(gentity_t *ent)
 {
 	ent->classname = "info_player_checkpoint";
+	G_TouchEntityIndex(ent);
 	SP_info_player_deathmatch(ent);
 }
 
@@ -110,6 +111,7 @@ void SP_info_player_checkpoint(gentity_t *ent)
 void SP_info_player_start(gentity_t *ent)
 {
 	ent->classname = "info_player_deathmatch";
+	G_TouchEntityIndex(ent);
 	SP_info_player_deathmatch(ent);
 }
 
@@ -543,6 +545,7 @@ void CopyToBodyQue(gentity_t *ent)
 
 	body->s.eType   = ET_CORPSE;
 	body->classname = "corpse";
+	G_TouchEntityIndex(body);
 
 	body->s.powerups    = 0; // clear powerups
 	body->s.loopSound   = 0; // clear lava burning
@@ -3022,6 +3025,7 @@ void ClientSpawn(gentity_t *ent, qboolean revived, qboolean teamChange, qboolean
 	ent->classname         = "player";
 	ent->r.contents        = CONTENTS_BODY;
 	ent->clipmask          = MASK_PLAYERSOLID;
+	G_TouchEntityIndex(ent);
 
 	// Init to -1 on first spawn;
 	if (!revived)
@@ -3417,7 +3421,7 @@ void ClientDisconnect(int clientNum)
 		{
 			teamList = &mapEntityData[i];
 
-			if ((mEnt = G_FindMapEntityData(&mapEntityData[0], ent - g_entities)) != NULL)
+			if ((mEnt = G_FindMapEntityData(teamList, ent - g_entities)) != NULL)
 			{
 				G_FreeMapEntityData(teamList, mEnt);
 			}
@@ -3489,6 +3493,7 @@ void ClientDisconnect(int clientNum)
 	i                                      = ent->client->sess.sessionTeam;
 	ent->client->sess.sessionTeam          = TEAM_FREE;
 	ent->active                            = 0;
+	G_TouchEntityIndex(ent);
 
 	// this needs to be cleared
 	ent->r.svFlags &= ~SVF_BOT;
@@ -1492,7 +1492,7 @@ qboolean SetTeam(gentity_t *ent, const char *s, qboolean force, weapon_t w1, wea
 		{
 			teamList = &mapEntityData[i];
 
-			if ((mEnt = G_FindMapEntityData(&mapEntityData[0], ent - g_entities)) != NULL)
+			if ((mEnt = G_FindMapEntityData(teamList, ent - g_entities)) != NULL)
 			{
 				G_FreeMapEntityData(teamList, mEnt);
 			}
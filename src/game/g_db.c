@@ -91,7 +91,8 @@ int G_DB_Init()
 	// open db
 	if (db_mode == 1)
 	{
-		result = sqlite3_open_v2(level.database.path, &level.database.db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_MEMORY | SQLITE_OPEN_SHAREDCACHE, NULL);
+		// the connection is shared with the database thread
+		result = sqlite3_open_v2(level.database.path, &level.database.db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_MEMORY | SQLITE_OPEN_SHAREDCACHE | SQLITE_OPEN_FULLMUTEX, NULL);
 
 		if (result != SQLITE_OK)
 		{
@@ -113,7 +114,8 @@ int G_DB_Init()
 		char         *err_msg = NULL;
 		sqlite3_stmt *sqlstmt;
 
-		result = sqlite3_open_v2(level.database.path, &level.database.db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,NULL);
+		// the connection is shared with the database thread
+		result = sqlite3_open_v2(level.database.path, &level.database.db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, NULL);
 
 		if (result != SQLITE_OK)
 		{
@@ -156,6 +158,8 @@ int G_DB_Init()
 	// initialize db - keep it open until deinit
 	level.database.initialized = 1;
 
+	G_DB_StartWorker();
+
 	return 0;
 }
 
@@ -173,6 +177,9 @@ int G_DB_DeInit()
 		return 1;
 	}
 
+	// complete pending jobs and release the cached statements
+	G_DB_StopWorker();
+
 	// close db
 	result = sqlite3_close(level.database.db);
 	if (result != SQLITE_OK)
@@ -0,0 +1,973 @@
+/*
+ * ET: Legacy
+ * Copyright (C) 2012-2024 ET:Legacy team <mail@etlegacy.com>
+ *
+ * This file is part of ET: Legacy - http://www.etlegacy.com
+ *
+ * ET: Legacy is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ET: Legacy is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ET: Legacy. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file g_db_worker.c
+ * @brief Runs the player data queries (XP saver, skill rating, prestige) on a
+ *        database thread so a slow disk doesn't stall the server frame.
+ *
+ * Jobs are run in the order they were queued. The run function of a job is
+ * called on the database thread, its done function on the game thread at the
+ * start of the next G_RunFrame(). With g_dbThread 0 or if the thread can't be
+ * started, jobs run in place but are still completed at the next frame.
+ *
+ * While jobs are pending the database thread owns the statement cache. Game
+ * code that uses G_DB_Statement() or depends on the result of queued writes
+ * has to call G_DB_Flush() first.
+ *
+ * Code run by a job must not call G_Printf(), va() or any trap, use
+ * G_DB_Printf() for messages instead.
+ *
+ * Jobs queued between G_DB_BeginBatch() and G_DB_EndBatch() run in a single
+ * transaction, so a burst of writes (e.g. at intermission) is synced to disk
+ * once instead of once per statement. The time spent on each kind of job is
+ * logged when the batch is committed.
+ */
+
+#ifdef FEATURE_DBMS
+
+#include "g_local.h"
+#include <sqlite3.h>
+
+#ifdef _WIN32
+#   include <windows.h>
+typedef CRITICAL_SECTION dbMutex_t;
+typedef CONDITION_VARIABLE dbCond_t;
+typedef HANDLE dbThread_t;
+#else
+#   include <pthread.h>
+#   include <time.h>
+typedef pthread_mutex_t dbMutex_t;
+typedef pthread_cond_t dbCond_t;
+typedef pthread_t dbThread_t;
+#endif
+
+#define DB_MAX_JOBS       256       ///< power of two
+#define DB_MAX_STATEMENTS 32
+#define DB_MAX_MESSAGE    256
+#define DB_MAX_PHASES     12
+
+/**
+ * @struct dbJob_t
+ * @brief A queued job and a copy of its data
+ */
+typedef struct
+{
+	const char *name;
+	dbJobFunc_t run;
+	dbJobFunc_t done;
+
+	unsigned int queued;                ///< microseconds
+	unsigned int started;
+	unsigned int finished;
+
+	char message[DB_MAX_MESSAGE];       ///< G_DB_Printf() output of the job, printed when it is done
+
+	union
+	{
+		byte bytes[DB_JOB_DATASIZE];
+		double align;
+		void *alignPtr;
+	} data;
+} dbJob_t;
+
+/**
+ * @struct dbWorker_s
+ * @brief
+ */
+static struct dbWorker_s
+{
+	qboolean running;                   ///< thread is started
+	dbThread_t thread;
+#ifdef _WIN32
+	DWORD threadId;
+#endif
+
+	dbMutex_t lock;
+	dbCond_t wake;                      ///< signalled when a job is queued or the thread has to quit
+	dbCond_t idle;                      ///< signalled when a job is finished
+	qboolean quit;
+
+	// the counters only grow, jobs[count % DB_MAX_JOBS] is the next one
+	unsigned int numQueued;             ///< written by the game thread
+	unsigned int numRun;                ///< written by the database thread
+	unsigned int numDone;               ///< written by the game thread
+
+	dbJob_t *current;                   ///< job run by the database thread
+
+	dbJob_t jobs[DB_MAX_JOBS];
+} dbWorker;
+
+/**
+ * @struct dbStats_s
+ * @brief Counted on the game thread when jobs are done
+ */
+static struct dbStats_s
+{
+	int jobs;
+	int maxDepth;                       ///< most jobs queued but not yet run
+	int flushes;
+	int fullQueue;                      ///< times the queue had to be flushed to queue a job
+	double waitTotal;                   ///< microseconds from queued to started
+	unsigned int waitMax;
+	double runTotal;                    ///< microseconds from started to finished
+	unsigned int runMax;
+} dbStats;
+
+/**
+ * @struct dbPhase_t
+ * @brief Time spent on one kind of work of a batch
+ */
+typedef struct
+{
+	const char *name;                   ///< job name or game thread phase
+	qboolean game;                      ///< run on the game thread
+	int count;
+	double time;                        ///< microseconds
+} dbPhase_t;
+
+/**
+ * @struct dbBatch_s
+ * @brief The current or last batch, game thread only
+ */
+static struct dbBatch_s
+{
+	const char *name;
+	qboolean open;                      ///< G_DB_EndBatch() not yet called
+	qboolean active;                    ///< COMMIT not yet done, jobs done are timed
+	qboolean committed;
+	unsigned int first;                 ///< number of the BEGIN job
+	unsigned int started;               ///< microseconds
+	unsigned int finished;
+
+	const char *phase;                  ///< game thread phase in progress
+	unsigned int phaseStarted;
+
+	dbPhase_t phases[DB_MAX_PHASES];
+	int numPhases;
+} dbBatch;
+
+/**
+ * @struct dbBatchJob_t
+ * @brief Data of the BEGIN and COMMIT jobs
+ */
+typedef struct
+{
+	int result;
+	unsigned int finished;
+} dbBatchJob_t;
+
+static qboolean dbTransaction;          ///< database thread: the batch transaction is open
+
+/**
+ * @struct dbStatement_t
+ * @brief A prepared statement, kept until the database is closed
+ */
+typedef struct
+{
+	const char *sql;
+	sqlite3_stmt *stmt;
+} dbStatement_t;
+
+static dbStatement_t dbStatements[DB_MAX_STATEMENTS];
+static int           dbNumStatements;
+
+#ifdef _WIN32
+
+/****** THREAD HANDLING - WINDOWS VARIANT ******/
+
+#define DB_Lock()       EnterCriticalSection(&dbWorker.lock)
+#define DB_Unlock()     LeaveCriticalSection(&dbWorker.lock)
+#define DB_Wait(c)      SleepConditionVariableCS(c, &dbWorker.lock, INFINITE)
+#define DB_Signal(c)    WakeConditionVariable(c)
+
+static void G_DB_WorkerLoop(void);
+
+/**
+ * @brief G_DB_SystemThreadProc
+ * @param[in] param
+ * @return
+ */
+static DWORD WINAPI G_DB_SystemThreadProc(LPVOID param)
+{
+	G_DB_WorkerLoop();
+	return 0;
+}
+
+/**
+ * @brief G_DB_StartThread
+ * @return
+ */
+static qboolean G_DB_StartThread(void)
+{
+	InitializeCriticalSection(&dbWorker.lock);
+	InitializeConditionVariable(&dbWorker.wake);
+	InitializeConditionVariable(&dbWorker.idle);
+
+	dbWorker.thread = CreateThread(NULL, 0, G_DB_SystemThreadProc, NULL, 0, &dbWorker.threadId);
+	if (!dbWorker.thread)
+	{
+		DeleteCriticalSection(&dbWorker.lock);
+		return qfalse;
+	}
+	return qtrue;
+}
+
+/**
+ * @brief G_DB_JoinThread
+ */
+static void G_DB_JoinThread(void)
+{
+	WaitForSingleObject(dbWorker.thread, INFINITE);
+	CloseHandle(dbWorker.thread);
+	DeleteCriticalSection(&dbWorker.lock);
+}
+
+/**
+ * @brief G_DB_OnThread
+ * @return qtrue if called from the database thread
+ */
+static qboolean G_DB_OnThread(void)
+{
+	return dbWorker.running && GetCurrentThreadId() == dbWorker.threadId;
+}
+
+/**
+ * @brief G_DB_Microseconds
+ * @return
+ */
+static unsigned int G_DB_Microseconds(void)
+{
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER        counter;
+
+	if (!frequency.QuadPart)
+	{
+		QueryPerformanceFrequency(&frequency);
+	}
+	QueryPerformanceCounter(&counter);
+
+	return (unsigned int)(counter.QuadPart * 1000000 / frequency.QuadPart);
+}
+
+#else // defined __linux__ || defined __APPLE__ || defined __FreeBSD__
+
+/****** THREAD HANDLING - UNIX VARIANT ******/
+
+#define DB_Lock()       pthread_mutex_lock(&dbWorker.lock)
+#define DB_Unlock()     pthread_mutex_unlock(&dbWorker.lock)
+#define DB_Wait(c)      pthread_cond_wait(c, &dbWorker.lock)
+#define DB_Signal(c)    pthread_cond_signal(c)
+
+static void G_DB_WorkerLoop(void);
+
+/**
+ * @brief G_DB_SystemThreadProc
+ * @param[in] param
+ * @return
+ */
+static void *G_DB_SystemThreadProc(void *param)
+{
+	G_DB_WorkerLoop();
+	return NULL;
+}
+
+/**
+ * @brief G_DB_StartThread
+ * @return
+ */
+static qboolean G_DB_StartThread(void)
+{
+	pthread_mutex_init(&dbWorker.lock, NULL);
+	pthread_cond_init(&dbWorker.wake, NULL);
+	pthread_cond_init(&dbWorker.idle, NULL);
+
+	if (pthread_create(&dbWorker.thread, NULL, G_DB_SystemThreadProc, NULL) != 0)
+	{
+		pthread_cond_destroy(&dbWorker.idle);
+		pthread_cond_destroy(&dbWorker.wake);
+		pthread_mutex_destroy(&dbWorker.lock);
+		return qfalse;
+	}
+	return qtrue;
+}
+
+/**
+ * @brief G_DB_JoinThread
+ */
+static void G_DB_JoinThread(void)
+{
+	pthread_join(dbWorker.thread, NULL);
+
+	pthread_cond_destroy(&dbWorker.idle);
+	pthread_cond_destroy(&dbWorker.wake);
+	pthread_mutex_destroy(&dbWorker.lock);
+}
+
+/**
+ * @brief G_DB_OnThread
+ * @return qtrue if called from the database thread
+ */
+static qboolean G_DB_OnThread(void)
+{
+	return dbWorker.running && pthread_equal(pthread_self(), dbWorker.thread);
+}
+
+/**
+ * @brief G_DB_Microseconds
+ * @return
+ */
+static unsigned int G_DB_Microseconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (unsigned int)(now.tv_sec * 1000000 + now.tv_nsec / 1000);
+}
+
+#endif
+
+/**
+ * @brief Runs a job and records its timing
+ * @param[in,out] job
+ */
+static void G_DB_RunJob(dbJob_t *job)
+{
+	dbWorker.current = job;
+
+	job->started = G_DB_Microseconds();
+	job->run(job->data.bytes);
+	job->finished = G_DB_Microseconds();
+
+	dbWorker.current = NULL;
+}
+
+/**
+ * @brief Runs queued jobs until the thread is told to quit, pending jobs are run first.
+ */
+static void G_DB_WorkerLoop(void)
+{
+	dbJob_t *job;
+
+	DB_Lock();
+	while (1)
+	{
+		while (!dbWorker.quit && dbWorker.numRun == dbWorker.numQueued)
+		{
+			DB_Wait(&dbWorker.wake);
+		}
+
+		if (dbWorker.numRun == dbWorker.numQueued)
+		{
+			break;
+		}
+
+		job = &dbWorker.jobs[dbWorker.numRun & (DB_MAX_JOBS - 1)];
+
+		DB_Unlock();
+		G_DB_RunJob(job);
+		DB_Lock();
+
+		dbWorker.numRun++;
+		DB_Signal(&dbWorker.idle);
+	}
+	DB_Unlock();
+}
+
+/**
+ * @brief Starts the database thread, unless disabled by g_dbThread
+ */
+void G_DB_StartWorker(void)
+{
+	Com_Memset(&dbWorker, 0, sizeof(dbWorker));
+	Com_Memset(&dbStats, 0, sizeof(dbStats));
+	Com_Memset(&dbBatch, 0, sizeof(dbBatch));
+	dbTransaction = qfalse;
+
+	if (!g_dbThread.integer)
+	{
+		return;
+	}
+
+	if (!G_DB_StartThread())
+	{
+		G_Printf("^3WARNING: G_DB_StartWorker: could not start database thread, running queries in place\n");
+		return;
+	}
+
+	dbWorker.running = qtrue;
+}
+
+/**
+ * @brief Completes all queued jobs, stops the database thread and finalizes the cached statements
+ */
+void G_DB_StopWorker(void)
+{
+	int i;
+
+	G_DB_Flush();
+
+	if (dbWorker.running)
+	{
+		DB_Lock();
+		dbWorker.quit = qtrue;
+		DB_Signal(&dbWorker.wake);
+		DB_Unlock();
+
+		G_DB_JoinThread();
+		dbWorker.running = qfalse;
+	}
+
+	for (i = 0; i < dbNumStatements; i++)
+	{
+		sqlite3_finalize(dbStatements[i].stmt);
+	}
+
+	Com_Memset(dbStatements, 0, sizeof(dbStatements));
+	dbNumStatements = 0;
+}
+
+/**
+ * @brief Adds time to a phase of the current batch
+ * @param[in] name Must be a string constant
+ * @param[in] game
+ * @param[in] usec
+ */
+static void G_DB_AddPhase(const char *name, qboolean game, unsigned int usec)
+{
+	dbPhase_t *phase;
+	int       i;
+
+	for (i = 0; i < dbBatch.numPhases; i++)
+	{
+		if (dbBatch.phases[i].name == name && dbBatch.phases[i].game == game)
+		{
+			break;
+		}
+	}
+
+	if (i == dbBatch.numPhases)
+	{
+		if (dbBatch.numPhases == DB_MAX_PHASES)
+		{
+			return;
+		}
+		dbBatch.numPhases++;
+	}
+
+	phase        = &dbBatch.phases[i];
+	phase->name  = name;
+	phase->game  = game;
+	phase->count++;
+	phase->time += usec;
+}
+
+/**
+ * @brief Calls the done functions of all jobs the database thread has finished.
+ *        Called at the start of each frame.
+ */
+void G_DB_RunFrame(void)
+{
+	static dbJob_t job;
+	unsigned int   numRun, seq, wait, run;
+
+	if (dbWorker.running)
+	{
+		DB_Lock();
+		numRun = dbWorker.numRun;
+		DB_Unlock();
+	}
+	else
+	{
+		numRun = dbWorker.numRun;
+	}
+
+	while (dbWorker.numDone != numRun)
+	{
+		// copy it, the done function may queue jobs into the slot
+		seq = dbWorker.numDone++;
+		job = dbWorker.jobs[seq & (DB_MAX_JOBS - 1)];
+
+		wait = job.started - job.queued;
+		run  = job.finished - job.started;
+
+		dbStats.jobs++;
+		dbStats.waitTotal += wait;
+		dbStats.runTotal  += run;
+		dbStats.waitMax    = MAX(dbStats.waitMax, wait);
+		dbStats.runMax     = MAX(dbStats.runMax, run);
+
+		// jobs queued before the batch began may still complete during it
+		if (dbBatch.active && (int)(seq - dbBatch.first) >= 0)
+		{
+			G_DB_AddPhase(job.name, !dbWorker.running, run);
+		}
+
+		if (job.message[0])
+		{
+			G_Printf("%s", job.message);
+		}
+
+		if (job.done)
+		{
+			job.done(job.data.bytes);
+		}
+	}
+}
+
+/**
+ * @brief Waits until all queued jobs are run and calls their done functions.
+ *        Afterwards the game thread can use the database until the next job is queued.
+ */
+void G_DB_Flush(void)
+{
+	unsigned int started;
+
+	if (dbWorker.numDone == dbWorker.numQueued)
+	{
+		return;
+	}
+
+	dbStats.flushes++;
+	started = G_DB_Microseconds();
+
+	do
+	{
+		if (dbWorker.running)
+		{
+			DB_Lock();
+			while (dbWorker.numRun != dbWorker.numQueued)
+			{
+				DB_Wait(&dbWorker.idle);
+			}
+			DB_Unlock();
+		}
+
+		G_DB_RunFrame();
+	}
+	while (dbWorker.numDone != dbWorker.numQueued);     // done functions may queue jobs
+
+	// the game thread was blocked, unless it's part of a timed phase anyway
+	if (dbBatch.active && !dbBatch.phase)
+	{
+		G_DB_AddPhase("flush", qtrue, G_DB_Microseconds() - started);
+	}
+}
+
+/**
+ * @brief Queues a job for the database thread
+ * @param[in] name For the stats
+ * @param[in] run Called on the database thread with a copy of data
+ * @param[in] done Called on the game thread with the same copy once run returned, may be NULL
+ * @param[in] data
+ * @param[in] size At most DB_JOB_DATASIZE bytes
+ */
+void G_DB_QueueJob(const char *name, dbJobFunc_t run, dbJobFunc_t done, const void *data, int size)
+{
+	dbJob_t *job;
+	int     depth;
+
+	if (size > DB_JOB_DATASIZE)
+	{
+		G_Error("G_DB_QueueJob: %s job data too large (%i bytes)\n", name, size);
+	}
+
+	// queue is full of jobs not yet done, wait for them
+	if (dbWorker.numQueued - dbWorker.numDone >= DB_MAX_JOBS)
+	{
+		dbStats.fullQueue++;
+		G_DB_Flush();
+	}
+
+	job = &dbWorker.jobs[dbWorker.numQueued & (DB_MAX_JOBS - 1)];
+
+	job->name       = name;
+	job->run        = run;
+	job->done       = done;
+	job->queued     = G_DB_Microseconds();
+	job->message[0] = '\0';
+	Com_Memcpy(job->data.bytes, data, size);
+
+	if (!dbWorker.running)
+	{
+		G_DB_RunJob(job);
+		dbWorker.numQueued++;
+		dbWorker.numRun++;
+		return;
+	}
+
+	DB_Lock();
+	dbWorker.numQueued++;
+	depth = dbWorker.numQueued - dbWorker.numRun;
+	DB_Signal(&dbWorker.wake);
+	DB_Unlock();
+
+	dbStats.maxDepth = MAX(dbStats.maxDepth, depth);
+}
+
+/**
+ * @brief Opens the batch transaction on the database thread
+ * @param[in,out] data
+ */
+static void G_DB_BeginBatchJob(void *data)
+{
+	dbBatchJob_t *job  = (dbBatchJob_t *)data;
+	sqlite3_stmt *stmt = G_DB_Statement("BEGIN;");
+
+	job->result = stmt ? sqlite3_step(stmt) : SQLITE_ERROR;
+
+	if (job->result != SQLITE_DONE)
+	{
+		G_DB_Printf("^3WARNING: G_DB_BeginBatch: BEGIN failed: %s\n", sqlite3_errmsg(level.database.db));
+	}
+
+	G_DB_ReleaseStatement(stmt);
+
+	dbTransaction = (job->result == SQLITE_DONE);
+}
+
+/**
+ * @brief Commits the batch transaction on the database thread, rolls it back if that fails
+ * @param[in,out] data
+ */
+static void G_DB_EndBatchJob(void *data)
+{
+	dbBatchJob_t *job = (dbBatchJob_t *)data;
+	sqlite3_stmt *stmt;
+
+	if (!dbTransaction)
+	{
+		// statements ran on their own
+		job->result   = SQLITE_DONE;
+		job->finished = G_DB_Microseconds();
+		return;
+	}
+
+	stmt        = G_DB_Statement("COMMIT;");
+	job->result = stmt ? sqlite3_step(stmt) : SQLITE_ERROR;
+	G_DB_ReleaseStatement(stmt);
+
+	if (job->result != SQLITE_DONE)
+	{
+		G_DB_Printf("^1G_DB_EndBatch: COMMIT failed: %s\n", sqlite3_errmsg(level.database.db));
+
+		stmt = G_DB_Statement("ROLLBACK;");
+		if (stmt)
+		{
+			sqlite3_step(stmt);
+			G_DB_ReleaseStatement(stmt);
+		}
+	}
+
+	dbTransaction = qfalse;
+	job->finished = G_DB_Microseconds();
+}
+
+/**
+ * @brief Prints the phases of the last batch
+ * @param[in] print G_Printf or G_LogPrintf
+ */
+static void G_DB_PrintBatch(void(QDECL * print)(const char *fmt, ...))
+{
+	dbPhase_t *phase;
+	double    game = 0;
+	int       i;
+
+	for (i = 0; i < dbBatch.numPhases; i++)
+	{
+		if (dbBatch.phases[i].game)
+		{
+			game += dbBatch.phases[i].time;
+		}
+	}
+
+	print("Database: %s %s in %.3f ms, game thread blocked %.3f ms\n", dbBatch.name,
+	      dbBatch.committed ? "committed" : "rolled back", (dbBatch.finished - dbBatch.started) / 1000.0, game / 1000.0);
+
+	for (i = 0; i < dbBatch.numPhases; i++)
+	{
+		phase = &dbBatch.phases[i];
+
+		print("Database:   %-16s %4i x %8.3f ms (%s)\n", phase->name, phase->count, phase->time / 1000.0,
+		      phase->game ? "game thread" : "database thread");
+	}
+}
+
+/**
+ * @brief Logs the batch once it is committed
+ * @param[in] data
+ */
+static void G_DB_EndBatchDone(void *data)
+{
+	dbBatchJob_t *job = (dbBatchJob_t *)data;
+
+	dbBatch.active    = qfalse;
+	dbBatch.committed = (job->result == SQLITE_DONE);
+	dbBatch.finished  = job->finished;
+
+	G_DB_PrintBatch(G_LogPrintf);
+}
+
+/**
+ * @brief Runs the jobs queued until G_DB_EndBatch() in a single transaction
+ * @param[in] name For the log, must be a string constant
+ *
+ * @note Game thread code using the database in between should be wrapped in
+ *       G_DB_BeginPhase() and G_DB_EndPhase(), it's then part of the transaction.
+ */
+void G_DB_BeginBatch(const char *name)
+{
+	dbBatchJob_t job;
+
+	if (!level.database.initialized || dbBatch.open)
+	{
+		return;
+	}
+
+	// the previous batch must be committed before its stats are cleared
+	if (dbBatch.active)
+	{
+		G_DB_Flush();
+	}
+
+	Com_Memset(&dbBatch, 0, sizeof(dbBatch));
+	dbBatch.name    = name;
+	dbBatch.open    = qtrue;
+	dbBatch.active  = qtrue;
+	dbBatch.started = G_DB_Microseconds();
+
+	Com_Memset(&job, 0, sizeof(job));
+	G_DB_QueueJob("begin", G_DB_BeginBatchJob, NULL, &job, sizeof(job));
+
+	dbBatch.first = dbWorker.numQueued - 1;
+}
+
+/**
+ * @brief Queues the commit of the batch, its phases are logged once it is done
+ */
+void G_DB_EndBatch(void)
+{
+	dbBatchJob_t job;
+
+	if (!dbBatch.open)
+	{
+		return;
+	}
+
+	G_DB_EndPhase();
+
+	dbBatch.open = qfalse;
+
+	Com_Memset(&job, 0, sizeof(job));
+	G_DB_QueueJob("commit", G_DB_EndBatchJob, G_DB_EndBatchDone, &job, sizeof(job));
+}
+
+/**
+ * @brief Starts timing game thread work of the batch. Completes the pending
+ *        jobs, so the game thread may use the database afterwards.
+ * @param[in] name Must be a string constant
+ */
+void G_DB_BeginPhase(const char *name)
+{
+	G_DB_EndPhase();
+	G_DB_Flush();
+
+	if (!dbBatch.active)
+	{
+		return;
+	}
+
+	dbBatch.phase        = name;
+	dbBatch.phaseStarted = G_DB_Microseconds();
+}
+
+/**
+ * @brief Stops timing the game thread work started by G_DB_BeginPhase()
+ */
+void G_DB_EndPhase(void)
+{
+	const char *name = dbBatch.phase;
+
+	if (!name)
+	{
+		return;
+	}
+
+	dbBatch.phase = NULL;
+
+	if (dbBatch.active)
+	{
+		G_DB_AddPhase(name, qtrue, G_DB_Microseconds() - dbBatch.phaseStarted);
+	}
+}
+
+/**
+ * @brief Prints a message, from the database thread the message is kept until the job is done
+ * @param[in] fmt
+ */
+void QDECL G_DB_Printf(const char *fmt, ...)
+{
+	va_list argptr;
+	char    text[DB_MAX_MESSAGE];
+
+	va_start(argptr, fmt);
+	Q_vsnprintf(text, sizeof(text), fmt, argptr);
+	va_end(argptr);
+
+	if (G_DB_OnThread() && dbWorker.current)
+	{
+		Q_strcat(dbWorker.current->message, sizeof(dbWorker.current->message), text);
+		return;
+	}
+
+	G_Printf("%s", text);
+}
+
+/**
+ * @brief Gets a prepared statement from the cache, preparing it on first use
+ * @param[in] sql Must be a string constant, the cache keeps the pointer
+ * @return The statement, NULL on failure
+ *
+ * @note Pass the statement to G_DB_ReleaseStatement() when done with it.
+ */
+sqlite3_stmt *G_DB_Statement(const char *sql)
+{
+	int          i, result;
+	sqlite3_stmt *stmt;
+
+	if (!level.database.initialized)
+	{
+		G_DB_Printf("G_DB_Statement: access to non-initialized database\n");
+		return NULL;
+	}
+
+	for (i = 0; i < dbNumStatements; i++)
+	{
+		if (dbStatements[i].sql == sql || !strcmp(dbStatements[i].sql, sql))
+		{
+			return dbStatements[i].stmt;
+		}
+	}
+
+	result = sqlite3_prepare_v2(level.database.db, sql, -1, &stmt, NULL);
+
+	if (result != SQLITE_OK)
+	{
+		G_DB_Printf("G_DB_Statement: sqlite3_prepare_v2 failed: %s\n", sqlite3_errmsg(level.database.db));
+		return NULL;
+	}
+
+	// keep it if there's room, otherwise it's finalized on release
+	if (dbNumStatements < DB_MAX_STATEMENTS)
+	{
+		dbStatements[dbNumStatements].sql  = sql;
+		dbStatements[dbNumStatements].stmt = stmt;
+		dbNumStatements++;
+	}
+
+	return stmt;
+}
+
+/**
+ * @brief Resets a statement from G_DB_Statement() for its next use
+ * @param[in] stmt
+ */
+void G_DB_ReleaseStatement(sqlite3_stmt *stmt)
+{
+	int i;
+
+	if (!stmt)
+	{
+		return;
+	}
+
+	for (i = 0; i < dbNumStatements; i++)
+	{
+		if (dbStatements[i].stmt == stmt)
+		{
+			sqlite3_reset(stmt);
+			sqlite3_clear_bindings(stmt);
+			return;
+		}
+	}
+
+	sqlite3_finalize(stmt);
+}
+
+/**
+ * @brief Checks a client is still the one a job was queued for
+ * @param[in] clientNum
+ * @param[in] guid
+ * @return
+ */
+qboolean G_DB_IsSameClient(int clientNum, const char *guid)
+{
+	char userinfo[MAX_INFO_STRING];
+
+	if (clientNum < 0 || clientNum >= level.maxclients || level.clients[clientNum].pers.connected == CON_DISCONNECTED)
+	{
+		return qfalse;
+	}
+
+	trap_GetUserinfo(clientNum, userinfo, sizeof(userinfo));
+
+	return !Q_strncmp(Info_ValueForKey(userinfo, "cl_guid"), guid, MAX_GUID_LENGTH + 1);
+}
+
+/**
+ * @brief Prints the database thread stats, "db_stats reset" clears them
+ */
+void G_DB_Stats_f(void)
+{
+	char arg[MAX_TOKEN_CHARS];
+
+	if (trap_Argc() > 1)
+	{
+		trap_Argv(1, arg, sizeof(arg));
+
+		if (!Q_stricmp(arg, "reset"))
+		{
+			Com_Memset(&dbStats, 0, sizeof(dbStats));
+			return;
+		}
+	}
+
+	if (!level.database.initialized)
+	{
+		G_Printf("Database is not initialized.\n");
+		return;
+	}
+
+	G_Printf("Database jobs (%s):\n", dbWorker.running ? "database thread" : "in place, g_dbThread 0");
+	G_Printf("pending    : %u\n", dbWorker.numQueued - dbWorker.numDone);
+	G_Printf("done       : %i\n", dbStats.jobs);
+	G_Printf("max queued : %i\n", dbStats.maxDepth);
+	G_Printf("flushes    : %i (%i on full queue)\n", dbStats.flushes, dbStats.fullQueue);
+	G_Printf("wait       : %.3f ms avg, %.3f ms max\n", dbStats.jobs ? dbStats.waitTotal / dbStats.jobs / 1000.0 : 0.0, dbStats.waitMax / 1000.0);
+	G_Printf("query      : %.3f ms avg, %.3f ms max\n", dbStats.jobs ? dbStats.runTotal / dbStats.jobs / 1000.0 : 0.0, dbStats.runMax / 1000.0);
+	G_Printf("statements : %i cached\n", dbNumStatements);
+
+	if (dbBatch.name && !dbBatch.active)
+	{
+		G_DB_PrintBatch(G_Printf);
+	}
+}
+
+#endif
@@ -131,15 +131,73 @@ typedef struct
 	int hash;
 } g_script_stack_action_t;
 
+/**
+ * @enum scriptKeyword_t
+ * @brief Words with a meaning to the script actions, resolved once when the script is compiled
+ */
+typedef enum
+{
+	SCRIPT_KW_NONE = -1,
+	SCRIPT_KW_SELF,
+	SCRIPT_KW_GLOBAL,
+	SCRIPT_KW_PLAYER,
+	SCRIPT_KW_ACTIVATOR,
+	SCRIPT_KW_RANDOM,
+	SCRIPT_KW_INC,
+	SCRIPT_KW_SET,
+	SCRIPT_KW_BITSET,
+	SCRIPT_KW_BITRESET,
+	SCRIPT_KW_ABORT_IF_LESS_THAN,
+	SCRIPT_KW_ABORT_IF_GREATER_THAN,
+	SCRIPT_KW_ABORT_IF_NOT_EQUAL,
+	SCRIPT_KW_ABORT_IF_NOT_EQUALS,
+	SCRIPT_KW_ABORT_IF_EQUAL,
+	SCRIPT_KW_ABORT_IF_BITSET,
+	SCRIPT_KW_ABORT_IF_NOT_BITSET,
+	SCRIPT_KW_TRIGGER_IF_EQUAL,
+	SCRIPT_KW_WAIT_WHILE_EQUAL,
+	SCRIPT_KW_MAX
+} scriptKeyword_t;
+
+/**
+ * @struct g_script_operand_t
+ * @brief A parameter of a compiled script action, tokenized like the action would do it
+ */
+typedef struct
+{
+	char *string;                           ///< interned token, shared by all actions using the same word
+	qboolean isNumber;
+	int intValue;                           ///< Q_atoi() of the token
+	float floatValue;                       ///< Q_atof() of the token
+	scriptKeyword_t keyword;
+} g_script_operand_t;
+
+#define G_MAX_SCRIPT_ENTREFS 16
+
+/**
+ * @struct g_script_entref_t
+ * @brief Entities an action refers to by name, valid while no named entity is spawned, renamed or freed
+ */
+typedef struct
+{
+	int generation;                         ///< see G_Script_InvalidateEntityRefs()
+	int hash;                               ///< BG_StringHashValue() of the name, targetname lookups compare it too
+	int count;                              ///< -1 if too many entities share the name to cache them
+	short entityNums[G_MAX_SCRIPT_ENTREFS];
+} g_script_entref_t;
+
 /**
  * @struct g_script_stack_item_t
- * @brief
+ * @brief An instruction of a compiled script event
  */
 typedef struct
 {
 	// set during script parsing
-	g_script_stack_action_t *action;                ///< points to an action to perform
+	g_script_stack_action_t *action;                ///< points to an action to perform, the dispatch table entry
 	char *params;
+	int numOperands;
+	g_script_operand_t *operands;                   ///< params split into tokens
+	g_script_entref_t *entRef;                      ///< cached targets of actions naming entities, else NULL
 } g_script_stack_item_t;
 
 /// value set high for the tank
@@ -151,7 +209,7 @@ typedef struct
  */
 typedef struct
 {
-	g_script_stack_item_t items[G_MAX_SCRIPT_STACK_ITEMS];
+	g_script_stack_item_t *items;
 	int numItems;
 } g_script_stack_t;
 
@@ -890,8 +948,6 @@ typedef struct
 	qboolean legsPitching;
 } clientMarker_t;
 
-#define MAX_CLIENT_MARKERS 17
-
 #define FIELDOPS_SPECIAL_PICKUP_MOD 3   ///< Number of times (minus one for modulo) field ops must drop ammo before scoring a point
 #define MEDIC_SPECIAL_PICKUP_MOD    4   ///< Same thing for medic
 
@@ -990,9 +1046,7 @@ struct gclient_s
 
 	combatstate_t combatState;
 
-	int topMarker;
-	clientMarker_t clientMarkers[MAX_CLIENT_MARKERS];
-	clientMarker_t backupMarker;
+	clientMarker_t backupMarker;       ///< position before the time shift, the history itself is kept in g_antilag.c
 
 	// zinx etpro antiwarp
 	int lastUpdateFrame;
@@ -1506,6 +1560,31 @@ gentity_t *G_FindVector(gentity_t *from, int fieldofs, const vec3_t match);
 gentity_t *G_FindByTargetname(gentity_t *from, const char *match);
 gentity_t *G_FindByTargetnameFast(gentity_t *from, const char *match, int hash);
 gentity_t *G_PickTarget(const char *targetname);
+void G_InitEntityIndex(void);
+void G_InitEntityFreeList(void);
+void G_EntityFreeListStats(void);
+void G_SyncEntityIndex(void);
+void G_TouchEntityIndex(gentity_t *ent);
+
+/**
+ * @enum entCategory_t
+ * @brief Kinds of entities kept in lists of their own, see G_FindByCategory()
+ */
+typedef enum
+{
+	ENTCAT_NONE = -1,
+	ENTCAT_LANDMINE,                    ///< ET_MISSILE with MOD_LANDMINE
+	ENTCAT_DYNAMITE,                    ///< ET_MISSILE with MOD_DYNAMITE
+	ENTCAT_SATCHEL,                     ///< ET_MISSILE with MOD_SATCHEL
+	ENTCAT_INDICATOR,                   ///< constructible, explosive and tank indicators
+	ENTCAT_COMMANDMAP_MARKER,
+	ENTCAT_MAX
+} entCategory_t;
+
+void G_UpdateEntityCategory(gentity_t *ent);
+void G_InitEntityCategories(void);
+gentity_t *G_FindByCategory(gentity_t *from, entCategory_t category);
+int G_CountByCategory(entCategory_t category);
 void G_UseTargets(gentity_t *ent, gentity_t *activator);
 void G_SetMovedir(vec3_t angles, vec3_t movedir);
 
@@ -1594,6 +1673,8 @@ typedef struct
 	qhandle_t oldTorsoFrameModel;
 	float backlerp;                     ///< 0.0 = current, 1.0 = old
 	float torsoBacklerp;
+
+	int poseEntity;                     ///< entity number + 1 for the MDX pose cache, 0 keeps the pose out of it
 } grefEntity_t;
 
 // g_combat.c
@@ -1762,8 +1843,10 @@ void QDECL G_Error(const char *fmt, ...) _attribute((noreturn, format(printf, 1,
 // extension interface
 qboolean trap_GetValue(char *value, int valueSize, const char *key);
 void trap_DemoSupport(const char *commands);
+int trap_Cvar_Changes(int *sequence, int *changes, int maxChanges);
 extern int dll_com_trapGetValue;
 extern int dll_trap_DemoSupport;
+extern int dll_trap_CvarChanges;
 
 // g_demo_legacy.c
 void G_DemoStateChanged(demoState_t demoState, int demoClientsNum);
@@ -1825,6 +1908,11 @@ char *Q_AddCR(char *s);
 void G_Script_ScriptParse(gentity_t *ent);
 qboolean G_Script_ScriptRun(gentity_t *ent);
 void G_Script_ScriptLoad(void);
+scriptKeyword_t G_Script_KeywordForString(const char *string);
+const g_script_operand_t *G_Script_Operands(const char *params, int *numOperands);
+gentity_t *G_Script_FindEntityRef(const char *params, gentity_t *from, size_t fieldofs, const char *match);
+void G_Script_InvalidateEntityRefs(void);
+void G_Script_Disassemble_f(void);
 
 void mountedmg42_fire(gentity_t *other);
 void script_mover_use(gentity_t *ent, gentity_t *other, gentity_t *activator);
@@ -1998,6 +2086,9 @@ extern vmCvar_t g_scriptName;               ///< name of script file to run (ins
 extern vmCvar_t g_scriptDebug;              ///< what level of detail do we want script printing to go to.
 extern vmCvar_t g_scriptDebugLevel;         ///< filter out script debug messages from other entities
 extern vmCvar_t g_scriptDebugTarget;
+#ifdef ETLEGACY_DEBUG
+extern vmCvar_t g_debugEntityIndex;        ///< cross-checks entity name index lookups against a scan of all entities
+#endif
 
 extern vmCvar_t g_userAim;
 extern vmCvar_t g_developer;
@@ -2045,6 +2136,8 @@ extern vmCvar_t g_gamestate;
 extern vmCvar_t g_swapteams;
 
 extern vmCvar_t g_antilag;
+extern vmCvar_t g_antilagLazy;
+extern vmCvar_t g_antilagMarkers;
 
 extern vmCvar_t refereePassword;
 extern vmCvar_t shoutcastPassword;
@@ -2202,6 +2295,10 @@ extern vmCvar_t g_multiview;
 extern vmCvar_t g_stickyCharge;
 extern vmCvar_t g_xpSaver;
 
+#ifdef FEATURE_DBMS
+extern vmCvar_t g_dbThread;
+#endif
+
 extern vmCvar_t g_debugForSingleClient;
 
 #define G_InactivityValue (g_inactivity.integer ? g_inactivity.integer : 60)
@@ -2310,14 +2407,17 @@ void Svcmd_ResetMatch_f(qboolean fDoReset, qboolean fDoRestart);
 void Svcmd_SwapTeams_f(void);
 
 // g_antilag.c
+void G_InitAntilag(void);
 void G_StoreClientPosition(gentity_t *ent);
 qboolean G_ReAdjustSingleClientPosition(gentity_t *ent);
 void G_ResetMarkers(gentity_t *ent);
 void G_HistoricalTrace(gentity_t *ent, trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask);
 void G_HistoricalTraceBegin(gentity_t *ent);
+void G_HistoricalTraceBeginSegment(gentity_t *ent, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end);
 void G_HistoricalTraceEnd(gentity_t *ent);
 void G_Trace(gentity_t *ent, trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask);
 void G_PredictPmove(gentity_t *ent, float frametime);
+void G_AntilagStats_f(void);
 
 #define BODY_VALUE(ENT) ENT->watertype
 #define BODY_TEAM(ENT) ENT->s.modelindex
@@ -2331,6 +2431,9 @@ void G_RemoveFromAllIgnoreLists(int clientNum);
 
 // g_teammapdata.c
 
+#define MAX_MAPENTITY_UPDATE 2048        ///< size of an entnfo command
+#define MAX_MAPENTITY_ENCODED 64         ///< size of one encoded map entity
+
 /**
  * @struct mapEntityData_s
  * @typedef mapEntityData_t
@@ -2347,8 +2450,36 @@ typedef struct mapEntityData_s
 
 	int entNum;
 	struct mapEntityData_s *next, *prev;
+	struct mapEntityData_s *nextSingleClient;           ///< next single client entry of the same entity
+
+	char encoded[MAX_MAPENTITY_ENCODED];                ///< as sent in entnfo
+	int encodedLength;
+	qboolean dirty;                                     ///< encoded is out of date
 } mapEntityData_t;
 
+/**
+ * @enum mapEntityUpdateType_t
+ * @brief Encoded sets of map entities kept for each team
+ */
+typedef enum
+{
+	MEU_ALL = 0,                                        ///< for team members and shoutcasters
+	MEU_OBJECTIVES,                                     ///< for spectators
+	MEU_MAX
+} mapEntityUpdateType_t;
+
+/**
+ * @struct mapEntityUpdate_s
+ * @typedef mapEntityUpdate_t
+ * @brief Encoded entities of one team, shared by everyone who receives them
+ */
+typedef struct mapEntityUpdate_s
+{
+	char text[MAX_MAPENTITY_UPDATE];
+	short ends[MAX_GENTITIES];                          ///< end of each entity in text
+	int count;
+} mapEntityUpdate_t;
+
 /**
  * @struct mapEntityData_Team_s
  * @typedef mapEntityData_Team_t
@@ -2359,13 +2490,21 @@ typedef struct mapEntityData_Team_s
 	mapEntityData_t mapEntityData_Team[MAX_GENTITIES];
 	mapEntityData_t *freeMapEntityData;                 ///< single linked list
 	mapEntityData_t activeMapEntityData;                ///< double linked list
+
+	mapEntityData_t *entityIndex[MAX_GENTITIES];        ///< team wide entry of each entity
+	mapEntityData_t *singleClientIndex[MAX_GENTITIES];  ///< single client entries of each entity
+	int singleClientCount;
+
+	int expireTime;                                     ///< when the oldest player entry expires, 0 if there is none
+	qboolean dirty;                                     ///< updates have to be rebuilt
+	mapEntityUpdate_t updates[MEU_MAX];
 } mapEntityData_Team_t;
 
 extern mapEntityData_Team_t mapEntityData[2];
 
 void G_InitMapEntityData(mapEntityData_Team_t *teamList);
 mapEntityData_t *G_FreeMapEntityData(mapEntityData_Team_t *teamList, mapEntityData_t *mEnt);
-mapEntityData_t *G_AllocMapEntityData(mapEntityData_Team_t *teamList);
+mapEntityData_t *G_AllocMapEntityData(mapEntityData_Team_t *teamList, int entNum, int singleClient);
 mapEntityData_t *G_FindMapEntityData(mapEntityData_Team_t *teamList, int entNum);
 mapEntityData_t *G_FindMapEntityDataSingleClient(mapEntityData_Team_t *teamList, mapEntityData_t *start, int entNum, int clientNum);
 
@@ -2527,6 +2666,26 @@ void G_statsPrint(gentity_t *ent, int nType);
 #ifdef FEATURE_DBMS
 int G_DB_Init(void);
 int G_DB_DeInit(void);
+
+// g_db_worker.c
+#define DB_JOB_DATASIZE 256             ///< max size of the data queued with a job
+
+typedef void (*dbJobFunc_t)(void *data);
+
+void G_DB_StartWorker(void);
+void G_DB_StopWorker(void);
+void G_DB_RunFrame(void);
+void G_DB_Flush(void);
+void G_DB_QueueJob(const char *name, dbJobFunc_t run, dbJobFunc_t done, const void *data, int size);
+void QDECL G_DB_Printf(const char *fmt, ...) _attribute((format(printf, 1, 2)));
+sqlite3_stmt *G_DB_Statement(const char *sql);
+void G_DB_ReleaseStatement(sqlite3_stmt *stmt);
+qboolean G_DB_IsSameClient(int clientNum, const char *guid);
+void G_DB_BeginBatch(const char *name);
+void G_DB_EndBatch(void);
+void G_DB_BeginPhase(const char *name);
+void G_DB_EndPhase(void);
+void G_DB_Stats_f(void);
 #endif
 
 #ifdef FEATURE_RATING
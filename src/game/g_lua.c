@@ -25,6 +25,48 @@ extern field_t fields[];
 
 lua_vm_t *lVM[LUA_NUM_VM];
 
+/**
+ * @struct luaHookList_t
+ * @brief The VMs defining a callback, in VM order, and the time spent in it
+ */
+typedef struct
+{
+	int numVMs;
+	lua_vm_t *vms[LUA_NUM_VM];
+	int calls;
+	int msec;
+} luaHookList_t;
+
+static luaHookList_t luaHooks[LUA_HOOK_MAX];
+
+static const char *luaHookNames[LUA_HOOK_MAX] =
+{
+	"et_InitGame",
+	"et_ShutdownGame",
+	"et_RunFrame",
+	"et_Quit",
+	"et_IPCReceive",
+	"et_ClientConnect",
+	"et_ClientDisconnect",
+	"et_ClientBegin",
+	"et_ClientUserinfoChanged",
+	"et_ClientSpawn",
+	"et_ClientCommand",
+	"et_ConsoleCommand",
+	"et_UpgradeSkill",
+	"et_SetPlayerSkill",
+	"et_Print",
+	"et_DPrint",
+	"et_Error",
+	"et_Obituary",
+	"et_Damage",
+	"et_WeaponFire",
+	"et_FixedMGFire",
+	"et_MountedMGFire",
+	"et_AAGunFire",
+	"et_SpawnEntitiesFromString",
+};
+
 /**
  * @param addr pointer to a gentity (gentity*)
  * @returns the entity number.
@@ -131,7 +173,7 @@ static int _et_IPCSend(lua_State *L)
 	}
 
 	// Find callback
-	if (!G_LuaGetNamedFunction(vm, "et_IPCReceive"))
+	if (!G_LuaGetHookFunction(vm, LUA_HOOK_IPCRECEIVE))
 	{
 		lua_pushinteger(L, 0);
 		return 1;
@@ -149,7 +191,7 @@ static int _et_IPCSend(lua_State *L)
 	lua_pushstring(vm->L, message);
 
 	// Call
-	if (!G_LuaCall(vm, "et.IPCSend", 2, 0))
+	if (!G_LuaCallHook(vm, LUA_HOOK_IPCRECEIVE, 2, 0))
 	{
 		//G_LuaStopVM(vm);
 		lua_pushinteger(L, 0);
@@ -1170,32 +1212,246 @@ static const gentity_field_t gentity_fields[] =
 	{ NULL },
 };
 
-// gentity fields helper functions
-static gentity_field_t *_et_gentity_getfield(gentity_t *ent, char *fieldname)
+// gentity fields lookup
+// Both field tables are put into a perfect hash the first time the Lua API is
+// started (hash and displace): the names are spread over LUA_FIELD_BUCKETS
+// buckets, then for each bucket, biggest first, a seed is searched that moves
+// all of its names into free slots. Looking up a field is two hashes and a
+// single string compare, whatever the number of fields.
+#define LUA_FIELD_SLOTS     512 ///< power of two, at least twice the number of field names
+#define LUA_FIELD_BUCKETS   128 ///< power of two
+#define LUA_FIELD_MAXSEED   0xffff
+#define LUA_FIELD_MAXNAMES  (ARRAY_LEN(gclient_fields) + ARRAY_LEN(gentity_fields))
+
+/**
+ * @struct luaFieldSlot_t
+ * @brief A field name and the client and entity fields of that name, either may be NULL
+ */
+typedef struct
 {
-	int i;
+	const char *name;
+	const gentity_field_t *client;
+	const gentity_field_t *entity;
+} luaFieldSlot_t;
+
+static luaFieldSlot_t luaFieldSlots[LUA_FIELD_SLOTS];
+static unsigned short luaFieldSeeds[LUA_FIELD_BUCKETS];
+static qboolean       luaFieldHashBuilt = qfalse;
+
+/**
+ * @brief Case insensitive FNV-1a with a final mix, so seeds give independent slots
+ * @param[in] name
+ * @param[in] seed
+ * @return
+ */
+static unsigned int _et_gentity_hashfield(const char *name, unsigned int seed)
+{
+	unsigned int hash = 2166136261u ^ (seed * 0x9e3779b9u);
+
+	for (; *name; name++)
+	{
+		hash ^= (unsigned char)tolower(*name);
+		hash *= 16777619u;
+	}
+
+	hash ^= hash >> 16;
+	hash *= 0x45d9f3bu;
+	hash ^= hash >> 16;
+
+	return hash;
+}
 
-	// search through client fields first
-	if (ent->client)
+/**
+ * @brief Adds the fields of one table to the list of unique field names
+ * @param[in] fields
+ * @param[in] client
+ * @param[in,out] names
+ * @param[in,out] numNames
+ */
+static void _et_gentity_addfieldnames(const gentity_field_t *fields, qboolean client, luaFieldSlot_t *names, int *numNames)
+{
+	int i, j;
+
+	for (i = 0; fields[i].name; i++)
 	{
-		for (i = 0; gclient_fields[i].name; i++)
+		for (j = 0; j < *numNames; j++)
 		{
-			if (Q_stricmp(fieldname, gclient_fields[i].name) == 0)
+			if (!Q_stricmp(fields[i].name, names[j].name))
 			{
-				return (gentity_field_t *)&gclient_fields[i];
+				break;
 			}
 		}
+
+		if (j == *numNames)
+		{
+			names[j].name   = fields[i].name;
+			names[j].client = NULL;
+			names[j].entity = NULL;
+			(*numNames)++;
+		}
+
+		// keep the first one of a table, as the linear search did
+		if (client && !names[j].client)
+		{
+			names[j].client = &fields[i];
+		}
+		else if (!client && !names[j].entity)
+		{
+			names[j].entity = &fields[i];
+		}
+	}
+}
+
+/**
+ * @brief Builds the perfect hash of the gclient and gentity field names
+ */
+static void _et_gentity_buildfieldhash(void)
+{
+	static luaFieldSlot_t names[LUA_FIELD_MAXNAMES];
+	static short          bucketNames[LUA_FIELD_MAXNAMES];
+	int                   bucketStart[LUA_FIELD_BUCKETS + 1], bucketFill[LUA_FIELD_BUCKETS], order[LUA_FIELD_BUCKETS];
+	int                   slots[LUA_FIELD_MAXNAMES];
+	int                   numNames = 0, i, j, b, seed, count, bucket, tmp;
+
+	if (luaFieldHashBuilt)
+	{
+		return;
+	}
+
+	_et_gentity_addfieldnames(gclient_fields, qtrue, names, &numNames);
+	_et_gentity_addfieldnames(gentity_fields, qfalse, names, &numNames);
+
+	if (numNames * 2 > LUA_FIELD_SLOTS)
+	{
+		G_Error("_et_gentity_buildfieldhash: %i field names, increase LUA_FIELD_SLOTS\n", numNames);
+	}
+
+	// sort the names into buckets
+	Com_Memset(bucketFill, 0, sizeof(bucketFill));
+	for (i = 0; i < numNames; i++)
+	{
+		bucketFill[(_et_gentity_hashfield(names[i].name, 0) >> 16) & (LUA_FIELD_BUCKETS - 1)]++;
+	}
+
+	bucketStart[0] = 0;
+	for (b = 0; b < LUA_FIELD_BUCKETS; b++)
+	{
+		bucketStart[b + 1] = bucketStart[b] + bucketFill[b];
+		bucketFill[b]      = 0;
+		order[b]           = b;
+	}
+
+	for (i = 0; i < numNames; i++)
+	{
+		b = (_et_gentity_hashfield(names[i].name, 0) >> 16) & (LUA_FIELD_BUCKETS - 1);
+		bucketNames[bucketStart[b] + bucketFill[b]++] = i;
 	}
 
-	for (i = 0; gentity_fields[i].name; i++)
+	// place the biggest buckets first, while there is most room
+	for (i = 1; i < LUA_FIELD_BUCKETS; i++)
 	{
-		if (Q_stricmp(fieldname, gentity_fields[i].name) == 0)
+		tmp = order[i];
+		for (j = i; j > 0 && bucketFill[order[j - 1]] < bucketFill[tmp]; j--)
 		{
-			return (gentity_field_t *)&gentity_fields[i];
+			order[j] = order[j - 1];
 		}
+		order[j] = tmp;
 	}
 
-	return 0;
+	Com_Memset(luaFieldSlots, 0, sizeof(luaFieldSlots));
+	Com_Memset(luaFieldSeeds, 0, sizeof(luaFieldSeeds));
+
+	for (b = 0; b < LUA_FIELD_BUCKETS; b++)
+	{
+		bucket = order[b];
+		count  = bucketFill[bucket];
+
+		if (!count)
+		{
+			break;
+		}
+
+		for (seed = 1; seed <= LUA_FIELD_MAXSEED; seed++)
+		{
+			for (i = 0; i < count; i++)
+			{
+				slots[i] = _et_gentity_hashfield(names[bucketNames[bucketStart[bucket] + i]].name, seed) & (LUA_FIELD_SLOTS - 1);
+
+				if (luaFieldSlots[slots[i]].name)
+				{
+					break;
+				}
+
+				for (j = 0; j < i && slots[j] != slots[i]; j++)
+					;
+
+				if (j < i)
+				{
+					break;
+				}
+			}
+
+			if (i == count)
+			{
+				break;
+			}
+		}
+
+		if (seed > LUA_FIELD_MAXSEED)
+		{
+			G_Error("_et_gentity_buildfieldhash: no seed found for %i field names, increase LUA_FIELD_SLOTS\n", count);
+		}
+
+		luaFieldSeeds[bucket] = (unsigned short)seed;
+		for (i = 0; i < count; i++)
+		{
+			luaFieldSlots[slots[i]] = names[bucketNames[bucketStart[bucket] + i]];
+		}
+	}
+
+	luaFieldHashBuilt = qtrue;
+}
+
+/**
+ * @brief Looks up a gentity field by name
+ * @param[in] fieldname
+ * @param[in] client Client fields take precedence over entity fields of the same name
+ * @return The field, NULL if there is none
+ */
+static const gentity_field_t *_et_gentity_findfield(const char *fieldname, qboolean client)
+{
+	const luaFieldSlot_t *slot;
+	unsigned int         seed;
+
+	if (!luaFieldHashBuilt)
+	{
+		_et_gentity_buildfieldhash();
+	}
+
+	seed = luaFieldSeeds[(_et_gentity_hashfield(fieldname, 0) >> 16) & (LUA_FIELD_BUCKETS - 1)];
+	if (!seed)
+	{
+		return NULL;
+	}
+
+	slot = &luaFieldSlots[_et_gentity_hashfield(fieldname, seed) & (LUA_FIELD_SLOTS - 1)];
+	if (!slot->name || Q_stricmp(fieldname, slot->name))
+	{
+		return NULL;
+	}
+
+	if (client && slot->client)
+	{
+		return slot->client;
+	}
+
+	return slot->entity;
+}
+
+// gentity fields helper functions
+static const gentity_field_t *_et_gentity_getfield(gentity_t *ent, const char *fieldname)
+{
+	return _et_gentity_findfield(fieldname, ent->client != NULL);
 }
 
 static void _et_gentity_getvec3(lua_State *L, vec3_t vec3)
@@ -1621,20 +1877,10 @@ static int _et_G_SetSpawnVar(lua_State *L)
 	return 0;
 }
 
-// variable = et.gentity_get( entnum, fieldname, arrayindex )
-static int _et_gentity_get(lua_State *L)
+// pushes the value of a gentity field, nil for NULL entities (prevents server crashes!)
+static void _et_gentity_pushfield(lua_State *L, gentity_t *ent, const gentity_field_t *field, int arrayindex)
 {
-	gentity_t       *ent       = g_entities + (int)luaL_checkinteger(L, 1);
-	const char      *fieldname = luaL_checkstring(L, 2);
-	gentity_field_t *field     = _et_gentity_getfield(ent, (char *)fieldname);
-	unsigned long   addr;
-
-	// break on invalid gentity field
-	if (!field)
-	{
-		luaL_error(L, "tried to get invalid gentity field \"%s\"", fieldname);
-		return 0;
-	}
+	unsigned long addr;
 
 	if (field->flags & FIELD_FLAG_GENTITY)
 	{
@@ -1645,11 +1891,10 @@ static int _et_gentity_get(lua_State *L)
 		addr = (unsigned long)ent->client;
 	}
 
-	// for NULL entities, return nil (prevents server crashes!)
 	if (!addr)
 	{
 		lua_pushnil(L);
-		return 1;
+		return;
 	}
 
 	addr += field->mapping;
@@ -1658,7 +1903,7 @@ static int _et_gentity_get(lua_State *L)
 	{
 	case FIELD_INT:
 		lua_pushinteger(L, *(int *)addr);
-		return 1;
+		return;
 	case FIELD_STRING:
 		if (field->flags & FIELD_FLAG_NOPTR)
 		{
@@ -1668,10 +1913,10 @@ static int _et_gentity_get(lua_State *L)
 		{
 			lua_pushstring(L, *(char **)addr);
 		}
-		return 1;
+		return;
 	case FIELD_FLOAT:
 		lua_pushnumber(L, *(float *)addr);
-		return 1;
+		return;
 	case FIELD_ENTITY:
 	{
 		// core: return the entity-number  of the entity that the pointer is pointing at.
@@ -1686,35 +1931,132 @@ static int _et_gentity_get(lua_State *L)
 			lua_pushinteger(L, entNum);
 		}
 	}
-		return 1;
+		return;
 	case FIELD_VEC3:
 		_et_gentity_getvec3(L, *(vec3_t *)addr);
-		return 1;
+		return;
 	case FIELD_INT_ARRAY:
-		lua_pushinteger(L, (*(int *)(addr + (sizeof(int) * (int)luaL_optinteger(L, 3, 0)))));
-		return 1;
+		lua_pushinteger(L, (*(int *)(addr + (sizeof(int) * arrayindex))));
+		return;
 	case FIELD_TRAJECTORY:
 		_et_gentity_gettrajectory(L, (trajectory_t *)addr);
-		return 1;
+		return;
 	case FIELD_FLOAT_ARRAY:
-		lua_pushnumber(L, (*(float *)(addr + (sizeof(int) * (int)luaL_optinteger(L, 3, 0)))));
-		return 1;
+		lua_pushnumber(L, (*(float *)(addr + (sizeof(int) * arrayindex))));
+		return;
 	case FIELD_WEAPONSTAT:
-		_et_gentity_getweaponstat(L, (weapon_stat_t *)(addr + (sizeof(weapon_stat_t) * (int)luaL_optinteger(L, 3, 0))));
-		return 1;
+		_et_gentity_getweaponstat(L, (weapon_stat_t *)(addr + (sizeof(weapon_stat_t) * arrayindex)));
+		return;
+	default:
+		lua_pushnil(L);
+		return;
+	}
+}
+
+#define _et_gentity_isarray(field) ((field)->type == FIELD_INT_ARRAY || (field)->type == FIELD_FLOAT_ARRAY || (field)->type == FIELD_WEAPONSTAT)
+
+// variable = et.gentity_get( entnum, fieldname, arrayindex )
+static int _et_gentity_get(lua_State *L)
+{
+	gentity_t             *ent       = g_entities + (int)luaL_checkinteger(L, 1);
+	const char            *fieldname = luaL_checkstring(L, 2);
+	const gentity_field_t *field     = _et_gentity_getfield(ent, fieldname);
 
+	// break on invalid gentity field
+	if (!field)
+	{
+		luaL_error(L, "tried to get invalid gentity field \"%s\"", fieldname);
+		return 0;
 	}
-	return 0;
+
+	_et_gentity_pushfield(L, ent, field, _et_gentity_isarray(field) ? (int)luaL_optinteger(L, 3, 0) : 0);
+	return 1;
+}
+
+// variable1, variable2, ... = et.gentity_getfields( entnum, fieldname1 [, arrayindex1], fieldname2 [, arrayindex2], ... )
+static int _et_gentity_getfields(lua_State *L)
+{
+	gentity_t             *ent = g_entities + (int)luaL_checkinteger(L, 1);
+	const gentity_field_t *field;
+	const char            *fieldname;
+	int                   top = lua_gettop(L), arg, arrayindex, count = 0;
+
+	luaL_checkstack(L, top, "too many gentity fields");
+
+	for (arg = 2; arg <= top; arg++)
+	{
+		if (lua_type(L, arg) != LUA_TSTRING)
+		{
+			return luaL_argerror(L, arg, "gentity field name expected");
+		}
+
+		fieldname = lua_tostring(L, arg);
+		field     = _et_gentity_getfield(ent, fieldname);
+
+		// break on invalid gentity field
+		if (!field)
+		{
+			luaL_error(L, "tried to get invalid gentity field \"%s\"", fieldname);
+			return 0;
+		}
+
+		// an array index may follow the name
+		arrayindex = 0;
+		if (arg < top && lua_type(L, arg + 1) == LUA_TNUMBER)
+		{
+			arrayindex = (int)lua_tointeger(L, ++arg);
+		}
+
+		_et_gentity_pushfield(L, ent, field, arrayindex);
+		count++;
+	}
+
+	return count;
+}
+
+// values = et.gentity_getclients( fieldname, arrayindex )
+// values is indexed by client number and holds the connected clients only
+static int _et_gentity_getclients(lua_State *L)
+{
+	const char            *fieldname = luaL_checkstring(L, 1);
+	const gentity_field_t *field     = _et_gentity_findfield(fieldname, qtrue);
+	int                   arrayindex, i;
+	gentity_t             *ent;
+
+	// break on invalid gentity field
+	if (!field)
+	{
+		luaL_error(L, "tried to get invalid gentity field \"%s\"", fieldname);
+		return 0;
+	}
+
+	arrayindex = _et_gentity_isarray(field) ? (int)luaL_optinteger(L, 2, 0) : 0;
+
+	lua_createtable(L, 0, level.numConnectedClients);
+	for (i = 0; i < level.maxclients; i++)
+	{
+		ent = g_entities + i;
+
+		if (!ent->client || ent->client->pers.connected == CON_DISCONNECTED)
+		{
+			continue;
+		}
+
+		_et_gentity_pushfield(L, ent, field, arrayindex);
+		lua_rawseti(L, -2, i);
+	}
+
+	return 1;
 }
 
 // et.gentity_set( entnum, fieldname, arrayindex, value )
 static int _et_gentity_set(lua_State *L)
 {
-	gentity_t       *ent       = g_entities + (int)luaL_checkinteger(L, 1);
-	const char      *fieldname = luaL_checkstring(L, 2);
-	gentity_field_t *field     = _et_gentity_getfield(ent, (char *)fieldname);
-	unsigned long   addr;
-	const char      *buffer;
+	gentity_t             *ent       = g_entities + (int)luaL_checkinteger(L, 1);
+	const char            *fieldname = luaL_checkstring(L, 2);
+	const gentity_field_t *field     = _et_gentity_getfield(ent, fieldname);
+	unsigned long         addr;
+	const char            *buffer;
 
 	// break on invalid gentity field
 	if (!field)
@@ -1752,6 +2094,11 @@ static int _et_gentity_set(lua_State *L)
 	{
 	case FIELD_INT:
 		*(int *)addr = (int)luaL_checkinteger(L, 3);
+		if (field->flags & FIELD_FLAG_GENTITY)
+		{
+			// eType or methodOfDeath may have changed
+			G_UpdateEntityCategory(ent);
+		}
 		break;
 	case FIELD_STRING:
 		buffer = luaL_checkstring(L, 3);
@@ -1765,6 +2112,11 @@ static int _et_gentity_set(lua_State *L)
 			*(char **)addr = Com_Allocate(strlen(buffer) + 1);
 			Q_strncpyz(*(char **)addr, buffer, strlen(buffer));
 		}
+		if (field->flags & FIELD_FLAG_GENTITY)
+		{
+			// classname may have changed
+			G_TouchEntityIndex(ent);
+		}
 		break;
 	case FIELD_FLOAT:
 		*(float *)addr = (float)luaL_checknumber(L, 3);
@@ -2066,6 +2418,8 @@ static const luaL_Reg etlib[] =
 	{ "G_SetSpawnVar",           _et_G_SetSpawnVar           },
 	{ "gentity_get",             _et_gentity_get             },
 	{ "gentity_set",             _et_gentity_set             },
+	{ "gentity_getfields",       _et_gentity_getfields       },
+	{ "gentity_getclients",      _et_gentity_getclients      },
 	{ "G_AddEvent",              _et_G_AddEvent              },
 	// Shaders
 	{ "G_ShaderRemap",           _et_G_ShaderRemap           },
@@ -2082,57 +2436,152 @@ static const luaL_Reg etlib[] =
 /*************/
 
 /*
- * G_LuaRunIsolated(modName)
- * Creates and runs specified module in isolated state
+ * G_LuaResolveHooks( vm )
+ * Looks up the callbacks a module defines and keeps registry references
+ * to them, so calling them doesn't need a lookup by name.
  */
-qboolean G_LuaRunIsolated(const char *modName)
+static void G_LuaResolveHooks(lua_vm_t *vm)
 {
-	int          freeVM, flen = 0;
-	static char  allowedModules[MAX_CVAR_VALUE_STRING];
-	char         *code, *signature;
-	fileHandle_t f;
-	lua_vm_t     *vm;
+	int i;
 
-	for (freeVM = 0; freeVM < LUA_NUM_VM; freeVM++)
+	for (i = 0; i < LUA_HOOK_MAX; i++)
 	{
-		if (lVM[freeVM] == NULL)
+		if (vm->hookRef[i] != LUA_NOREF)
 		{
-			break;
+			luaL_unref(vm->L, LUA_REGISTRYINDEX, vm->hookRef[i]);
+			vm->hookRef[i] = LUA_NOREF;
 		}
-	}
 
-	if (freeVM == LUA_NUM_VM)
-	{
-		G_Printf("%s API: %sno free VMs left to load module: \"%s\" \n", LUA_VERSION, S_COLOR_BLUE, modName);
-		return qfalse;
+		lua_getglobal(vm->L, luaHookNames[i]);
+		if (lua_isfunction(vm->L, -1))
+		{
+			vm->hookRef[i] = luaL_ref(vm->L, LUA_REGISTRYINDEX);
+		}
+		else
+		{
+			lua_pop(vm->L, 1);
+		}
 	}
+}
 
-	Q_strncpyz(allowedModules, Q_strupr(lua_allowedModules.string), sizeof(allowedModules));
+/*
+ * G_LuaUpdateHooks()
+ * Rebuilds the lists of modules defining each callback, must be called
+ * whenever lVM[] or the hook references of a module change.
+ */
+static void G_LuaUpdateHooks(void)
+{
+	int      i, hook;
+	lua_vm_t *vm;
 
-	// try to open lua file
-	flen = trap_FS_FOpenFile(modName, &f, FS_READ);
-	if (flen < 0)
-	{
-		G_Printf("%s API: %scan not open file '%s'\n", LUA_VERSION, S_COLOR_BLUE, modName);
-	}
-	else if (flen > LUA_MAX_FSIZE)
+	for (hook = 0; hook < LUA_HOOK_MAX; hook++)
 	{
-		// Let's not load arbitrarily big files to memory.
-		// If your lua file exceeds the limit, let me know.
-		G_Printf("%s API: %signoring file '%s' (too big)\n", LUA_VERSION, S_COLOR_BLUE, modName);
-		trap_FS_FCloseFile(f);
+		luaHooks[hook].numVMs = 0;
 	}
-	else
-	{
-		code = Com_Allocate(flen + 1);
 
-		if (code == NULL)
+	for (i = 0; i < LUA_NUM_VM; i++)
+	{
+		vm = lVM[i];
+		if (!vm || vm->id < 0)
 		{
-			G_Error("%s API: %smemory allocation error for '%s' data\n", LUA_VERSION, S_COLOR_BLUE, modName);
+			continue;
 		}
 
-		trap_FS_Read(code, flen, f);
-		*(code + flen) = '\0';
+		for (hook = 0; hook < LUA_HOOK_MAX; hook++)
+		{
+			if (vm->hookRef[hook] != LUA_NOREF)
+			{
+				luaHooks[hook].vms[luaHooks[hook].numVMs++] = vm;
+			}
+		}
+	}
+}
+
+/*
+ * G_LuaGetHookFunction( vm, hook )
+ * Puts a callback of the module onto the stack.
+ * If the module doesn't define it, returns qfalse.
+ */
+qboolean G_LuaGetHookFunction(lua_vm_t *vm, luaHook_t hook)
+{
+	if (!vm->L || vm->hookRef[hook] == LUA_NOREF)
+	{
+		return qfalse;
+	}
+
+	lua_rawgeti(vm->L, LUA_REGISTRYINDEX, vm->hookRef[hook]);
+	return qtrue;
+}
+
+/*
+ * G_LuaCallHook( vm, hook, nargs, nresults )
+ * Calls a callback put onto the stack by G_LuaGetHookFunction() and
+ * accounts the call for lua_status.
+ */
+qboolean G_LuaCallHook(lua_vm_t *vm, luaHook_t hook, int nargs, int nresults)
+{
+	// millisecond ticks falling into a call add up to the time spent on average
+	int      msec = trap_Milliseconds();
+	qboolean ret  = G_LuaCall(vm, luaHookNames[hook], nargs, nresults);
+
+	luaHooks[hook].calls++;
+	luaHooks[hook].msec += trap_Milliseconds() - msec;
+
+	return ret;
+}
+
+/*
+ * G_LuaRunIsolated(modName)
+ * Creates and runs specified module in isolated state
+ */
+qboolean G_LuaRunIsolated(const char *modName)
+{
+	int          freeVM, flen = 0;
+	static char  allowedModules[MAX_CVAR_VALUE_STRING];
+	char         *code, *signature;
+	fileHandle_t f;
+	lua_vm_t     *vm;
+
+	for (freeVM = 0; freeVM < LUA_NUM_VM; freeVM++)
+	{
+		if (lVM[freeVM] == NULL)
+		{
+			break;
+		}
+	}
+
+	if (freeVM == LUA_NUM_VM)
+	{
+		G_Printf("%s API: %sno free VMs left to load module: \"%s\" \n", LUA_VERSION, S_COLOR_BLUE, modName);
+		return qfalse;
+	}
+
+	Q_strncpyz(allowedModules, Q_strupr(lua_allowedModules.string), sizeof(allowedModules));
+
+	// try to open lua file
+	flen = trap_FS_FOpenFile(modName, &f, FS_READ);
+	if (flen < 0)
+	{
+		G_Printf("%s API: %scan not open file '%s'\n", LUA_VERSION, S_COLOR_BLUE, modName);
+	}
+	else if (flen > LUA_MAX_FSIZE)
+	{
+		// Let's not load arbitrarily big files to memory.
+		// If your lua file exceeds the limit, let me know.
+		G_Printf("%s API: %signoring file '%s' (too big)\n", LUA_VERSION, S_COLOR_BLUE, modName);
+		trap_FS_FCloseFile(f);
+	}
+	else
+	{
+		code = Com_Allocate(flen + 1);
+
+		if (code == NULL)
+		{
+			G_Error("%s API: %smemory allocation error for '%s' data\n", LUA_VERSION, S_COLOR_BLUE, modName);
+		}
+
+		trap_FS_Read(code, flen, f);
+		*(code + flen) = '\0';
 		trap_FS_FCloseFile(f);
 		signature = G_SHA1(code);
 
@@ -2165,6 +2614,7 @@ qboolean G_LuaRunIsolated(const char *modName)
 			{
 				vm->id      = freeVM;
 				lVM[freeVM] = vm;
+				G_LuaUpdateHooks();
 				return qtrue;
 			}
 			else
@@ -2191,6 +2641,10 @@ qboolean G_LuaInit(void)
 		lVM[i] = NULL;
 	}
 
+	Com_Memset(luaHooks, 0, sizeof(luaHooks));
+
+	_et_gentity_buildfieldhash();
+
 	if (lua_modules.string[0])
 	{
 		Q_strncpyz(buff, lua_modules.string, sizeof(buff));
@@ -2789,6 +3243,11 @@ qboolean G_LuaStartVM(lua_vm_t *vm)
 	char       gamepath[MAX_OSPATH];
 	const char *luaPath, *luaCPath;
 
+	for (res = 0; res < LUA_HOOK_MAX; res++)
+	{
+		vm->hookRef[res] = LUA_NOREF;
+	}
+
 	// Open a new lua state
 	vm->L = luaL_newstate();
 	if (!vm->L)
@@ -2888,6 +3347,8 @@ qboolean G_LuaStartVM(lua_vm_t *vm)
 	// Load the code
 	G_Printf("%s API: %sfile '%s' loaded into Lua VM\n", LUA_VERSION, S_COLOR_BLUE, vm->file_name);
 
+	G_LuaResolveHooks(vm);
+
 	return qtrue;
 }
 
@@ -2908,9 +3369,9 @@ void G_LuaStopVM(lua_vm_t *vm)
 	}
 	if (vm->L)
 	{
-		if (G_LuaGetNamedFunction(vm, "et_Quit"))
+		if (G_LuaGetHookFunction(vm, LUA_HOOK_QUIT))
 		{
-			G_LuaCall(vm, "et_Quit", 0, 0);
+			G_LuaCallHook(vm, LUA_HOOK_QUIT, 0, 0);
 		}
 		lua_close(vm->L);
 		vm->L = NULL;
@@ -2920,6 +3381,7 @@ void G_LuaStopVM(lua_vm_t *vm)
 		if (lVM[vm->id] == vm)
 		{
 			lVM[vm->id] = NULL;
+			G_LuaUpdateHooks();
 		}
 		if (!vm->err)
 		{
@@ -2997,6 +3459,18 @@ void G_LuaStatus(gentity_t *ent)
 		}
 	}
 	G_refPrintf(ent, "-- ------------------------ ---------------------------------------- ------------------------");
+
+	G_refPrintf(ent, "%-26s %3s %10s %10s %9s", "Callback", "VMs", "Calls", "Time (ms)", "Avg (ms)");
+	G_refPrintf(ent, "-------------------------- --- ---------- ---------- ---------");
+	for (i = 0; i < LUA_HOOK_MAX; i++)
+	{
+		if (luaHooks[i].numVMs || luaHooks[i].calls)
+		{
+			G_refPrintf(ent, "%-26s %3d %10d %10d %9.3f", luaHookNames[i], luaHooks[i].numVMs, luaHooks[i].calls, luaHooks[i].msec,
+			            luaHooks[i].calls ? luaHooks[i].msec / (float)luaHooks[i].calls : 0.f);
+		}
+	}
+	G_refPrintf(ent, "-------------------------- --- ---------- ---------- ---------");
 }
 
 /*
@@ -3033,31 +3507,32 @@ void G_LuaHook_InitGame(int levelTime, int randomSeed, int restart)
 	int      i;
 	lua_vm_t *vm;
 
+	for (i = 0; i < luaHooks[LUA_HOOK_INITGAME].numVMs; i++)
+	{
+		vm = luaHooks[LUA_HOOK_INITGAME].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_INITGAME);
+		// Arguments
+		lua_pushinteger(vm->L, levelTime);
+		lua_pushinteger(vm->L, randomSeed);
+		lua_pushinteger(vm->L, restart);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_INITGAME, 3, 0))
+		{
+			//G_LuaStopVM(vm);
+			continue;
+		}
+	}
+
+	// et_InitGame might have defined further callbacks
 	for (i = 0; i < LUA_NUM_VM; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		if (lVM[i])
 		{
-			if (vm->id < 0) //|| vm->err)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_InitGame"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, levelTime);
-			lua_pushinteger(vm->L, randomSeed);
-			lua_pushinteger(vm->L, restart);
-			// Call
-			if (!G_LuaCall(vm, "et_InitGame", 3, 0))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
+			G_LuaResolveHooks(lVM[i]);
 		}
 	}
+	G_LuaUpdateHooks();
 }
 
 /*
@@ -3069,27 +3544,18 @@ void G_LuaHook_ShutdownGame(int restart)
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_SHUTDOWNGAME].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_SHUTDOWNGAME].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_SHUTDOWNGAME);
+		// Arguments
+		lua_pushinteger(vm->L, restart);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_SHUTDOWNGAME, 1, 0))
 		{
-			if (vm->id < 0) //|| vm->err)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_ShutdownGame"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, restart);
-			// Call
-			if (!G_LuaCall(vm, "et_ShutdownGame", 1, 0))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
+			//G_LuaStopVM(vm);
+			continue;
 		}
 	}
 }
@@ -3103,27 +3569,18 @@ void G_LuaHook_RunFrame(int levelTime)
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_RUNFRAME].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_RUNFRAME].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_RUNFRAME);
+		// Arguments
+		lua_pushinteger(vm->L, levelTime);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_RUNFRAME, 1, 0))
 		{
-			if (vm->id < 0) //|| vm->err)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_RunFrame"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, levelTime);
-			// Call
-			if (!G_LuaCall(vm, "et_RunFrame", 1, 0))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
+			//G_LuaStopVM(vm);
+			continue;
 		}
 	}
 }
@@ -3137,38 +3594,29 @@ qboolean G_LuaHook_ClientConnect(int clientNum, qboolean firstTime, qboolean isB
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_CLIENTCONNECT].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_CLIENTCONNECT].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_CLIENTCONNECT);
+		// Arguments
+		lua_pushinteger(vm->L, clientNum);
+		lua_pushinteger(vm->L, (int)firstTime);
+		lua_pushinteger(vm->L, (int)isBot);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_CLIENTCONNECT, 3, 1))
 		{
-			if (vm->id < 0) //|| vm->err)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_ClientConnect"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, clientNum);
-			lua_pushinteger(vm->L, (int)firstTime);
-			lua_pushinteger(vm->L, (int)isBot);
-			// Call
-			if (!G_LuaCall(vm, "et_ClientConnect", 3, 1))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
-			// Return values
-			if (lua_isstring(vm->L, -1))
-			{
-				Q_strncpyz(reason, lua_tostring(vm->L, -1), MAX_STRING_CHARS);
-				lua_pop(vm->L, 1);
-				return qtrue;
-			}
+			//G_LuaStopVM(vm);
+			continue;
+		}
+		// Return values
+		if (lua_isstring(vm->L, -1))
+		{
+			Q_strncpyz(reason, lua_tostring(vm->L, -1), MAX_STRING_CHARS);
 			lua_pop(vm->L, 1);
+			return qtrue;
 		}
+		lua_pop(vm->L, 1);
 	}
 	return qfalse;
 }
@@ -3182,27 +3630,18 @@ void G_LuaHook_ClientDisconnect(int clientNum)
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_CLIENTDISCONNECT].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_CLIENTDISCONNECT].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_CLIENTDISCONNECT);
+		// Arguments
+		lua_pushinteger(vm->L, clientNum);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_CLIENTDISCONNECT, 1, 0))
 		{
-			if (vm->id < 0) //|| vm->err)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_ClientDisconnect"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, clientNum);
-			// Call
-			if (!G_LuaCall(vm, "et_ClientDisconnect", 1, 0))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
+			//G_LuaStopVM(vm);
+			continue;
 		}
 	}
 }
@@ -3216,27 +3655,18 @@ void G_LuaHook_ClientBegin(int clientNum)
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_CLIENTBEGIN].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_CLIENTBEGIN].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_CLIENTBEGIN);
+		// Arguments
+		lua_pushinteger(vm->L, clientNum);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_CLIENTBEGIN, 1, 0))
 		{
-			if (vm->id < 0) //|| vm->err)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_ClientBegin"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, clientNum);
-			// Call
-			if (!G_LuaCall(vm, "et_ClientBegin", 1, 0))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
+			//G_LuaStopVM(vm);
+			continue;
 		}
 	}
 }
@@ -3250,27 +3680,18 @@ void G_LuaHook_ClientUserinfoChanged(int clientNum)
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_CLIENTUSERINFOCHANGED].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_CLIENTUSERINFOCHANGED].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_CLIENTUSERINFOCHANGED);
+		// Arguments
+		lua_pushinteger(vm->L, clientNum);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_CLIENTUSERINFOCHANGED, 1, 0))
 		{
-			if (vm->id < 0) //|| vm->err)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_ClientUserinfoChanged"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, clientNum);
-			// Call
-			if (!G_LuaCall(vm, "et_ClientUserinfoChanged", 1, 0))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
+			//G_LuaStopVM(vm);
+			continue;
 		}
 	}
 }
@@ -3284,30 +3705,21 @@ void G_LuaHook_ClientSpawn(int clientNum, qboolean revived, qboolean teamChange,
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_CLIENTSPAWN].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_CLIENTSPAWN].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_CLIENTSPAWN);
+		// Arguments
+		lua_pushinteger(vm->L, clientNum);
+		lua_pushinteger(vm->L, (int)revived);
+		lua_pushinteger(vm->L, (int)teamChange);
+		lua_pushinteger(vm->L, (int)restoreHealth);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_CLIENTSPAWN, 4, 0))
 		{
-			if (vm->id < 0) //|| vm->err)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_ClientSpawn"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, clientNum);
-			lua_pushinteger(vm->L, (int)revived);
-			lua_pushinteger(vm->L, (int)teamChange);
-			lua_pushinteger(vm->L, (int)restoreHealth);
-			// Call
-			if (!G_LuaCall(vm, "et_ClientSpawn", 4, 0))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
+			//G_LuaStopVM(vm);
+			continue;
 		}
 	}
 }
@@ -3321,39 +3733,30 @@ qboolean G_LuaHook_ClientCommand(int clientNum, char *command)
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_CLIENTCOMMAND].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_CLIENTCOMMAND].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_CLIENTCOMMAND);
+		// Arguments
+		lua_pushinteger(vm->L, clientNum);
+		lua_pushstring(vm->L, command);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_CLIENTCOMMAND, 2, 1))
 		{
-			if (vm->id < 0) //|| vm->err)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_ClientCommand"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, clientNum);
-			lua_pushstring(vm->L, command);
-			// Call
-			if (!G_LuaCall(vm, "et_ClientCommand", 2, 1))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
-			// Return values
-			if (lua_isnumber(vm->L, -1))
+			//G_LuaStopVM(vm);
+			continue;
+		}
+		// Return values
+		if (lua_isnumber(vm->L, -1))
+		{
+			if (lua_tointeger(vm->L, -1) == 1)
 			{
-				if (lua_tointeger(vm->L, -1) == 1)
-				{
-					lua_pop(vm->L, 1);
-					return qtrue;
-				}
+				lua_pop(vm->L, 1);
+				return qtrue;
 			}
-			lua_pop(vm->L, 1);
 		}
+		lua_pop(vm->L, 1);
 	}
 	return qfalse;
 }
@@ -3367,38 +3770,29 @@ qboolean G_LuaHook_ConsoleCommand(char *command)
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_CONSOLECOMMAND].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_CONSOLECOMMAND].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_CONSOLECOMMAND);
+		// Arguments
+		lua_pushstring(vm->L, command);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_CONSOLECOMMAND, 1, 1))
 		{
-			if (vm->id < 0) //|| vm->err)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_ConsoleCommand"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushstring(vm->L, command);
-			// Call
-			if (!G_LuaCall(vm, "et_ConsoleCommand", 1, 1))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
-			// Return values
-			if (lua_isnumber(vm->L, -1))
+			//G_LuaStopVM(vm);
+			continue;
+		}
+		// Return values
+		if (lua_isnumber(vm->L, -1))
+		{
+			if (lua_tointeger(vm->L, -1) == 1)
 			{
-				if (lua_tointeger(vm->L, -1) == 1)
-				{
-					lua_pop(vm->L, 1);
-					return qtrue;
-				}
+				lua_pop(vm->L, 1);
+				return qtrue;
 			}
-			lua_pop(vm->L, 1);
 		}
+		lua_pop(vm->L, 1);
 	}
 	return qfalse;
 }
@@ -3412,39 +3806,30 @@ qboolean G_LuaHook_UpgradeSkill(int cno, skillType_t skill)
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_UPGRADESKILL].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_UPGRADESKILL].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_UPGRADESKILL);
+		// Arguments
+		lua_pushinteger(vm->L, cno);
+		lua_pushinteger(vm->L, (int)skill);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_UPGRADESKILL, 2, 1))
 		{
-			if (vm->id < 0) //|| vm->err)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_UpgradeSkill"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, cno);
-			lua_pushinteger(vm->L, (int)skill);
-			// Call
-			if (!G_LuaCall(vm, "et_UpgradeSkill", 2, 1))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
-			// Return values
-			if (lua_isnumber(vm->L, -1))
+			//G_LuaStopVM(vm);
+			continue;
+		}
+		// Return values
+		if (lua_isnumber(vm->L, -1))
+		{
+			if (lua_tointeger(vm->L, -1) == -1)
 			{
-				if (lua_tointeger(vm->L, -1) == -1)
-				{
-					lua_pop(vm->L, 1);
-					return qtrue;
-				}
+				lua_pop(vm->L, 1);
+				return qtrue;
 			}
-			lua_pop(vm->L, 1);
 		}
+		lua_pop(vm->L, 1);
 	}
 	return qfalse;
 }
@@ -3458,48 +3843,39 @@ qboolean G_LuaHook_SetPlayerSkill(int cno, skillType_t skill)
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_SETPLAYERSKILL].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_SETPLAYERSKILL].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_SETPLAYERSKILL);
+		// Arguments
+		lua_pushinteger(vm->L, cno);
+		lua_pushinteger(vm->L, (int)skill);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_SETPLAYERSKILL, 2, 1))
 		{
-			if (vm->id < 0) //|| vm->err)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_SetPlayerSkill"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, cno);
-			lua_pushinteger(vm->L, (int)skill);
-			// Call
-			if (!G_LuaCall(vm, "et_SetPlayerSkill", 2, 1))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
-			// Return values
-			if (lua_isnumber(vm->L, -1))
+			//G_LuaStopVM(vm);
+			continue;
+		}
+		// Return values
+		if (lua_isnumber(vm->L, -1))
+		{
+			if (lua_tointeger(vm->L, -1) == -1)
 			{
-				if (lua_tointeger(vm->L, -1) == -1)
-				{
-					lua_pop(vm->L, 1);
-					return qtrue;
-				}
+				lua_pop(vm->L, 1);
+				return qtrue;
 			}
-			lua_pop(vm->L, 1);
 		}
+		lua_pop(vm->L, 1);
 	}
 	return qfalse;
 }
 
 static luaPrintFunctions_t g_luaPrintFunctions[] =
 {
-	{ GPRINT_TEXT,      "et_Print"  },
-	{ GPRINT_DEVELOPER, "et_DPrint" },
-	{ GPRINT_ERROR,     "et_Error"  }
+	{ GPRINT_TEXT,      "et_Print",  LUA_HOOK_PRINT  },
+	{ GPRINT_DEVELOPER, "et_DPrint", LUA_HOOK_DPRINT },
+	{ GPRINT_ERROR,     "et_Error",  LUA_HOOK_ERROR  }
 };
 
 /*
@@ -3508,32 +3884,24 @@ static luaPrintFunctions_t g_luaPrintFunctions[] =
  */
 void G_LuaHook_Print(printMessageType_t category, char *text)
 {
-	int      i;
-	lua_vm_t *vm;
+	int       i;
+	lua_vm_t  *vm;
+	luaHook_t hook = g_luaPrintFunctions[category].hook;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[hook].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[hook].vms[i];
+
+		G_LuaGetHookFunction(vm, hook);
+		// Arguments
+		lua_pushstring(vm->L, text);
+		// Call
+		if (!G_LuaCallHook(vm, hook, 1, 0))
 		{
-			if (vm->id < 0) //|| vm->err)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, g_luaPrintFunctions[category].function))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushstring(vm->L, text);
-			// Call
-			if (!G_LuaCall(vm, g_luaPrintFunctions[category].function, 1, 0))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
-			// Return values
+			//G_LuaStopVM(vm);
+			continue;
 		}
+		// Return values
 	}
 }
 
@@ -3550,38 +3918,29 @@ qboolean G_LuaHook_Obituary(int victim, int killer, int meansOfDeath)
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_OBITUARY].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
-		{
-			if (vm->id < 0 /*|| vm->err*/)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_Obituary"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, victim);
-			lua_pushinteger(vm->L, killer);
-			lua_pushinteger(vm->L, meansOfDeath);
+		vm = luaHooks[LUA_HOOK_OBITUARY].vms[i];
 
-			// Call
-			if (!G_LuaCall(vm, "et_Obituary", 3, 1))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
-			// Return values
-			if (lua_isstring(vm->L, -1))
-			{
-				lua_pop(vm->L, 1);
-				return qtrue;
-			}
+		G_LuaGetHookFunction(vm, LUA_HOOK_OBITUARY);
+		// Arguments
+		lua_pushinteger(vm->L, victim);
+		lua_pushinteger(vm->L, killer);
+		lua_pushinteger(vm->L, meansOfDeath);
+
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_OBITUARY, 3, 1))
+		{
+			//G_LuaStopVM(vm);
+			continue;
+		}
+		// Return values
+		if (lua_isstring(vm->L, -1))
+		{
 			lua_pop(vm->L, 1);
+			return qtrue;
 		}
+		lua_pop(vm->L, 1);
 	}
 	return qfalse;
 }
@@ -3593,39 +3952,30 @@ qboolean G_LuaHook_Damage(int target, int attacker, int damage, int dflags, mean
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_DAMAGE].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_DAMAGE].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_DAMAGE);
+		// Arguments
+		lua_pushinteger(vm->L, target);
+		lua_pushinteger(vm->L, attacker);
+		lua_pushinteger(vm->L, damage);
+		lua_pushinteger(vm->L, dflags);
+		lua_pushinteger(vm->L, mod);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_DAMAGE, 5, 1))
+		{
+			//G_LuaStopVM(vm);
+			continue;
+		}
+		// Return values
+		if (lua_tointeger(vm->L, -1) == 1)
 		{
-			if (vm->id < 0 /*|| vm->err*/)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_Damage"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, target);
-			lua_pushinteger(vm->L, attacker);
-			lua_pushinteger(vm->L, damage);
-			lua_pushinteger(vm->L, dflags);
-			lua_pushinteger(vm->L, mod);
-			// Call
-			if (!G_LuaCall(vm, "et_Damage", 5, 1))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
-			// Return values
-			if (lua_tointeger(vm->L, -1) == 1)
-			{
-				lua_pop(vm->L, 1);
-				return qtrue;
-			}
 			lua_pop(vm->L, 1);
+			return qtrue;
 		}
+		lua_pop(vm->L, 1);
 	}
 	return qfalse;
 }
@@ -3637,43 +3987,34 @@ qboolean G_LuaHook_WeaponFire(int clientNum, weapon_t weapon, gentity_t **pFired
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_WEAPONFIRE].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_WEAPONFIRE].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_WEAPONFIRE);
+		// Arguments
+		lua_pushinteger(vm->L, clientNum);
+		lua_pushinteger(vm->L, weapon);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_WEAPONFIRE, 2, 2))
 		{
-			if (vm->id < 0 /*|| vm->err*/)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_WeaponFire"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, clientNum);
-			lua_pushinteger(vm->L, weapon);
-			// Call
-			if (!G_LuaCall(vm, "et_WeaponFire", 2, 2))
-			{
-				continue;
-			}
-			// Return values
-			if (lua_tointeger(vm->L, -2) == 1)
+			continue;
+		}
+		// Return values
+		if (lua_tointeger(vm->L, -2) == 1)
+		{
+			if (lua_isinteger(vm->L, -1))
 			{
-				if (lua_isinteger(vm->L, -1))
+				int entNum = lua_tointeger(vm->L, -1);
+				if (entNum >= 0 && entNum < MAX_GENTITIES)
 				{
-					int entNum = lua_tointeger(vm->L, -1);
-					if (entNum >= 0 && entNum < MAX_GENTITIES)
-					{
-						*pFiredShot = g_entities + entNum;
-					}
+					*pFiredShot = g_entities + entNum;
 				}
-				lua_pop(vm->L, 2);
-				return qtrue;
 			}
 			lua_pop(vm->L, 2);
+			return qtrue;
 		}
+		lua_pop(vm->L, 2);
 	}
 	return qfalse;
 }
@@ -3685,34 +4026,25 @@ qboolean G_LuaHook_FixedMGFire(int clientNum)
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_FIXEDMGFIRE].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_FIXEDMGFIRE].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_FIXEDMGFIRE);
+		// Arguments
+		lua_pushinteger(vm->L, clientNum);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_FIXEDMGFIRE, 1, 1))
+		{
+			continue;
+		}
+		// Return values
+		if (lua_tointeger(vm->L, -1) == 1)
 		{
-			if (vm->id < 0 /*|| vm->err*/)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_FixedMGFire"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, clientNum);
-			// Call
-			if (!G_LuaCall(vm, "et_FixedMGFire", 1, 1))
-			{
-				continue;
-			}
-			// Return values
-			if (lua_tointeger(vm->L, -1) == 1)
-			{
-				lua_pop(vm->L, 1);
-				return qtrue;
-			}
 			lua_pop(vm->L, 1);
+			return qtrue;
 		}
+		lua_pop(vm->L, 1);
 	}
 	return qfalse;
 }
@@ -3724,34 +4056,25 @@ qboolean G_LuaHook_MountedMGFire(int clientNum)
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_MOUNTEDMGFIRE].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_MOUNTEDMGFIRE].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_MOUNTEDMGFIRE);
+		// Arguments
+		lua_pushinteger(vm->L, clientNum);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_MOUNTEDMGFIRE, 1, 1))
+		{
+			continue;
+		}
+		// Return values
+		if (lua_tointeger(vm->L, -1) == 1)
 		{
-			if (vm->id < 0 /*|| vm->err*/)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_MountedMGFire"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, clientNum);
-			// Call
-			if (!G_LuaCall(vm, "et_MountedMGFire", 1, 1))
-			{
-				continue;
-			}
-			// Return values
-			if (lua_tointeger(vm->L, -1) == 1)
-			{
-				lua_pop(vm->L, 1);
-				return qtrue;
-			}
 			lua_pop(vm->L, 1);
+			return qtrue;
 		}
+		lua_pop(vm->L, 1);
 	}
 	return qfalse;
 }
@@ -3763,34 +4086,25 @@ qboolean G_LuaHook_AAGunFire(int clientNum)
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_AAGUNFIRE].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
+		vm = luaHooks[LUA_HOOK_AAGUNFIRE].vms[i];
+
+		G_LuaGetHookFunction(vm, LUA_HOOK_AAGUNFIRE);
+		// Arguments
+		lua_pushinteger(vm->L, clientNum);
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_AAGUNFIRE, 1, 1))
+		{
+			continue;
+		}
+		// Return values
+		if (lua_tointeger(vm->L, -1) == 1)
 		{
-			if (vm->id < 0 /*|| vm->err*/)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_AAGunFire"))
-			{
-				continue;
-			}
-			// Arguments
-			lua_pushinteger(vm->L, clientNum);
-			// Call
-			if (!G_LuaCall(vm, "et_AAGunFire", 1, 1))
-			{
-				continue;
-			}
-			// Return values
-			if (lua_tointeger(vm->L, -1) == 1)
-			{
-				lua_pop(vm->L, 1);
-				return qtrue;
-			}
 			lua_pop(vm->L, 1);
+			return qtrue;
 		}
+		lua_pop(vm->L, 1);
 	}
 	return qfalse;
 }
@@ -3804,26 +4118,17 @@ void G_LuaHook_SpawnEntitiesFromString()
 	int      i;
 	lua_vm_t *vm;
 
-	for (i = 0; i < LUA_NUM_VM; i++)
+	for (i = 0; i < luaHooks[LUA_HOOK_SPAWNENTITIESFROMSTRING].numVMs; i++)
 	{
-		vm = lVM[i];
-		if (vm)
-		{
-			if (vm->id < 0 /*|| vm->err*/)
-			{
-				continue;
-			}
-			if (!G_LuaGetNamedFunction(vm, "et_SpawnEntitiesFromString"))
-			{
-				continue;
-			}
+		vm = luaHooks[LUA_HOOK_SPAWNENTITIESFROMSTRING].vms[i];
 
-			// Call
-			if (!G_LuaCall(vm, "et_SpawnEntitiesFromString", 0, 0))
-			{
-				//G_LuaStopVM(vm);
-				continue;
-			}
+		G_LuaGetHookFunction(vm, LUA_HOOK_SPAWNENTITIESFROMSTRING);
+
+		// Call
+		if (!G_LuaCallHook(vm, LUA_HOOK_SPAWNENTITIESFROMSTRING, 0, 0))
+		{
+			//G_LuaStopVM(vm);
+			continue;
 		}
 	}
 }
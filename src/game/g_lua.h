@@ -76,6 +76,39 @@
 #define _et_gclient_addfield(n, t, f) { #n, t, offsetof(struct gclient_s, n), FIELD_FLAG_GCLIENT + f }
 #define _et_gclient_addfieldalias(n, a, t, f) { #n, t, offsetof(struct gclient_s, a), FIELD_FLAG_GCLIENT + f }
 
+/**
+ * @enum luaHook_t
+ * @brief The et_* callbacks of the Lua modules
+ */
+typedef enum
+{
+	LUA_HOOK_INITGAME = 0,
+	LUA_HOOK_SHUTDOWNGAME,
+	LUA_HOOK_RUNFRAME,
+	LUA_HOOK_QUIT,
+	LUA_HOOK_IPCRECEIVE,
+	LUA_HOOK_CLIENTCONNECT,
+	LUA_HOOK_CLIENTDISCONNECT,
+	LUA_HOOK_CLIENTBEGIN,
+	LUA_HOOK_CLIENTUSERINFOCHANGED,
+	LUA_HOOK_CLIENTSPAWN,
+	LUA_HOOK_CLIENTCOMMAND,
+	LUA_HOOK_CONSOLECOMMAND,
+	LUA_HOOK_UPGRADESKILL,
+	LUA_HOOK_SETPLAYERSKILL,
+	LUA_HOOK_PRINT,
+	LUA_HOOK_DPRINT,
+	LUA_HOOK_ERROR,
+	LUA_HOOK_OBITUARY,
+	LUA_HOOK_DAMAGE,
+	LUA_HOOK_WEAPONFIRE,
+	LUA_HOOK_FIXEDMGFIRE,
+	LUA_HOOK_MOUNTEDMGFIRE,
+	LUA_HOOK_AAGUNFIRE,
+	LUA_HOOK_SPAWNENTITIESFROMSTRING,
+	LUA_HOOK_MAX
+} luaHook_t;
+
 /**
  * @struct lua_vm_s
  * @brief
@@ -90,6 +123,7 @@ typedef struct
 	int code_size;
 	int err;
 	lua_State *L;
+	int hookRef[LUA_HOOK_MAX];          ///< registry references of the callbacks, LUA_NOREF if not defined
 } lua_vm_t;
 
 /**
@@ -127,12 +161,15 @@ typedef struct luaPrintFunctions_s
 {
 	printMessageType_t category;
 	const char *function;
+	luaHook_t hook;
 } luaPrintFunctions_t;
 
 // API
 qboolean G_LuaInit(void);
 qboolean G_LuaCall(lua_vm_t *vm, const char *func, int nargs, int nresults);
 qboolean G_LuaGetNamedFunction(lua_vm_t *vm, const char *name);
+qboolean G_LuaGetHookFunction(lua_vm_t *vm, luaHook_t hook);
+qboolean G_LuaCallHook(lua_vm_t *vm, luaHook_t hook, int nargs, int nresults);
 qboolean G_LuaStartVM(lua_vm_t *vm);
 qboolean G_LuaRunIsolated(const char *modName);
 void G_LuaStopVM(lua_vm_t *vm);
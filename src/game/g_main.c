@@ -177,6 +177,8 @@ vmCvar_t g_soldierChargeTime;
 vmCvar_t g_covertopsChargeTime;
 
 vmCvar_t g_antilag;
+vmCvar_t g_antilagLazy;
+vmCvar_t g_antilagMarkers;
 
 vmCvar_t g_spectatorInactivity;
 vmCvar_t match_latejoin;
@@ -230,6 +232,9 @@ vmCvar_t g_landminetimeout;
 vmCvar_t g_scriptDebug;
 vmCvar_t g_scriptDebugLevel;
 vmCvar_t g_scriptDebugTarget;
+#ifdef ETLEGACY_DEBUG
+vmCvar_t g_debugEntityIndex;
+#endif
 vmCvar_t g_movespeed;
 
 vmCvar_t g_axismapxp;
@@ -370,6 +375,10 @@ vmCvar_t g_multiview; // 0 - off, other - enabled
 vmCvar_t g_stickyCharge;
 vmCvar_t g_xpSaver;
 
+#ifdef FEATURE_DBMS
+vmCvar_t g_dbThread;
+#endif
+
 vmCvar_t g_debugForSingleClient;
 
 vmCvar_t g_suddenDeath;
@@ -489,6 +498,8 @@ cvarTable_t gameCvarTable[] =
 	{ &g_scriptName,                      "g_scriptName",                      "",                           CVAR_CHEAT,                                      0, qfalse, qfalse },
 
 	{ &g_antilag,                         "g_antilag",                         "1",                          CVAR_SERVERINFO | CVAR_ARCHIVE,                  0, qfalse, qfalse },
+	{ &g_antilagLazy,                     "g_antilagLazy",                     "1",                          CVAR_ARCHIVE,                                    0, qfalse, qfalse },
+	{ &g_antilagMarkers,                  "g_antilagMarkers",                  "17",                         CVAR_ARCHIVE | CVAR_LATCH,                       0, qfalse, qfalse },
 
 	{ NULL,                               "P",                                 "",                           CVAR_SERVERINFO_NOUPDATE,                        0, qfalse, qfalse },
 
@@ -545,6 +556,9 @@ cvarTable_t gameCvarTable[] =
 	// What level of detail do we want script printing to go to.
 	{ &g_scriptDebugLevel,                "g_scriptDebugLevel",                "0",                          CVAR_CHEAT,                                      0, qfalse, qfalse },
 	{ &g_scriptDebugTarget,               "g_scriptDebugTarget",               "",                           CVAR_CHEAT,                                      0, qfalse, qfalse },
+#ifdef ETLEGACY_DEBUG
+	{ &g_debugEntityIndex,                "g_debugEntityIndex",                "0",                          CVAR_CHEAT,                                      0, qfalse, qfalse },
+#endif
 
 	// How fast do we want Allied single player movement?
 	{ &g_movespeed,                       "g_movespeed",                       "76",                         CVAR_CHEAT,                                      0, qfalse, qfalse },
@@ -674,6 +688,9 @@ cvarTable_t gameCvarTable[] =
 #endif
 	{ &g_stickyCharge,                    "g_stickyCharge",                    "0",                          CVAR_ARCHIVE,                                    0, qfalse, qfalse },
 	{ &g_xpSaver,                         "g_xpSaver",                         "0",                          CVAR_ARCHIVE,                                    0, qfalse, qfalse },
+#ifdef FEATURE_DBMS
+	{ &g_dbThread,                        "g_dbThread",                        "1",                          CVAR_LATCH | CVAR_ARCHIVE,                       0, qfalse, qfalse },
+#endif
 	{ &g_suddenDeath,                     "g_suddenDeath",                     "0",                          CVAR_ARCHIVE,                                    0, qtrue,  qfalse },
 	{ &g_dropObjDelay,                    "g_dropObjDelay",                    "3000",                       CVAR_ARCHIVE,                                    0, qtrue,  qfalse },
 
@@ -690,6 +707,12 @@ cvarTable_t gameCvarTable[] =
  */
 static int gameCvarTableSize = sizeof(gameCvarTable) / sizeof(gameCvarTable[0]);
 
+/**
+ * @var gameCvarChanges
+ * @brief Change sequence of trap_Cvar_Changes(), -1 updates all cvars
+ */
+static int gameCvarChanges = -1;
+
 /**
  * @var fActions
  * @brief Flag to store executed final auto-actions
@@ -733,6 +756,7 @@ qboolean G_SnapshotCallback(int entityNum, int clientNum)
 
 int dll_com_trapGetValue;
 int dll_trap_DemoSupport;
+int dll_trap_CvarChanges;
 
 /**
  * @brief This is the only way control passes into the module.
@@ -1592,6 +1616,9 @@ void G_SetTargetName(gentity_t *ent, char *targetname)
 	{
 		ent->targetnamehash = -1;
 	}
+
+	G_TouchEntityIndex(ent);
+	G_Script_InvalidateEntityRefs();
 }
 
 /**
@@ -1780,6 +1807,7 @@ void G_FindTeams(void)
 					if (Q_stricmp(e2->classname, "func_door_rotating"))
 					{
 						e2->targetname = NULL;
+						G_TouchEntityIndex(e2);
 					}
 				}
 			}
@@ -1809,6 +1837,7 @@ void G_RegisterCvars(void)
 	cvarTable_t *cv;
 
 	level.server_settings = 0;
+	gameCvarChanges       = -1;
 
 	G_Printf("%d cvars in use\n", gameCvarTableSize);
 
@@ -1867,10 +1896,19 @@ void G_UpdateCvars(void)
 	qboolean    chargetimechanged  = qfalse;
 	qboolean    clsweaprestriction = qfalse;
 	qboolean    skillLevelPoints   = qfalse;
+	int         changes[MAX_CVAR_CHANGES];
+	int         numChanges;
+
+	// only the cvars the engine reports as changed need an update
+	numChanges = trap_Cvar_Changes(&gameCvarChanges, changes, MAX_CVAR_CHANGES);
+	if (!numChanges)
+	{
+		return;
+	}
 
 	for (i = 0, cv = gameCvarTable ; i < gameCvarTableSize ; i++, cv++)
 	{
-		if (cv->vmCvar)
+		if (cv->vmCvar && Q_CvarChanged(cv->vmCvar, changes, numChanges))
 		{
 			trap_Cvar_Update(cv->vmCvar);
 
@@ -2336,6 +2374,7 @@ static ID_INLINE void G_SetupExtensions(void)
 		dll_com_trapGetValue = Q_atoi(value);
 
 		G_SetupExtensionTrap(value, MAX_CVAR_VALUE_STRING, &dll_trap_DemoSupport, "trap_DemoSupport_Legacy");
+		G_SetupExtensionTrap(value, MAX_CVAR_VALUE_STRING, &dll_trap_CvarChanges, "trap_CvarChanges_Legacy");
 	}
 }
 
@@ -2388,6 +2427,8 @@ void G_InitGame(int levelTime, int randomSeed, int restart, int etLegacyServer,
 
 	G_InitMemory();
 
+	G_InitAntilag();
+
 	G_InitSkillLevels();
 
 	// intialize gamestate
@@ -2649,6 +2690,10 @@ void G_InitGame(int levelTime, int randomSeed, int restart, int etLegacyServer,
 		g_entities[i].classname = "clientslot";
 	}
 
+	G_InitEntityIndex();
+	G_InitEntityCategories();
+	G_InitEntityFreeList();
+
 	// let the server system know where the entities are
 	trap_LocateGameData(level.gentities, level.num_entities, sizeof(gentity_t),
 	                    &level.clients[0].ps, sizeof(level.clients[0]));
@@ -3902,6 +3947,11 @@ void G_LogExit(const char *string)
 
 	G_LogPrintf("Exit: %s\n", string);
 
+#ifdef FEATURE_DBMS
+	// write all player data of the map in one transaction
+	G_DB_BeginBatch("intermission");
+#endif
+
 #ifdef FEATURE_RATING
 	// record match ratings
 	if (g_skillRating.integer && g_gametype.integer != GT_WOLF_STOPWATCH && g_gametype.integer != GT_WOLF_LMS)
@@ -3995,6 +4045,10 @@ void G_LogExit(const char *string)
 	}
 #endif
 
+#ifdef FEATURE_DBMS
+	G_DB_EndBatch();
+#endif
+
 	if (g_gametype.integer == GT_WOLF_STOPWATCH)
 	{
 		int winner, defender;
@@ -5438,6 +5492,14 @@ void G_RunFrame(int levelTime)
 		return;
 	}
 
+#ifdef FEATURE_DBMS
+	// complete the database jobs finished since the last frame
+	if (level.database.initialized)
+	{
+		G_DB_RunFrame();
+	}
+#endif
+
 	// workaround for q3 bug
 	// levelTime will start over when the timelimit expires on dual objective maps.
 	if (level.previousTime > level.time)
@@ -5504,6 +5566,9 @@ void G_RunFrame(int levelTime)
 
 	G_ConfigCheckLocked();
 
+	// pick up entity renames that weren't reported to the name index
+	G_SyncEntityIndex();
+
 	for (i = 0; i < level.num_entities; i++)
 	{
 		g_entities[i].runthisframe = qfalse;
@@ -34,6 +34,10 @@
 #include "g_mdx.h"
 #include "g_mdx_lut.h"
 
+#ifdef ETL_SSE
+#include <immintrin.h>
+#endif
+
 /******************** Internal */
 #ifdef BONE_HITTESTS
 const char *mdx_hit_type_names[MDX_HIT_TYPE_MAX] =
@@ -74,6 +78,32 @@ static hit_t *hits     = NULL;
 static int    mdx_bones_max = 0;
 static vec3_t *mdx_bones    = NULL;
 
+#define MDX_POSE_SLOTS     128          ///< power of two, poses are mapped to slots by entity number
+#define MDX_POSE_MAX_TAGS  32
+#define MDX_POSE_MAX_BONES 128
+
+/**
+ * @struct mdx_pose_t
+ * @brief Tag orientations (and with BONE_HITTESTS all bone origins) of one entity pose.
+ *
+ * The pose is a function of the grefEntity_t alone, so the whole refent is the key.
+ * It holds the entity number and the frames and backlerps of the (rewound) time it
+ * was taken at. Entries are only reused within the server frame they were made in.
+ */
+typedef struct
+{
+	int framenum;                       ///< level.framenum the pose was taken in
+	grefEntity_t refent;
+	byte tagValid[MDX_POSE_MAX_TAGS];
+	orientation_t tags[MDX_POSE_MAX_TAGS];
+#ifdef BONE_HITTESTS
+	int bone_count;                     ///< 0 until all bones are calculated
+	vec3_t bones[MDX_POSE_MAX_BONES];
+#endif // BONE_HITTESTS
+} mdx_pose_t;
+
+static mdx_pose_t mdx_poses[MDX_POSE_SLOTS];
+
 #define INDEXTOQHANDLE(idx)     (qhandle_t)((idx) + 1)
 /**
   * @var Index may be NULL sometimes, so just default to the first model
@@ -108,6 +138,9 @@ void mdx_cleanup(void)
 	Com_Dealloc(mdx_bones);
 	mdx_bones = NULL;
 
+	// model handles are about to be reused
+	Com_Memset(mdx_poses, 0, sizeof(mdx_poses));
+
 #ifdef BONE_HITTESTS
 	cachetag_count = 0;
 	Com_Dealloc(cachetag_names);
@@ -149,6 +182,35 @@ void mdx_cleanup(void)
  * Utility functions
  */
 
+/**
+ * @brief Finds the cache slot of a pose, the slot is reset if it holds another pose
+ * @param[in] refent
+ * @return The slot, NULL for refents not made by mdx_gentity_to_grefEntity()
+ */
+static mdx_pose_t *mdx_pose_lookup(const grefEntity_t *refent)
+{
+	mdx_pose_t *pose;
+
+	if (refent->poseEntity <= 0)
+	{
+		return NULL;
+	}
+
+	pose = &mdx_poses[(refent->poseEntity - 1) & (MDX_POSE_SLOTS - 1)];
+
+	if (pose->framenum != level.framenum || memcmp(&pose->refent, refent, sizeof(*refent)))
+	{
+		pose->framenum = level.framenum;
+		pose->refent   = *refent;
+		Com_Memset(pose->tagValid, 0, sizeof(pose->tagValid));
+#ifdef BONE_HITTESTS
+		pose->bone_count = 0;
+#endif // BONE_HITTESTS
+	}
+
+	return pose;
+}
+
 /**
  * @brief MatrixWeight
  * @param[in] m
@@ -172,6 +234,37 @@ static void MatrixWeight(/*const*/ vec3_t m[3], float weight, vec3_t mout[3])
 	mout[2][2] = m[2][2] * weight + one;
 }
 
+/**
+ * @brief Multiplies two 3x3 matrices for the tag, bone and hit box transforms.
+ * @param[in] in1
+ * @param[in] in2
+ * @param[out] out must not alias the inputs
+ */
+static ID_INLINE void mdx_matrix_multiply(vec3_t in1[3], vec3_t in2[3], vec3_t out[3])
+{
+#ifdef ETL_SSE
+	__m128 r0, r1, r2, o0, o1, o2;
+
+	// the last row is loaded in two parts to not read past the matrix
+	r0 = _mm_loadu_ps(in2[0]);
+	r1 = _mm_loadu_ps(in2[1]);
+	r2 = _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)in2[2]), _mm_load_ss(&in2[2][2]));
+
+	// same operation order as _MatrixMultiply, the results are bit identical
+	o0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(in1[0][0]), r0), _mm_mul_ps(_mm_set1_ps(in1[0][1]), r1)), _mm_mul_ps(_mm_set1_ps(in1[0][2]), r2));
+	o1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(in1[1][0]), r0), _mm_mul_ps(_mm_set1_ps(in1[1][1]), r1)), _mm_mul_ps(_mm_set1_ps(in1[1][2]), r2));
+	o2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(in1[2][0]), r0), _mm_mul_ps(_mm_set1_ps(in1[2][1]), r1)), _mm_mul_ps(_mm_set1_ps(in1[2][2]), r2));
+
+	// the 4th lane of the first two rows is overwritten by the next row
+	_mm_storeu_ps(out[0], o0);
+	_mm_storeu_ps(out[1], o1);
+	_mm_storel_pi((__m64 *)out[2], o2);
+	_mm_store_ss(&out[2][2], _mm_movehl_ps(o2, o2));
+#else
+	MatrixMultiply(in1, in2, out);
+#endif
+}
+
 /**
  * @brief The engine transforms short angles to an axis somewhat brokenly -
  *        it uses a LUT and has truely perplexing values
@@ -245,7 +338,19 @@ static void mdx_quaternion_nlerp(const vec4_t q1, const vec4_t q2, vec4_t qout,
 {
 	float fwdlerp = 1.0 - backlerp;
 	float len;
+#ifdef ETL_SSE
+	__m128 q;
+
+	// same operation order as the scalar version, the results are bit identical
+	q = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(q1), _mm_set1_ps(backlerp)), _mm_mul_ps(_mm_loadu_ps(q2), _mm_set1_ps(fwdlerp)));
+	_mm_storeu_ps(qout, q);
 
+	len = sqrt(qout[0] * qout[0] + qout[1] * qout[1] + qout[2] * qout[2] + qout[3] * qout[3]);
+	if (len)
+	{
+		_mm_storeu_ps(qout, _mm_div_ps(q, _mm_set1_ps(len)));
+	}
+#else
 	qout[0] = q1[0] * backlerp + q2[0] * fwdlerp;
 	qout[1] = q1[1] * backlerp + q2[1] * fwdlerp;
 	qout[2] = q1[2] * backlerp + q2[2] * fwdlerp;
@@ -259,6 +364,7 @@ static void mdx_quaternion_nlerp(const vec4_t q1, const vec4_t q2, vec4_t qout,
 		qout[2] /= len;
 		qout[3] /= len;
 	}
+#endif
 	else
 	{
 		// very rare -- quaternions pointing in opposite direction with backlerp 0.5
@@ -298,6 +404,8 @@ void mdx_gentity_to_grefEntity(gentity_t *ent, grefEntity_t *refent, int lerpTim
 
 	Com_Memset(refent, 0, sizeof(*refent));
 
+	refent->poseEntity = ent->s.number + 1;
+
 	if (ent->s.eType == ET_PLAYER)
 	{
 		character = BG_GetCharacter(ent->client->sess.sessionTeam, ent->client->sess.playerType);
@@ -1493,12 +1601,13 @@ static void mdx_calculate_bone_lerp(
 
 #ifdef BONE_HITTESTS
 /**
- * @brief Calculates all bones
+ * @brief Calculates all bones, reusing the bones of the pose if they were calculated this frame
  * @param[in] refent
  */
 static void mdx_calculate_bones(/*const*/ grefEntity_t *refent)
 {
-	int i;
+	int        i;
+	mdx_pose_t *pose = mdx_pose_lookup(refent);
 
 	mdx_t *frameModel    = &mdx_models[QHANDLETOINDEX(refent->frameModel)];
 	mdx_t *oldFrameModel = &mdx_models[QHANDLETOINDEX_SAFE(refent->oldframeModel, refent->frameModel)];
@@ -1515,6 +1624,12 @@ static void mdx_calculate_bones(/*const*/ grefEntity_t *refent)
 	}
 #endif
 
+	if (pose && pose->bone_count == frameModel->bone_count)
+	{
+		Com_Memcpy(mdx_bones, pose->bones, pose->bone_count * sizeof(*mdx_bones));
+		return;
+	}
+
 	for (i = 0; i < frameModel->bone_count; i++)
 	{
 		mdx_calculate_bone_lerp(
@@ -1525,6 +1640,12 @@ static void mdx_calculate_bones(/*const*/ grefEntity_t *refent)
 			qfalse
 			);
 	}
+
+	if (pose && frameModel->bone_count <= MDX_POSE_MAX_BONES)
+	{
+		Com_Memcpy(pose->bones, mdx_bones, frameModel->bone_count * sizeof(*mdx_bones));
+		pose->bone_count = frameModel->bone_count;
+	}
 }
 #endif // BONE_HITTESTS
 
@@ -1657,7 +1778,7 @@ static void mdx_bone_orientation(/*const*/ grefEntity_t *refent, int idx, vec3_t
 	// torso angles
 	// FIXME: This probably isn't how the engine decides.
 	MatrixWeight(refent->torsoAxis, bone->torso_weight, tmpaxis);
-	MatrixMultiply(axis1, tmpaxis, axis);
+	mdx_matrix_multiply(axis1, tmpaxis, axis);
 }
 
 #ifdef BONE_HITTESTS
@@ -1706,7 +1827,7 @@ static void mdx_tag_orientation(/*const*/ grefEntity_t *refent, int idx, vec3_t
 	{
 		vec3_t tmp[3];
 		AxisCopy(tmpaxis, tmp);
-		MatrixMultiply(refent->headAxis, tmp, tmpaxis);
+		mdx_matrix_multiply(refent->headAxis, tmp, tmpaxis);
 	}
 
 	// Tag offset
@@ -1714,7 +1835,7 @@ static void mdx_tag_orientation(/*const*/ grefEntity_t *refent, int idx, vec3_t
 	VectorAdd(origin, offset, origin);
 
 	// Tag axis
-	MatrixMultiply(tag->axis, tmpaxis, axis);
+	mdx_matrix_multiply(tag->axis, tmpaxis, axis);
 
 	if (!recursion)
 	{
@@ -1725,12 +1846,12 @@ static void mdx_tag_orientation(/*const*/ grefEntity_t *refent, int idx, vec3_t
 
 		if (withhead)
 		{
-			MatrixMultiply(refent->headAxis, axis, tmpaxis);
-			MatrixMultiply(tmpaxis, refent->axis, axis);
+			mdx_matrix_multiply(refent->headAxis, axis, tmpaxis);
+			mdx_matrix_multiply(tmpaxis, refent->axis, axis);
 		}
 		else
 		{
-			MatrixMultiply(axis, refent->axis, tmpaxis);
+			mdx_matrix_multiply(axis, refent->axis, tmpaxis);
 			AxisCopy(tmpaxis, axis);
 		}
 	}
@@ -1762,10 +1883,11 @@ static void mdx_tag_orientation(/*const*/ grefEntity_t *refent, int idx, vec3_t
  */
 int trap_R_LerpTagNumber(orientation_t *tag, /*const*/ grefEntity_t *refent, int tagNum)
 {
-	mdm_t  *model;
-	vec3_t axis[3];
-	vec3_t offset;
-	int    bone;
+	mdm_t      *model;
+	mdx_pose_t *pose;
+	vec3_t     axis[3];
+	vec3_t     offset;
+	int        bone;
 
 	model = &mdm_models[QHANDLETOINDEX(refent->hModel)];
 
@@ -1774,6 +1896,14 @@ int trap_R_LerpTagNumber(orientation_t *tag, /*const*/ grefEntity_t *refent, int
 		return -1;
 	}
 
+	// head, legs and hit tests of one frame ask for the same few tags over and over
+	pose = tagNum < MDX_POSE_MAX_TAGS ? mdx_pose_lookup(refent) : NULL;
+	if (pose && pose->tagValid[tagNum])
+	{
+		*tag = pose->tags[tagNum];
+		return 0;
+	}
+
 	bone = model->tags[tagNum].attach_bone;
 
 	mdx_calculate_bones_single(refent, bone);
@@ -1782,7 +1912,13 @@ int trap_R_LerpTagNumber(orientation_t *tag, /*const*/ grefEntity_t *refent, int
 	vec3_rotate(model->tags[tagNum].offset, axis, offset);
 	VectorAdd(tag->origin, offset, tag->origin);
 
-	MatrixMultiply(model->tags[tagNum].axis, axis, tag->axis);
+	mdx_matrix_multiply(model->tags[tagNum].axis, axis, tag->axis);
+
+	if (pose)
+	{
+		pose->tags[tagNum]     = *tag;
+		pose->tagValid[tagNum] = 1;
+	}
 
 	return 0;
 }
@@ -2796,7 +2932,7 @@ qboolean mdx_hit_test(const vec3_t start, const vec3_t end, /*const*/ gentity_t
 			CrossProduct(a1[2], a1[1], a1[0]);
 
 			// Apply hit axis
-			MatrixMultiply(a1, hit->axis, a2);
+			mdx_matrix_multiply(a1, hit->axis, a2);
 
 			if (g_debugBullets.integer >= 3)
 			{
@@ -2852,7 +2988,7 @@ qboolean mdx_hit_test(const vec3_t start, const vec3_t end, /*const*/ gentity_t
 		else
 		{
 			// Apply hit axis
-			MatrixMultiply(a1, hit->axis, a2);
+			mdx_matrix_multiply(a1, hit->axis, a2);
 
 			if (g_debugBullets.integer >= 3)
 			{
@@ -2943,8 +3079,8 @@ void mdx_head_position(/*const*/ gentity_t *ent, /*const*/ grefEntity_t *refent,
 	VectorMA(org, orientation.origin[2], refent->axis[2], org);
 
 	// Apply head/body rotation
-	MatrixMultiply(refent->headAxis, orientation.axis, axis);
-	MatrixMultiply(axis, refent->axis, orientation.axis);
+	mdx_matrix_multiply(refent->headAxis, orientation.axis, axis);
+	mdx_matrix_multiply(axis, refent->axis, orientation.axis);
 
 	// calculate center position for standard head (this offset is just a guess)
 	VectorMA(org, 6.5f, orientation.axis[2], org); // up
@@ -80,4 +80,5 @@ void G_InitMemory(void)
 void Svcmd_GameMem_f(void)
 {
 	G_Printf("Game memory status: %i out of %i bytes allocated - %i bytes free\n", allocPoint, POOLSIZE, POOLSIZE - allocPoint);
+	G_EntityFreeListStats();
 }
@@ -2423,6 +2423,7 @@ void SP_misc_commandmap_marker(gentity_t *ent)
 {
 	ent->s.eType = ET_COMMANDMAP_MARKER;
 	ent->parent  = NULL;
+	G_UpdateEntityCategory(ent);
 
 	G_SetOrigin(ent, ent->s.origin);
 }
@@ -2948,6 +2949,12 @@ void G_PreFilledMissileEntity(gentity_t *ent, int weaponNum, int realWeapon, int
 	VectorCopy(dir, ent->s.pos.trDelta);
 
 	SnapVector(ent->s.pos.trDelta); // save net bandwidth
+
+	// the classname comes from the weapon table
+	G_TouchEntityIndex(ent);
+
+	// landmines, dynamite and satchels are looked up by category
+	G_UpdateEntityCategory(ent);
 }
 
 /**
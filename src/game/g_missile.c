@@ -285,6 +285,7 @@ void G_MissileImpact(gentity_t *ent, trace_t *trace, int impactDamage)
 
 		ent->s.eType        = ET_GENERAL;
 		ent->freeAfterEvent = qtrue;
+		G_UpdateEntityCategory(ent);
 	}
 }
 
@@ -299,6 +300,7 @@ void G_ExplodeMissile(gentity_t *ent)
 
 	etype        = ent->s.eType;
 	ent->s.eType = ET_GENERAL;
+	G_UpdateEntityCategory(ent);
 
 	// splash damage
 	if (ent->splashDamage)
@@ -1309,26 +1311,28 @@ void G_ChainFree(gentity_t *self)
  */
 void G_FadeItems(gentity_t *ent, int modType)
 {
-	gentity_t *e = &g_entities[MAX_CLIENTS];
-	int       i;
+	gentity_t     *e = NULL;
+	entCategory_t category;
+
+	switch (modType)
+	{
+	case MOD_LANDMINE:
+		category = ENTCAT_LANDMINE;
+		break;
+	case MOD_DYNAMITE:
+		category = ENTCAT_DYNAMITE;
+		break;
+	case MOD_SATCHEL:
+		category = ENTCAT_SATCHEL;
+		break;
+	default:
+		G_Printf("G_FadeItems: no entity category for mod %i\n", modType);
+		return;
+	}
 
-	for (i = MAX_CLIENTS ; i < level.num_entities ; i++, e++)
+	// the category already implies the missile type and method of death
+	while ((e = G_FindByCategory(e, category)) != NULL)
 	{
-		if (!e->inuse)
-		{
-			continue;
-		}
-
-		if (e->s.eType != ET_MISSILE)
-		{
-			continue;
-		}
-
-		if (e->methodOfDeath != modType)
-		{
-			continue;
-		}
-
 		if (e->parent != ent)
 		{
 			continue;
@@ -1356,17 +1360,11 @@ void G_FadeItems(gentity_t *ent, int modType)
  */
 int G_CountTeamLandmines(team_t team)
 {
-	gentity_t *e = &g_entities[MAX_CLIENTS];
-	int       i;
+	gentity_t *e  = NULL;
 	int       cnt = 0;
 
-	for (i = MAX_CLIENTS ; i < level.num_entities ; i++, e++)
+	while ((e = G_FindByCategory(e, ENTCAT_LANDMINE)) != NULL)
 	{
-		if (!e->inuse)
-		{
-			continue;
-		}
-
 		if (e->s.eType != ET_MISSILE)
 		{
 			continue;
@@ -1395,19 +1393,13 @@ int G_CountTeamLandmines(team_t team)
  */
 qboolean G_SweepForLandmines(vec3_t origin, float radius, int team)
 {
-	gentity_t *e = &g_entities[MAX_CLIENTS];
-	int       i;
+	gentity_t *e = NULL;
 	vec3_t    dist;
 
 	radius *= radius;
 
-	for (i = MAX_CLIENTS; i < level.num_entities; i++, e++)
+	while ((e = G_FindByCategory(e, ENTCAT_LANDMINE)) != NULL)
 	{
-		if (!e->inuse)
-		{
-			continue;
-		}
-
 		if (e->s.eType != ET_MISSILE)
 		{
 			continue;
@@ -1440,16 +1432,10 @@ qboolean G_SweepForLandmines(vec3_t origin, float radius, int team)
  */
 gentity_t *G_FindSatchel(gentity_t *ent)
 {
-	gentity_t *e = &g_entities[MAX_CLIENTS];
-	int       i;
+	gentity_t *e = NULL;
 
-	for (i = MAX_CLIENTS ; i < level.num_entities ; i++, e++)
+	while ((e = G_FindByCategory(e, ENTCAT_SATCHEL)) != NULL)
 	{
-		if (!e->inuse)
-		{
-			continue;
-		}
-
 		if (e->s.eType != ET_MISSILE)
 		{
 			continue;
@@ -1491,18 +1477,12 @@ void G_ExplodeMines(gentity_t *ent)
  */
 qboolean G_ExplodeSatchels(gentity_t *ent)
 {
-	gentity_t *e = &g_entities[MAX_CLIENTS];
+	gentity_t *e = NULL;
 	vec3_t    dist;
-	int       i;
 	qboolean  blown = qfalse;
 
-	for (i = MAX_CLIENTS ; i < level.num_entities; i++, e++)
+	while ((e = G_FindByCategory(e, ENTCAT_SATCHEL)) != NULL)
 	{
-		if (!e->inuse)
-		{
-			continue;
-		}
-
 		if (e->s.eType != ET_MISSILE)
 		{
 			continue;
@@ -5515,6 +5515,7 @@ void func_constructiblespawn(gentity_t *ent)
 							}
 						}
 					}
+					G_UpdateEntityCategory(e);
 				}
 				e->s.pos.trType = TR_STATIONARY;
 
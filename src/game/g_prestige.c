@@ -31,10 +31,27 @@
 
 #define PRCHECK_SQLWRAP_TABLES "SELECT * FROM prestige_users;"
 #define PRCHECK_SQLWRAP_SCHEMA "SELECT guid, prestige, streak, skill0, skill1, skill2, skill3, skill4, skill5, skill6, created, updated FROM prestige_users;"
-#define PRUSERS_SQLWRAP_SELECT "SELECT * FROM prestige_users WHERE guid = '%s';"
-#define PRUSERS_SQLWRAP_INSERT "INSERT INTO prestige_users " \
-	                           "(guid, prestige, streak, skill0, skill1, skill2, skill3, skill4, skill5, skill6, created, updated) VALUES ('%s', '%i', '%i', '%i', '%i', '%i', '%i', '%i', '%i', '%i', CURRENT_TIMESTAMP, CURRENT_TIMESTAMP);"
-#define PRUSERS_SQLWRAP_UPDATE "UPDATE prestige_users SET prestige = '%i', streak = '%i', skill0 = '%i', skill1 = '%i', skill2 = '%i', skill3 = '%i', skill4 = '%i', skill5 = '%i', skill6 = '%i', updated = CURRENT_TIMESTAMP WHERE guid = '%s';"
+#define PRUSERS_SQLWRAP_SELECT "SELECT * FROM prestige_users WHERE guid = ?1;"
+#define PRUSERS_SQLWRAP_UPSERT "INSERT INTO prestige_users " \
+	                           "(guid, prestige, streak, skill0, skill1, skill2, skill3, skill4, skill5, skill6, created, updated) VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, CURRENT_TIMESTAMP, CURRENT_TIMESTAMP) " \
+	                           "ON CONFLICT (guid) DO UPDATE SET prestige = excluded.prestige, streak = excluded.streak, " \
+	                           "skill0 = excluded.skill0, skill1 = excluded.skill1, skill2 = excluded.skill2, skill3 = excluded.skill3, " \
+	                           "skill4 = excluded.skill4, skill5 = excluded.skill5, skill6 = excluded.skill6, updated = excluded.updated;"
+
+/**
+ * @struct prJob_t
+ * @brief Prestige queued for the database thread
+ */
+typedef struct
+{
+	int clientNum;
+	char guid[MAX_GUID_LENGTH + 1];
+	prData_t pr_data;
+	qboolean streakUp;                  ///< set: all skills are maxed out at the end of the map
+	qboolean resetStreak;               ///< set: prestige was increased
+	qboolean streakRead;                ///< set: the current streak was read, the session may be updated
+	int result;
+} prJob_t;
 
 /**
  * @brief Checks if database exists, if tables exist and if schemas are correct
@@ -115,17 +132,66 @@ int G_PrestigeDBCheck(char *db_path, int db_mode)
 	return 0;
 }
 
+/**
+ * @brief Retrieves prestige on the database thread
+ * @param[in,out] data
+ */
+static void G_GetClientPrestigeJob(void *data)
+{
+	prJob_t *job = (prJob_t *)data;
+
+	job->pr_data.guid = (const unsigned char *)job->guid;
+	job->result       = G_ReadPrestige(&job->pr_data);
+}
+
+/**
+ * @brief Assigns the retrieved prestige to the client session
+ * @param[in] data
+ */
+static void G_GetClientPrestigeDone(void *data)
+{
+	prJob_t   *job = (prJob_t *)data;
+	gclient_t *cl;
+	int       i;
+
+	// client left or slot was taken over while loading
+	if (job->result || !G_DB_IsSameClient(job->clientNum, job->guid))
+	{
+		return;
+	}
+
+	cl = level.clients + job->clientNum;
+
+	// assign user data to session
+	cl->sess.prestige     = job->pr_data.prestige;
+	cl->sess.startxptotal = 0;
+
+	for (i = 0; i < SK_NUM_SKILLS; i++)
+	{
+		cl->sess.skillpoints[i]      = job->pr_data.skillpoints[i];
+		cl->sess.startskillpoints[i] = job->pr_data.skillpoints[i];
+		cl->sess.startxptotal       += job->pr_data.skillpoints[i];
+	}
+
+	for (i = 0; i < SK_NUM_SKILLS; i++)
+	{
+		G_SetPlayerSkill(cl, i);
+	}
+
+	ClientUserinfoChanged(job->clientNum);
+}
+
 /**
  * @brief Retrieve prestige for client
  *         Called on ClientConnect
+ *         The query is queued, the prestige is assigned at the start of a later frame.
  * @param[in] cl
  */
 void G_GetClientPrestige(gclient_t *cl)
 {
 	char      userinfo[MAX_INFO_STRING];
-	char      *guid;
-	int       clientNum, i;
-	prData_t  pr_data;
+	int       clientNum;
+	prJob_t   job;
 	gentity_t *ent;
 
 	// disable for these game types
@@ -157,40 +223,100 @@ void G_GetClientPrestige(gclient_t *cl)
 
 	// retrieve guid
 	trap_GetUserinfo(clientNum, userinfo, sizeof(userinfo));
-	guid = Info_ValueForKey(userinfo, "cl_guid");
 
-	// assign guid
-	pr_data.guid = (const unsigned char *)guid;
+	Com_Memset(&job, 0, sizeof(job));
+	job.clientNum = clientNum;
+	Q_strncpyz(job.guid, Info_ValueForKey(userinfo, "cl_guid"), sizeof(job.guid));
 
-	// retrieve current prestige or assign default values
-	if (G_ReadPrestige(&pr_data))
+	G_DB_QueueJob("prestige get", G_GetClientPrestigeJob, G_GetClientPrestigeDone, &job, sizeof(job));
+}
+
+/**
+ * @brief Updates the streak and saves prestige on the database thread
+ * @param[in,out] data
+ */
+static void G_SetClientPrestigeJob(void *data)
+{
+	prJob_t  *job = (prJob_t *)data;
+	prData_t current;
+
+	job->pr_data.guid = (const unsigned char *)job->guid;
+	current.guid      = job->pr_data.guid;
+
+	// retrieve current streak or assign default values
+	if (G_ReadPrestige(&current))
 	{
+		job->result = 1;
 		return;
 	}
 
-	// assign user data to session
-	cl->sess.prestige     = pr_data.prestige;
-	cl->sess.startxptotal = 0;
+	job->streakRead     = qtrue;
+	job->pr_data.streak = current.streak;
+
+	// increase streak if all skills are maxed out
+	if (job->streakUp)
+	{
+		job->pr_data.streak += 1;
+	}
+
+	// reset streak
+	if (job->resetStreak)
+	{
+		job->pr_data.streak = 0;
+	}
+
+	// save or update prestige
+	job->result = G_WritePrestige(&job->pr_data);
+}
+
+/**
+ * @brief Increases the prestige and resets the skills of the session once
+ *         the streak could be read, a failed read leaves the session untouched
+ * @param[in] data
+ */
+static void G_SetClientPrestigeDone(void *data)
+{
+	prJob_t   *job = (prJob_t *)data;
+	gclient_t *cl;
+	int       i;
+
+	// client left or slot was taken over while saving
+	if (!job->resetStreak || !job->streakRead || !G_DB_IsSameClient(job->clientNum, job->guid))
+	{
+		return;
+	}
+
+	cl = level.clients + job->clientNum;
+
+	// increase prestige and reset skill points
+	cl->sess.prestige = job->pr_data.prestige;
 
 	for (i = 0; i < SK_NUM_SKILLS; i++)
 	{
-		cl->sess.skillpoints[i]      = pr_data.skillpoints[i];
-		cl->sess.startskillpoints[i] = pr_data.skillpoints[i];
-		cl->sess.startxptotal       += pr_data.skillpoints[i];
+		cl->sess.skillpoints[i] = 0;
+	}
+
+	// reset skills and starting points for correct debriefing display
+	for (i = 0; i < SK_NUM_SKILLS; i++)
+	{
+		cl->sess.skill[i]            = 0;
+		cl->sess.startskillpoints[i] = 0;
 	}
 }
 
 /**
  * @brief Sets or updates prestige and timestamp for client
  *         Called on ClientDisconnect and on G_LogExit before intermissionQueued
+ *         The query is queued, the session data is copied. A collected prestige
+ *         is applied to the session once the current streak was read.
  * @param[in] cl
+ * @param[in] streakUp
  */
 void G_SetClientPrestige(gclient_t *cl, qboolean streakUp)
 {
 	char      userinfo[MAX_INFO_STRING];
-	char      *guid;
 	int       clientNum, i, j, skillMax, cnt = 0;
-	prData_t  pr_data;
+	prJob_t   job;
 	gentity_t *ent;
 	qboolean  hasMapXPs = qfalse;
 
@@ -229,9 +355,10 @@ void G_SetClientPrestige(gclient_t *cl, qboolean streakUp)
 
 	// retrieve guid
 	trap_GetUserinfo(clientNum, userinfo, sizeof(userinfo));
-	guid = Info_ValueForKey(userinfo, "cl_guid");
 
-	pr_data.guid = (const unsigned char *)guid;
+	Com_Memset(&job, 0, sizeof(job));
+	job.clientNum = clientNum;
+	Q_strncpyz(job.guid, Info_ValueForKey(userinfo, "cl_guid"), sizeof(job.guid));
 
 	// count the number of maxed out skills
 	for (i = 0; i < SK_NUM_SKILLS; i++)
@@ -254,17 +381,7 @@ void G_SetClientPrestige(gclient_t *cl, qboolean streakUp)
 		}
 	}
 
-	// retrieve current streak or assign default values
-	if (G_ReadPrestige(&pr_data))
-	{
-		return;
-	}
-
-	// increase streak if all skills are maxed out
-	if (cnt >= SK_NUM_SKILLS && streakUp)
-	{
-		pr_data.streak += 1;
-	}
+	job.streakUp = (cnt >= SK_NUM_SKILLS && streakUp) ? qtrue : qfalse;
 
 	// prestige button clicked in intermission
 	if (!level.intermissionQueued && level.intermissiontime)
@@ -274,31 +391,23 @@ void G_SetClientPrestige(gclient_t *cl, qboolean streakUp)
 			return;
 		}
 
-		// increase prestige and reset skill points
-		cl->sess.prestige = cl->sess.prestige + 1;
-
-		for (i = 0; i < SK_NUM_SKILLS; i++)
-		{
-			cl->sess.skillpoints[i] = 0;
-		}
-
-		// reset skills and starting points for correct debriefing display
-		for (i = 0; i < SK_NUM_SKILLS; i++)
-		{
-			cl->sess.skill[i]            = 0;
-			cl->sess.startskillpoints[i] = 0;
-		}
+		// increase prestige and reset skill points, the session follows in
+		// G_SetClientPrestigeDone once the current streak was read
+		job.pr_data.prestige = cl->sess.prestige + 1;
 
 		// reset streak
-		pr_data.streak = 0;
+		job.resetStreak = qtrue;
+
+		G_DB_QueueJob("prestige set", G_SetClientPrestigeJob, G_SetClientPrestigeDone, &job, sizeof(job));
+		return;
 	}
 
 	// assign match data
-	pr_data.prestige = cl->sess.prestige;
+	job.pr_data.prestige = cl->sess.prestige;
 
 	for (i = 0; i < SK_NUM_SKILLS; i++)
 	{
-		pr_data.skillpoints[i] = (int)cl->sess.skillpoints[i];
+		job.pr_data.skillpoints[i] = (int)cl->sess.skillpoints[i];
 
 		// check for new points this map
 		if (!hasMapXPs && (cl->sess.skillpoints[i] - cl->sess.startskillpoints[i]) != 0.f) // Skillpoints can be negative
@@ -314,10 +423,7 @@ void G_SetClientPrestige(gclient_t *cl, qboolean streakUp)
 	}
 
 	// save or update prestige
-	if (G_WritePrestige(&pr_data))
-	{
-		return;
-	}
+	G_DB_QueueJob("prestige set", G_SetClientPrestigeJob, NULL, &job, sizeof(job));
 }
 
 /**
@@ -328,28 +434,27 @@ void G_SetClientPrestige(gclient_t *cl, qboolean streakUp)
 int G_ReadPrestige(prData_t *pr_data)
 {
 	int          result, i;
-	char         *err_msg = NULL;
-	char         *sql;
 	sqlite3_stmt *sqlstmt;
 
 	if (!level.database.initialized)
 	{
-		G_Printf("G_ReadPrestige: access to non-initialized database\n");
+		G_DB_Printf("G_ReadPrestige: access to non-initialized database\n");
 		return 1;
 	}
 
-	sql = va(PRUSERS_SQLWRAP_SELECT, pr_data->guid);
-
-	result = sqlite3_prepare(level.database.db, sql, strlen(sql), &sqlstmt, NULL);
+	sqlstmt = G_DB_Statement(PRUSERS_SQLWRAP_SELECT);
 
-	if (result != SQLITE_OK)
+	if (!sqlstmt)
 	{
-		G_Printf("G_ReadPrestige: sqlite3_prepare failed: %s\n", err_msg);
-		sqlite3_free(err_msg);
 		return 1;
 	}
 
-	result = sqlite3_step(sqlstmt);
+	result = sqlite3_bind_text(sqlstmt, 1, (const char *)pr_data->guid, -1, SQLITE_STATIC);
+
+	if (result == SQLITE_OK)
+	{
+		result = sqlite3_step(sqlstmt);
+	}
 
 	if (result == SQLITE_ROW)
 	{
@@ -362,38 +467,26 @@ int G_ReadPrestige(prData_t *pr_data)
 			pr_data->skillpoints[i] = sqlite3_column_int(sqlstmt, i + 3);
 		}
 	}
-	else
+	else if (result == SQLITE_DONE)
 	{
-		// no entry found or other failure
-		if (result == SQLITE_DONE)
-		{
-			// assign default values
-			pr_data->prestige = 0;
-			pr_data->streak   = 0;
+		// no entry found, assign default values
+		pr_data->prestige = 0;
+		pr_data->streak   = 0;
 
-			for (i = 0; i < SK_NUM_SKILLS; i++)
-			{
-				pr_data->skillpoints[i] = 0;
-			}
-		}
-		else
+		for (i = 0; i < SK_NUM_SKILLS; i++)
 		{
-			sqlite3_finalize(sqlstmt);
-
-			G_Printf("G_ReadPrestige: sqlite3_step failed: %s\n", err_msg);
-			sqlite3_free(err_msg);
-			return 1;
+			pr_data->skillpoints[i] = 0;
 		}
 	}
-
-	result = sqlite3_finalize(sqlstmt);
-
-	if (result != SQLITE_OK)
+	else
 	{
-		G_Printf("G_ReadPrestige: sqlite3_finalize failed\n");
+		G_DB_Printf("G_ReadPrestige: sqlite3_step failed: %s\n", sqlite3_errmsg(level.database.db));
+		G_DB_ReleaseStatement(sqlstmt);
 		return 1;
 	}
 
+	G_DB_ReleaseStatement(sqlstmt);
+
 	return 0;
 }
 
@@ -404,85 +497,53 @@ int G_ReadPrestige(prData_t *pr_data)
  */
 int G_WritePrestige(prData_t *pr_data)
 {
-	int          result;
-	char         *err_msg = NULL;
-	char         *sql;
+	int          result, i;
 	sqlite3_stmt *sqlstmt;
 
 	if (!level.database.initialized)
 	{
-		G_Printf("G_WritePrestige: access to non-initialized database\n");
+		G_DB_Printf("G_WritePrestige: access to non-initialized database\n");
 		return 1;
 	}
 
-	sql = va(PRUSERS_SQLWRAP_SELECT, pr_data->guid);
+	sqlstmt = G_DB_Statement(PRUSERS_SQLWRAP_UPSERT);
 
-	result = sqlite3_prepare(level.database.db, sql, strlen(sql), &sqlstmt, NULL);
-
-	if (result != SQLITE_OK)
+	if (!sqlstmt)
 	{
-		G_Printf("G_WritePrestige: sqlite3_prepare failed: %s\n", err_msg);
-		sqlite3_free(err_msg);
 		return 1;
 	}
 
-	result = sqlite3_step(sqlstmt);
+	result = sqlite3_bind_text(sqlstmt, 1, (const char *)pr_data->guid, -1, SQLITE_STATIC);
 
-	if (result == SQLITE_DONE)
+	if (result == SQLITE_OK)
 	{
-		sql = va(PRUSERS_SQLWRAP_INSERT,
-		         pr_data->guid,
-		         pr_data->prestige,
-		         pr_data->streak,
-		         pr_data->skillpoints[0],
-		         pr_data->skillpoints[1],
-		         pr_data->skillpoints[2],
-		         pr_data->skillpoints[3],
-		         pr_data->skillpoints[4],
-		         pr_data->skillpoints[5],
-		         pr_data->skillpoints[6]);
-
-		result = sqlite3_exec(level.database.db, sql, NULL, NULL, &err_msg);
-
-		if (result != SQLITE_OK)
-		{
-			G_Printf("G_WritePrestige: sqlite3_exec:INSERT failed: %s\n", err_msg);
-			sqlite3_free(err_msg);
-			return 1;
-		}
+		result = sqlite3_bind_int(sqlstmt, 2, pr_data->prestige);
 	}
-	else
-	{
-		sql = va(PRUSERS_SQLWRAP_UPDATE,
-		         pr_data->prestige,
-		         pr_data->streak,
-		         (int)pr_data->skillpoints[0],
-		         (int)pr_data->skillpoints[1],
-		         (int)pr_data->skillpoints[2],
-		         (int)pr_data->skillpoints[3],
-		         (int)pr_data->skillpoints[4],
-		         (int)pr_data->skillpoints[5],
-		         (int)pr_data->skillpoints[6],
-		         pr_data->guid);
 
-		result = sqlite3_exec(level.database.db, sql, NULL, NULL, &err_msg);
+	if (result == SQLITE_OK)
+	{
+		result = sqlite3_bind_int(sqlstmt, 3, pr_data->streak);
+	}
 
-		if (result != SQLITE_OK)
-		{
-			G_Printf("G_WritePrestige: sqlite3_exec:UPDATE failed: %s\n", err_msg);
-			sqlite3_free(err_msg);
-			return 1;
-		}
+	for (i = 0; i < SK_NUM_SKILLS && result == SQLITE_OK; i++)
+	{
+		result = sqlite3_bind_int(sqlstmt, i + 4, pr_data->skillpoints[i]);
 	}
 
-	result = sqlite3_finalize(sqlstmt);
+	if (result == SQLITE_OK)
+	{
+		result = sqlite3_step(sqlstmt);
+	}
 
-	if (result != SQLITE_OK)
+	if (result != SQLITE_DONE)
 	{
-		G_Printf("G_WritePrestige: sqlite3_finalize failed\n");
+		G_DB_Printf("G_WritePrestige: UPSERT failed: %s\n", sqlite3_errmsg(level.database.db));
+		G_DB_ReleaseStatement(sqlstmt);
 		return 1;
 	}
 
+	G_DB_ReleaseStatement(sqlstmt);
+
 	return 0;
 }
 
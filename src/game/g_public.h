@@ -267,7 +267,9 @@ typedef enum
 	///< engine extensions padding
 	G_TRAP_GETVALUE = COM_TRAP_GETVALUE,
 
-	G_DEMOSUPPORT
+	G_DEMOSUPPORT,
+
+	G_CVAR_CHANGES     ///< ( int *sequence, int *handles, int maxHandles );
 
 } gameImport_t;
 
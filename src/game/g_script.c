@@ -181,6 +181,39 @@ static g_script_event_define_t gScriptEvents[] =
 	{ NULL,          NULL,                            00               }
 };
 
+/**
+ * @var gScriptKeywords
+ * @brief Names of the scriptKeyword_t values
+ */
+static const char *gScriptKeywords[SCRIPT_KW_MAX] =
+{
+	"self",
+	"global",
+	"player",
+	"activator",
+	"random",
+	"inc",
+	"set",
+	"bitset",
+	"bitreset",
+	"abort_if_less_than",
+	"abort_if_greater_than",
+	"abort_if_not_equal",
+	"abort_if_not_equals",
+	"abort_if_equal",
+	"abort_if_bitset",
+	"abort_if_not_bitset",
+	"trigger_if_equal",
+	"wait_while_equal",
+};
+
+#define SCRIPT_STRING_HASH_SIZE 4096    ///< power of two
+#define SCRIPT_MAX_OPERANDS     64      ///< actions with more tokens aren't compiled and parse their params
+
+static char                  *scriptStrings[SCRIPT_STRING_HASH_SIZE]; ///< interned operand strings of the current map
+static int                   scriptEntRefGeneration = 1;
+static g_script_stack_item_t *scriptCurrentItem;                      ///< instruction being executed
+
 /**
  * @brief G_Script_EventMatch_StringEqual
  * @param[in] event
@@ -262,6 +295,300 @@ g_script_stack_action_t *G_Script_ActionForString(const char *string)
 	return NULL;
 }
 
+/**
+ * @brief G_Script_KeywordForString
+ * @param[in] string
+ * @return The keyword, SCRIPT_KW_NONE for any other word
+ */
+scriptKeyword_t G_Script_KeywordForString(const char *string)
+{
+	int i;
+
+	for (i = 0; i < SCRIPT_KW_MAX; i++)
+	{
+		if (!Q_stricmp(string, gScriptKeywords[i]))
+		{
+			return (scriptKeyword_t)i;
+		}
+	}
+
+	return SCRIPT_KW_NONE;
+}
+
+/**
+ * @brief Returns a copy of the string that is shared by all script operands with the same text
+ * @param[in] string
+ * @return
+ */
+static char *G_Script_InternString(const char *string)
+{
+	unsigned int hash = (unsigned int)BG_StringHashValue_Lwr(string);
+	char         **slot;
+	char         *copy;
+	int          i;
+
+	for (i = 0; i < SCRIPT_STRING_HASH_SIZE; i++)
+	{
+		slot = &scriptStrings[(hash + i) & (SCRIPT_STRING_HASH_SIZE - 1)];
+
+		if (!*slot)
+		{
+			break;
+		}
+
+		if (!strcmp(*slot, string))
+		{
+			return *slot;
+		}
+	}
+
+	copy = G_Alloc(strlen(string) + 1);
+	strcpy(copy, string);
+
+	// a full table just doesn't share any more strings
+	if (i < SCRIPT_STRING_HASH_SIZE)
+	{
+		*slot = copy;
+	}
+
+	return copy;
+}
+
+/**
+ * @brief G_Script_InternedStrings
+ * @return Number of strings shared by the operands of the current map
+ */
+static int G_Script_InternedStrings(void)
+{
+	int i, count = 0;
+
+	for (i = 0; i < SCRIPT_STRING_HASH_SIZE; i++)
+	{
+		if (scriptStrings[i])
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/**
+ * @brief Splits the params of an action into operands the same way the action tokenizes them,
+ * and gives actions refering to entities by name a cache for them
+ * @param[in,out] item
+ */
+static void G_Script_CompileAction(g_script_stack_item_t *item)
+{
+	g_script_operand_t operands[SCRIPT_MAX_OPERANDS];
+	g_script_operand_t *op;
+	char               *pString = item->params, *token;
+	int                numOperands = 0;
+	qboolean           entRef;
+
+	item->numOperands = 0;
+	item->operands    = NULL;
+	item->entRef      = NULL;
+
+	if (!pString)
+	{
+		return;
+	}
+
+	while (1)
+	{
+		token = COM_ParseExt(&pString, qfalse);
+		if (!token[0])
+		{
+			break;
+		}
+
+		if (numOperands == SCRIPT_MAX_OPERANDS)
+		{
+			return;
+		}
+
+		op             = &operands[numOperands++];
+		op->string     = G_Script_InternString(token);
+		op->isNumber   = Q_isanumber(token);
+		op->intValue   = Q_atoi(token);
+		op->floatValue = Q_atof(token);
+		op->keyword    = G_Script_KeywordForString(token);
+	}
+
+	if (!numOperands)
+	{
+		return;
+	}
+
+	item->numOperands = numOperands;
+	item->operands    = G_Alloc(numOperands * sizeof(g_script_operand_t));
+	Com_Memcpy(item->operands, operands, numOperands * sizeof(g_script_operand_t));
+
+	switch (item->action->hash)
+	{
+	case ALERTENTITY_HASH:
+		entRef = qtrue;
+		break;
+	case TRIGGER_HASH:
+		entRef = operands[0].keyword < SCRIPT_KW_SELF || operands[0].keyword > SCRIPT_KW_ACTIVATOR;
+		break;
+	case ACCUM_HASH:
+	case GLOBALACCUM_HASH:
+		entRef = numOperands > 1 && operands[1].keyword == SCRIPT_KW_TRIGGER_IF_EQUAL;
+		break;
+	default:
+		entRef = qfalse;
+		break;
+	}
+
+	if (entRef)
+	{
+		item->entRef             = G_Alloc(sizeof(g_script_entref_t));
+		item->entRef->generation = 0;
+		item->entRef->hash       = 0;
+		item->entRef->count      = 0;
+	}
+}
+
+/**
+ * @brief G_Script_Operands
+ * @param[in] params Params the action was called with
+ * @param[out] numOperands
+ * @return The compiled params if the action is run by the script, NULL if it was called
+ * from elsewhere and has to parse its params.
+ */
+const g_script_operand_t *G_Script_Operands(const char *params, int *numOperands)
+{
+	if (!params || !scriptCurrentItem || scriptCurrentItem->params != params)
+	{
+		*numOperands = 0;
+		return NULL;
+	}
+
+	*numOperands = scriptCurrentItem->numOperands;
+	return scriptCurrentItem->operands;
+}
+
+/**
+ * @brief Marks the cached entity references of all actions as outdated,
+ * must be called whenever an entity gets or loses a targetname or scriptname.
+ */
+void G_Script_InvalidateEntityRefs(void)
+{
+	scriptEntRefGeneration++;
+}
+
+/**
+ * @brief G_Script_EntityRefMatches
+ * @param[in] ent
+ * @param[in] fieldofs
+ * @param[in] match
+ * @param[in] hash
+ * @return
+ */
+static qboolean G_Script_EntityRefMatches(gentity_t *ent, size_t fieldofs, const char *match, int hash)
+{
+	char *s;
+
+	if (!ent->inuse)
+	{
+		return qfalse;
+	}
+
+	s = *(char **)((byte *)ent + fieldofs);
+	if (!s)
+	{
+		return qfalse;
+	}
+
+	if (fieldofs == FOFS(targetname) && ent->targetnamehash != hash)
+	{
+		return qfalse;
+	}
+
+	return !Q_stricmp(s, match);
+}
+
+/**
+ * @brief Finds the same entities as G_Find() (or G_FindByTargetnameFast() for targetnames),
+ * looking only at the entities cached for the running action.
+ * @param[in] params Params the action was called with
+ * @param[in] from
+ * @param[in] fieldofs
+ * @param[in] match
+ * @return
+ */
+gentity_t *G_Script_FindEntityRef(const char *params, gentity_t *from, size_t fieldofs, const char *match)
+{
+	g_script_entref_t *ref = NULL;
+	gentity_t         *ent;
+	int               i, start;
+
+	if (params && scriptCurrentItem && scriptCurrentItem->params == params)
+	{
+		ref = scriptCurrentItem->entRef;
+	}
+
+	if (!ref)
+	{
+		if (fieldofs == FOFS(targetname))
+		{
+			return G_FindByTargetnameFast(from, match, BG_StringHashValue(match));
+		}
+		return G_Find(from, fieldofs, match);
+	}
+
+	if (ref->generation != scriptEntRefGeneration)
+	{
+		ref->generation = scriptEntRefGeneration;
+		ref->hash       = BG_StringHashValue(match);
+		ref->count      = 0;
+
+		for (i = 0, ent = g_entities; i < level.num_entities; i++, ent++)
+		{
+			if (!G_Script_EntityRefMatches(ent, fieldofs, match, ref->hash))
+			{
+				continue;
+			}
+
+			if (ref->count == G_MAX_SCRIPT_ENTREFS)
+			{
+				ref->count = -1;
+				break;
+			}
+			ref->entityNums[ref->count++] = i;
+		}
+	}
+
+	if (ref->count < 0)
+	{
+		if (fieldofs == FOFS(targetname))
+		{
+			return G_FindByTargetnameFast(from, match, ref->hash);
+		}
+		return G_Find(from, fieldofs, match);
+	}
+
+	start = from ? (int)(from - g_entities) : -1;
+
+	for (i = 0; i < ref->count; i++)
+	{
+		if (ref->entityNums[i] <= start)
+		{
+			continue;
+		}
+
+		ent = &g_entities[ref->entityNums[i]];
+		if (G_Script_EntityRefMatches(ent, fieldofs, match, ref->hash))
+		{
+			return ent;
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * @brief Loads the script for the current level into the buffer
  */
@@ -323,6 +650,10 @@ void G_Script_ScriptLoad(void)
 	// make sure we clear out the temporary scriptname
 	trap_Cvar_Set("g_scriptName", "");
 
+	// the strings were allocated in the memory of the previous map
+	Com_Memset(scriptStrings, 0, sizeof(scriptStrings));
+	scriptCurrentItem = NULL;
+
 	if (len < 0)
 	{
 		return;
@@ -349,6 +680,7 @@ void G_Script_ScriptParse(gentity_t *ent)
 	qboolean                inScript;
 	int                     eventNum;
 	g_script_event_t        events[G_MAX_SCRIPT_STACK_ITEMS];
+	g_script_stack_item_t   items[G_MAX_SCRIPT_STACK_ITEMS];
 	unsigned int            numEventItems;
 	g_script_event_t        *curEvent;
 	char                    params[MAX_INFO_STRING]; // was MAX_QPATH some of our multiplayer script commands have longer parameters
@@ -442,8 +774,9 @@ void G_Script_ScriptParse(gentity_t *ent)
 				G_Error("G_Script_ScriptParse(), Error (line %d): G_MAX_SCRIPT_STACK_ITEMS reached (%d)\n", COM_GetCurrentParseLine(), G_MAX_SCRIPT_STACK_ITEMS);
 			}
 
-			curEvent           = &events[numEventItems];
-			curEvent->eventNum = eventNum;
+			curEvent              = &events[numEventItems];
+			curEvent->eventNum    = eventNum;
+			curEvent->stack.items = items;
 			Com_Memset(params, 0, sizeof(params));
 
 			// parse any event params before the start of this event's actions
@@ -484,6 +817,7 @@ void G_Script_ScriptParse(gentity_t *ent)
 				}
 
 				curEvent->stack.items[curEvent->stack.numItems].action = action;
+				curEvent->stack.items[curEvent->stack.numItems].params = NULL;
 
 				Com_Memset(params, 0, sizeof(params));
 
@@ -584,6 +918,22 @@ void G_Script_ScriptParse(gentity_t *ent)
 				}
 			}
 
+			// compile the actions into the event's own instruction stream
+			if (curEvent->stack.numItems)
+			{
+				curEvent->stack.items = G_Alloc(sizeof(g_script_stack_item_t) * curEvent->stack.numItems);
+				Com_Memcpy(curEvent->stack.items, items, sizeof(g_script_stack_item_t) * curEvent->stack.numItems);
+
+				for (i = 0; i < curEvent->stack.numItems; i++)
+				{
+					G_Script_CompileAction(&curEvent->stack.items[i]);
+				}
+			}
+			else
+			{
+				curEvent->stack.items = NULL;
+			}
+
 			numEventItems++;
 		}
 		else     // skip this character completely
@@ -793,8 +1143,10 @@ void G_Script_ScriptEvent(gentity_t *ent, const char *eventStr, const char *para
  */
 qboolean G_Script_ScriptRun(gentity_t *ent)
 {
-	g_script_stack_t *stack;
-	int              oldScriptId;
+	g_script_stack_t      *stack;
+	g_script_stack_item_t *item, *prevItem;
+	int                   oldScriptId;
+	qboolean              finished;
 
 	if (!ent->scriptEvents)
 	{
@@ -839,8 +1191,16 @@ qboolean G_Script_ScriptRun(gentity_t *ent)
 
 	while (ent->scriptStatus.scriptStackHead < stack->numItems)
 	{
+		item        = &stack->items[ent->scriptStatus.scriptStackHead];
 		oldScriptId = ent->scriptStatus.scriptId;
-		if (!stack->items[ent->scriptStatus.scriptStackHead].action->actionFunc(ent, stack->items[ent->scriptStatus.scriptStackHead].params))
+
+		// actions may run other scripts, restore the instruction they were called for
+		prevItem          = scriptCurrentItem;
+		scriptCurrentItem = item;
+		finished          = item->action->actionFunc(ent, item->params);
+		scriptCurrentItem = prevItem;
+
+		if (!finished)
 		{
 			ent->scriptStatus.scriptFlags &= ~SCFL_FIRST_CALL;
 			return qfalse;
@@ -872,6 +1232,87 @@ qboolean G_Script_ScriptRun(gentity_t *ent)
 	return qtrue;
 }
 
+/**
+ * @brief Prints the compiled scripts of the entities whose scriptname matches the argument,
+ * or g_scriptDebugTarget without one, in the format of the g_scriptDebug output.
+ * Numbers are printed in cyan, keywords in yellow, strings in green, actions with
+ * cached entity references are marked with a '*'.
+ * @details syntax: script_disasm [scriptname]
+ */
+void G_Script_Disassemble_f(void)
+{
+	char                  target[MAX_QPATH];
+	char                  line[MAX_STRING_CHARS];
+	gentity_t             *ent;
+	g_script_event_t      *event;
+	g_script_stack_item_t *item;
+	g_script_operand_t    *op;
+	int                   i, j, k, l, count = 0;
+
+	trap_Argv(1, target, sizeof(target));
+	if (!target[0])
+	{
+		Q_strncpyz(target, g_scriptDebugTarget.string, sizeof(target));
+	}
+
+	for (i = 0, ent = g_entities; i < level.num_entities; i++, ent++)
+	{
+		if (!ent->inuse || !ent->scriptEvents || !ent->scriptName)
+		{
+			continue;
+		}
+
+		if (target[0] && !G_MatchString(target, ent->scriptName, qfalse))
+		{
+			continue;
+		}
+
+		count++;
+
+		for (j = 0; j < ent->numScriptEvents; j++)
+		{
+			event = &ent->scriptEvents[j];
+
+			G_Printf("^7%i : (^5%s^7) ^9GScript Event: ^5%s %s\n", i, ent->scriptName, gScriptEvents[event->eventNum].eventStr, event->params ? event->params : "");
+
+			for (k = 0; k < event->stack.numItems; k++)
+			{
+				item = &event->stack.items[k];
+
+				Com_sprintf(line, sizeof(line), "^7%4i%c ^9GScript Action: ^d%s", k, item->entRef ? '*' : ':', item->action->actionString);
+
+				for (l = 0; l < item->numOperands; l++)
+				{
+					op = &item->operands[l];
+
+					if (op->isNumber)
+					{
+						Q_strcat(line, sizeof(line), va(" ^5%s", op->string));
+					}
+					else if (op->keyword != SCRIPT_KW_NONE)
+					{
+						Q_strcat(line, sizeof(line), va(" ^3%s", op->string));
+					}
+					else
+					{
+						Q_strcat(line, sizeof(line), va(" ^2\"%s\"", op->string));
+					}
+				}
+
+				// not compiled, show what the action parses
+				if (!item->numOperands && item->params)
+				{
+					Q_strcat(line, sizeof(line), va(" ^7%s", item->params));
+				}
+
+				G_Printf("%s\n", line);
+			}
+		}
+	}
+
+	G_Printf("^7%i scripted entities, %i interned strings\n", count, G_Script_InternedStrings());
+}
+
 //================================================================================
 // Script Entities
 
@@ -1402,6 +1843,8 @@ void SP_script_camera(gentity_t *ent)
 void SP_script_multiplayer(gentity_t *ent)
 {
 	ent->scriptName = "game_manager";
+	G_TouchEntityIndex(ent);
+	G_Script_InvalidateEntityRefs();
 
 	// broadcasting this to clients now, should be cheaper in bandwidth for sending landmine info
 	ent->s.eType   = ET_GAMEMANAGER;
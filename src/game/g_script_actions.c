@@ -1650,9 +1650,11 @@ qboolean G_ScriptAction_GotoMarker(gentity_t *ent, char *params)
  */
 qboolean G_ScriptAction_Wait(gentity_t *ent, char *params)
 {
-	char *pString = params, *token;
-	int  duration;
-	int  frametime = 1000 / sv_fps.integer;
+	const g_script_operand_t *op;
+	char                     *pString = params, *token;
+	int                      duration = 0, min = 0, max = 0, numOperands;
+	int                      frametime = 1000 / sv_fps.integer;
+	qboolean                 isRandom;
 
 	if (level.suddenDeath)
 	{
@@ -1660,32 +1662,55 @@ qboolean G_ScriptAction_Wait(gentity_t *ent, char *params)
 		return qtrue;
 	}
 
-	// get the duration
-	token = COM_ParseExt(&pString, qfalse);
-	if (!token[0])
+	op = G_Script_Operands(params, &numOperands);
+	if (op && (op[0].keyword != SCRIPT_KW_RANDOM || numOperands >= 3))
 	{
-		G_Error("G_ScriptAction_Wait: wait must have a duration\n");
+		isRandom = (op[0].keyword == SCRIPT_KW_RANDOM);
+		if (isRandom)
+		{
+			min = op[1].intValue;
+			max = op[2].intValue;
+		}
+		else
+		{
+			duration = op[0].intValue;
+		}
 	}
-
-	// adding random wait ability
-	if (!Q_stricmp(token, "random"))
+	else
 	{
-		int min, max;
-
+		// get the duration
 		token = COM_ParseExt(&pString, qfalse);
 		if (!token[0])
 		{
-			G_Error("G_ScriptAction_Wait: wait random must have a min duration\n");
+			G_Error("G_ScriptAction_Wait: wait must have a duration\n");
 		}
-		min = Q_atoi(token);
 
-		token = COM_ParseExt(&pString, qfalse);
-		if (!token[0])
+		// adding random wait ability
+		isRandom = !Q_stricmp(token, "random");
+		if (isRandom)
 		{
-			G_Error("G_ScriptAction_Wait: wait random must have a max duration\n");
+			token = COM_ParseExt(&pString, qfalse);
+			if (!token[0])
+			{
+				G_Error("G_ScriptAction_Wait: wait random must have a min duration\n");
+			}
+			min = Q_atoi(token);
+
+			token = COM_ParseExt(&pString, qfalse);
+			if (!token[0])
+			{
+				G_Error("G_ScriptAction_Wait: wait random must have a max duration\n");
+			}
+			max = Q_atoi(token);
 		}
-		max = Q_atoi(token);
+		else
+		{
+			duration = Q_atoi(token);
+		}
+	}
 
+	if (isRandom)
+	{
 		// match wait time to sv_fps 20
 		if (sv_fps.integer > 20)
 		{
@@ -1706,8 +1731,6 @@ qboolean G_ScriptAction_Wait(gentity_t *ent, char *params)
 		return !(rand() % (int)((max - min) * 0.02f));
 	}
 
-	duration = Q_atoi(token);
-
 	// match wait time to sv_fps 20
 	if (sv_fps.integer > 20)
 	{
@@ -1726,27 +1749,44 @@ qboolean G_ScriptAction_Wait(gentity_t *ent, char *params)
  */
 qboolean G_ScriptAction_Trigger(gentity_t *ent, char *params)
 {
-	gentity_t *trent;
-	char      *pString = params, name[MAX_QPATH], trigger[MAX_QPATH], *token;
-	int       oldId, i;
-	qboolean  terminate, found;
+	const g_script_operand_t *op;
+	gentity_t                *trent;
+	char                     *pString = params, nameBuf[MAX_QPATH], triggerBuf[MAX_QPATH], *token;
+	const char               *name, *trigger;
+	int                      oldId, i, numOperands;
+	scriptKeyword_t          keyword;
+	qboolean                 terminate, found;
 
-	// get the cast name
-	token = COM_ParseExt(&pString, qfalse);
-	Q_strncpyz(name, token, sizeof(name));
-	if (!*name)
+	op = G_Script_Operands(params, &numOperands);
+	if (op && numOperands >= 2 && strlen(op[0].string) < MAX_QPATH && strlen(op[1].string) < MAX_QPATH)
 	{
-		G_Error("G_ScriptAction_Trigger: trigger must have a name and an identifier: %s\n", params);
+		name    = op[0].string;
+		trigger = op[1].string;
+		keyword = op[0].keyword;
 	}
-
-	token = COM_ParseExt(&pString, qfalse);
-	Q_strncpyz(trigger, token, sizeof(trigger));
-	if (!*trigger)
+	else
 	{
-		G_Error("G_ScriptAction_Trigger: trigger must have a name and an identifier: %s\n", params);
+		// get the cast name
+		token = COM_ParseExt(&pString, qfalse);
+		Q_strncpyz(nameBuf, token, sizeof(nameBuf));
+		if (!*nameBuf)
+		{
+			G_Error("G_ScriptAction_Trigger: trigger must have a name and an identifier: %s\n", params);
+		}
+
+		token = COM_ParseExt(&pString, qfalse);
+		Q_strncpyz(triggerBuf, token, sizeof(triggerBuf));
+		if (!*triggerBuf)
+		{
+			G_Error("G_ScriptAction_Trigger: trigger must have a name and an identifier: %s\n", params);
+		}
+
+		name    = nameBuf;
+		trigger = triggerBuf;
+		keyword = G_Script_KeywordForString(name);
 	}
 
-	if (!Q_stricmp(name, "self"))
+	if (keyword == SCRIPT_KW_SELF)
 	{
 		trent = ent;
 		oldId = trent->scriptStatus.scriptId;
@@ -1754,7 +1794,7 @@ qboolean G_ScriptAction_Trigger(gentity_t *ent, char *params)
 		// if the script changed, return false so we don't muck with it's variables
 		return ((trent != ent) || (oldId == trent->scriptStatus.scriptId));
 	}
-	else if (!Q_stricmp(name, "global"))
+	else if (keyword == SCRIPT_KW_GLOBAL)
 	{
 		terminate = qfalse;
 		found     = qfalse;
@@ -1796,7 +1836,7 @@ qboolean G_ScriptAction_Trigger(gentity_t *ent, char *params)
 			return qtrue;
 		}
 	}
-	else if (!Q_stricmp(name, "player"))
+	else if (keyword == SCRIPT_KW_PLAYER)
 	{
 		for (i = 0; i < MAX_CLIENTS; i++)
 		{
@@ -1808,7 +1848,7 @@ qboolean G_ScriptAction_Trigger(gentity_t *ent, char *params)
 		}
 		return qtrue;   // always true, as players aren't always there
 	}
-	else if (!Q_stricmp(name, "activator"))
+	else if (keyword == SCRIPT_KW_ACTIVATOR)
 	{
 		return qtrue;   // always true, as players aren't always there
 	}
@@ -1818,7 +1858,7 @@ qboolean G_ScriptAction_Trigger(gentity_t *ent, char *params)
 		found     = qfalse;
 		// for all entities/bots with this scriptName
 		trent = NULL;
-		while ((trent = G_Find(trent, FOFS(scriptName), name)))
+		while ((trent = G_Script_FindEntityRef(params, trent, FOFS(scriptName), name)))
 		{
 			found = qtrue;
 			if (!(trent->r.svFlags & SVF_BOT))
@@ -2243,18 +2283,16 @@ qboolean G_ScriptAction_AlertEntity(gentity_t *ent, char *params)
 {
 	gentity_t *alertent     = NULL;
 	qboolean  foundalertent = qfalse;
-	int       hash;
 
 	if (!params || !*params)
 	{
 		G_Error("G_ScriptAction_AlertEntity: alertentity without targetname\n");
 	}
-	hash = BG_StringHashValue(params);
 
 	// find this targetname
 	while (1)
 	{
-		alertent = G_FindByTargetnameFast(alertent, params, hash);
+		alertent = G_Script_FindEntityRef(params, alertent, FOFS(targetname), params);
 		if (!alertent)
 		{
 			if (!foundalertent)
@@ -2411,6 +2449,146 @@ qboolean G_ScriptAction_EnableSpeaker(gentity_t *ent, char *params)
 	return qtrue;
 }
 
+/**
+ * @brief Runs an accum or globalaccum command from the compiled operands of the action
+ * @param[in,out] ent
+ * @param[in,out] buffers Accum buffers the command works on
+ * @param[in] numBuffers
+ * @param[in] params
+ * @param[in] func Name of the action for messages
+ * @param[out] result Return value of the action
+ * @return qfalse if the action isn't compiled or the command needs the parsing path
+ * (set_to_dynamitecount and errors)
+ */
+static qboolean G_ScriptAction_AccumCompiled(gentity_t *ent, int *buffers, int numBuffers, char *params, const char *func, qboolean *result)
+{
+	const g_script_operand_t *op;
+	gentity_t                *trent;
+	int                      numOperands, bufferIndex, value, oldId;
+	qboolean                 terminate, found;
+
+	op = G_Script_Operands(params, &numOperands);
+	if (!op || numOperands < 3)
+	{
+		return qfalse;
+	}
+
+	bufferIndex = op[0].intValue;
+	if (bufferIndex < 0 || bufferIndex >= numBuffers)
+	{
+		return qfalse;
+	}
+
+	value   = op[2].intValue;
+	*result = qtrue;
+
+	switch (op[1].keyword)
+	{
+	case SCRIPT_KW_INC:
+		buffers[bufferIndex] += value;
+		break;
+	case SCRIPT_KW_ABORT_IF_LESS_THAN:
+		if (buffers[bufferIndex] < value)
+		{
+			// abort the current script
+			ent->scriptStatus.scriptStackHead = ent->scriptEvents[ent->scriptStatus.scriptEventIndex].stack.numItems;
+		}
+		break;
+	case SCRIPT_KW_ABORT_IF_GREATER_THAN:
+		if (buffers[bufferIndex] > value)
+		{
+			ent->scriptStatus.scriptStackHead = ent->scriptEvents[ent->scriptStatus.scriptEventIndex].stack.numItems;
+		}
+		break;
+	case SCRIPT_KW_ABORT_IF_NOT_EQUAL:
+	case SCRIPT_KW_ABORT_IF_NOT_EQUALS:
+		if (buffers[bufferIndex] != value)
+		{
+			ent->scriptStatus.scriptStackHead = ent->scriptEvents[ent->scriptStatus.scriptEventIndex].stack.numItems;
+		}
+		break;
+	case SCRIPT_KW_ABORT_IF_EQUAL:
+		if (buffers[bufferIndex] == value)
+		{
+			ent->scriptStatus.scriptStackHead = ent->scriptEvents[ent->scriptStatus.scriptEventIndex].stack.numItems;
+		}
+		break;
+	case SCRIPT_KW_BITSET:
+		buffers[bufferIndex] |= (1 << value);
+		break;
+	case SCRIPT_KW_BITRESET:
+		buffers[bufferIndex] &= ~(1 << value);
+		break;
+	case SCRIPT_KW_ABORT_IF_BITSET:
+		if (buffers[bufferIndex] & (1 << value))
+		{
+			ent->scriptStatus.scriptStackHead = ent->scriptEvents[ent->scriptStatus.scriptEventIndex].stack.numItems;
+		}
+		break;
+	case SCRIPT_KW_ABORT_IF_NOT_BITSET:
+		if (!(buffers[bufferIndex] & (1 << value)))
+		{
+			ent->scriptStatus.scriptStackHead = ent->scriptEvents[ent->scriptStatus.scriptEventIndex].stack.numItems;
+		}
+		break;
+	case SCRIPT_KW_SET:
+		buffers[bufferIndex] = value;
+		break;
+	case SCRIPT_KW_RANDOM:
+		if (value == 0)
+		{
+			return qfalse;
+		}
+		buffers[bufferIndex] = rand() % value;
+		break;
+	case SCRIPT_KW_TRIGGER_IF_EQUAL:
+		if (buffers[bufferIndex] != value)
+		{
+			break;
+		}
+		if (numOperands < 5 || strlen(op[3].string) >= MAX_QPATH || strlen(op[4].string) >= MAX_QPATH)
+		{
+			return qfalse;
+		}
+
+		terminate = qfalse;
+		found     = qfalse;
+		// for all entities/bots with this scriptName
+		trent = NULL;
+		while ((trent = G_Script_FindEntityRef(params, trent, FOFS(scriptName), op[3].string)))
+		{
+			found = qtrue;
+			oldId = trent->scriptStatus.scriptId;
+			G_Script_ScriptEvent(trent, "trigger", op[4].string);
+			// if the script changed, return false so we don't muck with it's variables
+			if ((trent == ent) && (oldId != trent->scriptStatus.scriptId))
+			{
+				terminate = qtrue;
+			}
+		}
+
+		if (terminate)
+		{
+			*result = qfalse;
+		}
+		else if (!found)
+		{
+			G_Printf("%s: trigger has unknown name: %s\n", func, op[4].string);
+		}
+		break;
+	case SCRIPT_KW_WAIT_WHILE_EQUAL:
+		if (buffers[bufferIndex] == value)
+		{
+			*result = qfalse;
+		}
+		break;
+	default:
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
 /**
  * @brief G_ScriptAction_Accum
  * @details syntax: accum \<buffer_index\> \<command\> \<paramater...\>
@@ -2437,8 +2615,14 @@ qboolean G_ScriptAction_EnableSpeaker(gentity_t *ent, char *params)
  */
 qboolean G_ScriptAction_Accum(gentity_t *ent, char *params)
 {
-	char *pString = params, *token, lastToken[MAX_QPATH], name[MAX_QPATH];
-	int  bufferIndex;
+	char     *pString = params, *token, lastToken[MAX_QPATH], name[MAX_QPATH];
+	int      bufferIndex;
+	qboolean result;
+
+	if (G_ScriptAction_AccumCompiled(ent, ent->scriptAccumBuffer, G_MAX_SCRIPT_ACCUM_BUFFERS, params, "G_ScriptAction_Accum", &result))
+	{
+		return result;
+	}
 
 	token = COM_ParseExt(&pString, qfalse);
 	if (!token[0])
@@ -2721,8 +2905,14 @@ qboolean G_ScriptAction_Accum(gentity_t *ent, char *params)
  */
 qboolean G_ScriptAction_GlobalAccum(gentity_t *ent, char *params)
 {
-	char *pString = params, *token, lastToken[MAX_QPATH], name[MAX_QPATH];
-	int  bufferIndex;
+	char     *pString = params, *token, lastToken[MAX_QPATH], name[MAX_QPATH];
+	int      bufferIndex;
+	qboolean result;
+
+	if (G_ScriptAction_AccumCompiled(ent, level.globalAccumBuffer, MAX_SCRIPT_ACCUM_BUFFERS, params, "G_ScriptAction_GlobalAccum", &result))
+	{
+		return result;
+	}
 
 	token = COM_ParseExt(&pString, qfalse);
 	if (!token[0])
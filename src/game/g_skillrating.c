@@ -36,22 +36,21 @@
 	                           "SELECT guid, mu, sigma, time_axis, time_allies FROM rating_match; " \
 	                           "SELECT mapname, win_axis, win_allies FROM rating_maps;"
 #define SRMATCH_SQLWRAP_DELETE "DELETE FROM rating_match;"
-#define SRMATCH_SQLWRAP_SELECT "SELECT * FROM rating_match WHERE guid = '%s';"
-#define SRMATCH_SQLWRAP_INSERT "INSERT INTO rating_match " \
-	                           "(guid, mu, sigma, time_axis, time_allies) VALUES ('%s', '%f', '%f', '%i', '%i');"
-#define SRMATCH_SQLWRAP_UPDATE "UPDATE rating_match " \
-	                           "SET mu = '%f', sigma = '%f', time_axis = '%i', time_allies = '%i' WHERE guid = '%s';"
-#define SRUSERS_SQLWRAP_SELECT "SELECT * FROM rating_users WHERE guid = '%s';"
-#define SRUSERS_SQLWRAP_INSERT "INSERT INTO rating_users " \
-	                           "(guid, mu, sigma, created, updated) VALUES ('%s', '%f', '%f', CURRENT_TIMESTAMP, CURRENT_TIMESTAMP);"
-#define SRUSERS_SQLWRAP_UPDATE "UPDATE rating_users " \
-	                           "SET mu = '%f', sigma = '%f', updated = CURRENT_TIMESTAMP WHERE guid = '%s';"
+#define SRMATCH_SQLWRAP_SELECT "SELECT * FROM rating_match WHERE guid = ?1;"
+#define SRMATCH_SQLWRAP_UPSERT "INSERT INTO rating_match " \
+	                           "(guid, mu, sigma, time_axis, time_allies) VALUES (?1, ?2, ?3, ?4, ?5) " \
+	                           "ON CONFLICT (guid) DO UPDATE SET mu = excluded.mu, sigma = excluded.sigma, " \
+	                           "time_axis = excluded.time_axis, time_allies = excluded.time_allies;"
+#define SRUSERS_SQLWRAP_SELECT "SELECT * FROM rating_users WHERE guid = ?1;"
+#define SRUSERS_SQLWRAP_UPSERT "INSERT INTO rating_users " \
+	                           "(guid, mu, sigma, created, updated) VALUES (?1, ?2, ?3, CURRENT_TIMESTAMP, CURRENT_TIMESTAMP) " \
+	                           "ON CONFLICT (guid) DO UPDATE SET mu = excluded.mu, sigma = excluded.sigma, updated = excluded.updated;"
 #define SRMATCH_SQLWRAP_TABLE  "SELECT * FROM rating_match;"
 #define SRMAPS_SQLWRAP_SELECT  "SELECT * FROM rating_maps WHERE mapname = '%s';"
-#define SRMAPS_SQLWRAP_INSERT  "INSERT INTO rating_maps " \
-	                           "(win_axis, win_allies, mapname) VALUES ('%i', '%i', '%s');"
-#define SRMAPS_SQLWRAP_UPDATE  "UPDATE rating_maps " \
-	                           "SET win_axis = win_axis + '%i', win_allies = win_allies + '%i' WHERE mapname = '%s';"
+#define SRMAPS_SQLWRAP_UPSERT  "INSERT INTO rating_maps " \
+	                           "(mapname, win_axis, win_allies) VALUES (?1, ?2, ?3) " \
+	                           "ON CONFLICT (mapname) DO UPDATE SET win_axis = win_axis + excluded.win_axis, " \
+	                           "win_allies = win_allies + excluded.win_allies;"
 
 // MU      25            - mean
 // SIGMA   MU / 3        - standard deviation
@@ -190,146 +189,165 @@ int G_SkillRatingPrepareMatchRating(void)
 }
 
 /**
- * @brief Retrieve rating from the rating_match table
- * @param[in] sr_data
- * @return 0 if successful, 2 if data is not found, 1 otherwise.
+ * @struct srJob_t
+ * @brief Rating queued for the database thread
  */
-int G_SkillRatingGetMatchRating(srData_t *sr_data)
+typedef struct
 {
-	int          result;
-	char         *err_msg = NULL;
-	char         *sql;
-	sqlite3_stmt *sqlstmt;
-	qboolean     datafound = qtrue;
+	int clientNum;
+	char guid[MAX_GUID_LENGTH + 1];
+	srData_t sr_data;
+	qboolean match;                     ///< rating_match table, or rating_users only
+	qboolean resetTime;                 ///< get: clear time played
+	qboolean keepOld;                   ///< get: keep the rating delta of the map
+	int result;
+} srJob_t;
 
-	if (!level.database.initialized)
+/**
+ * @brief Looks up a guid with a cached select statement
+ * @param[in] sql
+ * @param[in] guid
+ * @param[out] sqlstmt The statement, to be released by the caller
+ * @return SQLITE_ROW, SQLITE_DONE or an error code
+ */
+static int G_SkillRatingSelect(const char *sql, const unsigned char *guid, sqlite3_stmt **sqlstmt)
+{
+	int result;
+
+	*sqlstmt = G_DB_Statement(sql);
+
+	if (!*sqlstmt)
 	{
-		G_Printf("G_SkillRatingGetMatchRating: access to non-initialized database\n");
-		return 1;
+		return SQLITE_ERROR;
 	}
 
-	sql = va(SRMATCH_SQLWRAP_SELECT, sr_data->guid);
-
-	result = sqlite3_prepare(level.database.db, sql, strlen(sql), &sqlstmt, NULL);
+	result = sqlite3_bind_text(*sqlstmt, 1, (const char *)guid, -1, SQLITE_STATIC);
 
 	if (result != SQLITE_OK)
 	{
-		G_Printf("G_SkillRatingGetMatchRating: sqlite3_prepare failed: %s\n", err_msg);
-		sqlite3_free(err_msg);
-		return 1;
+		return result;
 	}
 
-	result = sqlite3_step(sqlstmt);
+	return sqlite3_step(*sqlstmt);
+}
 
-	if (result == SQLITE_ROW)
+/**
+ * @brief Inserts or updates the rating of a guid with a cached statement
+ * @param[in] sql
+ * @param[in] sr_data
+ * @param[in] withTime Also bind time_axis and time_allies
+ * @return SQLITE_DONE or an error code
+ */
+static int G_SkillRatingWrite(const char *sql, srData_t *sr_data, qboolean withTime)
+{
+	int          result;
+	sqlite3_stmt *sqlstmt = G_DB_Statement(sql);
+
+	if (!sqlstmt)
 	{
-		// assign match data
-		sr_data->mu          = sqlite3_column_double(sqlstmt, 1);
-		sr_data->sigma       = sqlite3_column_double(sqlstmt, 2);
-		sr_data->time_axis   = sqlite3_column_int(sqlstmt, 3);
-		sr_data->time_allies = sqlite3_column_int(sqlstmt, 4);
+		return SQLITE_ERROR;
 	}
-	else
-	{
-		// no entry found (failsafe) or other failure
-		if (result == SQLITE_DONE)
-		{
-			// assign default values (failsafe)
-			sr_data->mu          = MU;
-			sr_data->sigma       = SIGMA;
-			sr_data->time_axis   = 0;
-			sr_data->time_allies = 0;
 
-			datafound = qfalse;
-		}
-		else
-		{
-			sqlite3_finalize(sqlstmt);
+	result = sqlite3_bind_text(sqlstmt, 1, (const char *)sr_data->guid, -1, SQLITE_STATIC);
 
-			G_Printf("G_SkillRatingGetMatchRating: sqlite3_step failed: %s\n", err_msg);
-			sqlite3_free(err_msg);
-			return 1;
-		}
+	if (result == SQLITE_OK)
+	{
+		result = sqlite3_bind_double(sqlstmt, 2, sr_data->mu);
 	}
 
-	result = sqlite3_finalize(sqlstmt);
+	if (result == SQLITE_OK)
+	{
+		result = sqlite3_bind_double(sqlstmt, 3, sr_data->sigma);
+	}
 
-	if (result != SQLITE_OK)
+	if (result == SQLITE_OK && withTime)
 	{
-		G_Printf("G_SkillRatingGetMatchRating: sqlite3_finalize failed\n");
-		return 1;
+		result = sqlite3_bind_int(sqlstmt, 4, sr_data->time_axis);
+
+		if (result == SQLITE_OK)
+		{
+			result = sqlite3_bind_int(sqlstmt, 5, sr_data->time_allies);
+		}
 	}
 
-	if (!datafound)
+	if (result == SQLITE_OK)
 	{
-		return 2;
+		result = sqlite3_step(sqlstmt);
 	}
-	return 0;
+
+	G_DB_ReleaseStatement(sqlstmt);
+
+	return result;
 }
 
 /**
- * @brief Sets or updates rating and time played in the rating_match table
+ * @brief Retrieve rating from the rating_match table
  * @param[in] sr_data
- * @return 0 if successful, 1 otherwise.
+ * @return 0 if successful, 2 if data is not found, 1 otherwise.
  */
-int G_SkillRatingSetMatchRating(srData_t *sr_data)
+int G_SkillRatingGetMatchRating(srData_t *sr_data)
 {
 	int          result;
-	char         *err_msg = NULL;
-	char         *sql;
 	sqlite3_stmt *sqlstmt;
 
 	if (!level.database.initialized)
 	{
-		G_Printf("G_SkillRatingSetMatchRating: access to non-initialized database\n");
+		G_DB_Printf("G_SkillRatingGetMatchRating: access to non-initialized database\n");
 		return 1;
 	}
 
-	sql = va(SRMATCH_SQLWRAP_SELECT, sr_data->guid);
+	result = G_SkillRatingSelect(SRMATCH_SQLWRAP_SELECT, sr_data->guid, &sqlstmt);
 
-	result = sqlite3_prepare(level.database.db, sql, strlen(sql), &sqlstmt, NULL);
-
-	if (result != SQLITE_OK)
+	if (result == SQLITE_ROW)
 	{
-		G_Printf("G_SkillRatingSetMatchRating: sqlite3_prepare failed: %s\n", err_msg);
-		sqlite3_free(err_msg);
-		return 1;
+		// assign match data
+		sr_data->mu          = sqlite3_column_double(sqlstmt, 1);
+		sr_data->sigma       = sqlite3_column_double(sqlstmt, 2);
+		sr_data->time_axis   = sqlite3_column_int(sqlstmt, 3);
+		sr_data->time_allies = sqlite3_column_int(sqlstmt, 4);
+	}
+	else if (result == SQLITE_DONE)
+	{
+		// no entry found, assign default values (failsafe)
+		sr_data->mu          = MU;
+		sr_data->sigma       = SIGMA;
+		sr_data->time_axis   = 0;
+		sr_data->time_allies = 0;
+	}
+	else
+	{
+		G_DB_Printf("G_SkillRatingGetMatchRating: sqlite3_step failed: %s\n", sqlite3_errmsg(level.database.db));
 	}
 
-	result = sqlite3_step(sqlstmt);
+	G_DB_ReleaseStatement(sqlstmt);
 
 	if (result == SQLITE_DONE)
 	{
-		sql = va(SRMATCH_SQLWRAP_INSERT, sr_data->guid, sr_data->mu, sr_data->sigma, sr_data->time_axis, sr_data->time_allies);
-
-		result = sqlite3_exec(level.database.db, sql, NULL, NULL, &err_msg);
-
-		if (result != SQLITE_OK)
-		{
-			G_Printf("G_SkillRatingSetMatchRating: sqlite3_exec:INSERT failed: %s\n", err_msg);
-			sqlite3_free(err_msg);
-			return 1;
-		}
+		return 2;
 	}
-	else
-	{
-		sql = va(SRMATCH_SQLWRAP_UPDATE, sr_data->mu, sr_data->sigma, sr_data->time_axis, sr_data->time_allies, sr_data->guid);
+	return result == SQLITE_ROW ? 0 : 1;
+}
 
-		result = sqlite3_exec(level.database.db, sql, NULL, NULL, &err_msg);
+/**
+ * @brief Sets or updates rating and time played in the rating_match table
+ * @param[in] sr_data
+ * @return 0 if successful, 1 otherwise.
+ */
+int G_SkillRatingSetMatchRating(srData_t *sr_data)
+{
+	int result;
 
-		if (result != SQLITE_OK)
-		{
-			G_Printf("G_SkillRatingSetMatchRating: sqlite3_exec:UPDATE failed: %s\n", err_msg);
-			sqlite3_free(err_msg);
-			return 1;
-		}
+	if (!level.database.initialized)
+	{
+		G_DB_Printf("G_SkillRatingSetMatchRating: access to non-initialized database\n");
+		return 1;
 	}
 
-	result = sqlite3_finalize(sqlstmt);
+	result = G_SkillRatingWrite(SRMATCH_SQLWRAP_UPSERT, sr_data, qtrue);
 
-	if (result != SQLITE_OK)
+	if (result != SQLITE_DONE)
 	{
-		G_Printf("G_SkillRatingSetMatchRating: sqlite3_finalize failed\n");
+		G_DB_Printf("G_SkillRatingSetMatchRating: UPSERT failed: %s\n", sqlite3_errmsg(level.database.db));
 		return 1;
 	}
 
@@ -344,28 +362,15 @@ int G_SkillRatingSetMatchRating(srData_t *sr_data)
 int G_SkillRatingGetUserRating(srData_t *sr_data)
 {
 	int          result;
-	char         *err_msg = NULL;
-	char         *sql;
 	sqlite3_stmt *sqlstmt;
 
 	if (!level.database.initialized)
 	{
-		G_Printf("G_SkillRatingGetUserRating: access to non-initialized database\n");
+		G_DB_Printf("G_SkillRatingGetUserRating: access to non-initialized database\n");
 		return 1;
 	}
 
-	sql = va(SRUSERS_SQLWRAP_SELECT, sr_data->guid);
-
-	result = sqlite3_prepare(level.database.db, sql, strlen(sql), &sqlstmt, NULL);
-
-	if (result != SQLITE_OK)
-	{
-		G_Printf("G_SkillRatingGetUserRating: sqlite3_prepare failed: %s\n", err_msg);
-		sqlite3_free(err_msg);
-		return 1;
-	}
-
-	result = sqlite3_step(sqlstmt);
+	result = G_SkillRatingSelect(SRUSERS_SQLWRAP_SELECT, sr_data->guid, &sqlstmt);
 
 	if (result == SQLITE_ROW)
 	{
@@ -375,36 +380,22 @@ int G_SkillRatingGetUserRating(srData_t *sr_data)
 		sr_data->time_axis   = 0;
 		sr_data->time_allies = 0;
 	}
-	else
+	else if (result == SQLITE_DONE)
 	{
-		// no entry found or other failure
-		if (result == SQLITE_DONE)
-		{
-			// assign default values
-			sr_data->mu          = MU;
-			sr_data->sigma       = SIGMA;
-			sr_data->time_axis   = 0;
-			sr_data->time_allies = 0;
-		}
-		else
-		{
-			sqlite3_finalize(sqlstmt);
-
-			G_Printf("G_SkillRatingGetUserRating: sqlite3_step failed: %s\n", err_msg);
-			sqlite3_free(err_msg);
-			return 1;
-		}
+		// no entry found, assign default values
+		sr_data->mu          = MU;
+		sr_data->sigma       = SIGMA;
+		sr_data->time_axis   = 0;
+		sr_data->time_allies = 0;
 	}
-
-	result = sqlite3_finalize(sqlstmt);
-
-	if (result != SQLITE_OK)
+	else
 	{
-		G_Printf("G_SkillRatingGetUserRating: sqlite3_finalize failed\n");
-		return 1;
+		G_DB_Printf("G_SkillRatingGetUserRating: sqlite3_step failed: %s\n", sqlite3_errmsg(level.database.db));
 	}
 
-	return 0;
+	G_DB_ReleaseStatement(sqlstmt);
+
+	return (result == SQLITE_ROW || result == SQLITE_DONE) ? 0 : 1;
 }
 
 /**
@@ -414,79 +405,118 @@ int G_SkillRatingGetUserRating(srData_t *sr_data)
  */
 int G_SkillRatingSetUserRating(srData_t *sr_data)
 {
-	int          result;
-	char         *err_msg = NULL;
-	char         *sql;
-	sqlite3_stmt *sqlstmt;
+	int result;
 
 	if (!level.database.initialized)
 	{
-		G_Printf("G_SkillRatingSetUserRating: access to non-initialized database\n");
+		G_DB_Printf("G_SkillRatingSetUserRating: access to non-initialized database\n");
 		return 1;
 	}
 
-	sql = va(SRUSERS_SQLWRAP_SELECT, sr_data->guid);
+	result = G_SkillRatingWrite(SRUSERS_SQLWRAP_UPSERT, sr_data, qfalse);
 
-	result = sqlite3_prepare(level.database.db, sql, strlen(sql), &sqlstmt, NULL);
-
-	if (result != SQLITE_OK)
+	if (result != SQLITE_DONE)
 	{
-		G_Printf("G_SkillRatingSetUserRating: sqlite3_prepare failed: %s\n", err_msg);
-		sqlite3_free(err_msg);
+		G_DB_Printf("G_SkillRatingSetUserRating: UPSERT failed: %s\n", sqlite3_errmsg(level.database.db));
 		return 1;
 	}
 
-	result = sqlite3_step(sqlstmt);
+	return 0;
+}
 
-	if (result == SQLITE_DONE)
-	{
-		sql = va(SRUSERS_SQLWRAP_INSERT, sr_data->guid, sr_data->mu, sr_data->sigma);
+/**
+ * @brief Retrieves a client rating on the database thread
+ * @param[in,out] data
+ */
+static void G_SkillRatingGetClientRatingJob(void *data)
+{
+	srJob_t *job = (srJob_t *)data;
 
-		result = sqlite3_exec(level.database.db, sql, NULL, NULL, &err_msg);
+	job->sr_data.guid = (const unsigned char *)job->guid;
 
-		if (result != SQLITE_OK)
-		{
-			G_Printf("G_SkillRatingSetUserRating: sqlite3_exec:INSERT failed: %s\n", err_msg);
-			sqlite3_free(err_msg);
-			return 1;
-		}
+	if (!job->match)
+	{
+		// retrieve rating from rating_users table
+		job->result = G_SkillRatingGetUserRating(&job->sr_data);
+		return;
 	}
-	else
+
+	// retrieve rating from rating_match or rating_users table or set default values
+	switch (G_SkillRatingGetMatchRating(&job->sr_data))
 	{
-		sql = va(SRUSERS_SQLWRAP_UPDATE, sr_data->mu, sr_data->sigma, sr_data->guid);
+	case 1:
+		// error occurred
+		job->result = 1;
+		return;
+	case 2:
+		// data not found in rating_match
+		G_SkillRatingGetUserRating(&job->sr_data);
+		break;
+	case 0:
+	// data found
+	default:
+		break;
+	}
 
-		result = sqlite3_exec(level.database.db, sql, NULL, NULL, &err_msg);
+	job->result = 0;
+}
 
-		if (result != SQLITE_OK)
-		{
-			G_Printf("G_SkillRatingSetUserRating: sqlite3_exec:UPDATE failed: %s\n", err_msg);
-			sqlite3_free(err_msg);
-			return 1;
-		}
+/**
+ * @brief Assigns a retrieved rating to the client session
+ * @param[in] data
+ */
+static void G_SkillRatingGetClientRatingDone(void *data)
+{
+	srJob_t   *job = (srJob_t *)data;
+	gclient_t *cl;
+
+	// client left or slot was taken over while loading
+	if (job->result || !G_DB_IsSameClient(job->clientNum, job->guid))
+	{
+		return;
 	}
 
-	result = sqlite3_finalize(sqlstmt);
+	cl = level.clients + job->clientNum;
 
-	if (result != SQLITE_OK)
+	// assign user data to session
+	cl->sess.mu    = job->sr_data.mu;
+	cl->sess.sigma = job->sr_data.sigma;
+
+	if (job->match)
 	{
-		G_Printf("G_SkillRatingSetUserRating: sqlite3_finalize failed\n");
-		return 1;
+		cl->sess.time_axis   = job->sr_data.time_axis;
+		cl->sess.time_allies = job->sr_data.time_allies;
+	}
+	// ensure auto statsdump is correct
+	else if (job->resetTime)
+	{
+		cl->sess.time_axis   = 0;
+		cl->sess.time_allies = 0;
 	}
 
-	return 0;
+	// prepare delta rating
+	if (!job->keepOld)
+	{
+		cl->sess.oldmu    = job->sr_data.mu;
+		cl->sess.oldsigma = job->sr_data.sigma;
+	}
+
+	// update rank
+	G_CalcRank(cl);
+	ClientUserinfoChanged(job->clientNum);
 }
 
 /**
  * @brief Retrieve rating for client
  *         Called on ClientConnect and on G_UpdateSkillRating
+ *         The query is queued, the rating is assigned at the start of a later frame.
  * @param[in] cl
  */
 void G_SkillRatingGetClientRating(gclient_t *cl)
 {
-	char         userinfo[MAX_INFO_STRING];
-	char         *guid;
-	int          clientNum;
-	srData_t     sr_data;
+	char    userinfo[MAX_INFO_STRING];
+	int     clientNum;
+	srJob_t job;
 
 	// disable for these game types
 	if (g_gametype.integer == GT_WOLF_STOPWATCH || g_gametype.integer == GT_WOLF_LMS)
@@ -509,79 +539,59 @@ void G_SkillRatingGetClientRating(gclient_t *cl)
 
 	// retrieve guid
 	trap_GetUserinfo(clientNum, userinfo, sizeof(userinfo));
-	guid = Info_ValueForKey(userinfo, "cl_guid");
 
-	// assign guid
-	sr_data.guid = (const unsigned char *)guid;
+	Com_Memset(&job, 0, sizeof(job));
+	job.clientNum = clientNum;
+	Q_strncpyz(job.guid, Info_ValueForKey(userinfo, "cl_guid"), sizeof(job.guid));
 
 	// retrieve current rating or assign default values
 	if (level.warmupTime || level.intermissionQueued || level.intermissiontime)
 	{
-		// retrieve rating from rating_users table
-		if (G_SkillRatingGetUserRating(&sr_data))
-		{
-			return;
-		}
-
-		// assign user data to session
-		cl->sess.mu          = sr_data.mu;
-		cl->sess.sigma       = sr_data.sigma;
-
-		// ensure auto statsdump is correct
-		if (!level.intermissionQueued && !level.intermissiontime)
-		{
-			cl->sess.time_axis   = 0;
-			cl->sess.time_allies = 0;
-		}
-
-		// prepare delta rating
-		if (!level.intermissionQueued)
-		{
-			cl->sess.oldmu    = sr_data.mu;
-			cl->sess.oldsigma = sr_data.sigma;
-		}
+		job.match     = qfalse;
+		job.resetTime = !level.intermissionQueued && !level.intermissiontime;
+		job.keepOld   = level.intermissionQueued ? qtrue : qfalse;
 	}
 	else // playing
 	{
-		// retrieve rating from rating_match or rating_users table or set default values
-		switch (G_SkillRatingGetMatchRating(&sr_data))
-		{
-			case 1:
-				// error occurred
-				return;
-			case 2:
-				// data not found in rating_match
-				G_SkillRatingGetUserRating(&sr_data);
-				break;
-			case 0:
-				// data found
-			default:
-				break;
-		}
+		job.match = qtrue;
+	}
+
+	G_DB_QueueJob("rating get", G_SkillRatingGetClientRatingJob, G_SkillRatingGetClientRatingDone, &job, sizeof(job));
+}
 
-		// assign match data to session
-		cl->sess.mu          = sr_data.mu;
-		cl->sess.sigma       = sr_data.sigma;
-		cl->sess.time_axis   = sr_data.time_axis;
-		cl->sess.time_allies = sr_data.time_allies;
+/**
+ * @brief Saves a client rating on the database thread
+ * @param[in,out] data
+ */
+static void G_SkillRatingSetClientRatingJob(void *data)
+{
+	srJob_t *job = (srJob_t *)data;
 
-		// prepare delta rating
-		cl->sess.oldmu    = sr_data.mu;
-		cl->sess.oldsigma = sr_data.sigma;
+	job->sr_data.guid = (const unsigned char *)job->guid;
+
+	if (job->match)
+	{
+		// save or update rating in rating_match table
+		job->result = G_SkillRatingSetMatchRating(&job->sr_data);
+	}
+	else
+	{
+		// save or update rating in rating_users table
+		job->result = G_SkillRatingSetUserRating(&job->sr_data);
 	}
 }
 
 /**
  * @brief Sets or updates rating and timestamp for client
  *         Called on ClientDisconnect and on G_LogExit before intermissionQueued
+ *         The query is queued, the session data is copied.
  * @param[in] cl
  */
 void G_SkillRatingSetClientRating(gclient_t *cl)
 {
-	char         userinfo[MAX_INFO_STRING];
-	char         *guid;
-	int          clientNum;
-	srData_t     sr_data;
+	char    userinfo[MAX_INFO_STRING];
+	int     clientNum;
+	srJob_t job;
 
 	// disable for these game types
 	if (g_gametype.integer == GT_WOLF_STOPWATCH || g_gametype.integer == GT_WOLF_LMS)
@@ -610,38 +620,27 @@ void G_SkillRatingSetClientRating(gclient_t *cl)
 
 	// retrieve guid
 	trap_GetUserinfo(clientNum, userinfo, sizeof(userinfo));
-	guid = Info_ValueForKey(userinfo, "cl_guid");
+
+	Com_Memset(&job, 0, sizeof(job));
+	job.clientNum = clientNum;
+	Q_strncpyz(job.guid, Info_ValueForKey(userinfo, "cl_guid"), sizeof(job.guid));
 
 	// assign match data
-	sr_data.guid        = (const unsigned char *)guid;
-	sr_data.mu          = cl->sess.mu;
-	sr_data.sigma       = cl->sess.sigma;
-	sr_data.time_axis   = cl->sess.time_axis;
-	sr_data.time_allies = cl->sess.time_allies;
+	job.sr_data.mu          = cl->sess.mu;
+	job.sr_data.sigma       = cl->sess.sigma;
+	job.sr_data.time_axis   = cl->sess.time_axis;
+	job.sr_data.time_allies = cl->sess.time_allies;
 
 	// save match rating or update new user rating after calculation
-	if (!level.intermissionQueued)
-	{
-		// player has not played at all
-		if (sr_data.time_axis == 0 && sr_data.time_allies == 0)
-		{
-			return;
-		}
+	job.match = !level.intermissionQueued;
 
-		// save or update rating in rating_match table
-		if (G_SkillRatingSetMatchRating(&sr_data))
-		{
-			return;
-		}
-	}
-	else
+	// player has not played at all
+	if (job.match && job.sr_data.time_axis == 0 && job.sr_data.time_allies == 0)
 	{
-		// save or update rating in rating_users table
-		if (G_SkillRatingSetUserRating(&sr_data))
-		{
-			return;
-		}
+		return;
 	}
+
+	G_DB_QueueJob("rating set", G_SkillRatingSetClientRatingJob, NULL, &job, sizeof(job));
 }
 
 /**
@@ -740,8 +739,6 @@ float G_SkillRatingGetMapRating(char *mapname)
 void G_SkillRatingSetMapRating(char *mapname, int winner)
 {
 	int          result;
-	char         *err_msg = NULL;
-	char         *sql;
 	sqlite3_stmt *sqlstmt;
 
 	if (!level.database.initialized)
@@ -750,67 +747,39 @@ void G_SkillRatingSetMapRating(char *mapname, int winner)
 		return;
 	}
 
-	sql = va(SRMAPS_SQLWRAP_SELECT, mapname);
+	// the statement cache belongs to the database thread while jobs are pending
+	G_DB_Flush();
 
-	result = sqlite3_prepare(level.database.db, sql, strlen(sql), &sqlstmt, NULL);
+	sqlstmt = G_DB_Statement(SRMAPS_SQLWRAP_UPSERT);
 
-	if (result != SQLITE_OK)
+	if (!sqlstmt)
 	{
-		G_Printf("G_SkillRatingSetMapRating: sqlite3_prepare failed: %s\n", err_msg);
-		sqlite3_free(err_msg);
 		return;
 	}
 
-	result = sqlite3_step(sqlstmt);
+	result = sqlite3_bind_text(sqlstmt, 1, mapname, -1, SQLITE_STATIC);
 
-	if (result == SQLITE_DONE)
+	if (result == SQLITE_OK)
 	{
-		if (winner == TEAM_AXIS)
-		{
-			sql = va(SRMAPS_SQLWRAP_INSERT, 1, 0, mapname);
-		}
-		else // winner == TEAM_ALLIES
-		{
-			sql = va(SRMAPS_SQLWRAP_INSERT, 0, 1, mapname);
-		}
-
-		result = sqlite3_exec(level.database.db, sql, NULL, NULL, &err_msg);
-
-		if (result != SQLITE_OK)
-		{
-			G_Printf("G_SkillRatingSetMapRating: sqlite3_exec:INSERT failed: %s\n", err_msg);
-			sqlite3_free(err_msg);
-			return;
-		}
+		result = sqlite3_bind_int(sqlstmt, 2, winner == TEAM_AXIS ? 1 : 0);
 	}
-	else
-	{
-		if (winner == TEAM_AXIS)
-		{
-			sql = va(SRMAPS_SQLWRAP_UPDATE, 1, 0, mapname);
-		}
-		else // winner == TEAM_ALLIES
-		{
-			sql = va(SRMAPS_SQLWRAP_UPDATE, 0, 1, mapname);
-		}
-
-		result = sqlite3_exec(level.database.db, sql, NULL, NULL, &err_msg);
 
-		if (result != SQLITE_OK)
-		{
-			G_Printf("G_SkillRatingSetMapRating: sqlite3_exec:UPDATE failed: %s\n", err_msg);
-			sqlite3_free(err_msg);
-			return;
-		}
+	if (result == SQLITE_OK)
+	{
+		result = sqlite3_bind_int(sqlstmt, 3, winner == TEAM_AXIS ? 0 : 1); // winner == TEAM_ALLIES
 	}
 
-	result = sqlite3_finalize(sqlstmt);
+	if (result == SQLITE_OK)
+	{
+		result = sqlite3_step(sqlstmt);
+	}
 
-	if (result != SQLITE_OK)
+	if (result != SQLITE_DONE)
 	{
-		G_Printf("G_SkillRatingSetMapRating: sqlite3_finalize failed\n");
-		return;
+		G_Printf("G_SkillRatingSetMapRating: UPSERT failed: %s\n", sqlite3_errmsg(level.database.db));
 	}
+
+	G_DB_ReleaseStatement(sqlstmt);
 }
 
 /**
@@ -855,8 +824,10 @@ void G_CalculateSkillRatings(void)
 	// update map rating
 	if (g_skillRating.integer > 1)
 	{
+		G_DB_BeginPhase("map rating");
 		G_SkillRatingSetMapRating(level.rawmapname, winner);
 		level.mapProb = G_SkillRatingGetMapRating(level.rawmapname);
+		G_DB_EndPhase();
 
 		G_LogPrintf("SkillRating: Map bias: %.6f\n", level.mapProb);
 
@@ -869,7 +840,9 @@ void G_CalculateSkillRatings(void)
 	// log last estimated win probability
 	G_LogPrintf("SkillRating: Win probability X/L: %.6f/%.6f\n", level.axisProb, level.alliesProb);
 
+	G_DB_BeginPhase("user ratings");
 	G_UpdateSkillRating(winner);
+	G_DB_EndPhase();
 }
 
 /**
@@ -949,8 +922,6 @@ float G_MapWinProb(int team)
  */
 void G_UpdateSkillRating(int winner)
 {
-	int          result;
-	char         *err_msg = NULL;
 	sqlite3_stmt *sqlstmt;
 	srData_t     sr_data;
 
@@ -979,6 +950,9 @@ void G_UpdateSkillRating(int winner)
 		return;
 	}
 
+	// the match ratings recorded at G_LogExit must be written
+	G_DB_Flush();
+
 	// map side parameter
 	if (g_skillRating.integer > 1)
 	{
@@ -989,12 +963,10 @@ void G_UpdateSkillRating(int winner)
 	}
 
 	// player additive factors
-	result = sqlite3_prepare(level.database.db, SRMATCH_SQLWRAP_TABLE, strlen(SRMATCH_SQLWRAP_TABLE), &sqlstmt, NULL);
+	sqlstmt = G_DB_Statement(SRMATCH_SQLWRAP_TABLE);
 
-	if (result != SQLITE_OK)
+	if (!sqlstmt)
 	{
-		G_Printf("G_UpdateSkillRating: sqlite3_prepare failed: %s\n", err_msg);
-		sqlite3_free(err_msg);
 		return;
 	}
 
@@ -1028,13 +1000,7 @@ void G_UpdateSkillRating(int winner)
 		}
 	}
 
-	result = sqlite3_finalize(sqlstmt);
-
-	if (result != SQLITE_OK)
-	{
-		G_Printf("G_UpdateSkillRating: sqlite3_finalize failed\n");
-		return;
-	}
+	G_DB_ReleaseStatement(sqlstmt);
 
 	// normalizing constant
 	if (g_skillRating.integer > 1)
@@ -1071,12 +1037,10 @@ void G_UpdateSkillRating(int winner)
 	w = W(t, EPSILON / c);
 
 	// update players rating
-	result = sqlite3_prepare(level.database.db, SRMATCH_SQLWRAP_TABLE, strlen(SRMATCH_SQLWRAP_TABLE), &sqlstmt, NULL);
+	sqlstmt = G_DB_Statement(SRMATCH_SQLWRAP_TABLE);
 
-	if (result != SQLITE_OK)
+	if (!sqlstmt)
 	{
-		G_Printf("G_UpdateSkillRating: sqlite3_prepare failed: %s\n", err_msg);
-		sqlite3_free(err_msg);
 		return;
 	}
 
@@ -1126,6 +1090,7 @@ void G_UpdateSkillRating(int winner)
 		// save or update rating in rating_users table
 		if (G_SkillRatingSetUserRating(&sr_data))
 		{
+			G_DB_ReleaseStatement(sqlstmt);
 			return;
 		}
 
@@ -1137,24 +1102,14 @@ void G_UpdateSkillRating(int winner)
 		            sr_data.time_axis, sr_data.time_allies);
 	}
 
-	result = sqlite3_finalize(sqlstmt);
+	G_DB_ReleaseStatement(sqlstmt);
 
-	if (result != SQLITE_OK)
-	{
-		G_Printf("G_UpdateSkillRating: sqlite3_finalize failed\n");
-		return;
-	}
-
-	// assign updated rating to connected players
+	// assign updated rating to connected players, rank is updated once loaded
 	for (i = 0; i < level.numConnectedClients; i++)
 	{
 		cl = level.clients + level.sortedClients[i];
 
 		G_SkillRatingGetClientRating(cl);
-
-		// update rank
-		G_CalcRank(cl);
-		ClientUserinfoChanged(level.sortedClients[i]);
 	}
 }
 
@@ -1259,6 +1214,10 @@ float G_CalculateWinProbability(int team)
 		sqlite3_stmt *sqlstmt;
 		srData_t     sr_data;
 
+		// the connection belongs to the database thread while jobs are pending,
+		// this also makes the queued match times visible to the query
+		G_DB_Flush();
+
 		result = sqlite3_prepare(level.database.db, SRMATCH_SQLWRAP_TABLE, strlen(SRMATCH_SQLWRAP_TABLE), &sqlstmt, NULL);
 
 		if (result != SQLITE_OK)
@@ -755,6 +755,14 @@ void G_ParseField(const char *key, const char *value, gentity_t *ent)
 			{
 			case F_LSTRING:
 				*( char ** )(b + f->ofs) = G_NewString(value);
+				if (f->ofs == FOFS(targetname) || f->ofs == FOFS(scriptName))
+				{
+					G_Script_InvalidateEntityRefs();
+				}
+				if (f->ofs == FOFS(targetname) || f->ofs == FOFS(scriptName) || f->ofs == FOFS(classname))
+				{
+					G_TouchEntityIndex(ent);
+				}
 				break;
 			case F_VECTOR:
 				Q_sscanf(value, "%f %f %f", &vec[0], &vec[1], &vec[2]);
@@ -1001,6 +1009,9 @@ void SP_worldspawn(void)
 	g_entities[ENTITYNUM_NONE].r.ownerNum = ENTITYNUM_NONE;
 	g_entities[ENTITYNUM_NONE].classname  = "nothing";
 
+	G_TouchEntityIndex(&g_entities[ENTITYNUM_WORLD]);
+	G_TouchEntityIndex(&g_entities[ENTITYNUM_NONE]);
+
 	// see if we want a warmup time
 	trap_SetConfigstring(CS_WARMUP, "");
 	if (g_restarted.integer)
@@ -2549,6 +2549,11 @@ static consoleCommandTable_t consoleCommandTable[] =
 	{ "csinfo",                     Svcmd_CSInfo_f                },
 	{ "forceteam",                  Svcmd_ForceTeam_f             },
 	{ "game_memory",                Svcmd_GameMem_f               },
+	{ "antilag_stats",              G_AntilagStats_f              },
+#ifdef FEATURE_DBMS
+	{ "db_stats",                   G_DB_Stats_f                  },
+#endif
+	{ "script_disasm",              G_Script_Disassemble_f        },
 	{ "addip",                      Svcmd_AddIP_f                 },
 	{ "removeip",                   Svcmd_RemoveIP_f              },
 	{ "listip",                     Svcmd_ListIp_f                },
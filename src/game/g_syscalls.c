@@ -826,3 +826,21 @@ void trap_DemoSupport(const char *commands)
 		SystemCall(dll_trap_DemoSupport, commands);
 	}
 }
+
+/**
+ * @brief Extension listing the cvars changed since the last call, so that
+ * G_UpdateCvars() only has to update those
+ * @param[in,out] sequence
+ * @param[out] changes Handles of the changed cvars
+ * @param[in] maxChanges
+ * @return Number of changed cvars, -1 if all cvars have to be updated
+ */
+int trap_Cvar_Changes(int *sequence, int *changes, int maxChanges)
+{
+	if (dll_trap_CvarChanges)
+	{
+		return SystemCall(dll_trap_CvarChanges, sequence, changes, maxChanges);
+	}
+
+	return -1;
+}
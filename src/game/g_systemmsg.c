@@ -44,16 +44,10 @@
  */
 qboolean G_NeedEngineers(int team)
 {
-	int       i;
-	gentity_t *e;
+	gentity_t *e = NULL;
 
-	for (i = MAX_CLIENTS, e = &g_entities[MAX_CLIENTS]; i < level.num_entities; i++, e++)
+	while ((e = G_FindByCategory(e, ENTCAT_INDICATOR)) != NULL)
 	{
-		if (!e->inuse)
-		{
-			continue;
-		}
-
 		if (e->s.eType == ET_CONSTRUCTIBLE_INDICATOR || e->s.eType == ET_EXPLOSIVE_INDICATOR || e->s.eType == ET_TANK_INDICATOR)
 		{
 			if (e->s.teamNum == 3)
@@ -107,9 +107,29 @@ mapEntityData_t *G_FreeMapEntityData(mapEntityData_Team_t *teamList, mapEntityDa
 		G_Error("G_FreeMapEntityData: not active\n");
 	}
 
+	// remove from the entity index
+	if (mEnt->singleClient < 0)
+	{
+		teamList->entityIndex[mEnt->entNum] = NULL;
+		teamList->dirty                     = qtrue;
+	}
+	else
+	{
+		mapEntityData_t **link = &teamList->singleClientIndex[mEnt->entNum];
+
+		while (*link != mEnt)
+		{
+			link = &(*link)->nextSingleClient;
+		}
+		*link = mEnt->nextSingleClient;
+
+		teamList->singleClientCount--;
+	}
+
 	// remove from the doubly linked active list
 	mEnt->prev->next = mEnt->next;
 	mEnt->next->prev = mEnt->prev;
+	mEnt->prev       = NULL;
 
 	// the free list is only singly linked
 	mEnt->next                  = teamList->freeMapEntityData;
@@ -121,9 +141,11 @@ mapEntityData_t *G_FreeMapEntityData(mapEntityData_Team_t *teamList, mapEntityDa
 /**
  * @brief G_AllocMapEntityData
  * @param[in,out] teamList
+ * @param[in] entNum
+ * @param[in] singleClient Client the entry is only sent to, -1 to send it to the whole team
  * @return
  */
-mapEntityData_t *G_AllocMapEntityData(mapEntityData_Team_t *teamList)
+mapEntityData_t *G_AllocMapEntityData(mapEntityData_Team_t *teamList, int entNum, int singleClient)
 {
 	mapEntityData_t *mEnt;
 
@@ -138,7 +160,27 @@ mapEntityData_t *G_AllocMapEntityData(mapEntityData_Team_t *teamList)
 
 	Com_Memset(mEnt, 0, sizeof(*mEnt));
 
-	mEnt->singleClient = -1;
+	mEnt->entNum       = entNum;
+	mEnt->singleClient = singleClient;
+	mEnt->dirty        = qtrue;
+
+	// link into the entity index
+	if (singleClient < 0)
+	{
+		if (teamList->entityIndex[entNum])
+		{
+			G_Error("G_AllocMapEntityData: entity %i already has an entry\n", entNum);
+		}
+
+		teamList->entityIndex[entNum] = mEnt;
+		teamList->dirty               = qtrue;
+	}
+	else
+	{
+		mEnt->nextSingleClient                = teamList->singleClientIndex[entNum];
+		teamList->singleClientIndex[entNum] = mEnt;
+		teamList->singleClientCount++;
+	}
 
 	// link into the active list
 	mEnt->next                               = teamList->activeMapEntityData.next;
@@ -155,18 +197,47 @@ mapEntityData_t *G_AllocMapEntityData(mapEntityData_Team_t *teamList)
  * @return
  */
 mapEntityData_t *G_FindMapEntityData(mapEntityData_Team_t *teamList, int entNum)
+{
+	return teamList->entityIndex[entNum];
+}
+
+/**
+ * @brief G_FindMapEntityDataSingleClient
+ * @param[in] teamList
+ * @param[in] start
+ * @param[in] entNum
+ * @param[in] clientNum -1 to find the single client entries of all clients
+ * @return
+ *
+ * @note For a clientNum other than -1 the team wide entry is returned first.
+ */
+mapEntityData_t *G_FindMapEntityDataSingleClient(mapEntityData_Team_t *teamList, mapEntityData_t *start, int entNum, int clientNum)
 {
 	mapEntityData_t *mEnt;
 
-	for (mEnt = teamList->activeMapEntityData.next; mEnt && mEnt != &teamList->activeMapEntityData; mEnt = mEnt->next)
+	if (!start)
 	{
-		if (mEnt->singleClient >= 0)
+		if (clientNum != -1 && teamList->entityIndex[entNum])
 		{
-			continue;
+			return teamList->entityIndex[entNum];
 		}
-		if (entNum == mEnt->entNum)
+
+		mEnt = teamList->singleClientIndex[entNum];
+	}
+	else if (start->singleClient < 0)
+	{
+		mEnt = teamList->singleClientIndex[entNum];
+	}
+	else
+	{
+		mEnt = start->nextSingleClient;
+	}
+
+	for ( ; mEnt; mEnt = mEnt->nextSingleClient)
+	{
+		if (clientNum == -1 || clientNum == mEnt->singleClient)
 		{
-			return mEnt;
+			return(mEnt);
 		}
 	}
 
@@ -175,47 +246,249 @@ mapEntityData_t *G_FindMapEntityData(mapEntityData_Team_t *teamList, int entNum)
 }
 
 /**
- * @brief G_FindMapEntityDataSingleClient
- * @param[in] teamList
- * @param[in] start
+ * @brief Sets what is sent about an entry, marking it for encoding if that changes
+ * @param[in,out] teamList
+ * @param[in,out] mEnt
+ * @param[in] org
+ * @param[in] yaw
+ * @param[in] data
+ * @param[in] type
+ */
+static void G_SetMapEntityData(mapEntityData_Team_t *teamList, mapEntityData_t *mEnt, const vec3_t org, int yaw, int data, int type)
+{
+	// only the cell the entity is in gets sent
+	if (mEnt->type != type || mEnt->yaw != yaw || mEnt->data != data ||
+	    ((int)mEnt->org[0]) / 128 != ((int)org[0]) / 128 ||
+	    ((int)mEnt->org[1]) / 128 != ((int)org[1]) / 128 ||
+	    (level.ccLayers && ((int)mEnt->org[2]) / 128 != ((int)org[2]) / 128))
+	{
+		mEnt->dirty = qtrue;
+
+		// single client entries aren't part of the shared updates
+		if (mEnt->singleClient < 0)
+		{
+			teamList->dirty = qtrue;
+		}
+	}
+
+	VectorCopy(org, mEnt->org);
+	mEnt->yaw  = yaw;
+	mEnt->data = data;
+	mEnt->type = type;
+}
+
+/**
+ * @brief Checks if an entry is dropped when it isn't refreshed
+ * @param[in] mEnt
+ * @return
+ */
+static qboolean G_MapEntityDataExpires(mapEntityData_t *mEnt)
+{
+	switch (mEnt->type)
+	{
+	case ME_PLAYER:
+	case ME_PLAYER_REVIVE:
+	case ME_PLAYER_OBJECTIVE:
+	case ME_PLAYER_DISGUISED:
+		return qtrue;
+	default:
+		return qfalse;
+	}
+}
+
+/**
+ * @brief Marks an entry as seen at this time
+ * @param[in,out] teamList
+ * @param[in,out] mEnt
+ */
+static void G_RefreshMapEntityData(mapEntityData_Team_t *teamList, mapEntityData_t *mEnt)
+{
+	mEnt->startTime = level.time;
+
+	if (!teamList->expireTime && G_MapEntityDataExpires(mEnt))
+	{
+		teamList->expireTime = mEnt->startTime + 1000;
+	}
+}
+
+/**
+ * @brief Sets a team wide entry, creating it if the entity doesn't have one yet
+ * @param[in,out] teamList
  * @param[in] entNum
- * @param[in] clientNum
+ * @param[in] org
+ * @param[in] yaw
+ * @param[in] data
+ * @param[in] type
+ */
+static void G_UpdateMapEntityData(mapEntityData_Team_t *teamList, int entNum, const vec3_t org, int yaw, int data, int type)
+{
+	mapEntityData_t *mEnt = G_FindMapEntityData(teamList, entNum);
+
+	if (!mEnt)
+	{
+		mEnt = G_AllocMapEntityData(teamList, entNum, -1);
+	}
+
+	G_SetMapEntityData(teamList, mEnt, org, yaw, data, type);
+	G_RefreshMapEntityData(teamList, mEnt);
+}
+
+/**
+ * @brief Encodes an entry if it changed since it was last encoded
+ * @param[in,out] mEnt
+ */
+static void G_EncodeMapEntityData(mapEntityData_t *mEnt)
+{
+	if (!mEnt->dirty)
+	{
+		return;
+	}
+
+	mEnt->encoded[0] = '\0';
+	G_PushMapEntityToBuffer(mEnt->encoded, sizeof(mEnt->encoded), mEnt);
+	mEnt->encodedLength = strlen(mEnt->encoded);
+	mEnt->dirty         = qfalse;
+}
+
+/**
+ * @brief Checks if an entry is an objective, which spectators get to see
+ * @param[in] mEnt
  * @return
  */
-mapEntityData_t *G_FindMapEntityDataSingleClient(mapEntityData_Team_t *teamList, mapEntityData_t *start, int entNum, int clientNum)
+static qboolean G_IsObjectiveMapEntity(mapEntityData_t *mEnt)
 {
-	mapEntityData_t *mEnt;
+	switch (mEnt->type)
+	{
+	case ME_CONSTRUCT:
+	case ME_DESTRUCT:
+	case ME_DESTRUCT_2:
+	case ME_TANK:
+	case ME_TANK_DEAD:
+	case ME_COMMANDMAP_MARKER:
+		return qtrue;
+	default:
+		return qfalse;
+	}
+}
 
-	if (start)
+/**
+ * @brief Room left for encoded entities in an entnfo command, after its header
+ */
+#define MAPENTITY_UPDATE_ROOM (MAX_MAPENTITY_UPDATE - 32)
+
+/**
+ * @brief Gets the length of the first count entities of an update
+ * @param[in] update
+ * @param[in] count
+ * @return
+ */
+static int G_MapEntityUpdateLength(const mapEntityUpdate_t *update, int count)
+{
+	return count ? update->ends[count - 1] : 0;
+}
+
+/**
+ * @brief Adds an encoded entry to an update, if there is room left
+ * @param[in,out] update
+ * @param[in] mEnt
+ */
+static void G_AddToMapEntityUpdate(mapEntityUpdate_t *update, mapEntityData_t *mEnt)
+{
+	int length = G_MapEntityUpdateLength(update, update->count);
+
+	if (length + mEnt->encodedLength > MAPENTITY_UPDATE_ROOM)
 	{
-		mEnt = start->next;
+		return;
 	}
-	else
+
+	Com_Memcpy(update->text + length, mEnt->encoded, mEnt->encodedLength);
+	update->ends[update->count++] = length + mEnt->encodedLength;
+}
+
+/**
+ * @brief Counts how many entities of an update fit into the room left
+ * @param[in] update
+ * @param[in] room
+ * @return
+ */
+static int G_MapEntityUpdateFit(const mapEntityUpdate_t *update, int room)
+{
+	int count = update->count;
+
+	while (count > 0 && update->ends[count - 1] > room)
 	{
-		mEnt = teamList->activeMapEntityData.next;
+		count--;
 	}
 
-	for ( ; mEnt && mEnt != &teamList->activeMapEntityData; mEnt = mEnt->next)
+	return count;
+}
+
+/**
+ * @brief Drops expired players and rebuilds the encoded updates of a team if anything changed
+ * @param[in,out] teamList
+ *
+ * @note Everyone receiving the map entities of a team shares these updates, entries
+ * that didn't change since the last rebuild aren't encoded again.
+ */
+static void G_RefreshMapEntityUpdates(mapEntityData_Team_t *teamList)
+{
+	mapEntityData_t *mEnt;
+	int             i;
+
+	// we can free players from the list once they weren't seen for a while
+	if (teamList->expireTime && level.time > teamList->expireTime)
 	{
-		if (clientNum == -1)
+		teamList->expireTime = 0;
+
+		mEnt = teamList->activeMapEntityData.next;
+		while (mEnt != &teamList->activeMapEntityData)
 		{
-			if (mEnt->singleClient < 0)
+			if (G_MapEntityDataExpires(mEnt))
 			{
-				continue;
+				if (level.time - mEnt->startTime > 1000)
+				{
+					mEnt = G_FreeMapEntityData(teamList, mEnt);
+					continue;
+				}
+
+				if (!teamList->expireTime || mEnt->startTime + 1000 < teamList->expireTime)
+				{
+					teamList->expireTime = mEnt->startTime + 1000;
+				}
 			}
+
+			mEnt = mEnt->next;
 		}
-		else if (mEnt->singleClient >= 0 && clientNum != mEnt->singleClient)
+	}
+
+	if (!teamList->dirty)
+	{
+		return;
+	}
+
+	for (i = 0; i < MEU_MAX; i++)
+	{
+		teamList->updates[i].count = 0;
+	}
+
+	for (mEnt = teamList->activeMapEntityData.next; mEnt != &teamList->activeMapEntityData; mEnt = mEnt->next)
+	{
+		if (mEnt->singleClient >= 0)
 		{
 			continue;
 		}
-		if (entNum == mEnt->entNum)
+
+		G_EncodeMapEntityData(mEnt);
+
+		G_AddToMapEntityUpdate(&teamList->updates[MEU_ALL], mEnt);
+
+		if (G_IsObjectiveMapEntity(mEnt))
 		{
-			return(mEnt);
+			G_AddToMapEntityUpdate(&teamList->updates[MEU_OBJECTIVES], mEnt);
 		}
 	}
 
-	// not found
-	return NULL;
+	teamList->dirty = qfalse;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -348,6 +621,31 @@ static qboolean G_CullPointAndRadius(vec3_t pt, float radius)
 	return qtrue;
 }
 
+/**
+ * @brief Checks if any part of a player could be inside the frustum
+ * @param[in] ent
+ * @return false if the whole bounding sphere of the player is outside
+ */
+static qboolean G_PlayerInFrustum(gentity_t *ent)
+{
+	vec3_t center;
+	float  radius = (ent->client->ps.maxs[2] - ent->client->ps.mins[2]) * 0.5f;
+	int    i;
+
+	VectorCopy(ent->client->ps.origin, center);
+	center[2] += (ent->client->ps.mins[2] + ent->client->ps.maxs[2]) * 0.5f;
+
+	for (i = 0; i < 4; i++)
+	{
+		if (DotProduct(center, frustum[i].normal) - frustum[i].dist < -radius)
+		{
+			return qfalse;
+		}
+	}
+
+	return qtrue;
+}
+
 /**
  * @brief G_VisibleFromBinoculars
  * @param[in] viewer
@@ -405,56 +703,23 @@ void G_ResetTeamMapData()
  */
 void G_UpdateTeamMapData_Construct(gentity_t *ent)
 {
-	int                  num = ent - g_entities;
-	mapEntityData_Team_t *teamList;
-	mapEntityData_t      *mEnt;
+	int num = ent - g_entities;
 
 	switch (ent->s.teamNum)
 	{
-	case TEAM_SPECTATOR: // both teams - do twice
-	{
-		teamList = &mapEntityData[0];
-		mEnt     = G_FindMapEntityData(teamList, num);
-		if (!mEnt)
-		{
-			mEnt         = G_AllocMapEntityData(teamList);
-			mEnt->entNum = num;
-		}
-		VectorCopy(ent->s.pos.trBase, mEnt->org);
-		mEnt->data      = mEnt->entNum; //ent->s.modelindex2;
-		mEnt->type      = ME_CONSTRUCT;
-		mEnt->startTime = level.time;
-		mEnt->yaw       = 0;
-
-		teamList = &mapEntityData[1];
+	case TEAM_SPECTATOR: // both teams
+		G_UpdateMapEntityData(&mapEntityData[0], num, ent->s.pos.trBase, 0, num, ME_CONSTRUCT);
+		G_UpdateMapEntityData(&mapEntityData[1], num, ent->s.pos.trBase, 0, num, ME_CONSTRUCT);
 		break;
-	}
 	case TEAM_AXIS:
-	{
-		teamList = &mapEntityData[0];
+		G_UpdateMapEntityData(&mapEntityData[0], num, ent->s.pos.trBase, 0, num, ME_CONSTRUCT);
 		break;
-	}
 	case TEAM_ALLIES:
-	{
-		teamList = &mapEntityData[1];
-
+		G_UpdateMapEntityData(&mapEntityData[1], num, ent->s.pos.trBase, 0, num, ME_CONSTRUCT);
 		break;
-	}
 	default:
-		return;
-	}
-
-	mEnt = G_FindMapEntityData(teamList, num);
-	if (!mEnt)
-	{
-		mEnt         = G_AllocMapEntityData(teamList);
-		mEnt->entNum = num;
+		break;
 	}
-	VectorCopy(ent->s.pos.trBase, mEnt->org);
-	mEnt->data      = mEnt->entNum; //ent->s.modelindex2;
-	mEnt->type      = ME_CONSTRUCT;
-	mEnt->startTime = level.time;
-	mEnt->yaw       = 0;
 }
 
 /**
@@ -463,49 +728,11 @@ void G_UpdateTeamMapData_Construct(gentity_t *ent)
  */
 void G_UpdateTeamMapData_Tank(gentity_t *ent)
 {
-	int                  num       = ent - g_entities;
-	mapEntityData_Team_t *teamList = &mapEntityData[0];
-	mapEntityData_t      *mEnt;
-
-	mEnt = G_FindMapEntityData(teamList, num);
-
-	if (!mEnt)
-	{
-		mEnt         = G_AllocMapEntityData(teamList);
-		mEnt->entNum = num;
-	}
-	VectorCopy(ent->s.pos.trBase, mEnt->org);
-	mEnt->data      = ent->s.modelindex2;
-	mEnt->startTime = level.time;
-	if (ent->s.eType == ET_TANK_INDICATOR_DEAD)
-	{
-		mEnt->type = ME_TANK_DEAD;
-	}
-	else
-	{
-		mEnt->type = ME_TANK;
-	}
-	mEnt->yaw = 0;
+	int num  = ent - g_entities;
+	int type = ent->s.eType == ET_TANK_INDICATOR_DEAD ? ME_TANK_DEAD : ME_TANK;
 
-	teamList = &mapEntityData[1];
-	mEnt     = G_FindMapEntityData(teamList, num);
-	if (!mEnt)
-	{
-		mEnt         = G_AllocMapEntityData(teamList);
-		mEnt->entNum = num;
-	}
-	VectorCopy(ent->s.pos.trBase, mEnt->org);
-	mEnt->data      = ent->s.modelindex2;
-	mEnt->startTime = level.time;
-	if (ent->s.eType == ET_TANK_INDICATOR_DEAD)
-	{
-		mEnt->type = ME_TANK_DEAD;
-	}
-	else
-	{
-		mEnt->type = ME_TANK;
-	}
-	mEnt->yaw = 0;
+	G_UpdateMapEntityData(&mapEntityData[0], num, ent->s.pos.trBase, 0, ent->s.modelindex2, type);
+	G_UpdateMapEntityData(&mapEntityData[1], num, ent->s.pos.trBase, 0, ent->s.modelindex2, type);
 }
 
 /**
@@ -514,24 +741,11 @@ void G_UpdateTeamMapData_Tank(gentity_t *ent)
  */
 void G_UpdateTeamMapData_Destruct(gentity_t *ent)
 {
-	int                  num = ent - g_entities;
-	mapEntityData_Team_t *teamList;
-	mapEntityData_t      *mEnt;
+	int num = ent - g_entities;
 
 	if (ent->s.teamNum == TEAM_AXIS)
 	{
-		teamList = &mapEntityData[1];   // inverted
-		mEnt     = G_FindMapEntityData(teamList, num);
-		if (!mEnt)
-		{
-			mEnt         = G_AllocMapEntityData(teamList);
-			mEnt->entNum = num;
-		}
-		VectorCopy(ent->s.pos.trBase, mEnt->org);
-		mEnt->data      = mEnt->entNum; //ent->s.modelindex2;
-		mEnt->startTime = level.time;
-		mEnt->type      = ME_DESTRUCT;
-		mEnt->yaw       = 0;
+		G_UpdateMapEntityData(&mapEntityData[1], num, ent->s.pos.trBase, 0, num, ME_DESTRUCT);    // inverted
 	}
 	else
 	{
@@ -539,52 +753,19 @@ void G_UpdateTeamMapData_Destruct(gentity_t *ent)
 		{
 			if (ent->parent->spawnflags & ((1 << 6) | (1 << 4)))
 			{
-				teamList = &mapEntityData[1];   // inverted
-				mEnt     = G_FindMapEntityData(teamList, num);
-				if (!mEnt)
-				{
-					mEnt         = G_AllocMapEntityData(teamList);
-					mEnt->entNum = num;
-				}
-				VectorCopy(ent->s.pos.trBase, mEnt->org);
-				mEnt->data      = mEnt->entNum; //ent->s.modelindex2;
-				mEnt->startTime = level.time;
-				mEnt->type      = ME_DESTRUCT_2;
-				mEnt->yaw       = 0;
+				G_UpdateMapEntityData(&mapEntityData[1], num, ent->s.pos.trBase, 0, num, ME_DESTRUCT_2);    // inverted
 			}
 		}
 		else if (ent->parent->target_ent && ent->parent->target_ent->s.eType == ET_EXPLOSIVE)
 		{
 			// do we have any spawn vars to check?
-			teamList = &mapEntityData[1];       // inverted
-			mEnt     = G_FindMapEntityData(teamList, num);
-			if (!mEnt)
-			{
-				mEnt         = G_AllocMapEntityData(teamList);
-				mEnt->entNum = num;
-			}
-			VectorCopy(ent->s.pos.trBase, mEnt->org);
-			mEnt->data      = mEnt->entNum;     //ent->s.modelindex2;
-			mEnt->startTime = level.time;
-			mEnt->type      = ME_DESTRUCT;     // or ME_DESTRUCT_2?
-			mEnt->yaw       = 0;
+			G_UpdateMapEntityData(&mapEntityData[1], num, ent->s.pos.trBase, 0, num, ME_DESTRUCT);    // inverted, or ME_DESTRUCT_2?
 		}
 	}
 
 	if (ent->s.teamNum == TEAM_ALLIES)
 	{
-		teamList = &mapEntityData[0];   // inverted
-		mEnt     = G_FindMapEntityData(teamList, num);
-		if (!mEnt)
-		{
-			mEnt         = G_AllocMapEntityData(teamList);
-			mEnt->entNum = num;
-		}
-		VectorCopy(ent->s.pos.trBase, mEnt->org);
-		mEnt->data      = mEnt->entNum; //ent->s.modelindex2;
-		mEnt->startTime = level.time;
-		mEnt->type      = ME_DESTRUCT;
-		mEnt->yaw       = 0;
+		G_UpdateMapEntityData(&mapEntityData[0], num, ent->s.pos.trBase, 0, num, ME_DESTRUCT);    // inverted
 	}
 	else
 	{
@@ -592,35 +773,13 @@ void G_UpdateTeamMapData_Destruct(gentity_t *ent)
 		{
 			if (ent->parent->spawnflags & ((1 << 6) | (1 << 4)))
 			{
-				teamList = &mapEntityData[0];   // inverted
-				mEnt     = G_FindMapEntityData(teamList, num);
-				if (!mEnt)
-				{
-					mEnt         = G_AllocMapEntityData(teamList);
-					mEnt->entNum = num;
-				}
-				VectorCopy(ent->s.pos.trBase, mEnt->org);
-				mEnt->data      = mEnt->entNum; //ent->s.modelindex2;
-				mEnt->startTime = level.time;
-				mEnt->type      = ME_DESTRUCT_2;
-				mEnt->yaw       = 0;
+				G_UpdateMapEntityData(&mapEntityData[0], num, ent->s.pos.trBase, 0, num, ME_DESTRUCT_2);    // inverted
 			}
 		}
 		else if (ent->parent->target_ent && ent->parent->target_ent->s.eType == ET_EXPLOSIVE)
 		{
 			// do we have any spawn vars to check?
-			teamList = &mapEntityData[0];   // inverted
-			mEnt     = G_FindMapEntityData(teamList, num);
-			if (!mEnt)
-			{
-				mEnt         = G_AllocMapEntityData(teamList);
-				mEnt->entNum = num;
-			}
-			VectorCopy(ent->s.pos.trBase, mEnt->org);
-			mEnt->data      = mEnt->entNum; //ent->s.modelindex2;
-			mEnt->startTime = level.time;
-			mEnt->type      = ME_DESTRUCT; // or ME_DESTRUCT_2?
-			mEnt->yaw       = 0;
+			G_UpdateMapEntityData(&mapEntityData[0], num, ent->s.pos.trBase, 0, num, ME_DESTRUCT);    // inverted, or ME_DESTRUCT_2?
 		}
 	}
 }
@@ -633,9 +792,8 @@ void G_UpdateTeamMapData_Destruct(gentity_t *ent)
  */
 void G_UpdateTeamMapData_Player(gentity_t *ent, qboolean forceAllied, qboolean forceAxis)
 {
-	int                  num = ent - g_entities;
-	mapEntityData_Team_t *teamList;
-	mapEntityData_t      *mEnt;
+	int num = ent - g_entities;
+	int type;
 
 	if (!ent->client)
 	{
@@ -656,60 +814,27 @@ void G_UpdateTeamMapData_Player(gentity_t *ent, qboolean forceAllied, qboolean f
 		forceAllied = qtrue;
 	}
 
-	if (forceAxis)
+	if (ent->health <= 0)
 	{
-		teamList = &mapEntityData[0];
-		mEnt     = G_FindMapEntityData(teamList, num);
-		if (!mEnt)
-		{
-			mEnt         = G_AllocMapEntityData(teamList);
-			mEnt->entNum = num;
-		}
-		VectorCopy(ent->client->ps.origin, mEnt->org);
-		mEnt->yaw       = ent->client->ps.viewangles[YAW];
-		mEnt->data      = num;
-		mEnt->startTime = level.time;
+		type = ME_PLAYER_REVIVE;
+	}
+	else if (ent->client->ps.powerups[PW_REDFLAG] || ent->client->ps.powerups[PW_BLUEFLAG])
+	{
+		type = ME_PLAYER_OBJECTIVE;
+	}
+	else
+	{
+		type = ME_PLAYER;
+	}
 
-		if (ent->health <= 0)
-		{
-			mEnt->type = ME_PLAYER_REVIVE;
-		}
-		else if (ent->client->ps.powerups[PW_REDFLAG] || ent->client->ps.powerups[PW_BLUEFLAG])
-		{
-			mEnt->type = ME_PLAYER_OBJECTIVE;
-		}
-		else
-		{
-			mEnt->type = ME_PLAYER;
-		}
+	if (forceAxis)
+	{
+		G_UpdateMapEntityData(&mapEntityData[0], num, ent->client->ps.origin, ent->client->ps.viewangles[YAW], num, type);
 	}
 
 	if (forceAllied)
 	{
-		teamList = &mapEntityData[1];
-		mEnt     = G_FindMapEntityData(teamList, num);
-		if (!mEnt)
-		{
-			mEnt         = G_AllocMapEntityData(teamList);
-			mEnt->entNum = num;
-		}
-
-		VectorCopy(ent->client->ps.origin, mEnt->org);
-		mEnt->yaw       = ent->client->ps.viewangles[YAW];
-		mEnt->data      = num;
-		mEnt->startTime = level.time;
-		if (ent->health <= 0)
-		{
-			mEnt->type = ME_PLAYER_REVIVE;
-		}
-		else if (ent->client->ps.powerups[PW_REDFLAG] || ent->client->ps.powerups[PW_BLUEFLAG])
-		{
-			mEnt->type = ME_PLAYER_OBJECTIVE;
-		}
-		else
-		{
-			mEnt->type = ME_PLAYER;
-		}
+		G_UpdateMapEntityData(&mapEntityData[1], num, ent->client->ps.origin, ent->client->ps.viewangles[YAW], num, type);
 	}
 }
 
@@ -755,15 +880,10 @@ static void G_UpdateTeamMapData_DisguisedPlayer(gentity_t *spotter, gentity_t *e
 		mEnt = G_FindMapEntityDataSingleClient(teamList, NULL, num, spotter->s.clientNum);
 		if (!mEnt)
 		{
-			mEnt               = G_AllocMapEntityData(teamList);
-			mEnt->entNum       = num;
-			mEnt->singleClient = spotter->s.clientNum;
+			mEnt = G_AllocMapEntityData(teamList, num, spotter->s.clientNum);
 		}
-		VectorCopy(ent->client->ps.origin, mEnt->org);
-		mEnt->yaw       = ent->client->ps.viewangles[YAW];
-		mEnt->data      = num;
-		mEnt->startTime = level.time;
-		mEnt->type      = ME_PLAYER_DISGUISED;
+		G_SetMapEntityData(teamList, mEnt, ent->client->ps.origin, ent->client->ps.viewangles[YAW], num, ME_PLAYER_DISGUISED);
+		G_RefreshMapEntityData(teamList, mEnt);
 	}
 
 	if (forceAllied)
@@ -773,15 +893,10 @@ static void G_UpdateTeamMapData_DisguisedPlayer(gentity_t *spotter, gentity_t *e
 		mEnt = G_FindMapEntityDataSingleClient(teamList, NULL, num, spotter->s.clientNum);
 		if (!mEnt)
 		{
-			mEnt               = G_AllocMapEntityData(teamList);
-			mEnt->entNum       = num;
-			mEnt->singleClient = spotter->s.clientNum;
+			mEnt = G_AllocMapEntityData(teamList, num, spotter->s.clientNum);
 		}
-		VectorCopy(ent->client->ps.origin, mEnt->org);
-		mEnt->yaw       = ent->client->ps.viewangles[YAW];
-		mEnt->data      = num;
-		mEnt->startTime = level.time;
-		mEnt->type      = ME_PLAYER_DISGUISED;
+		G_SetMapEntityData(teamList, mEnt, ent->client->ps.origin, ent->client->ps.viewangles[YAW], num, ME_PLAYER_DISGUISED);
+		G_RefreshMapEntityData(teamList, mEnt);
 	}
 }
 
@@ -791,9 +906,7 @@ static void G_UpdateTeamMapData_DisguisedPlayer(gentity_t *spotter, gentity_t *e
  */
 void G_UpdateTeamMapData_LandMine(gentity_t *ent)
 {
-	int                  num = ent - g_entities;
-	mapEntityData_Team_t *teamList;
-	mapEntityData_t      *mEnt;
+	int num = ent - g_entities;
 
 	// must be armed..
 	if (!ent->s.effect1Time)
@@ -804,31 +917,11 @@ void G_UpdateTeamMapData_LandMine(gentity_t *ent)
 	// inversed teamlists, we want to see the enemy mines
 	if (ent->s.modelindex2)     // must be spotted..
 	{
-		teamList = &mapEntityData[(ent->s.teamNum == TEAM_AXIS) ? 1 : 0];
-		mEnt     = G_FindMapEntityData(teamList, num);
-		if (!mEnt)
-		{
-			mEnt         = G_AllocMapEntityData(teamList);
-			mEnt->entNum = num;
-		}
-		VectorCopy(ent->r.currentOrigin, mEnt->org);
-		mEnt->data      = ent->s.teamNum;
-		mEnt->startTime = level.time;
-		mEnt->type      = ME_LANDMINE;
+		G_UpdateMapEntityData(&mapEntityData[(ent->s.teamNum == TEAM_AXIS) ? 1 : 0], num, ent->r.currentOrigin, 0, ent->s.teamNum, ME_LANDMINE);
 	}
 
 	// team mines..
-	teamList = &mapEntityData[(ent->s.teamNum == TEAM_AXIS) ? 0 : 1];
-	mEnt     = G_FindMapEntityData(teamList, num);
-	if (!mEnt)
-	{
-		mEnt         = G_AllocMapEntityData(teamList);
-		mEnt->entNum = num;
-	}
-	VectorCopy(ent->r.currentOrigin, mEnt->org);
-	mEnt->data      = ent->s.teamNum;
-	mEnt->startTime = level.time;
-	mEnt->type      = ME_LANDMINE;
+	G_UpdateMapEntityData(&mapEntityData[(ent->s.teamNum == TEAM_AXIS) ? 0 : 1], num, ent->r.currentOrigin, 0, ent->s.teamNum, ME_LANDMINE);
 }
 
 /**
@@ -849,38 +942,13 @@ void G_UpdateTeamMapData_CommandmapMarker(gentity_t *ent)
 
 	if (ent->parent->spawnflags & (ALLIED_OBJECTIVE | AXIS_OBJECTIVE))
 	{
-		int                  num = ent - g_entities;
-		mapEntityData_Team_t *teamList;
-		mapEntityData_t      *mEnt;
+		int num = ent - g_entities;
 
 		// alies
-		teamList = &mapEntityData[0];
-		mEnt     = G_FindMapEntityData(teamList, num);
-		if (!mEnt)
-		{
-			mEnt         = G_AllocMapEntityData(teamList);
-			mEnt->entNum = num;
-		}
-		VectorCopy(ent->s.origin, mEnt->org);
-		mEnt->data      = ent->parent ? ent->parent->s.teamNum : -1;
-		mEnt->startTime = level.time;
-		mEnt->type      = ME_COMMANDMAP_MARKER;
-		mEnt->yaw       = 0;
-
+		G_UpdateMapEntityData(&mapEntityData[0], num, ent->s.origin, 0, ent->parent->s.teamNum, ME_COMMANDMAP_MARKER);
 
 		// axis
-		teamList = &mapEntityData[1];
-		mEnt     = G_FindMapEntityData(teamList, num);
-		if (!mEnt)
-		{
-			mEnt         = G_AllocMapEntityData(teamList);
-			mEnt->entNum = num;
-		}
-		VectorCopy(ent->s.origin, mEnt->org);
-		mEnt->data      = ent->parent ? ent->parent->s.teamNum : -1;
-		mEnt->startTime = level.time;
-		mEnt->type      = ME_COMMANDMAP_MARKER;
-		mEnt->yaw       = 0;
+		G_UpdateMapEntityData(&mapEntityData[1], num, ent->s.origin, 0, ent->parent->s.teamNum, ME_COMMANDMAP_MARKER);
 	}
 }
 
@@ -891,144 +959,40 @@ void G_UpdateTeamMapData_CommandmapMarker(gentity_t *ent)
 void G_SendSpectatorMapEntityInfo(gentity_t *e)
 {
 	// special version, sends different set of ents - only the objectives, but also team info (string is split in two basically)
-	mapEntityData_t      *mEnt;
-	mapEntityData_Team_t *teamList = &mapEntityData[0]; // Axis data init
-	char                 buffer[2048];
-	int                  al_cnt = 0, ax_cnt = 0;
-
-	buffer[0] = '\0';
-
-	for (mEnt = teamList->activeMapEntityData.next; mEnt && mEnt != &teamList->activeMapEntityData; mEnt = mEnt->next)
-	{
-		if (!e->client->sess.shoutcaster)
-		{
-			if (mEnt->type != ME_CONSTRUCT && mEnt->type != ME_DESTRUCT && mEnt->type != ME_DESTRUCT_2 && mEnt->type != ME_TANK && mEnt->type != ME_TANK_DEAD && mEnt->type != ME_COMMANDMAP_MARKER)
-			{
-				continue;
-			}
-
-			if (mEnt->singleClient >= 0 && e->s.clientNum != mEnt->singleClient)
-			{
-				continue;
-			}
-		}
-		else
-		{
-			if (level.time - mEnt->startTime > 1000)
-			{
-				// we can free this player from the list now
-				if (mEnt->type == ME_PLAYER || mEnt->type == ME_PLAYER_REVIVE || mEnt->type == ME_PLAYER_OBJECTIVE)
-				{
-					mEnt = G_FreeMapEntityData(teamList, mEnt);
-					continue;
-				}
-				else if (mEnt->type == ME_PLAYER_DISGUISED)
-				{
-					if (mEnt->singleClient == e->s.clientNum)
-					{
-						mEnt = G_FreeMapEntityData(teamList, mEnt);
-						continue;
-					}
-				}
-			}
-		}
-
-		ax_cnt++;
-	}
-
-	// Allied data init
-	teamList = &mapEntityData[1];
+	mapEntityUpdateType_t which = e->client->sess.shoutcaster ? MEU_ALL : MEU_OBJECTIVES;
+	mapEntityUpdate_t     *axis, *allies;
+	char                  buffer[MAX_MAPENTITY_UPDATE];
+	int                   al_cnt, ax_cnt, length;
 
-	for (mEnt = teamList->activeMapEntityData.next; mEnt && mEnt != &teamList->activeMapEntityData; mEnt = mEnt->next)
-	{
-		if (!e->client->sess.shoutcaster)
-		{
-			if (mEnt->type != ME_CONSTRUCT && mEnt->type != ME_DESTRUCT && mEnt->type != ME_DESTRUCT_2 &&
-			    mEnt->type != ME_TANK && mEnt->type != ME_TANK_DEAD && mEnt->type != ME_COMMANDMAP_MARKER)
-			{
-				continue;
-			}
+	G_RefreshMapEntityUpdates(&mapEntityData[0]);
+	G_RefreshMapEntityUpdates(&mapEntityData[1]);
 
-			if (mEnt->singleClient >= 0 && e->s.clientNum != mEnt->singleClient)
-			{
-				continue;
-			}
-		}
-		else
-		{
-			if (level.time - mEnt->startTime > 1000)
-			{
-				// we can free this player from the list now
-				if (mEnt->type == ME_PLAYER || mEnt->type == ME_PLAYER_REVIVE || mEnt->type == ME_PLAYER_OBJECTIVE)
-				{
-					mEnt = G_FreeMapEntityData(teamList, mEnt);
-					continue;
-				}
-				else if (mEnt->type == ME_PLAYER_DISGUISED)
-				{
-					if (mEnt->singleClient == e->s.clientNum)
-					{
-						mEnt = G_FreeMapEntityData(teamList, mEnt);
-						continue;
-					}
-				}
-			}
-		}
+	axis   = &mapEntityData[0].updates[which];
+	allies = &mapEntityData[1].updates[which];
 
-		al_cnt++;
-	}
+	ax_cnt = axis->count;
+	al_cnt = G_MapEntityUpdateFit(allies, MAPENTITY_UPDATE_ROOM - G_MapEntityUpdateLength(axis, ax_cnt));
 
 	// Data setup
 	// FIXME: Find out why objective counts are reset to zero when a new player connects
-	if (ax_cnt > 0 || al_cnt > 0)
+	if (ax_cnt <= 0 && al_cnt <= 0)
 	{
-		Com_sprintf(buffer, sizeof(buffer), "entnfo %i %i", ax_cnt, al_cnt);
+		return; // don't send an emtpy buffer
 	}
 
-	// Axis data
-	teamList = &mapEntityData[0];
-
-	for (mEnt = teamList->activeMapEntityData.next; mEnt && mEnt != &teamList->activeMapEntityData; mEnt = mEnt->next)
-	{
-		if (mEnt->type != ME_CONSTRUCT && mEnt->type != ME_DESTRUCT && mEnt->type != ME_DESTRUCT_2 &&
-		    mEnt->type != ME_TANK && mEnt->type != ME_TANK_DEAD && mEnt->type != ME_COMMANDMAP_MARKER &&
-		    !e->client->sess.shoutcaster)
-		{
-			continue;
-		}
-
-		if (mEnt->singleClient >= 0 && e->s.clientNum != mEnt->singleClient)
-		{
-			continue;
-		}
+	length = Com_sprintf(buffer, sizeof(buffer), "entnfo %i %i", ax_cnt, al_cnt);
 
-		G_PushMapEntityToBuffer(buffer, sizeof(buffer), mEnt);
-	}
+	// Axis data
+	Com_Memcpy(buffer + length, axis->text, G_MapEntityUpdateLength(axis, ax_cnt));
+	length += G_MapEntityUpdateLength(axis, ax_cnt);
 
 	// Allied data
-	teamList = &mapEntityData[1];
+	Com_Memcpy(buffer + length, allies->text, G_MapEntityUpdateLength(allies, al_cnt));
+	length += G_MapEntityUpdateLength(allies, al_cnt);
 
-	for (mEnt = teamList->activeMapEntityData.next; mEnt && mEnt != &teamList->activeMapEntityData; mEnt = mEnt->next)
-	{
-		if (mEnt->type != ME_CONSTRUCT && mEnt->type != ME_DESTRUCT && mEnt->type != ME_DESTRUCT_2 &&
-		    mEnt->type != ME_TANK && mEnt->type != ME_TANK_DEAD && mEnt->type != ME_COMMANDMAP_MARKER &&
-		    !e->client->sess.shoutcaster)
-		{
-			continue;
-		}
+	buffer[length] = '\0';
 
-		if (mEnt->singleClient >= 0 && e->s.clientNum != mEnt->singleClient)
-		{
-			continue;
-		}
-
-		G_PushMapEntityToBuffer(buffer, sizeof(buffer), mEnt);
-	}
-
-	if (buffer[0] != '\0') // don't send an emtpy buffer
-	{
-		trap_SendServerCommand(e - g_entities, buffer);
-	}
+	trap_SendServerCommand(e - g_entities, buffer);
 }
 
 /**
@@ -1039,10 +1003,10 @@ void G_SendMapEntityInfo(gentity_t *e)
 {
 	mapEntityData_t      *mEnt;
 	mapEntityData_Team_t *teamList;
-	char                 buffer[2048];
-	int                  cnt = 0;
-
-	buffer[0] = '\0';
+	mapEntityUpdate_t    *update;
+	mapEntityData_t      *spotted[MAX_CLIENTS];
+	char                 buffer[MAX_MAPENTITY_UPDATE];
+	int                  cnt, spottedCnt = 0, length, room, i;
 
 	if (e->client->sess.sessionTeam == TEAM_SPECTATOR)
 	{
@@ -1058,61 +1022,60 @@ void G_SendMapEntityInfo(gentity_t *e)
 
 	teamList = e->client->sess.sessionTeam == TEAM_AXIS ? &mapEntityData[0] : &mapEntityData[1];
 
-	mEnt = teamList->activeMapEntityData.next;
-	while (mEnt && mEnt != &teamList->activeMapEntityData)
+	G_RefreshMapEntityUpdates(teamList);
+
+	update = &teamList->updates[MEU_ALL];
+	cnt    = update->count;
+	room   = MAPENTITY_UPDATE_ROOM - G_MapEntityUpdateLength(update, cnt);
+
+	// entries only this client gets to see
+	if (teamList->singleClientCount)
 	{
-		if (level.time - mEnt->startTime > 1000)
+		for (mEnt = teamList->activeMapEntityData.next; mEnt != &teamList->activeMapEntityData; mEnt = mEnt->next)
 		{
-			// we can free this player from the list now
-			if (mEnt->type == ME_PLAYER || mEnt->type == ME_PLAYER_REVIVE || mEnt->type == ME_PLAYER_OBJECTIVE)
+			if (mEnt->singleClient != e->s.clientNum)
 			{
-				mEnt = G_FreeMapEntityData(teamList, mEnt);
 				continue;
 			}
-			else if (mEnt->type == ME_PLAYER_DISGUISED)
+
+			G_EncodeMapEntityData(mEnt);
+
+			if (mEnt->encodedLength > room || spottedCnt == MAX_CLIENTS)
 			{
-				if (mEnt->singleClient == e->s.clientNum)
-				{
-					mEnt = G_FreeMapEntityData(teamList, mEnt);
-					continue;
-				}
+				break;
 			}
+
+			room                   -= mEnt->encodedLength;
+			spotted[spottedCnt++] = mEnt;
 		}
-		cnt++;
+	}
 
-		mEnt = mEnt->next;
+	if (cnt + spottedCnt <= 0)
+	{
+		return; // don't send an emtpy buffer
 	}
 
 	if (e->client->sess.sessionTeam == TEAM_AXIS)
 	{
-		if (cnt > 0)
-		{
-			Com_sprintf(buffer, sizeof(buffer), "entnfo %i 0", cnt);
-		}
+		length = Com_sprintf(buffer, sizeof(buffer), "entnfo %i 0", cnt + spottedCnt);
 	}
 	else
 	{
-		if (cnt > 0)
-		{
-			Com_sprintf(buffer, sizeof(buffer), "entnfo 0 %i", cnt);
-		}
+		length = Com_sprintf(buffer, sizeof(buffer), "entnfo 0 %i", cnt + spottedCnt);
 	}
 
-	for (mEnt = teamList->activeMapEntityData.next; mEnt && mEnt != &teamList->activeMapEntityData; mEnt = mEnt->next)
-	{
+	Com_Memcpy(buffer + length, update->text, G_MapEntityUpdateLength(update, cnt));
+	length += G_MapEntityUpdateLength(update, cnt);
 
-		if (mEnt->singleClient >= 0 && e->s.clientNum != mEnt->singleClient)
-		{
-			continue;
-		}
-
-		G_PushMapEntityToBuffer(buffer, sizeof(buffer), mEnt);
-	}
-
-	if (buffer[0] != '\0') // don't send an emtpy buffer
+	for (i = 0; i < spottedCnt; i++)
 	{
-		trap_SendServerCommand(e - g_entities, buffer);
+		Com_Memcpy(buffer + length, spotted[i]->encoded, spotted[i]->encodedLength);
+		length += spotted[i]->encodedLength;
 	}
+
+	buffer[length] = '\0';
+
+	trap_SendServerCommand(e - g_entities, buffer);
 }
 
 /**
@@ -1136,7 +1099,7 @@ void G_PopupMessageForMines(gentity_t *player) // int sound
  */
 void G_CheckSpottedLandMines(void)
 {
-	int       i, j;
+	int       i;
 	gentity_t *ent, *ent2;
 
 	if (level.time - level.lastMapSpottedMinesUpdate < 500)
@@ -1145,6 +1108,12 @@ void G_CheckSpottedLandMines(void)
 	}
 	level.lastMapSpottedMinesUpdate = level.time;
 
+	// nothing to spot
+	if (!G_CountByCategory(ENTCAT_LANDMINE))
+	{
+		return;
+	}
+
 	for (i = 0; i < level.numConnectedClients; i++)
 	{
 		ent = &g_entities[level.sortedClients[i]];
@@ -1174,9 +1143,10 @@ void G_CheckSpottedLandMines(void)
 		{
 			G_SetupFrustum_ForBinoculars(ent);
 
-			for (j = 0, ent2 = g_entities; j < level.num_entities; j++, ent2++)
+			ent2 = NULL;
+			while ((ent2 = G_FindByCategory(ent2, ENTCAT_LANDMINE)) != NULL)
 			{
-				if (!ent2->inuse || ent2 == ent)
+				if (ent2 == ent)
 				{
 					continue;
 				}
@@ -1258,10 +1228,11 @@ void G_CheckSpottedLandMines(void)
  */
 void G_UpdateTeamMapData(void)
 {
-	int             i, j;
-	gentity_t       *ent, *ent2;
-	mapEntityData_t *mEnt;
-	qboolean        f1, f2;
+	static const entCategory_t mapCategories[] = { ENTCAT_INDICATOR, ENTCAT_LANDMINE, ENTCAT_COMMANDMAP_MARKER };
+	int                        i, j;
+	gentity_t                  *ent, *ent2;
+	mapEntityData_t            *mEnt;
+	qboolean                   f1, f2;
 
 	G_CheckSpottedLandMines();
 
@@ -1271,67 +1242,72 @@ void G_UpdateTeamMapData(void)
 	}
 	level.lastMapEntityUpdate = level.time;
 
-	// all ents - comon update
-	for (i = 0; i < level.num_entities; i++)
+	// clients - comon update
+	for (i = 0; i < level.maxclients; i++)
 	{
 		ent = &g_entities[i];
 
-		if (!ent->inuse)
+		if (!ent->inuse || !ent->client)
 		{
-			//mapEntityData[0][i].valid = qfalse;
-			//mapEntityData[1][i].valid = qfalse;
 			continue;
 		}
 
-		switch (ent->s.eType)
+		if (ent->s.eType != ET_PLAYER && ent->s.eType != ET_INVISIBLE) // noclip
 		{
-		case ET_PLAYER:
-		case ET_INVISIBLE: // noclip
-			if (ent->client)
-			{
-				G_UpdateTeamMapData_Player(ent, qfalse, qfalse);
-				for (j = 0; j < 2; j++)
-				{
-					mapEntityData_Team_t *teamList = &mapEntityData[j];
+			continue;
+		}
 
-					mEnt = G_FindMapEntityDataSingleClient(teamList, NULL, ent->s.number, -1);
+		G_UpdateTeamMapData_Player(ent, qfalse, qfalse);
+		for (j = 0; j < 2; j++)
+		{
+			mapEntityData_Team_t *teamList = &mapEntityData[j];
 
-					while (mEnt)
-					{
-						VectorCopy(ent->client->ps.origin, mEnt->org);
-						mEnt->yaw = ent->client->ps.viewangles[YAW];
-						mEnt      = G_FindMapEntityDataSingleClient(teamList, mEnt, ent->s.number, -1);
-					}
-				}
-			}
-			break;
-		case ET_CONSTRUCTIBLE_INDICATOR:
-			if (ent->parent && ent->parent->entstate == STATE_DEFAULT)
-			{
-				G_UpdateTeamMapData_Construct(ent);
-			}
-			break;
-		case ET_EXPLOSIVE_INDICATOR:
-			if (ent->parent && ent->parent->entstate == STATE_DEFAULT)
+			mEnt = G_FindMapEntityDataSingleClient(teamList, NULL, ent->s.number, -1);
+
+			while (mEnt)
 			{
-				G_UpdateTeamMapData_Destruct(ent);
+				G_SetMapEntityData(teamList, mEnt, ent->client->ps.origin, ent->client->ps.viewangles[YAW], mEnt->data, mEnt->type);
+				mEnt = G_FindMapEntityDataSingleClient(teamList, mEnt, ent->s.number, -1);
 			}
-			break;
-		case ET_TANK_INDICATOR:
-		case ET_TANK_INDICATOR_DEAD:
-			G_UpdateTeamMapData_Tank(ent);
-			break;
-		case ET_MISSILE:
-			if (ent->methodOfDeath == MOD_LANDMINE)
+		}
+	}
+
+	// everything else that shows up on the command map is kept in a category list
+	for (i = 0; i < (int)ARRAY_LEN(mapCategories); i++)
+	{
+		ent = NULL;
+		while ((ent = G_FindByCategory(ent, mapCategories[i])) != NULL)
+		{
+			switch (ent->s.eType)
 			{
-				G_UpdateTeamMapData_LandMine(ent);
+			case ET_CONSTRUCTIBLE_INDICATOR:
+				if (ent->parent && ent->parent->entstate == STATE_DEFAULT)
+				{
+					G_UpdateTeamMapData_Construct(ent);
+				}
+				break;
+			case ET_EXPLOSIVE_INDICATOR:
+				if (ent->parent && ent->parent->entstate == STATE_DEFAULT)
+				{
+					G_UpdateTeamMapData_Destruct(ent);
+				}
+				break;
+			case ET_TANK_INDICATOR:
+			case ET_TANK_INDICATOR_DEAD:
+				G_UpdateTeamMapData_Tank(ent);
+				break;
+			case ET_MISSILE:
+				if (ent->methodOfDeath == MOD_LANDMINE)
+				{
+					G_UpdateTeamMapData_LandMine(ent);
+				}
+				break;
+			case ET_COMMANDMAP_MARKER:
+				G_UpdateTeamMapData_CommandmapMarker(ent);
+				break;
+			default:
+				break;
 			}
-			break;
-		case ET_COMMANDMAP_MARKER:
-			G_UpdateTeamMapData_CommandmapMarker(ent);
-			break;
-		default:
-			break;
 		}
 	}
 
@@ -1397,6 +1373,12 @@ void G_UpdateTeamMapData(void)
 					continue;
 				}
 
+				// none of the points below can be seen if the whole body is out of view
+				if (!G_PlayerInFrustum(ent2))
+				{
+					continue;
+				}
+
 				VectorCopy(ent2->client->ps.origin, pos[0]);
 				pos[0][2] += ent2->client->ps.mins[2];
 				VectorCopy(ent2->client->ps.origin, pos[1]);
@@ -1450,6 +1432,19 @@ void G_UpdateTeamMapData(void)
 					continue;
 				}
 
+				// already spotted by a teammate during this update
+				mEnt = G_FindMapEntityData(&mapEntityData[f2 ? 0 : 1], ent2->s.number);
+				if (mEnt && mEnt->startTime == level.time)
+				{
+					continue;
+				}
+
+				// none of the points below can be seen if the whole body is out of view
+				if (!G_PlayerInFrustum(ent2))
+				{
+					continue;
+				}
+
 				VectorCopy(ent2->client->ps.origin, pos[0]);
 				pos[0][2] += ent2->client->ps.mins[2];
 				VectorCopy(ent2->client->ps.origin, pos[1]);
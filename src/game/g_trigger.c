@@ -1622,6 +1622,7 @@ void Think_SetupObjectiveInfo(gentity_t *ent)
 			{
 				e->s.eType = ET_EXPLOSIVE_INDICATOR;
 			}
+			G_UpdateEntityCategory(e);
 			e->parent       = ent;
 			e->s.pos.trType = TR_STATIONARY;
 
@@ -1722,6 +1723,7 @@ void Think_SetupObjectiveInfo(gentity_t *ent)
 			{
 				e->s.eType = ET_CONSTRUCTIBLE_INDICATOR;
 			}
+			G_UpdateEntityCategory(e);
 			e->s.pos.trType = TR_STATIONARY;
 
 			if (constructibles[1])
@@ -307,17 +307,196 @@ void G_TeamCommand(team_t team, const char *cmd)
 }
 
 /**
- * @brief Searches all active entities for the next one that holds
- * the matching string at fieldofs (use the FOFS() macro) in the structure.
- * Searches beginning at the entity after from, or the beginning if NULL
- * NULL will be returned if the end of the list is reached.
+=========================================================================
+entity name index
+=========================================================================
+*/
+
+/**
+ * @enum entIndexField_t
+ * @brief Entity name fields kept in the index
+ */
+typedef enum
+{
+	ENTINDEX_TARGETNAME,
+	ENTINDEX_SCRIPTNAME,
+	ENTINDEX_CLASSNAME,
+	ENTINDEX_MAX
+} entIndexField_t;
+
+#define ENTINDEX_BUCKETS 1024           ///< power of two
+
+/**
+ * @struct entIndex_t
+ * @brief Entities of one name field, chained per name hash in ascending entity order
+ */
+typedef struct
+{
+	short head[ENTINDEX_BUCKETS];           ///< first entity of each bucket, -1 if empty
+	short next[MAX_GENTITIES];              ///< next entity in the same bucket, -1 ends the chain
+	short bucket[MAX_GENTITIES];            ///< bucket the entity is chained in, -1 if none
+	const char *name[MAX_GENTITIES];        ///< field value the entity was indexed with
+} entIndex_t;
+
+static entIndex_t entIndex[ENTINDEX_MAX];
+static const int  entIndexOfs[ENTINDEX_MAX] = { FOFS(targetname), FOFS(scriptName), FOFS(classname) };
+
+static short entIndexTouched[MAX_GENTITIES];    ///< entities to reindex before the next lookup
+static byte  entIndexIsTouched[MAX_GENTITIES];
+static int   numEntIndexTouched;
+
+/**
+ * @brief Moves an entity to the bucket of its current name
+ * @param[in,out] index
+ * @param[in] num
+ * @param[in] name
+ */
+static void G_EntityIndexRelink(entIndex_t *index, int num, const char *name)
+{
+	short *link;
+	int   bucket;
+
+	// unlink
+	if (index->bucket[num] >= 0)
+	{
+		for (link = &index->head[index->bucket[num]]; *link >= 0; link = &index->next[*link])
+		{
+			if (*link == num)
+			{
+				*link = index->next[num];
+				break;
+			}
+		}
+	}
+
+	index->name[num]   = name;
+	index->next[num]   = -1;
+	index->bucket[num] = -1;
+
+	if (!name)
+	{
+		return;
+	}
+
+	// link in ascending entity order, so lookups can continue behind 'from'
+	bucket = (int)BG_StringHashValue(name) & (ENTINDEX_BUCKETS - 1);
+
+	for (link = &index->head[bucket]; *link >= 0 && *link < num; link = &index->next[*link])
+	{
+	}
+
+	index->next[num]   = *link;
+	index->bucket[num] = bucket;
+	*link              = num;
+}
+
+/**
+ * @brief Reindexes an entity
+ * @param[in] num
+ * @param[in] force Relink even if the name pointers didn't change (strings reallocated in place)
+ */
+static void G_EntityIndexUpdate(int num, qboolean force)
+{
+	const char *name;
+	int        i;
+
+	for (i = 0; i < ENTINDEX_MAX; i++)
+	{
+		name = *(const char **)((byte *)&g_entities[num] + entIndexOfs[i]);
+
+		if (force || name != entIndex[i].name[num])
+		{
+			G_EntityIndexRelink(&entIndex[i], num, name);
+		}
+	}
+}
+
+/**
+ * @brief Reindexes the entities touched since the last lookup
+ */
+static void G_EntityIndexFlush(void)
+{
+	int i, num;
+
+	for (i = 0; i < numEntIndexTouched; i++)
+	{
+		num = entIndexTouched[i];
+
+		entIndexIsTouched[num] = 0;
+		G_EntityIndexUpdate(num, qtrue);
+	}
+
+	numEntIndexTouched = 0;
+}
+
+/**
+ * @brief Marks the names of an entity as changed, the entity is reindexed before the next lookup.
+ * @param[in] ent
  *
- * @param[in,out] from
+ * @note Needed wherever a targetname, scriptName or classname of an entity changes outside
+ * of G_Spawn() and G_ParseField(). Names set right after G_Spawn() are covered by its
+ * touch, as the entity is only reindexed at the next lookup. Changes that aren't reported
+ * are picked up by G_SyncEntityIndex() at the start of the next frame, see G_Find().
+ */
+void G_TouchEntityIndex(gentity_t *ent)
+{
+	int num = ent - g_entities;
+
+	if (num < 0 || num >= MAX_GENTITIES || entIndexIsTouched[num])
+	{
+		return;
+	}
+
+	entIndexIsTouched[num]                 = 1;
+	entIndexTouched[numEntIndexTouched++] = num;
+}
+
+/**
+ * @brief Reindexes all entities whose name fields point to other strings than when they were indexed
+ */
+void G_SyncEntityIndex(void)
+{
+	int i;
+
+	G_EntityIndexFlush();
+
+	for (i = 0; i < MAX_GENTITIES; i++)
+	{
+		G_EntityIndexUpdate(i, qfalse);
+	}
+}
+
+/**
+ * @brief Empties the index and indexes the current entities
+ */
+void G_InitEntityIndex(void)
+{
+	int i;
+
+	for (i = 0; i < ENTINDEX_MAX; i++)
+	{
+		Com_Memset(entIndex[i].head, -1, sizeof(entIndex[i].head));
+		Com_Memset(entIndex[i].next, -1, sizeof(entIndex[i].next));
+		Com_Memset(entIndex[i].bucket, -1, sizeof(entIndex[i].bucket));
+		Com_Memset(entIndex[i].name, 0, sizeof(entIndex[i].name));
+	}
+
+	Com_Memset(entIndexIsTouched, 0, sizeof(entIndexIsTouched));
+	numEntIndexTouched = 0;
+
+	G_SyncEntityIndex();
+}
+
+/**
+ * @brief Searches all active entities for the next one that holds
+ * the matching string at fieldofs, by going through the entities one by one.
+ * @param[in] from
  * @param[in] fieldofs
  * @param[in] match
+ * @param[in] hash Compared to the targetnamehash of the entities if not -1
  * @return
  */
-gentity_t *G_Find(gentity_t *from, int fieldofs, const char *match)
+static gentity_t *G_FindLinear(gentity_t *from, int fieldofs, const char *match, int hash)
 {
 	char      *s;
 	gentity_t *max = &g_entities[level.num_entities];
@@ -342,6 +521,10 @@ gentity_t *G_Find(gentity_t *from, int fieldofs, const char *match)
 		{
 			continue;
 		}
+		if (hash != -1 && from->targetnamehash != hash)
+		{
+			continue;
+		}
 		if (!Q_stricmp(s, match))
 		{
 			return from;
@@ -351,6 +534,111 @@ gentity_t *G_Find(gentity_t *from, int fieldofs, const char *match)
 	return NULL;
 }
 
+/**
+ * @brief Looks up the next entity after from with a matching name in the index
+ * @param[in] from
+ * @param[in] field
+ * @param[in] match
+ * @param[in] hash BG_StringHashValue() of match
+ * @param[in] checkHash Also compare the targetnamehash of the entities
+ * @return
+ */
+static gentity_t *G_FindIndexed(gentity_t *from, entIndexField_t field, const char *match, int hash, qboolean checkHash)
+{
+	entIndex_t *index = &entIndex[field];
+	gentity_t  *ent   = NULL;
+	char       *s;
+	int        bucket = hash & (ENTINDEX_BUCKETS - 1);
+	int        num, start = from ? (int)(from - g_entities) : -1;
+
+	G_EntityIndexFlush();
+
+	// continue behind 'from' if it still is in this chain
+	if (start >= 0 && index->bucket[start] == bucket)
+	{
+		num = index->next[start];
+	}
+	else
+	{
+		for (num = index->head[bucket]; num >= 0 && num <= start; num = index->next[num])
+		{
+		}
+	}
+
+	for ( ; num >= 0 && num < level.num_entities; num = index->next[num])
+	{
+		if (!g_entities[num].inuse)
+		{
+			continue;
+		}
+		s = *(char **)((byte *)&g_entities[num] + entIndexOfs[field]);
+		if (!s)
+		{
+			continue;
+		}
+		if (checkHash && g_entities[num].targetnamehash != hash)
+		{
+			continue;
+		}
+		if (!Q_stricmp(s, match))
+		{
+			ent = &g_entities[num];
+			break;
+		}
+	}
+
+#ifdef ETLEGACY_DEBUG
+	if (g_debugEntityIndex.integer)
+	{
+		gentity_t *check = G_FindLinear(from, entIndexOfs[field], match, checkHash ? hash : -1);
+
+		if (check != ent)
+		{
+			G_Printf(S_COLOR_YELLOW "WARNING G_FindIndexed: field %i lookup of \"%s\" after %i found %i, the entity list has %i\n",
+			         field, match, start, ent ? (int)(ent - g_entities) : -1, check ? (int)(check - g_entities) : -1);
+			G_SyncEntityIndex();
+			return check;
+		}
+	}
+#endif
+
+	return ent;
+}
+
+/**
+ * @brief Searches all active entities for the next one that holds
+ * the matching string at fieldofs (use the FOFS() macro) in the structure.
+ * Searches beginning at the entity after from, or the beginning if NULL
+ * NULL will be returned if the end of the list is reached.
+ *
+ * @param[in,out] from
+ * @param[in] fieldofs
+ * @param[in] match
+ * @return
+ *
+ * @note targetname, scriptName and classname are looked up in the entity name index.
+ * A name changed without G_TouchEntityIndex() is only found under its new value
+ * after G_SyncEntityIndex() ran at the start of the next frame, until then
+ * lookups within the same frame still see the old name.
+ */
+gentity_t *G_Find(gentity_t *from, int fieldofs, const char *match)
+{
+	int i;
+
+	if (match)
+	{
+		for (i = 0; i < ENTINDEX_MAX; i++)
+		{
+			if (fieldofs == entIndexOfs[i])
+			{
+				return G_FindIndexed(from, (entIndexField_t)i, match, (int)BG_StringHashValue(match), qfalse);
+			}
+		}
+	}
+
+	return G_FindLinear(from, fieldofs, match, -1);
+}
+
 /**
  * @brief Like G_Find, but searches for integer values.
  * @param[in,out] from
@@ -474,8 +762,7 @@ gentity_t *G_FindVector(gentity_t *from, int fieldofs, const vec3_t match)
  */
 gentity_t *G_FindByTargetname(gentity_t *from, const char *match)
 {
-	gentity_t *max = &g_entities[level.num_entities];
-	int       hash;
+	int hash;
 
 	hash = BG_StringHashValue(match);
 
@@ -485,34 +772,7 @@ gentity_t *G_FindByTargetname(gentity_t *from, const char *match)
 		return NULL;
 	}
 
-	if (!from)
-	{
-		from = g_entities;
-	}
-	else
-	{
-		from++;
-	}
-
-	for ( ; from < max ; from++)
-	{
-		if (!from->inuse)
-		{
-			continue;
-		}
-
-		if (!from->targetname) // there are ents with no targetname set
-		{
-			continue;
-		}
-
-		if (from->targetnamehash == hash && !Q_stricmp(from->targetname, match))
-		{
-			return from;
-		}
-	}
-
-	return NULL;
+	return G_FindIndexed(from, ENTINDEX_TARGETNAME, match, hash, qtrue);
 }
 
 /**
@@ -524,36 +784,12 @@ gentity_t *G_FindByTargetname(gentity_t *from, const char *match)
  */
 gentity_t *G_FindByTargetnameFast(gentity_t *from, const char *match, int hash)
 {
-	gentity_t *max = &g_entities[level.num_entities];
-
-	if (!from)
+	if (!match)
 	{
-		from = g_entities;
-	}
-	else
-	{
-		from++;
-	}
-
-	for ( ; from < max ; from++)
-	{
-		if (!from->inuse)
-		{
-			continue;
-		}
-
-		if (!from->targetname) // there are ents with no targetname set
-		{
-			continue;
-		}
-
-		if (from->targetnamehash == hash && !Q_stricmp(from->targetname, match))
-		{
-			return from;
-		}
+		return NULL;
 	}
 
-	return NULL;
+	return G_FindIndexed(from, ENTINDEX_TARGETNAME, match, hash, qtrue);
 }
 
 #define MAXCHOICES  32
@@ -598,6 +834,175 @@ gentity_t *G_PickTarget(const char *targetname)
 	return choice[rand() % num_choices];
 }
 
+/**
+=========================================================================
+entity categories
+=========================================================================
+*/
+
+/**
+ * @struct entCategoryList_t
+ * @brief Numbers of the entities of one category, in ascending order
+ */
+typedef struct
+{
+	short num[MAX_GENTITIES];
+	int count;
+} entCategoryList_t;
+
+static entCategoryList_t entCategoryLists[ENTCAT_MAX];
+static signed char       entCategory[MAX_GENTITIES];    ///< list the entity is in, ENTCAT_NONE if none
+
+/**
+ * @brief Works out the category of an entity
+ * @param[in] ent
+ * @return
+ */
+static entCategory_t G_EntityCategory(gentity_t *ent)
+{
+	if (!ent->inuse)
+	{
+		return ENTCAT_NONE;
+	}
+
+	switch (ent->s.eType)
+	{
+	case ET_MISSILE:
+		switch (ent->methodOfDeath)
+		{
+		case MOD_LANDMINE:
+			return ENTCAT_LANDMINE;
+		case MOD_DYNAMITE:
+			return ENTCAT_DYNAMITE;
+		case MOD_SATCHEL:
+			return ENTCAT_SATCHEL;
+		default:
+			return ENTCAT_NONE;
+		}
+	case ET_CONSTRUCTIBLE_INDICATOR:
+	case ET_EXPLOSIVE_INDICATOR:
+	case ET_TANK_INDICATOR:
+	case ET_TANK_INDICATOR_DEAD:
+		return ENTCAT_INDICATOR;
+	case ET_COMMANDMAP_MARKER:
+		return ENTCAT_COMMANDMAP_MARKER;
+	default:
+		return ENTCAT_NONE;
+	}
+}
+
+/**
+ * @brief Finds the position of the first entity numbered num or higher in a list
+ * @param[in] list
+ * @param[in] num
+ * @return
+ */
+static int G_EntityCategorySearch(entCategoryList_t *list, int num)
+{
+	int low = 0, high = list->count, mid;
+
+	while (low < high)
+	{
+		mid = (low + high) >> 1;
+
+		if (list->num[mid] < num)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	return low;
+}
+
+/**
+ * @brief Moves an entity to the list of its current category
+ * @param[in] ent
+ *
+ * @note Needed wherever the eType or methodOfDeath of an entity changes to or from one
+ * that has a category, and when it's freed.
+ */
+void G_UpdateEntityCategory(gentity_t *ent)
+{
+	entCategoryList_t *list;
+	entCategory_t     category = G_EntityCategory(ent);
+	int               num      = ent - g_entities;
+	int               pos;
+
+	if (category == entCategory[num])
+	{
+		return;
+	}
+
+	if (entCategory[num] != ENTCAT_NONE)
+	{
+		list = &entCategoryLists[(int)entCategory[num]];
+		pos  = G_EntityCategorySearch(list, num);
+
+		memmove(&list->num[pos], &list->num[pos + 1], (list->count - pos - 1) * sizeof(list->num[0]));
+		list->count--;
+	}
+
+	if (category != ENTCAT_NONE)
+	{
+		list = &entCategoryLists[category];
+		pos  = G_EntityCategorySearch(list, num);
+
+		memmove(&list->num[pos + 1], &list->num[pos], (list->count - pos) * sizeof(list->num[0]));
+		list->num[pos] = num;
+		list->count++;
+	}
+
+	entCategory[num] = category;
+}
+
+/**
+ * @brief Empties the category lists and sorts the current entities into them
+ */
+void G_InitEntityCategories(void)
+{
+	int i;
+
+	Com_Memset(entCategoryLists, 0, sizeof(entCategoryLists));
+	Com_Memset(entCategory, ENTCAT_NONE, sizeof(entCategory));
+
+	for (i = 0; i < MAX_GENTITIES; i++)
+	{
+		G_UpdateEntityCategory(&g_entities[i]);
+	}
+}
+
+/**
+ * @brief Searches the entities of a category, in the same order as a scan of all entities would
+ * @param[in] from Entity to continue after, NULL to start at the first one
+ * @param[in] category
+ * @return The next entity of the category, NULL if there is none.
+ *
+ * @note The entity returned last may be freed before the next call.
+ */
+gentity_t *G_FindByCategory(gentity_t *from, entCategory_t category)
+{
+	entCategoryList_t *list = &entCategoryLists[category];
+	int               pos;
+
+	pos = G_EntityCategorySearch(list, from ? (int)(from - g_entities) + 1 : 0);
+
+	return pos < list->count ? &g_entities[list->num[pos]] : NULL;
+}
+
+/**
+ * @brief Counts the entities of a category
+ * @param[in] category
+ * @return
+ */
+int G_CountByCategory(entCategory_t category)
+{
+	return entCategoryLists[category].count;
+}
+
 /**
  * @brief G_AllowTeamsAllowed
  * @param[in] ent
@@ -772,12 +1177,211 @@ void G_SetMovedir(vec3_t angles, vec3_t movedir)
 	VectorClear(angles);
 }
 
+/**
+=========================================================================
+free entity queues
+=========================================================================
+*/
+
+#define ENTFREE_QUEUE_SIZE MAX_GENTITIES   ///< power of two
+#define ENTFREE_RELAX_MSEC 1000            ///< time a freed slot rests before it's reused
+
+/**
+ * @struct entFreeQueue_t
+ * @brief FIFO ring of freed entity slots
+ */
+typedef struct
+{
+	short num[ENTFREE_QUEUE_SIZE];
+	int serial[ENTFREE_QUEUE_SIZE];     ///< entry is stale unless it matches entFree.serial of its slot
+	int head;                           ///< head and tail run freely and are masked on access
+	int tail;
+	int count;                          ///< valid entries
+} entFreeQueue_t;
+
+/**
+ * @struct entFreeList_t
+ * @brief Free entity slots of G_Spawn() and its allocation counters
+ */
+typedef struct
+{
+	entFreeQueue_t ready;               ///< slots that can be reused right away
+	entFreeQueue_t relax;               ///< slots that have to rest first, in freetime order
+
+	int serial[MAX_GENTITIES];          ///< serial of the valid queue entry of each slot, 0 for none
+	entFreeQueue_t *owner[MAX_GENTITIES];
+	int nextSerial;
+
+	int spawns;
+	int reusedReady;
+	int reusedRelaxed;
+	int reusedForced;
+	int grown;
+	int peakQueued;
+} entFreeList_t;
+
+static entFreeList_t entFree;
+
+/**
+ * @brief Drops the stale entries of a full queue
+ * @param[in,out] q
+ */
+static void G_EntFreeQueueCompact(entFreeQueue_t *q)
+{
+	int i, j = q->head;
+
+	for (i = q->head; i != q->tail; i++)
+	{
+		int num = q->num[i & (ENTFREE_QUEUE_SIZE - 1)];
+		int ser = q->serial[i & (ENTFREE_QUEUE_SIZE - 1)];
+
+		if (entFree.serial[num] == ser)
+		{
+			q->num[j & (ENTFREE_QUEUE_SIZE - 1)]    = num;
+			q->serial[j & (ENTFREE_QUEUE_SIZE - 1)] = ser;
+			j++;
+		}
+	}
+
+	q->tail = j;
+}
+
+/**
+ * @brief Queues a freed slot, an older entry of the same slot goes stale
+ * @param[in,out] q
+ * @param[in] num
+ */
+static void G_EntFreeQueuePush(entFreeQueue_t *q, int num)
+{
+	if (entFree.serial[num])
+	{
+		entFree.owner[num]->count--;
+	}
+
+	if (q->tail - q->head == ENTFREE_QUEUE_SIZE)
+	{
+		G_EntFreeQueueCompact(q);
+	}
+
+	if (++entFree.nextSerial <= 0)
+	{
+		entFree.nextSerial = 1;
+	}
+
+	q->num[q->tail & (ENTFREE_QUEUE_SIZE - 1)]    = num;
+	q->serial[q->tail & (ENTFREE_QUEUE_SIZE - 1)] = entFree.nextSerial;
+	q->tail++;
+	q->count++;
+
+	entFree.serial[num] = entFree.nextSerial;
+	entFree.owner[num]  = q;
+
+	if (entFree.ready.count + entFree.relax.count > entFree.peakQueued)
+	{
+		entFree.peakQueued = entFree.ready.count + entFree.relax.count;
+	}
+}
+
+/**
+ * @brief Drops stale entries from the head of a queue
+ * @param[in,out] q
+ * @return Oldest queued slot or -1 if the queue is empty
+ */
+static int G_EntFreeQueuePeek(entFreeQueue_t *q)
+{
+	while (q->head != q->tail)
+	{
+		int num = q->num[q->head & (ENTFREE_QUEUE_SIZE - 1)];
+
+		if (entFree.serial[num] == q->serial[q->head & (ENTFREE_QUEUE_SIZE - 1)])
+		{
+			if (!g_entities[num].inuse)
+			{
+				return num;
+			}
+
+			// slot was taken without going through G_Spawn()
+			entFree.serial[num] = 0;
+			q->count--;
+		}
+
+		q->head++;
+	}
+
+	return -1;
+}
+
+/**
+ * @brief Takes the head entry returned by G_EntFreeQueuePeek() off the queue
+ * @param[in,out] q
+ * @param[in] num
+ */
+static void G_EntFreeQueuePop(entFreeQueue_t *q, int num)
+{
+	entFree.serial[num] = 0;
+	q->count--;
+	q->head++;
+}
+
+/**
+ * @brief Queues a slot released by G_FreeEntity()
+ * @param[in] ent
+ *
+ * @note Slots freed in the first couple seconds of server time or without
+ * a freetime (temp and event entities) can be reused right away.
+ */
+static void G_QueueFreeEntity(gentity_t *ent)
+{
+	int num = ent - g_entities;
+
+	if (num < MAX_CLIENTS || num >= level.num_entities)
+	{
+		return;
+	}
+
+	if (ent->freetime > level.startTime + 2000)
+	{
+		G_EntFreeQueuePush(&entFree.relax, num);
+	}
+	else
+	{
+		G_EntFreeQueuePush(&entFree.ready, num);
+	}
+}
+
+/**
+ * @brief Empties the free entity queues and clears the counters
+ */
+void G_InitEntityFreeList(void)
+{
+	Com_Memset(&entFree, 0, sizeof(entFree));
+}
+
+/**
+ * @brief Prints the G_Spawn() counters for the game_memory command
+ */
+void G_EntityFreeListStats(void)
+{
+	int seconds = (level.time - level.startTime) / 1000;
+
+	G_Printf("Entity slots: %i out of %i in use (%i%%) - %i queued for reuse (%i ready, %i relaxing), peak %i\n",
+	         level.num_entities - entFree.ready.count - entFree.relax.count, ENTITYNUM_MAX_NORMAL,
+	         (level.num_entities - entFree.ready.count - entFree.relax.count) * 100 / ENTITYNUM_MAX_NORMAL,
+	         entFree.ready.count + entFree.relax.count, entFree.ready.count, entFree.relax.count, entFree.peakQueued);
+	G_Printf("Entity spawns: %i (%.1f/s) - %i new slots, %i reused (%i ready, %i relaxed, %i forced)\n",
+	         entFree.spawns, seconds > 0 ? entFree.spawns / (float)seconds : 0.f, entFree.grown,
+	         entFree.reusedReady + entFree.reusedRelaxed + entFree.reusedForced,
+	         entFree.reusedReady, entFree.reusedRelaxed, entFree.reusedForced);
+}
+
 /**
  * @brief G_InitGentity
  * @param[in,out] e
  */
 void G_InitGentity(gentity_t *e)
 {
+	G_TouchEntityIndex(e);
+
 	e->inuse      = qtrue;
 	e->classname  = "noclass";
 	e->s.number   = e - g_entities;
@@ -812,50 +1416,62 @@ void G_InitGentity(gentity_t *e)
  */
 gentity_t *G_Spawn(void)
 {
-	int       i = 0, force;
-	gentity_t *e = NULL;
+	gentity_t      *e;
+	entFreeQueue_t *q = &entFree.ready;
+	int            num;
 
-	for (force = 0 ; force < 2 ; force++)
-	{
-		// if we go through all entities and can't find one to free,
-		// override the normal minimum times before use
-		e = &g_entities[MAX_CLIENTS];
-		for (i = MAX_CLIENTS ; i < level.num_entities ; i++, e++)
-		{
-			if (e->inuse)
-			{
-				continue;
-			}
+	entFree.spawns++;
 
-			// the first couple seconds of server time can involve a lot of
-			// freeing and allocating, so relax the replacement policy
-			// FIXME: inspect -> add '&& level.startTime != 0' for warmup?
-			if (!force && e->freetime > level.startTime + 2000 && level.time - e->freetime < 1000)
-			{
-				continue;
-			}
+	// the first couple seconds of server time can involve a lot of
+	// freeing and allocating, so those slots don't relax
+	// FIXME: inspect -> add '&& level.startTime != 0' for warmup?
+	num = G_EntFreeQueuePeek(q);
+	if (num >= 0)
+	{
+		entFree.reusedReady++;
+	}
+	else
+	{
+		q   = &entFree.relax;
+		num = G_EntFreeQueuePeek(q);
 
-			// reuse this slot
-			G_InitGentity(e);
-			return e;
+		if (num >= 0 && level.time - g_entities[num].freetime >= ENTFREE_RELAX_MSEC)
+		{
+			entFree.reusedRelaxed++;
 		}
-		if (i != ENTITYNUM_MAX_NORMAL)
+		else if (level.num_entities < ENTITYNUM_MAX_NORMAL)
 		{
-			break;
+			num = -1;
+		}
+		else if (num >= 0)
+		{
+			// can't find one to free, override the normal minimum times before use
+			entFree.reusedForced++;
 		}
 	}
 
-	if (i == ENTITYNUM_MAX_NORMAL)
+	if (num >= 0)
 	{
-		for (i = 0; i < MAX_GENTITIES; i++)
+		// reuse this slot
+		G_EntFreeQueuePop(q, num);
+		e = &g_entities[num];
+		G_InitGentity(e);
+		return e;
+	}
+
+	if (level.num_entities == ENTITYNUM_MAX_NORMAL)
+	{
+		for (num = 0; num < MAX_GENTITIES; num++)
 		{
-			G_Printf("%4i: %s\n", i, g_entities[i].classname);
+			G_Printf("%4i: %s\n", num, g_entities[num].classname);
 		}
 		G_Error("G_Spawn: no free entities\n");
 	}
 
 	// open up a new slot
+	e = &g_entities[level.num_entities];
 	level.num_entities++;
+	entFree.grown++;
 
 	// let the server system know that there are more entities
 	trap_LocateGameData(level.gentities, level.num_entities, sizeof(gentity_t),
@@ -909,6 +1525,11 @@ void G_FreeEntity(gentity_t *ent)
 		return;
 	}
 
+	if (ent->targetname || ent->scriptName)
+	{
+		G_Script_InvalidateEntityRefs();
+	}
+
 	// this tiny hack fixes level.num_entities rapidly reaching MAX_GENTITIES-1
 	// some very often spawned entities don't have to relax (=spawned, immediately freed and not transmitted)
 	// before all game entities did relax - now  ET_TEMPHEAD, ET_TEMPLEGS and ET_EVENTS no longer relax
@@ -936,7 +1557,7 @@ void G_FreeEntity(gentity_t *ent)
 		// game entity is immediately available and a 'slot' will be reused
 		Com_Memset(ent, 0, sizeof(*ent));
 		ent->classname = "freed";
-		ent->freetime  = -9999;  // e->freetime is never greater than level.startTime + 2000 see G_Spawn()
+		ent->freetime  = -9999;  // e->freetime is never greater than level.startTime + 2000 see G_QueueFreeEntity()
 		ent->inuse     = qfalse;
 	}
 	else // all other game entities relax
@@ -946,6 +1567,10 @@ void G_FreeEntity(gentity_t *ent)
 		ent->freetime  = level.time;
 		ent->inuse     = qfalse;
 	}
+
+	G_QueueFreeEntity(ent);
+	G_TouchEntityIndex(ent);
+	G_UpdateEntityCategory(ent);
 }
 
 /**
@@ -1162,6 +1162,7 @@ static qboolean TryConstructing(gentity_t *ent, gentity_t *trigger)
 						e->parent = tent;
 					}
 				}
+				G_UpdateEntityCategory(e);
 
 				if (constructible->spawnflags & AXIS_CONSTRUCTIBLE)
 				{
@@ -1197,11 +1198,10 @@ static qboolean TryConstructing(gentity_t *ent, gentity_t *trigger)
 			}
 			else
 			{
-				gentity_t *check;
-				int       i;
+				gentity_t *check = NULL;
 
 				// find our marker and update it's coordinates
-				for (i = 0, check = g_entities; i < level.num_entities; i++, check++)
+				while ((check = G_FindByCategory(check, ENTCAT_INDICATOR)) != NULL)
 				{
 					if (check->s.eType != ET_EXPLOSIVE_INDICATOR && check->s.eType != ET_TANK_INDICATOR && check->s.eType != ET_TANK_INDICATOR_DEAD)
 					{
@@ -1376,6 +1376,7 @@ void AutoBuildConstruction(gentity_t *constructible)
 					e->parent = tent;
 				}
 			}
+			G_UpdateEntityCategory(e);
 
 			if (constructible->spawnflags & AXIS_CONSTRUCTIBLE)
 			{
@@ -1411,11 +1412,10 @@ void AutoBuildConstruction(gentity_t *constructible)
 		}
 		else
 		{
-			gentity_t *check;
-			int       i;
+			gentity_t *check = NULL;
 
 			// find our marker and update it's coordinates
-			for (i = 0, check = g_entities; i < level.num_entities; i++, check++)
+			while ((check = G_FindByCategory(check, ENTCAT_INDICATOR)) != NULL)
 			{
 				if (check->s.eType != ET_EXPLOSIVE_INDICATOR && check->s.eType != ET_TANK_INDICATOR && check->s.eType != ET_TANK_INDICATOR_DEAD)
 				{
@@ -3424,7 +3424,8 @@ gentity_t *Bullet_Fire(gentity_t *ent)
 
 	Bullet_Endpos(ent, spread, &end);
 
-	G_HistoricalTraceBegin(ent);
+	// the bullet and the ones it spawns passing through stay on this line
+	G_HistoricalTraceBeginSegment(ent, muzzleTrace, NULL, NULL, end);
 
 	// skip corpses for bullet tracing (=non gibbing weapons)
 	G_TempTraceIgnoreBodies();
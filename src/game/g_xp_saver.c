@@ -39,7 +39,7 @@
 #define assert_return(cond, status, msg) \
 		if (!(cond)) { \
 			if (msg) { \
-				G_Printf("^1%s (%i): failed: %s\n", __func__, __LINE__, msg); \
+				G_DB_Printf("^1%s (%i): failed: %s\n", __func__, __LINE__, msg); \
 			} \
 			return status; \
 		}
@@ -51,14 +51,26 @@ typedef struct xpData_s
 	int medals[SK_NUM_SKILLS];
 } xpData_t;
 
+/**
+ * @struct xpJob_t
+ * @brief XP queued for the database thread
+ */
+typedef struct
+{
+	int clientNum;
+	char guid[MAX_GUID_LENGTH + 1];
+	xpData_t xp_data;
+	int result;
+} xpJob_t;
+
 static int G_XPSaver_Read(xpData_t *xp_data);
 static int G_XPSaver_Write(xpData_t *xp_data);
 
 #define XPCHECK_SQLWRAP_TABLES "SELECT * FROM xpsave_users;"
 #define XPCHECK_SQLWRAP_SCHEMA "SELECT guid, skills, medals, created, updated FROM xpsave_users;"
-#define XPUSERS_SQLWRAP_SELECT "SELECT * FROM xpsave_users WHERE guid = '%s';"
-#define XPUSERS_SQLWRAP_INSERT "INSERT INTO xpsave_users (guid, skills, medals, created, updated) VALUES ('%s', ?, ?, CURRENT_TIMESTAMP, CURRENT_TIMESTAMP);"
-#define XPUSERS_SQLWRAP_UPDATE "UPDATE xpsave_users SET skills = ?, medals = ?, updated = CURRENT_TIMESTAMP WHERE guid = '%s';"
+#define XPUSERS_SQLWRAP_SELECT "SELECT * FROM xpsave_users WHERE guid = ?1;"
+#define XPUSERS_SQLWRAP_UPSERT "INSERT INTO xpsave_users (guid, skills, medals, created, updated) VALUES (?1, ?2, ?3, CURRENT_TIMESTAMP, CURRENT_TIMESTAMP) " \
+	                           "ON CONFLICT (guid) DO UPDATE SET skills = excluded.skills, medals = excluded.medals, updated = excluded.updated;"
 #define XPUSERS_SQLWRAP_DELETE "DELETE FROM xpsave_users"
 
 /**
@@ -140,16 +152,64 @@ int G_XPSaver_CheckDB(char *db_path, int db_mode)
 	return 0;
 }
 
+/**
+ * @brief Retrieves XP on the database thread
+ * @param[in,out] data
+ */
+static void G_XPSaver_LoadJob(void *data)
+{
+	xpJob_t *job = (xpJob_t *)data;
+
+	job->xp_data.guid = (const unsigned char *)job->guid;
+	job->result       = G_XPSaver_Read(&job->xp_data);
+}
+
+/**
+ * @brief Assigns the retrieved XP to the client session
+ * @param[in] data
+ */
+static void G_XPSaver_LoadDone(void *data)
+{
+	xpJob_t   *job = (xpJob_t *)data;
+	gclient_t *cl;
+	int       i;
+
+	// client left or slot was taken over while loading
+	if (job->result || !G_DB_IsSameClient(job->clientNum, job->guid))
+	{
+		return;
+	}
+
+	cl = level.clients + job->clientNum;
+
+	// assign user data to session
+	cl->sess.startxptotal = 0;
+	for (i = 0; i < SK_NUM_SKILLS; i++)
+	{
+		cl->sess.skillpoints[i]      = job->xp_data.skillpoints[i];
+		cl->sess.startskillpoints[i] = job->xp_data.skillpoints[i];
+		cl->sess.startxptotal       += job->xp_data.skillpoints[i];
+		cl->sess.medals[i]          += job->xp_data.medals[i];
+	}
+
+	for (i = 0; i < SK_NUM_SKILLS; i++)
+	{
+		G_SetPlayerSkill(cl, i);
+	}
+
+	ClientUserinfoChanged(job->clientNum);
+}
+
 /**
  * @brief Retrieves xp for a client
+ *        The query is queued, the xp is assigned at the start of a later frame.
  * @param[in] cl
  */
 void G_XPSaver_Load(gclient_t *cl)
 {
 	char      userinfo[MAX_INFO_STRING];
-	char      *guid;
-	int       clientNum, i;
-	xpData_t  xp_data;
+	int       clientNum;
+	xpJob_t   job;
 	gentity_t *ent;
 
 	if (!level.database.initialized)
@@ -175,38 +235,36 @@ void G_XPSaver_Load(gclient_t *cl)
 
 	// retrieve guid
 	trap_GetUserinfo(clientNum, userinfo, sizeof(userinfo));
-	guid = Info_ValueForKey(userinfo, "cl_guid");
 
-	// assign guid
-	xp_data.guid = (const unsigned char *)guid;
+	Com_Memset(&job, 0, sizeof(job));
+	job.clientNum = clientNum;
+	Q_strncpyz(job.guid, Info_ValueForKey(userinfo, "cl_guid"), sizeof(job.guid));
 
-	// retrieve current xp or assign default values
-	if (G_XPSaver_Read(&xp_data))
-	{
-		return;
-	}
+	G_DB_QueueJob("xpsaver load", G_XPSaver_LoadJob, G_XPSaver_LoadDone, &job, sizeof(job));
+}
 
-	// assign user data to session
-	cl->sess.startxptotal = 0;
-	for (i = 0; i < SK_NUM_SKILLS; i++)
-	{
-		cl->sess.skillpoints[i]      = xp_data.skillpoints[i];
-		cl->sess.startskillpoints[i] = xp_data.skillpoints[i];
-		cl->sess.startxptotal       += xp_data.skillpoints[i];
-		cl->sess.medals[i]          += xp_data.medals[i];
-	}
+/**
+ * @brief Saves XP on the database thread
+ * @param[in,out] data
+ */
+static void G_XPSaver_StoreJob(void *data)
+{
+	xpJob_t *job = (xpJob_t *)data;
+
+	job->xp_data.guid = (const unsigned char *)job->guid;
+	job->result       = G_XPSaver_Write(&job->xp_data);
 }
 
 /**
  * @brief Updates xp stats and timestamp for client
+ *        The query is queued, the session data is copied.
  * @param[in] cl
  */
 void G_XPSaver_Store(gclient_t *cl)
 {
 	char      userinfo[MAX_INFO_STRING];
-	char      *guid;
 	int       clientNum, i;
-	xpData_t  xp_data;
+	xpJob_t   job;
 	gentity_t *ent;
 
 	if (!level.database.initialized)
@@ -238,21 +296,19 @@ void G_XPSaver_Store(gclient_t *cl)
 
 	// retrieve guid
 	trap_GetUserinfo(clientNum, userinfo, sizeof(userinfo));
-	guid = Info_ValueForKey(userinfo, "cl_guid");
 
-	xp_data.guid = (const unsigned char *)guid;
+	Com_Memset(&job, 0, sizeof(job));
+	job.clientNum = clientNum;
+	Q_strncpyz(job.guid, Info_ValueForKey(userinfo, "cl_guid"), sizeof(job.guid));
 
 	for (i = 0; i < SK_NUM_SKILLS; i++)
 	{
-		xp_data.skillpoints[i] = (int)cl->sess.skillpoints[i];
-		xp_data.medals[i]      = (int)cl->sess.medals[i];
+		job.xp_data.skillpoints[i] = (int)cl->sess.skillpoints[i];
+		job.xp_data.medals[i]      = (int)cl->sess.medals[i];
 	}
 
 	// save or update xp
-	if (G_XPSaver_Write(&xp_data))
-	{
-		return;
-	}
+	G_DB_QueueJob("xpsaver store", G_XPSaver_StoreJob, NULL, &job, sizeof(job));
 }
 
 /**
@@ -263,7 +319,6 @@ void G_XPSaver_Store(gclient_t *cl)
 static int G_XPSaver_Read(xpData_t *xp_data)
 {
 	int          result, i;
-	const char   *err;
 	sqlite3_stmt *sqlstmt;
 	const int    *pSkills;
 	const int    *pMedals;
@@ -273,23 +328,35 @@ static int G_XPSaver_Read(xpData_t *xp_data)
 
 	if (!level.database.initialized)
 	{
-		G_Printf("G_XPSaver_Read: access to non-initialized database\n");
+		G_DB_Printf("G_XPSaver_Read: access to non-initialized database\n");
 		return 1;
 	}
 
-	result = sqlite3_prepare(level.database.db, va(XPUSERS_SQLWRAP_SELECT, xp_data->guid), -1, &sqlstmt, NULL);
-	assert_return(result == SQLITE_OK, 1, sqlite3_errmsg(level.database.db));
+	sqlstmt = G_DB_Statement(XPUSERS_SQLWRAP_SELECT);
+	if (!sqlstmt)
+	{
+		return 1;
+	}
 
-	result = sqlite3_step(sqlstmt);
+	result = sqlite3_bind_text(sqlstmt, 1, (const char *)xp_data->guid, -1, SQLITE_STATIC);
+
+	if (result == SQLITE_OK)
+	{
+		result = sqlite3_step(sqlstmt);
+	}
 
 	if (result == SQLITE_ROW)
 	{
 		/* retrieve skills */
 		pSkills = (int *)sqlite3_column_blob(sqlstmt, 1);
-		assert_return(pSkills, 1, sqlite3_errmsg(level.database.db));
-
 		pMedals = (int *)sqlite3_column_blob(sqlstmt, 2);
-		assert_return(pMedals, 2, sqlite3_errmsg(level.database.db));
+
+		if (!pSkills || !pMedals)
+		{
+			G_DB_Printf("^1%s (%i): failed: %s\n", __func__, __LINE__, sqlite3_errmsg(level.database.db));
+			G_DB_ReleaseStatement(sqlstmt);
+			return 1;
+		}
 
 		for (i = 0; i < SK_NUM_SKILLS; i++)
 		{
@@ -300,17 +367,12 @@ static int G_XPSaver_Read(xpData_t *xp_data)
 	// no entry found or other failure
 	else if (result != SQLITE_DONE)
 	{
-		err = sqlite3_errmsg(level.database.db);
-		if (err)
-		{
-			G_Printf("^3%s (%i): failed: %s\n", __func__, __LINE__, err);
-		}
-		sqlite3_finalize(sqlstmt);
+		G_DB_Printf("^3%s (%i): failed: %s\n", __func__, __LINE__, sqlite3_errmsg(level.database.db));
+		G_DB_ReleaseStatement(sqlstmt);
 		return 1;
 	}
 
-	result = sqlite3_finalize(sqlstmt);
-	assert_return(result == SQLITE_OK, 1, sqlite3_errmsg(level.database.db));
+	G_DB_ReleaseStatement(sqlstmt);
 
 	return 0;
 }
@@ -331,15 +393,10 @@ static int G_XPSaver_Write(xpData_t *xp_data)
 
 	if (!level.database.initialized)
 	{
-		G_Printf("G_XPSaver_Write: access to non-initialized database\n");
+		G_DB_Printf("G_XPSaver_Write: access to non-initialized database\n");
 		return 1;
 	}
 
-	result = sqlite3_prepare(level.database.db, va(XPUSERS_SQLWRAP_SELECT, xp_data->guid), -1, &sqlstmt, NULL);
-	assert_return(result == SQLITE_OK, 1, sqlite3_errmsg(level.database.db));
-
-	result = sqlite3_step(sqlstmt);
-
 	pSkills = buffer;
 	pMedals = buffer + SK_NUM_SKILLS;
 	for (i = 0; i < SK_NUM_SKILLS; i++)
@@ -348,27 +405,34 @@ static int G_XPSaver_Write(xpData_t *xp_data)
 		bf_write(pMedals, int, xp_data->medals[i]);
 	}
 
-	if (result == SQLITE_DONE)
+	sqlstmt = G_DB_Statement(XPUSERS_SQLWRAP_UPSERT);
+	assert_return(sqlstmt, 1, sqlite3_errmsg(level.database.db));
+
+	result = sqlite3_bind_text(sqlstmt, 1, (const char *)xp_data->guid, -1, SQLITE_STATIC);
+
+	if (result == SQLITE_OK)
 	{
-		result = sqlite3_prepare(level.database.db, va(XPUSERS_SQLWRAP_INSERT, xp_data->guid), -1, &sqlstmt, NULL);
+		result = sqlite3_bind_blob(sqlstmt, 2, buffer, sizeof(int) * SK_NUM_SKILLS, SQLITE_STATIC);
 	}
-	else
+
+	if (result == SQLITE_OK)
 	{
-		result = sqlite3_prepare(level.database.db, va(XPUSERS_SQLWRAP_UPDATE, xp_data->guid), -1, &sqlstmt, NULL);
+		result = sqlite3_bind_blob(sqlstmt, 3, buffer + SK_NUM_SKILLS, sizeof(int) * SK_NUM_SKILLS, SQLITE_STATIC);
 	}
-	assert_return(result == SQLITE_OK, 1, sqlite3_errmsg(level.database.db));
-
-	result = sqlite3_bind_blob(sqlstmt, 1, buffer, sizeof(int) * SK_NUM_SKILLS, SQLITE_STATIC);
-	assert_return(result == SQLITE_OK, 1, sqlite3_errmsg(level.database.db));
 
-	result = sqlite3_bind_blob(sqlstmt, 2, buffer + SK_NUM_SKILLS, sizeof(int) * SK_NUM_SKILLS, SQLITE_STATIC);
-	assert_return(result == SQLITE_OK, 1, sqlite3_errmsg(level.database.db));
+	if (result == SQLITE_OK)
+	{
+		result = sqlite3_step(sqlstmt);
+	}
 
-	result = sqlite3_step(sqlstmt);
-	assert_return(result == SQLITE_DONE, 1, sqlite3_errmsg(level.database.db));
+	if (result != SQLITE_DONE)
+	{
+		G_DB_Printf("^1%s (%i): failed: %s\n", __func__, __LINE__, sqlite3_errmsg(level.database.db));
+		G_DB_ReleaseStatement(sqlstmt);
+		return 1;
+	}
 
-	result = sqlite3_finalize(sqlstmt);
-	assert_return(result == SQLITE_OK, 1, sqlite3_errmsg(level.database.db));
+	G_DB_ReleaseStatement(sqlstmt);
 
 	return 0;
 }
@@ -388,6 +452,9 @@ int G_XPSaver_Clear()
 		return 1;
 	}
 
+	// pending stores would bring the data back
+	G_DB_Flush();
+
 	result = sqlite3_exec(level.database.db, XPUSERS_SQLWRAP_DELETE, 0, 0, &err_msg);
 
 	if (result != SQLITE_OK)
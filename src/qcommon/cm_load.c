@@ -224,6 +224,57 @@ void CM_BoundBrush(cbrush_t *b)
 	b->bounds[1][2] = b->sides[5].plane->dist;
 }
 
+/**
+ * @brief Copies the side planes of all map brushes into the structure of
+ * arrays layout used by the traces.
+ *
+ * @note The box brush is left out, its planes are changed by CM_TempBoxModel()
+ */
+static void CM_LoadBrushPlanes(void)
+{
+	cbrush_t       *b;
+	cbrushPlanes_t *planes;
+	cplane_t       *plane;
+	int            i, j, k, numBlocks = 0;
+
+	for (i = 0, b = cm.brushes; i < cm.numBrushes; i++, b++)
+	{
+		numBlocks += (b->numsides + 3) >> 2;
+	}
+
+	planes = Hunk_Alloc(numBlocks * sizeof(*planes), h_high);
+
+	for (i = 0, b = cm.brushes; i < cm.numBrushes; i++, b++)
+	{
+		b->planes = planes;
+
+		for (j = 0; j < ((b->numsides + 3) & ~3); j++)
+		{
+			if (j < b->numsides)
+			{
+				plane = b->sides[j].plane;
+
+				for (k = 0; k < 3; k++)
+				{
+					planes[j >> 2].normal[k][j & 3] = plane->normal[k];
+				}
+				planes[j >> 2].dist[j & 3] = plane->dist;
+			}
+			else
+			{
+				// padding, every point is behind it
+				for (k = 0; k < 3; k++)
+				{
+					planes[j >> 2].normal[k][j & 3] = 0;
+				}
+				planes[j >> 2].dist[j & 3] = 1;
+			}
+		}
+
+		planes += (b->numsides + 3) >> 2;
+	}
+}
+
 /**
  * @brief CMod_LoadBrushes
  * @param[in] l
@@ -261,6 +312,8 @@ void CMod_LoadBrushes(lump_t *l)
 
 		CM_BoundBrush(out);
 	}
+
+	CM_LoadBrushPlanes();
 }
 
 /**
@@ -759,6 +812,7 @@ void CM_ClearMap(void)
 {
 	Com_Memset(&cm, 0, sizeof(cm));
 	CM_ClearLevelPatches();
+	CM_FreeThreadTraces();
 }
 
 /**
@@ -815,6 +869,15 @@ int CM_NumClusters(void)
 	return cm.numClusters;
 }
 
+/**
+ * @brief CM_NumAreas
+ * @return
+ */
+int CM_NumAreas(void)
+{
+	return cm.numAreas;
+}
+
 /**
  * @brief CM_NumInlineModels
  * @return
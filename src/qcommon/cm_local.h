@@ -91,6 +91,17 @@ typedef struct
 	int shaderNum;
 } cbrushside_t;
 
+/**
+ * @struct cbrushPlanes_t
+ * @brief The planes of four brush sides in structure of arrays layout,
+ * so the distances to all four can be computed at once
+ */
+typedef struct
+{
+	float normal[3][4];         ///< [axis][side]
+	float dist[4];
+} cbrushPlanes_t;
+
 /**
  * @struct cbrush_s
  */
@@ -101,6 +112,7 @@ typedef struct
 	vec3_t bounds[2];
 	int numsides;
 	cbrushside_t *sides;
+	cbrushPlanes_t *planes;     ///< [(numsides + 3) / 4] copy of the side planes, NULL for brushes with changing planes
 	int checkcount;            ///< to avoid repeated testings
 } cbrush_t;
 
@@ -205,6 +217,20 @@ typedef struct
 	vec3_t offset;
 } sphere_t;
 
+/**
+ * @struct traceChecks_t
+ * @brief Brush and patch marks of one trace thread, used instead of the
+ * checkcount of the shared map data
+ */
+typedef struct
+{
+	int count;              ///< incremented on each trace of the thread
+	int numBrushes;
+	int numSurfaces;
+	int *brushes;           ///< [numBrushes] count of the last trace that tested the brush
+	int *surfaces;          ///< [numSurfaces] count of the last trace that tested the patch
+} traceChecks_t;
+
 /**
  * @struct traceWork_s
  */
@@ -229,6 +255,8 @@ typedef struct
 	float traceDist2;
 	vec3_t dir;
 
+	traceChecks_t *checks;  ///< NULL for traces of the main thread, which use cm.checkcount
+
 } traceWork_t;
 
 /**
@@ -254,6 +282,9 @@ void CM_BoxLeafnums_r(leafList_t *ll, int nodenum);
 
 cmodel_t *CM_ClipHandleToModel(clipHandle_t handle);
 
+// cm_trace.c
+void CM_FreeThreadTraces(void);
+
 // cm_patch.c
 struct patchCollide_s *CM_GeneratePatchCollide(int width, int height, vec3_t *points, qboolean addBevels);
 void CM_TraceThroughPatchCollide(traceWork_t *tw, const struct patchCollide_s *pc);
@@ -1701,14 +1701,18 @@ void CM_TracePointThroughPatchCollide(traceWork_t *tw, const struct patchCollide
 		if (j == facet->numBorders)
 		{
 			// we hit this facet
-			if (!cv)
+			// the debug surface is main thread only, see CM_BoxTraceOnThread
+			if (!tw->checks)
 			{
-				cv = Cvar_Get("r_debugSurfaceUpdate", "1", 0);
-			}
-			if (cv->integer)
-			{
-				debugPatchCollide = pc;
-				debugFacet        = facet;
+				if (!cv)
+				{
+					cv = Cvar_Get("r_debugSurfaceUpdate", "1", 0);
+				}
+				if (cv->integer)
+				{
+					debugPatchCollide = pc;
+					debugFacet        = facet;
+				}
 			}
 			planes = &pc->planes[facet->surfacePlane];
 
@@ -1931,14 +1935,18 @@ void CM_TraceThroughPatchCollide(traceWork_t *tw, const struct patchCollide_s *p
 				{
 					enterFrac = 0;
 				}
-				if (!cv)
+				// the debug surface is main thread only, see CM_BoxTraceOnThread
+				if (!tw->checks)
 				{
-					cv = Cvar_Get("r_debugSurfaceUpdate", "1", 0);
-				}
-				if (cv && cv->integer)
-				{
-					debugPatchCollide = pc;
-					debugFacet        = facet;
+					if (!cv)
+					{
+						cv = Cvar_Get("r_debugSurfaceUpdate", "1", 0);
+					}
+					if (cv && cv->integer)
+					{
+						debugPatchCollide = pc;
+						debugFacet        = facet;
+					}
 				}
 				tw->trace.fraction = enterFrac;
 				VectorCopy(bestplane, tw->trace.plane.normal);
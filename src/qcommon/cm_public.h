@@ -49,6 +49,7 @@ void CM_SetTempBoxModelContents(int contents);
 void CM_ModelBounds(clipHandle_t model, vec3_t mins, vec3_t maxs);
 
 int CM_NumClusters(void);
+int CM_NumAreas(void);
 int CM_NumInlineModels(void);
 char *CM_EntityString(void);
 
@@ -63,6 +64,11 @@ void CM_TransformedBoxTrace(trace_t *results, const vec3_t start, const vec3_t e
                             const vec3_t mins, const vec3_t maxs,
                             clipHandle_t model, int brushmask,
                             const vec3_t origin, const vec3_t angles, qboolean capsule);
+void CM_PrepareThreadTraces(void);
+void CM_BoxTraceOnThread(trace_t *results, const vec3_t start, const vec3_t end,
+                         const vec3_t mins, const vec3_t maxs,
+                         clipHandle_t model, int brushmask, qboolean capsule, int thread);
+void CM_TraceBench_f(void);
 
 byte *CM_ClusterPVS(int cluster);
 
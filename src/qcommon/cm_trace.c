@@ -35,6 +35,10 @@
 #include "cm_local.h"
 #include "cm_patch.h"
 
+#ifdef ETL_SSE
+#include <immintrin.h>
+#endif
+
 /// Always use bbox vs. bbox collision and never capsule vs. bbox or vice versa
 #define ALWAYS_BBOX_VS_BBOX
 /// Always use capsule vs. capsule collision and never capsule vs. bbox or vice versa
@@ -42,6 +46,61 @@
 
 //#define CAPSULE_DEBUG
 
+static traceChecks_t cmThreadChecks[MAX_JOB_THREADS];   ///< see CM_BoxTraceOnThread
+static qboolean      cmPlaneBlocks = qtrue;              ///< use cbrush_t::planes, only cleared by CM_TraceBench_f
+
+/**
+ * @brief Marks a brush as tested by the current trace
+ * @param[in,out] tw
+ * @param[in] brushnum
+ * @return qtrue if the trace already tested it in another leaf
+ */
+static ID_INLINE qboolean CM_CheckBrush(traceWork_t *tw, int brushnum)
+{
+	if (tw->checks)
+	{
+		if (tw->checks->brushes[brushnum] == tw->checks->count)
+		{
+			return qtrue;
+		}
+		tw->checks->brushes[brushnum] = tw->checks->count;
+		return qfalse;
+	}
+
+	if (cm.brushes[brushnum].checkcount == cm.checkcount)
+	{
+		return qtrue;
+	}
+	cm.brushes[brushnum].checkcount = cm.checkcount;
+	return qfalse;
+}
+
+/**
+ * @brief Marks a patch as tested by the current trace
+ * @param[in,out] tw
+ * @param[in] surfacenum
+ * @return qtrue if the trace already tested it in another leaf
+ */
+static ID_INLINE qboolean CM_CheckSurface(traceWork_t *tw, int surfacenum)
+{
+	if (tw->checks)
+	{
+		if (tw->checks->surfaces[surfacenum] == tw->checks->count)
+		{
+			return qtrue;
+		}
+		tw->checks->surfaces[surfacenum] = tw->checks->count;
+		return qfalse;
+	}
+
+	if (cm.surfaces[surfacenum]->checkcount == cm.checkcount)
+	{
+		return qtrue;
+	}
+	cm.surfaces[surfacenum]->checkcount = cm.checkcount;
+	return qfalse;
+}
+
 /**
 ===============================================================================
 BASIC MATH
@@ -125,6 +184,134 @@ float SquareRootFloat(float number)
 
 #endif
 
+/**
+===============================================================================
+BRUSH PLANES
+===============================================================================
+*/
+
+#ifdef ETL_SSE
+
+/**
+ * @brief Picks size[1] where the normal component is negative, else size[0].
+ * Same as indexing tw->offsets with the plane signbits.
+ */
+#define CM_SelectOffset(n, lo, hi) _mm_or_ps(_mm_and_ps(_mm_cmplt_ps(n, _mm_setzero_ps()), hi), _mm_andnot_ps(_mm_cmplt_ps(n, _mm_setzero_ps()), lo))
+
+/**
+ * @brief Dot products of a point with four normals, summed in the order of DotProduct()
+ */
+#define CM_Dot4(x, y, z, nx, ny, nz) _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, nx), _mm_mul_ps(y, ny)), _mm_mul_ps(z, nz))
+
+/**
+ * @brief Plane distances of the box, adjusted for mins/maxs like the scalar code does
+ * @param[in] tw
+ * @param[in] p
+ * @param[out] nx
+ * @param[out] ny
+ * @param[out] nz
+ * @return The four plane distances
+ */
+static ID_INLINE __m128 CM_BoxPlaneDist4(const traceWork_t *tw, const cbrushPlanes_t *p, __m128 *nx, __m128 *ny, __m128 *nz)
+{
+	__m128 ox, oy, oz;
+
+	*nx = _mm_loadu_ps(p->normal[0]);
+	*ny = _mm_loadu_ps(p->normal[1]);
+	*nz = _mm_loadu_ps(p->normal[2]);
+
+	ox = CM_SelectOffset(*nx, _mm_set1_ps(tw->size[0][0]), _mm_set1_ps(tw->size[1][0]));
+	oy = CM_SelectOffset(*ny, _mm_set1_ps(tw->size[0][1]), _mm_set1_ps(tw->size[1][1]));
+	oz = CM_SelectOffset(*nz, _mm_set1_ps(tw->size[0][2]), _mm_set1_ps(tw->size[1][2]));
+
+	return _mm_sub_ps(_mm_loadu_ps(p->dist), CM_Dot4(ox, oy, oz, *nx, *ny, *nz));
+}
+
+#endif
+
+/**
+ * @brief Computes the start and end distances of the box to four brush planes.
+ * Gives the same values as the per side code in CM_TraceThroughBrush().
+ *
+ * @param[in] tw
+ * @param[in] p
+ * @param[out] d1 Start distances
+ * @param[out] d2 End distances
+ * @return Bit mask of the sides the trace is completely in front of
+ */
+static ID_INLINE int CM_BoxPlaneDistances(const traceWork_t *tw, const cbrushPlanes_t *p, float *d1, float *d2)
+{
+#ifdef ETL_SSE
+	__m128 nx, ny, nz, dist, v1, v2;
+
+	dist = CM_BoxPlaneDist4(tw, p, &nx, &ny, &nz);
+	v1   = _mm_sub_ps(CM_Dot4(_mm_set1_ps(tw->start[0]), _mm_set1_ps(tw->start[1]), _mm_set1_ps(tw->start[2]), nx, ny, nz), dist);
+	v2   = _mm_sub_ps(CM_Dot4(_mm_set1_ps(tw->end[0]), _mm_set1_ps(tw->end[1]), _mm_set1_ps(tw->end[2]), nx, ny, nz), dist);
+
+	_mm_storeu_ps(d1, v1);
+	_mm_storeu_ps(d2, v2);
+
+	// d1 > 0 && (d2 >= SURFACE_CLIP_EPSILON || d2 >= d1)
+	return _mm_movemask_ps(_mm_and_ps(_mm_cmpgt_ps(v1, _mm_setzero_ps()),
+	                                  _mm_or_ps(_mm_cmpge_ps(v2, _mm_set1_ps(SURFACE_CLIP_EPSILON)), _mm_cmpge_ps(v2, v1))));
+#else
+	int   i, front = 0;
+	float dist;
+
+	for (i = 0; i < 4; i++)
+	{
+		dist = p->dist[i] - (tw->size[p->normal[0][i] < 0][0] * p->normal[0][i]
+		                     + tw->size[p->normal[1][i] < 0][1] * p->normal[1][i]
+		                     + tw->size[p->normal[2][i] < 0][2] * p->normal[2][i]);
+
+		d1[i] = (tw->start[0] * p->normal[0][i] + tw->start[1] * p->normal[1][i] + tw->start[2] * p->normal[2][i]) - dist;
+		d2[i] = (tw->end[0] * p->normal[0][i] + tw->end[1] * p->normal[1][i] + tw->end[2] * p->normal[2][i]) - dist;
+
+		if (d1[i] > 0 && (d2[i] >= SURFACE_CLIP_EPSILON || d2[i] >= d1[i]))
+		{
+			front |= 1 << i;
+		}
+	}
+
+	return front;
+#endif
+}
+
+/**
+ * @brief Tests if the box at the trace start is in front of any of four brush planes
+ * @param[in] tw
+ * @param[in] p
+ * @return Bit mask of the sides the box is in front of
+ */
+static ID_INLINE int CM_BoxPlanesInFront(const traceWork_t *tw, const cbrushPlanes_t *p)
+{
+#ifdef ETL_SSE
+	__m128 nx, ny, nz, dist, v1;
+
+	dist = CM_BoxPlaneDist4(tw, p, &nx, &ny, &nz);
+	v1   = _mm_sub_ps(CM_Dot4(_mm_set1_ps(tw->start[0]), _mm_set1_ps(tw->start[1]), _mm_set1_ps(tw->start[2]), nx, ny, nz), dist);
+
+	return _mm_movemask_ps(_mm_cmpgt_ps(v1, _mm_setzero_ps()));
+#else
+	int   i, front = 0;
+	float dist;
+
+	for (i = 0; i < 4; i++)
+	{
+		dist = p->dist[i] - (tw->size[p->normal[0][i] < 0][0] * p->normal[0][i]
+		                     + tw->size[p->normal[1][i] < 0][1] * p->normal[1][i]
+		                     + tw->size[p->normal[2][i] < 0][2] * p->normal[2][i]);
+
+		if ((tw->start[0] * p->normal[0][i] + tw->start[1] * p->normal[1][i] + tw->start[2] * p->normal[2][i]) - dist > 0)
+		{
+			front |= 1 << i;
+		}
+	}
+
+	return front;
+#endif
+}
+
 /**
 ===============================================================================
 POSITION TESTING
@@ -194,6 +381,19 @@ void CM_TestBoxInBrush(traceWork_t *tw, cbrush_t *brush)
 			}
 		}
 	}
+	else if (brush->planes && cmPlaneBlocks)
+	{
+		// the first six planes are the axial planes, so we only
+		// need to test the remainder, four at a time
+		for (i = 4 ; i < brush->numsides ; i += 4)
+		{
+			// if completely in front of face, no intersection
+			if (CM_BoxPlanesInFront(tw, brush->planes + (i >> 2)) & (i == 4 ? 0xC : 0xF))
+			{
+				return;
+			}
+		}
+	}
 	else
 	{
 		// the first six planes are the axial planes, so we only
@@ -238,11 +438,10 @@ void CM_TestInLeaf(traceWork_t *tw, cLeaf_t *leaf)
 	{
 		brushnum = cm.leafbrushes[leaf->firstLeafBrush + k];
 		b        = &cm.brushes[brushnum];
-		if (b->checkcount == cm.checkcount)
+		if (CM_CheckBrush(tw, brushnum))
 		{
 			continue;   // already checked this brush in another leaf
 		}
-		b->checkcount = cm.checkcount;
 
 		if (!(b->contents & tw->contents))
 		{
@@ -268,11 +467,10 @@ void CM_TestInLeaf(traceWork_t *tw, cLeaf_t *leaf)
 			{
 				continue;
 			}
-			if (patch->checkcount == cm.checkcount)
+			if (CM_CheckSurface(tw, cm.leafsurfaces[leaf->firstLeafSurface + k]))
 			{
 				continue;   // already checked this brush in another leaf
 			}
-			patch->checkcount = cm.checkcount;
 
 			if (!(patch->contents & tw->contents))
 			{
@@ -434,11 +632,16 @@ void CM_PositionTest(traceWork_t *tw)
 	ll.lastLeaf   = 0;
 	ll.overflowed = qfalse;
 
-	cm.checkcount++;
-
 	CM_BoxLeafnums_r(&ll, 0);
 
-	cm.checkcount++;
+	if (tw->checks)
+	{
+		tw->checks->count++;
+	}
+	else
+	{
+		cm.checkcount++;
+	}
 
 	// test the contents of the leafs
 	for (i = 0 ; i < ll.count ; i++)
@@ -466,7 +669,10 @@ static void CM_TraceThroughPatch(traceWork_t *tw, cPatch_t *patch)
 {
 	float oldFrac = tw->trace.fraction;
 
-	c_patch_traces++;
+	if (!tw->checks)
+	{
+		c_patch_traces++;
+	}
 
 	CM_TraceThroughPatchCollide(tw, patch->pc);
 
@@ -617,7 +823,10 @@ static void CM_TraceThroughBrush(traceWork_t *tw, cbrush_t *brush)
 		return;
 	}
 
-	c_brush_traces++;
+	if (!tw->checks)
+	{
+		c_brush_traces++;
+	}
 
 	getout   = qfalse;
 	startout = qfalse;
@@ -712,16 +921,37 @@ static void CM_TraceThroughBrush(traceWork_t *tw, cbrush_t *brush)
 		// compare the trace against all planes of the brush
 		// find the latest time the trace crosses a plane towards the interior
 		// and the earliest time the trace crosses a plane towards the exterior
+		cbrushPlanes_t *planes = cmPlaneBlocks ? brush->planes : NULL;
+		float          d1s[4], d2s[4];
+
 		for (i = 0; i < brush->numsides; i++)
 		{
 			side  = brush->sides + i;
 			plane = side->plane;
 
-			// adjust the plane distance apropriately for mins/maxs
-			dist = plane->dist - DotProduct(tw->offsets[plane->signbits], plane->normal);
+			if (planes)
+			{
+				if (!(i & 3))
+				{
+					// distances of the next four sides at once,
+					// if completely in front of any, no intersection with the entire brush
+					if (CM_BoxPlaneDistances(tw, planes + (i >> 2), d1s, d2s))
+					{
+						return;
+					}
+				}
 
-			d1 = DotProduct(tw->start, plane->normal) - dist;
-			d2 = DotProduct(tw->end, plane->normal) - dist;
+				d1 = d1s[i & 3];
+				d2 = d2s[i & 3];
+			}
+			else
+			{
+				// adjust the plane distance apropriately for mins/maxs
+				dist = plane->dist - DotProduct(tw->offsets[plane->signbits], plane->normal);
+
+				d1 = DotProduct(tw->start, plane->normal) - dist;
+				d2 = DotProduct(tw->end, plane->normal) - dist;
+			}
 
 			if (d2 > 0)
 			{
@@ -819,11 +1049,10 @@ static void CM_TraceThroughLeaf(traceWork_t *tw, cLeaf_t *leaf)
 	{
 		// brushnum = cm.leafbrushes[leaf->firstLeafBrush + k];
 		brush = &cm.brushes[cm.leafbrushes[leaf->firstLeafBrush + k]];
-		if (brush->checkcount == cm.checkcount)
+		if (CM_CheckBrush(tw, cm.leafbrushes[leaf->firstLeafBrush + k]))
 		{
 			continue;   // already checked this brush in another leaf
 		}
-		brush->checkcount = cm.checkcount;
 
 		if (!(brush->contents & tw->contents))
 		{
@@ -865,11 +1094,10 @@ static void CM_TraceThroughLeaf(traceWork_t *tw, cLeaf_t *leaf)
 			{
 				continue;
 			}
-			if (patch->checkcount == cm.checkcount)
+			if (CM_CheckSurface(tw, cm.leafsurfaces[leaf->firstLeafSurface + k]))
 			{
 				continue;   // already checked this patch in another leaf
 			}
-			patch->checkcount = cm.checkcount;
 
 			if (!(patch->contents & tw->contents))
 			{
@@ -1399,7 +1627,7 @@ static void CM_TraceThroughTree(traceWork_t *tw, int num, float p1f, float p2f,
  */
 static void CM_Trace(trace_t *results, const vec3_t start, const vec3_t end,
                      const vec3_t mins, const vec3_t maxs,
-                     clipHandle_t model, const vec3_t origin, int brushmask, qboolean capsule, sphere_t *sphere)
+                     clipHandle_t model, const vec3_t origin, int brushmask, qboolean capsule, sphere_t *sphere, traceChecks_t *checks)
 {
 	int         i;
 	traceWork_t tw;
@@ -1409,13 +1637,21 @@ static void CM_Trace(trace_t *results, const vec3_t start, const vec3_t end,
 
 	cmod = CM_ClipHandleToModel(model);
 
-	cm.checkcount++;        // for multi-check avoidance
-
-	c_traces++;             // for statistics, may be zeroed
-
 	// fill in a default trace
 	Com_Memset(&tw, 0, sizeof(tw));
 	tw.trace.fraction = 1.0f;   // assume it goes the entire distance until shown otherwise
+	tw.checks         = checks;
+
+	if (checks)
+	{
+		checks->count++;    // for multi-check avoidance
+	}
+	else
+	{
+		cm.checkcount++;    // for multi-check avoidance
+
+		c_traces++;         // for statistics, may be zeroed
+	}
 	VectorCopy(origin, tw.modelOrigin);
 
 	if (!cm.numNodes)
@@ -1672,7 +1908,236 @@ void CM_BoxTrace(trace_t *results, const vec3_t start, const vec3_t end,
                  const vec3_t mins, const vec3_t maxs,
                  clipHandle_t model, int brushmask, qboolean capsule)
 {
-	CM_Trace(results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL);
+	CM_Trace(results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL, NULL);
+}
+
+/**
+ * @brief Makes sure every job thread has its brush and patch marks for the
+ * loaded map, call before running jobs that use CM_BoxTraceOnThread().
+ */
+void CM_PrepareThreadTraces(void)
+{
+	traceChecks_t *checks;
+	int           i;
+
+	for (i = 0; i < Com_JobThreads(); i++)
+	{
+		checks = &cmThreadChecks[i];
+
+		if (checks->numBrushes >= cm.numBrushes && checks->numSurfaces >= cm.numSurfaces && checks->brushes)
+		{
+			// marks of an older map are below count, no need to clear them on map changes
+			continue;
+		}
+
+		Com_Dealloc(checks->brushes);
+		Com_Dealloc(checks->surfaces);
+
+		checks->numBrushes  = cm.numBrushes;
+		checks->numSurfaces = cm.numSurfaces;
+		checks->brushes     = Com_Allocate(MAX(checks->numBrushes, 1) * sizeof(int));
+		checks->surfaces    = Com_Allocate(MAX(checks->numSurfaces, 1) * sizeof(int));
+
+		if (!checks->brushes || !checks->surfaces)
+		{
+			Com_Error(ERR_FATAL, "CM_PrepareThreadTraces: failed to allocate trace marks");
+		}
+
+		Com_Memset(checks->brushes, 0, MAX(checks->numBrushes, 1) * sizeof(int));
+		Com_Memset(checks->surfaces, 0, MAX(checks->numSurfaces, 1) * sizeof(int));
+	}
+}
+
+/**
+ * @brief Same as CM_BoxTrace(), but can run on several job threads at once
+ * as it doesn't touch the checkcount of the shared map data.
+ * @param[out] results
+ * @param[in] start
+ * @param[in] end
+ * @param[in] mins
+ * @param[in] maxs
+ * @param[in] model Only inline models, the temporary box models aren't thread safe
+ * @param[in] brushmask
+ * @param[in] capsule
+ * @param[in] thread Job thread the call is made from, see Com_RunJobs()
+ */
+void CM_BoxTraceOnThread(trace_t *results, const vec3_t start, const vec3_t end,
+                         const vec3_t mins, const vec3_t maxs,
+                         clipHandle_t model, int brushmask, qboolean capsule, int thread)
+{
+	CM_Trace(results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL, &cmThreadChecks[thread]);
+}
+
+/**
+ * @brief Frees the marks of the trace threads
+ *
+ * @note Must not be called while jobs are running.
+ */
+void CM_FreeThreadTraces(void)
+{
+	int i;
+
+	for (i = 0; i < MAX_JOB_THREADS; i++)
+	{
+		Com_Dealloc(cmThreadChecks[i].brushes);
+		Com_Dealloc(cmThreadChecks[i].surfaces);
+	}
+
+	Com_Memset(cmThreadChecks, 0, sizeof(cmThreadChecks));
+}
+
+#define TRACEBENCH_MAXTRACES 0x100000
+
+/**
+ * @struct traceBenchCase_t
+ * @brief A random trace of the benchmark
+ */
+typedef struct
+{
+	vec3_t start;
+	vec3_t end;
+	qboolean box;                       ///< player sized box, else a point (hitscan) trace
+} traceBenchCase_t;
+
+/**
+ * @brief Traces all benchmark cases, with or without the plane blocks of the brushes
+ * @param[in] cases
+ * @param[in] numCases
+ * @param[out] results
+ * @param[in] planeBlocks
+ * @return Time taken in microseconds
+ */
+static int64_t CM_TraceBenchRun(const traceBenchCase_t *cases, int numCases, trace_t *results, qboolean planeBlocks)
+{
+	static const vec3_t mins = { -18.f, -18.f, -24.f };
+	static const vec3_t maxs = { 18.f, 18.f, 48.f };
+	int64_t             start;
+	int                 i;
+
+	cmPlaneBlocks = planeBlocks;
+
+	start = Sys_Microseconds();
+	for (i = 0; i < numCases; i++)
+	{
+		CM_BoxTrace(&results[i], cases[i].start, cases[i].end, cases[i].box ? mins : vec3_origin, cases[i].box ? maxs : vec3_origin, 0, CONTENTS_SOLID | CONTENTS_PLAYERCLIP, qfalse);
+	}
+	start = Sys_Microseconds() - start;
+
+	cmPlaneBlocks = qtrue;
+
+	return start;
+}
+
+/**
+ * @brief Times random traces through the loaded map with the structure of
+ * arrays brush planes and with the per side planes, and verifies both
+ * give the same results.
+ *
+ * Usage: tracebench [traces] [iterations]
+ */
+void CM_TraceBench_f(void)
+{
+	traceBenchCase_t *cases;
+	trace_t          *blockResults, *sideResults;
+	vec3_t           dir;
+	int64_t          blockTime = 0, sideTime = 0;
+	int              numCases, iterations, i, j, tries, differ = 0, hits = 0;
+
+	if (!cm.name[0])
+	{
+		Com_Printf("tracebench: no map loaded\n");
+		return;
+	}
+
+	numCases   = Cmd_Argc() > 1 ? Com_Clamp(1, TRACEBENCH_MAXTRACES, Q_atoi(Cmd_Argv(1))) : 100000;
+	iterations = Cmd_Argc() > 2 ? MAX(1, Q_atoi(Cmd_Argv(2))) : 5;
+
+	cases        = Com_Allocate(numCases * sizeof(*cases));
+	blockResults = Com_Allocate(numCases * sizeof(*blockResults));
+	sideResults  = Com_Allocate(numCases * sizeof(*sideResults));
+
+	if (!cases || !blockResults || !sideResults)
+	{
+		Com_Printf("tracebench: out of memory\n");
+		goto done;
+	}
+
+	// random traces of up to 2048 units, starting outside of solid where possible
+	srand(numCases);
+	for (i = 0; i < numCases; i++)
+	{
+		for (tries = 0; tries < 16; tries++)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				cases[i].start[j] = cm.cmodels[0].mins[j] + (cm.cmodels[0].maxs[j] - cm.cmodels[0].mins[j]) * ((float)rand() / RAND_MAX);
+			}
+			if (!(CM_PointContents(cases[i].start, 0) & CONTENTS_SOLID))
+			{
+				break;
+			}
+		}
+
+		dir[0] = crandom();
+		dir[1] = crandom();
+		dir[2] = crandom() * 0.5f;
+		VectorNormalize(dir);
+		VectorMA(cases[i].start, 2048.f * ((float)rand() / RAND_MAX), dir, cases[i].end);
+
+		cases[i].box = (i & 1);
+	}
+
+	// warm up, results of both are compared below
+	CM_TraceBenchRun(cases, numCases, sideResults, qfalse);
+
+	for (i = 0; i < iterations; i++)
+	{
+		blockTime += CM_TraceBenchRun(cases, numCases, blockResults, qtrue);
+		sideTime  += CM_TraceBenchRun(cases, numCases, sideResults, qfalse);
+	}
+
+	for (i = 0; i < numCases; i++)
+	{
+		if (blockResults[i].fraction < 1.f)
+		{
+			hits++;
+		}
+
+		if (blockResults[i].fraction != sideResults[i].fraction
+		    || !VectorCompare(blockResults[i].endpos, sideResults[i].endpos)
+		    || !VectorCompare(blockResults[i].plane.normal, sideResults[i].plane.normal)
+		    || blockResults[i].plane.dist != sideResults[i].plane.dist
+		    || blockResults[i].startsolid != sideResults[i].startsolid
+		    || blockResults[i].allsolid != sideResults[i].allsolid
+		    || blockResults[i].surfaceFlags != sideResults[i].surfaceFlags
+		    || blockResults[i].contents != sideResults[i].contents)
+		{
+			if (!differ)
+			{
+				Com_Printf(S_COLOR_RED "tracebench: results differ for trace %i (%f/%f)\n", i, blockResults[i].fraction, sideResults[i].fraction);
+			}
+			differ++;
+		}
+	}
+
+	Com_Printf("%s: %i traces (%i hit), %i iterations, %s plane kernel\n", cm.name, numCases, hits, iterations,
+#ifdef ETL_SSE
+	           "SSE"
+#else
+	           "scalar"
+#endif
+	           );
+	Com_Printf("plane blocks: %8.2f ns/trace %10.0f traces/s\n", 1000.0 * blockTime / ((double)numCases * iterations), blockTime ? 1000000.0 * numCases * iterations / blockTime : 0.0);
+	Com_Printf("plane sides : %8.2f ns/trace %10.0f traces/s\n", 1000.0 * sideTime / ((double)numCases * iterations), sideTime ? 1000000.0 * numCases * iterations / sideTime : 0.0);
+	if (differ)
+	{
+		Com_Printf(S_COLOR_RED "%i traces differ\n", differ);
+	}
+
+done:
+	Com_Dealloc(cases);
+	Com_Dealloc(blockResults);
+	Com_Dealloc(sideResults);
 }
 
 /**
@@ -1771,7 +2236,7 @@ void CM_TransformedBoxTrace(trace_t *results, const vec3_t start, const vec3_t e
 	}
 
 	// sweep the box through the model
-	CM_Trace(&trace, start_l, end_l, symetricSize[0], symetricSize[1], model, origin, brushmask, capsule, &sphere);
+	CM_Trace(&trace, start_l, end_l, symetricSize[0], symetricSize[1], model, origin, brushmask, capsule, &sphere, NULL);
 
 	// if the bmodel was rotated and there was a collision
 	if (rotated && trace.fraction != 1.0f)
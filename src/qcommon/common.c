@@ -954,7 +954,15 @@ int Com_RealTime(qtime_t *qtime)
 There is never any space between memblocks, and there will never be two
 contiguous free memblocks.
 
-The rover can be left pointing at a non-empty block
+Small allocations are carved out of slabs, zone blocks split into equal chunks
+of one size class. Each class keeps a list of its slabs with free chunks, so
+allocating and freeing a chunk is a list operation. A slab that runs empty is
+handed back to the zone unless it's the last one of its class.
+
+Everything else comes from the blocks themselves. Free blocks are kept in
+bins, 16 per power of two of their size, with a bit set for every bin that
+isn't empty. A request is rounded up to the next bin, so any block in the
+first non empty bin from there fits, and finding it takes two bit scans.
 
 The zone calls are pretty much only used for small strings and structures,
 all big things are allocated on the hunk.
@@ -962,8 +970,19 @@ all big things are allocated on the hunk.
 */
 
 #define ZONEID  0x1d4a11
+#define SLABID  0x1d4a12            ///< id of the chunks carved out of a slab
 #define MINFRAGMENT 64
 
+#define TAG_SLAB -1                 ///< tag of the zone blocks holding slabs
+#define ZONE_TAGS (TAG_STATIC + 1)
+
+#define ZONE_BIN_SHIFT 4
+#define ZONE_BINS (1 << ZONE_BIN_SHIFT)  ///< bins per power of two
+#define ZONE_LEVELS 32
+
+#define ZONE_SLAB_SIZE 4096         ///< size of the zone block a slab is made of
+#define ZONE_SLAB_MAX 512           ///< largest chunk, including its header
+
 /**
  * @struct zonedebug_s
  */
@@ -977,18 +996,57 @@ typedef struct zonedebug_s
 
 /**
  * @struct memblock_s
+ *
+ * @note Chunks of a slab use next to link the free chunks of their slab
+ * and prev to point at the block of the slab.
  */
 typedef struct memblock_s
 {
 	size_t size;            ///< including the header and possibly tiny fragments
 	int tag;                ///< a tag of 0 is a free block
 	struct memblock_s *next, *prev;
-	int id;                 ///< should be ZONEID
+	int id;                 ///< should be ZONEID, or SLABID for chunks
 #ifdef ZONE_DEBUG
 	zonedebug_t d;
 #endif
 } memblock_t;
 
+/**
+ * @struct memfree_s
+ * @brief Links of a free block in its bin, kept right after its header
+ */
+typedef struct memfree_s
+{
+	memblock_t *next, *prev;
+} memfree_t;
+
+#define Z_FreeLinks(block) ((memfree_t *)((block) + 1))
+
+/**
+ * @struct memslab_s
+ * @brief Header of a slab, kept right after the header of its block
+ */
+typedef struct memslab_s
+{
+	struct memslab_s *next, *prev;  ///< slabs of the same class with free chunks
+	memblock_t *freeChunks;
+	int sizeClass;
+	int used;                       ///< chunks handed out
+	int count;                      ///< chunks in the slab
+} memslab_t;
+
+#define ZONE_SLAB_HEADER PAD(sizeof(memblock_t) + sizeof(memslab_t), 16)
+
+/// smallest block that can hold its free links once it's freed
+#define ZONE_MIN_BLOCK PAD(sizeof(memblock_t) + sizeof(memfree_t) + 4, sizeof(intptr_t))
+
+static const int zoneSlabSizes[] = { 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512 };
+
+#define ZONE_SLAB_CLASSES ARRAY_LEN(zoneSlabSizes)
+
+/// size class of every chunk size, in steps of 16 bytes
+static byte zoneSlabClass[ZONE_SLAB_MAX / 16 + 1];
+
 /**
  * @struct memzone_s
  */
@@ -997,7 +1055,17 @@ typedef struct
 	int size;               ///< total bytes malloced, including header
 	int used;               ///< total bytes used
 	memblock_t blocklist;   ///< start / end cap for linked list
-	memblock_t *rover;
+
+	int freeBytes;          ///< bytes in free blocks
+	int freeBlocks;
+	unsigned int levelBits; ///< levels with a non empty bin
+	unsigned int binBits[ZONE_LEVELS];
+	memblock_t *bins[ZONE_LEVELS][ZONE_BINS];
+
+	memslab_t *slabs[ZONE_SLAB_CLASSES];  ///< slabs with free chunks
+	int slabBytes;          ///< bytes in slab blocks
+	int slabUsed;           ///< bytes in chunks handed out
+	int slabCount;
 } memzone_t;
 
 /// main zone for all "dynamic" memory allocation
@@ -1006,8 +1074,426 @@ static memzone_t *mainzone;
 /// fragment the main zone (think of cvar and cmd strings)
 static memzone_t *smallzone;
 
+static int zoneTagBytes[ZONE_TAGS];
+static int zoneTagBlocks[ZONE_TAGS];
+static int zoneTagHighwater[ZONE_TAGS];
+
+static const char *zoneTagNames[ZONE_TAGS] = { "free", "general", "botlib", "renderer", "small", "static" };
+
 static void Z_CheckHeap(void);
 
+/**
+ * @brief Index of the lowest set bit
+ * @param[in] bits Must not be 0
+ * @return
+ */
+static ID_INLINE int Z_LowestBit(unsigned int bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctz(bits);
+#elif defined(_MSC_VER)
+	unsigned long index;
+
+	_BitScanForward(&index, bits);
+	return (int)index;
+#else
+	int index = 0;
+
+	while (!(bits & 1))
+	{
+		bits >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+
+/**
+ * @brief Index of the highest set bit
+ * @param[in] bits Must not be 0
+ * @return
+ */
+static ID_INLINE int Z_HighestBit(unsigned int bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return 31 - __builtin_clz(bits);
+#elif defined(_MSC_VER)
+	unsigned long index;
+
+	_BitScanReverse(&index, bits);
+	return (int)index;
+#else
+	int index = 0;
+
+	while (bits >>= 1)
+	{
+		index++;
+	}
+	return index;
+#endif
+}
+
+/**
+ * @brief Finds the bin of a free block
+ * @param[in] size
+ * @param[out] level
+ * @param[out] bin
+ */
+static void Z_BinIndex(size_t size, int *level, int *bin)
+{
+	*level = Z_HighestBit((unsigned int)size);
+	*bin   = (int)(size >> (*level - ZONE_BIN_SHIFT)) & (ZONE_BINS - 1);
+}
+
+/**
+ * @brief Adds a free block to its bin
+ * @param[in,out] zone
+ * @param[in,out] block
+ */
+static void Z_InsertFreeBlock(memzone_t *zone, memblock_t *block)
+{
+	int level, bin;
+
+	Z_BinIndex(block->size, &level, &bin);
+
+	Z_FreeLinks(block)->prev = NULL;
+	Z_FreeLinks(block)->next = zone->bins[level][bin];
+	if (zone->bins[level][bin])
+	{
+		Z_FreeLinks(zone->bins[level][bin])->prev = block;
+	}
+	zone->bins[level][bin] = block;
+
+	zone->binBits[level] |= 1u << bin;
+	zone->levelBits      |= 1u << level;
+
+	zone->freeBytes += block->size;
+	zone->freeBlocks++;
+}
+
+/**
+ * @brief Removes a free block from its bin
+ * @param[in,out] zone
+ * @param[in,out] block
+ */
+static void Z_RemoveFreeBlock(memzone_t *zone, memblock_t *block)
+{
+	memfree_t *links = Z_FreeLinks(block);
+	int       level, bin;
+
+	Z_BinIndex(block->size, &level, &bin);
+
+	if (links->prev)
+	{
+		Z_FreeLinks(links->prev)->next = links->next;
+	}
+	else
+	{
+		zone->bins[level][bin] = links->next;
+
+		if (!links->next)
+		{
+			zone->binBits[level] &= ~(1u << bin);
+			if (!zone->binBits[level])
+			{
+				zone->levelBits &= ~(1u << level);
+			}
+		}
+	}
+
+	if (links->next)
+	{
+		Z_FreeLinks(links->next)->prev = links->prev;
+	}
+
+	zone->freeBytes -= block->size;
+	zone->freeBlocks--;
+}
+
+/**
+ * @brief Finds a free block of at least size bytes
+ * @param[in] zone
+ * @param[in] size
+ * @return NULL if there is none
+ */
+static memblock_t *Z_FindFreeBlock(memzone_t *zone, size_t size)
+{
+	memblock_t   *block;
+	unsigned int bits;
+	int          level, bin;
+
+	// round up to the next bin, everything in there and above fits
+	Z_BinIndex(size + (((size_t)1 << (Z_HighestBit((unsigned int)size) - ZONE_BIN_SHIFT)) - 1), &level, &bin);
+
+	if (level < ZONE_LEVELS)
+	{
+		bits = zone->binBits[level] & (~0u << bin);
+		if (!bits && level + 1 < ZONE_LEVELS)
+		{
+			bits = zone->levelBits & (~0u << (level + 1));
+			if (bits)
+			{
+				level = Z_LowestBit(bits);
+				bits  = zone->binBits[level];
+			}
+		}
+
+		if (bits)
+		{
+			return zone->bins[level][Z_LowestBit(bits)];
+		}
+	}
+
+	// nearly out of memory, try the bin the request falls into as well
+	Z_BinIndex(size, &level, &bin);
+	for (block = zone->bins[level][bin]; block; block = Z_FreeLinks(block)->next)
+	{
+		if (block->size >= size)
+		{
+			return block;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Takes a block of size bytes from the free blocks
+ * @param[in,out] zone
+ * @param[in] size Including the header and trash tester
+ * @return NULL if the zone is out of memory
+ */
+static memblock_t *Z_BlockAlloc(memzone_t *zone, size_t size)
+{
+	memblock_t *base, *new;
+	size_t     extra;
+
+	if (size > (size_t)zone->size)
+	{
+		return NULL;
+	}
+
+	if (size < ZONE_MIN_BLOCK)
+	{
+		size = ZONE_MIN_BLOCK;
+	}
+
+	base = Z_FindFreeBlock(zone, size);
+	if (!base)
+	{
+		return NULL;
+	}
+
+	Z_RemoveFreeBlock(zone, base);
+
+	extra = base->size - size;
+	if (extra > MINFRAGMENT && extra >= ZONE_MIN_BLOCK)
+	{
+		// there will be a free fragment after the allocated block
+		new             = ( memblock_t * )((byte *)base + size);
+		new->size       = extra;
+		new->tag        = 0;    // free block
+		new->prev       = base;
+		new->id         = ZONEID;
+		new->next       = base->next;
+		new->next->prev = new;
+		base->next      = new;
+		base->size      = size;
+
+		Z_InsertFreeBlock(zone, new);
+	}
+
+	base->id = ZONEID;
+
+	return base;
+}
+
+/**
+ * @brief Returns a block to the free blocks, merging it with free neighbours
+ * @param[in,out] zone
+ * @param[in,out] block
+ * @return The free block it ended up in
+ */
+static memblock_t *Z_BlockFree(memzone_t *zone, memblock_t *block)
+{
+	memblock_t *other;
+
+	block->tag = 0;     // mark as free
+
+	other = block->prev;
+	if (!other->tag)
+	{
+		// merge with previous free block
+		Z_RemoveFreeBlock(zone, other);
+		other->size      += block->size;
+		other->next       = block->next;
+		other->next->prev = other;
+		block             = other;
+	}
+
+	other = block->next;
+	if (!other->tag)
+	{
+		// merge the next free block onto the end
+		Z_RemoveFreeBlock(zone, other);
+		block->size      += other->size;
+		block->next       = other->next;
+		block->next->prev = block;
+	}
+
+	Z_InsertFreeBlock(zone, block);
+
+	return block;
+}
+
+/**
+ * @brief Makes a new slab for a size class
+ * @param[in,out] zone
+ * @param[in] sizeClass
+ * @return NULL if the zone is out of memory
+ */
+static memslab_t *Z_NewSlab(memzone_t *zone, int sizeClass)
+{
+	memblock_t *block, *chunk;
+	memslab_t  *slab;
+	int        stride = zoneSlabSizes[sizeClass];
+	int        i;
+
+	block = Z_BlockAlloc(zone, ZONE_SLAB_SIZE);
+	if (!block)
+	{
+		return NULL;
+	}
+
+	block->tag = TAG_SLAB;
+	*( int * )((byte *)block + block->size - 4) = ZONEID;
+
+	slab             = ( memslab_t * )(block + 1);
+	slab->sizeClass  = sizeClass;
+	slab->used       = 0;
+	slab->count      = (int)((block->size - ZONE_SLAB_HEADER - 4) / stride);
+	slab->freeChunks = NULL;
+
+	// carve the chunks, the first one ends up at the head of the free list
+	for (i = slab->count - 1; i >= 0; i--)
+	{
+		chunk            = ( memblock_t * )((byte *)block + ZONE_SLAB_HEADER + i * stride);
+		chunk->size      = stride;
+		chunk->tag       = 0;
+		chunk->id        = SLABID;
+		chunk->prev      = block;
+		chunk->next      = slab->freeChunks;
+		slab->freeChunks = chunk;
+	}
+
+	slab->prev = NULL;
+	slab->next = zone->slabs[sizeClass];
+	if (slab->next)
+	{
+		slab->next->prev = slab;
+	}
+	zone->slabs[sizeClass] = slab;
+
+	zone->slabBytes += block->size;
+	zone->slabCount++;
+
+	return slab;
+}
+
+/**
+ * @brief Takes a chunk from the slabs of a size class
+ * @param[in,out] zone
+ * @param[in] sizeClass
+ * @return NULL if the zone is out of memory
+ */
+static memblock_t *Z_SlabAlloc(memzone_t *zone, int sizeClass)
+{
+	memslab_t  *slab = zone->slabs[sizeClass];
+	memblock_t *chunk;
+
+	if (!slab)
+	{
+		slab = Z_NewSlab(zone, sizeClass);
+		if (!slab)
+		{
+			return NULL;
+		}
+	}
+
+	chunk            = slab->freeChunks;
+	slab->freeChunks = chunk->next;
+	slab->used++;
+	chunk->next = NULL;
+
+	// full slabs leave the list
+	if (!slab->freeChunks)
+	{
+		zone->slabs[sizeClass] = slab->next;
+		if (slab->next)
+		{
+			slab->next->prev = NULL;
+		}
+		slab->next = slab->prev = NULL;
+	}
+
+	return chunk;
+}
+
+/**
+ * @brief Returns a chunk to its slab
+ * @param[in,out] zone
+ * @param[in,out] chunk
+ * @return The free block the slab ended up in if the slab was handed back to the zone, otherwise NULL
+ */
+static memblock_t *Z_SlabFree(memzone_t *zone, memblock_t *chunk)
+{
+	memblock_t *block = chunk->prev;
+	memslab_t  *slab  = ( memslab_t * )(block + 1);
+	int        sizeClass = slab->sizeClass;
+
+	chunk->tag = 0;
+
+	if (!slab->freeChunks)
+	{
+		// was full, it's got a free chunk again
+		slab->prev = NULL;
+		slab->next = zone->slabs[sizeClass];
+		if (slab->next)
+		{
+			slab->next->prev = slab;
+		}
+		zone->slabs[sizeClass] = slab;
+	}
+
+	chunk->next      = slab->freeChunks;
+	slab->freeChunks = chunk;
+	slab->used--;
+
+	// keep the last slab of a class around, otherwise hand empty ones back
+	if (slab->used || (zone->slabs[sizeClass] == slab && !slab->next))
+	{
+		return NULL;
+	}
+
+	if (slab->prev)
+	{
+		slab->prev->next = slab->next;
+	}
+	else
+	{
+		zone->slabs[sizeClass] = slab->next;
+	}
+	if (slab->next)
+	{
+		slab->next->prev = slab->prev;
+	}
+
+	zone->slabBytes -= block->size;
+	zone->slabCount--;
+
+	return Z_BlockFree(zone, block);
+}
+
 /**
  * @brief Z_ClearZone
  * @param[out] zone
@@ -1016,22 +1502,61 @@ static void Z_CheckHeap(void);
 static void Z_ClearZone(memzone_t *zone, int size)
 {
 	memblock_t *block;
+	int        i, j;
+
+	// size classes of the chunks
+	for (i = 0, j = 0; i < (int)ARRAY_LEN(zoneSlabClass); i++)
+	{
+		while (zoneSlabSizes[j] < i * 16)
+		{
+			j++;
+		}
+		zoneSlabClass[i] = j;
+	}
+
+	Com_Memset(zone, 0, sizeof(*zone));
 
 	// set the entire zone to one free block
 
 	zone->blocklist.next = zone->blocklist.prev = block =
-		( memblock_t * )((byte *)zone + sizeof(memzone_t));
+		( memblock_t * )((byte *)zone + PAD(sizeof(memzone_t), 16));
 	zone->blocklist.tag  = 1;   // in use block
 	zone->blocklist.id   = 0;
 	zone->blocklist.size = 0;
-	zone->rover          = block;
 	zone->size           = size;
 	zone->used           = 0;
 
 	block->prev = block->next = &zone->blocklist;
 	block->tag  = 0;        // free block
 	block->id   = ZONEID;
-	block->size = size - sizeof(memzone_t);
+	block->size = size - PAD(sizeof(memzone_t), 16);
+
+	Z_InsertFreeBlock(zone, block);
+}
+
+/**
+ * @brief Frees a block or chunk that passed the checks
+ * @param[in,out] zone
+ * @param[in,out] block
+ * @return The free block the memory ended up in, NULL if it stays in a slab
+ */
+static memblock_t *Z_Release(memzone_t *zone, memblock_t *block)
+{
+	zone->used               -= block->size;
+	zoneTagBytes[block->tag] -= block->size;
+	zoneTagBlocks[block->tag]--;
+
+	// set the block to something that should cause problems
+	// if it is referenced...
+	Com_Memset(block + 1, 0xaa, block->size - sizeof(*block));
+
+	if (block->id == SLABID)
+	{
+		zone->slabUsed -= block->size;
+		return Z_SlabFree(zone, block);
+	}
+
+	return Z_BlockFree(zone, block);
 }
 
 /**
@@ -1040,7 +1565,7 @@ static void Z_ClearZone(memzone_t *zone, int size)
  */
 void Z_Free(void *ptr)
 {
-	memblock_t *block, *other;
+	memblock_t *block;
 	memzone_t  *zone;
 
 	if (!ptr)
@@ -1049,7 +1574,7 @@ void Z_Free(void *ptr)
 	}
 
 	block = ( memblock_t * )((byte *)ptr - sizeof(memblock_t));
-	if (block->id != ZONEID)
+	if (block->id != ZONEID && block->id != SLABID)
 	{
 		Com_Error(ERR_FATAL, "Z_Free: freed a pointer without ZONEID");
 	}
@@ -1057,6 +1582,10 @@ void Z_Free(void *ptr)
 	{
 		Com_Error(ERR_FATAL, "Z_Free: freed a freed pointer");
 	}
+	if (block->tag == TAG_SLAB)
+	{
+		Com_Error(ERR_FATAL, "Z_Free: freed a slab");
+	}
 	// if static memory
 	if (block->tag == TAG_STATIC)
 	{
@@ -1078,41 +1607,7 @@ void Z_Free(void *ptr)
 		zone = mainzone;
 	}
 
-	zone->used -= block->size;
-	// set the block to something that should cause problems
-	// if it is referenced...
-	Com_Memset(ptr, 0xaa, block->size - sizeof(*block));
-
-	block->tag = 0;     // mark as free
-
-	other = block->prev;
-	if (!other->tag)
-	{
-		// merge with previous free block
-		other->size      += block->size;
-		other->next       = block->next;
-		other->next->prev = other;
-		if (block == zone->rover)
-		{
-			zone->rover = other;
-		}
-		block = other;
-	}
-
-	zone->rover = block;
-
-	other = block->next;
-	if (!other->tag)
-	{
-		// merge the next free block onto the end
-		block->size      += other->size;
-		block->next       = other->next;
-		block->next->prev = block;
-		if (other == zone->rover)
-		{
-			zone->rover = block;
-		}
-	}
+	Z_Release(zone, block);
 }
 
 /**
@@ -1121,7 +1616,10 @@ void Z_Free(void *ptr)
  */
 void Z_FreeTags(int tag)
 {
-	memzone_t *zone;
+	memzone_t  *zone;
+	memblock_t *block, *chunk, *freed;
+	memslab_t  *slab;
+	int        i;
 
 	if (tag == TAG_SMALL)
 	{
@@ -1132,19 +1630,30 @@ void Z_FreeTags(int tag)
 		zone = mainzone;
 	}
 
-	// use the rover as our pointer, because
-	// Z_Free automatically adjusts it
-	zone->rover = zone->blocklist.next;
-	do
+	for (block = zone->blocklist.next; block != &zone->blocklist; block = block->next)
 	{
-		if (zone->rover->tag == tag)
+		if (block->tag == tag)
 		{
-			Z_Free(( void * )(zone->rover + 1));
-			continue;
+			// continue after whatever it was merged into
+			block = Z_Release(zone, block);
+		}
+		else if (block->tag == TAG_SLAB)
+		{
+			slab = ( memslab_t * )(block + 1);
+
+			for (i = 0; i < slab->count; i++)
+			{
+				chunk = ( memblock_t * )((byte *)block + ZONE_SLAB_HEADER + i * zoneSlabSizes[slab->sizeClass]);
+
+				if (chunk->tag == tag && (freed = Z_Release(zone, chunk)) != NULL)
+				{
+					// the slab was handed back, the rest of it was free anyway
+					block = freed;
+					break;
+				}
+			}
 		}
-		zone->rover = zone->rover->next;
 	}
-	while (zone->rover != &zone->blocklist);
 }
 
 // so we can track a block to find out when it's getting trashed
@@ -1167,8 +1676,7 @@ void *Z_TagMallocDebug(size_t size, int tag, char *label, char *file, int line)
 void *Z_TagMalloc(size_t size, int tag)
 {
 #endif
-	size_t     extra;
-	memblock_t *start, *rover, *new, *base;
+	memblock_t *base = NULL;
 	memzone_t  *zone;
 
 	if (!tag)
@@ -1189,64 +1697,48 @@ void *Z_TagMalloc(size_t size, int tag)
 	allocSize = size;
 #endif
 
-	// scan through the block list looking for the first free block
-	// of sufficient size
-
 	size += sizeof(memblock_t);         // account for size of block header
 	size += 4;                          // space for memory trash tester
 	size  = PAD(size, sizeof(intptr_t)); // align to 32/64 bit boundary
 
-	base  = rover = zone->rover;
-	start = base->prev;
+	// small ones come from the slabs, unless there is no room for another slab
+	if (size <= ZONE_SLAB_MAX)
+	{
+		base = Z_SlabAlloc(zone, zoneSlabClass[(size + 15) >> 4]);
+	}
+	if (!base)
+	{
+		base = Z_BlockAlloc(zone, size);
+	}
 
-	do
+	if (!base)
 	{
-		if (rover == start)
-		{
 #ifdef ZONE_DEBUG
-			Z_LogHeap();
+		Z_LogHeap();
 
-			Com_Error(ERR_FATAL, "Z_Malloc: failed on allocation of %zu bytes from the %s zone: %s, line: %d (%s)",
-			          size, zone == smallzone ? "small" : "main", file, line, label);
+		Com_Error(ERR_FATAL, "Z_Malloc: failed on allocation of %zu bytes from the %s zone: %s, line: %d (%s)",
+		          size, zone == smallzone ? "small" : "main", file, line, label);
 #else
-			Com_Error(ERR_FATAL, "Z_Malloc: failed on allocation of %zu bytes from the %s zone",
-			          size, zone == smallzone ? "small" : "main");
+		Com_Error(ERR_FATAL, "Z_Malloc: failed on allocation of %zu bytes from the %s zone",
+		          size, zone == smallzone ? "small" : "main");
 #endif
-			return NULL;
-		}
-		if (rover->tag)
-		{
-			base = rover = rover->next;
-		}
-		else
-		{
-			rover = rover->next;
-		}
-	}
-	while (base->tag || base->size < size);
-
-	// found a block big enough
-	extra = base->size - size;
-	if (extra > MINFRAGMENT)
-	{
-		// there will be a free fragment after the allocated block
-		new             = ( memblock_t * )((byte *)base + size);
-		new->size       = extra;
-		new->tag        = 0;    // free block
-		new->prev       = base;
-		new->id         = ZONEID;
-		new->next       = base->next;
-		new->next->prev = new;
-		base->next      = new;
-		base->size      = size;
+		return NULL;
 	}
 
 	base->tag = tag;            // no longer a free block
 
-	zone->rover = base->next;   // next allocation will start looking here
-	zone->used += base->size;   //
+	zone->used += base->size;
+	if (base->id == SLABID)
+	{
+		zone->slabUsed += base->size;
+	}
 
-	base->id = ZONEID;
+	zoneTagBytes[tag] += base->size;
+	zoneTagBlocks[tag]++;
+	if (zoneTagBytes[tag] > zoneTagHighwater[tag])
+	{
+		zoneTagHighwater[tag] = zoneTagBytes[tag];
+	}
 
 #ifdef ZONE_DEBUG
 	base->d.label     = label;
@@ -1319,19 +1811,52 @@ static void Z_CheckHeap(void)
 }
 
 /**
- * @brief Z_LogZoneHeap
- * @param zone
- * @param name
+ * @brief Logs one block of a zone
+ * @param[in] block
+ * @param[in,out] size
+ * @param[in,out] allocSize
+ * @param[in,out] numBlocks
  */
-void Z_LogZoneHeap(memzone_t *zone, const char *name)
+static void Z_LogZoneBlock(memblock_t *block, int *size, int *allocSize, int *numBlocks)
 {
 #ifdef ZONE_DEBUG
 	char dump[32], *ptr;
+	char buf[4096];
 	int  i, j;
+
+	ptr = ((char *) block) + sizeof(memblock_t);
+	j   = 0;
+	for (i = 0; i < 20 && i < block->d.allocSize; i++)
+	{
+		if (ptr[i] >= 32 && ptr[i] < 127)
+		{
+			dump[j++] = ptr[i];
+		}
+		else
+		{
+			dump[j++] = '_';
+		}
+	}
+	dump[j] = '\0';
+	Com_sprintf(buf, sizeof(buf), "size = %8d: %s, line: %d (%s) [%s]\r\n", block->d.allocSize, block->d.file, block->d.line, block->d.label, dump);
+	FS_Write(buf, strlen(buf), logfile);
+	*allocSize += block->d.allocSize;
 #endif
-	memblock_t *block;
+	*size += block->size;
+	(*numBlocks)++;
+}
+
+/**
+ * @brief Z_LogZoneHeap
+ * @param zone
+ * @param name
+ */
+void Z_LogZoneHeap(memzone_t *zone, const char *name)
+{
+	memblock_t *block, *chunk;
+	memslab_t  *slab;
 	char       buf[4096];
-	int        size, allocSize, numBlocks;
+	int        size, allocSize, numBlocks, i;
 
 	if (!logfile || !FS_Initialized())
 	{
@@ -1342,29 +1867,23 @@ void Z_LogZoneHeap(memzone_t *zone, const char *name)
 	FS_Write(buf, strlen(buf), logfile);
 	for (block = zone->blocklist.next ; block->next != &zone->blocklist; block = block->next)
 	{
-		if (block->tag)
+		if (block->tag == TAG_SLAB)
 		{
-#ifdef ZONE_DEBUG
-			ptr = ((char *) block) + sizeof(memblock_t);
-			j   = 0;
-			for (i = 0; i < 20 && i < block->d.allocSize; i++)
+			slab = ( memslab_t * )(block + 1);
+
+			for (i = 0; i < slab->count; i++)
 			{
-				if (ptr[i] >= 32 && ptr[i] < 127)
-				{
-					dump[j++] = ptr[i];
-				}
-				else
+				chunk = ( memblock_t * )((byte *)block + ZONE_SLAB_HEADER + i * zoneSlabSizes[slab->sizeClass]);
+
+				if (chunk->tag)
 				{
-					dump[j++] = '_';
+					Z_LogZoneBlock(chunk, &size, &allocSize, &numBlocks);
 				}
 			}
-			dump[j] = '\0';
-			Com_sprintf(buf, sizeof(buf), "size = %8d: %s, line: %d (%s) [%s]\r\n", block->d.allocSize, block->d.file, block->d.line, block->d.label, dump);
-			FS_Write(buf, strlen(buf), logfile);
-			allocSize += block->d.allocSize;
-#endif
-			size += block->size;
-			numBlocks++;
+		}
+		else if (block->tag)
+		{
+			Z_LogZoneBlock(block, &size, &allocSize, &numBlocks);
 		}
 	}
 #ifdef ZONE_DEBUG
@@ -1523,16 +2042,45 @@ static int  s_hunkTotal;
 static int s_zoneTotal;
 static int s_smallZoneTotal;
 
+/**
+ * @brief Prints how fragmented the free memory of a zone is
+ * @param[in] zone
+ * @param[in] name
+ */
+static void Com_MeminfoZone(memzone_t *zone, const char *name)
+{
+	memblock_t *block;
+	int        largest = 0, level;
+
+	// the largest free block is in the highest bin that isn't empty
+	if (zone->levelBits)
+	{
+		level = Z_HighestBit(zone->levelBits);
+
+		for (block = zone->bins[level][Z_HighestBit(zone->binBits[level])]; block; block = Z_FreeLinks(block)->next)
+		{
+			if ((int)block->size > largest)
+			{
+				largest = (int)block->size;
+			}
+		}
+	}
+
+	Com_Printf("%9i bytes (%6.2f MB) free in %s zone, %i blocks, largest %i bytes, %.1f%% fragmented\n", zone->freeBytes, zone->freeBytes / Square(1024.f), name,
+	           zone->freeBlocks, largest, zone->freeBytes ? 100.f * (1.f - (float)largest / zone->freeBytes) : 0.f);
+	Com_Printf("%9i bytes (%6.2f MB) in %i %s zone slabs, %i bytes unused\n", zone->slabBytes, zone->slabBytes / Square(1024.f), zone->slabCount, name,
+	           zone->slabBytes - zone->slabUsed);
+}
+
 /**
  * @brief Com_Meminfo_f
  */
 void Com_Meminfo_f(void)
 {
 	memblock_t *block;
-	int        zoneBytes = 0, zoneBlocks = 0;
-	int        smallZoneBytes, smallZoneBlocks;
-	int        botlibBytes = 0, rendererBytes = 0;
+	int        zoneBytes, zoneBlocks;
 	int        unused;
+	int        i;
 
 	for (block = mainzone->blocklist.next ; ; block = block->next)
 	{
@@ -1541,19 +2089,6 @@ void Com_Meminfo_f(void)
 			Com_Printf("block:%p    size:%7zu    tag:%3i\n",
 			           block, block->size, block->tag);
 		}
-		if (block->tag)
-		{
-			zoneBytes += block->size;
-			zoneBlocks++;
-			if (block->tag == TAG_BOTLIB)
-			{
-				botlibBytes += block->size;
-			}
-			else if (block->tag == TAG_RENDERER)
-			{
-				rendererBytes += block->size;
-			}
-		}
 
 		if (block->next == &mainzone->blocklist)
 		{
@@ -1573,21 +2108,8 @@ void Com_Meminfo_f(void)
 		}
 	}
 
-	smallZoneBytes  = 0;
-	smallZoneBlocks = 0;
-	for (block = smallzone->blocklist.next ; ; block = block->next)
-	{
-		if (block->tag)
-		{
-			smallZoneBytes += block->size;
-			smallZoneBlocks++;
-		}
-
-		if (block->next == &smallzone->blocklist)
-		{
-			break;          // all blocks have been hit
-		}
-	}
+	zoneBytes  = zoneTagBytes[TAG_GENERAL] + zoneTagBytes[TAG_BOTLIB] + zoneTagBytes[TAG_RENDERER];
+	zoneBlocks = zoneTagBlocks[TAG_GENERAL] + zoneTagBlocks[TAG_BOTLIB] + zoneTagBlocks[TAG_RENDERER];
 
 	Com_Printf("%9i bytes (%6.2f MB) total hunk\n", s_hunkTotal, s_hunkTotal / Square(1024.f));
 	Com_Printf("%9i bytes (%6.2f MB) total zone\n", s_zoneTotal, s_zoneTotal / Square(1024.f));
@@ -1621,10 +2143,19 @@ void Com_Meminfo_f(void)
 	Com_Printf("%9i bytes (%6.2f MB) unused highwater\n", unused, unused / Square(1024.f));
 	Com_Printf("\n");
 	Com_Printf("%9i bytes (%6.2f MB) in %i zone blocks\n", zoneBytes, zoneBytes / Square(1024.f), zoneBlocks);
-	Com_Printf("        %9i bytes (%6.2f MB) in dynamic botlib\n", botlibBytes, botlibBytes / Square(1024.f));
-	Com_Printf("        %9i bytes (%6.2f MB) in dynamic renderer\n", rendererBytes, rendererBytes / Square(1024.f));
-	Com_Printf("        %9i bytes (%6.2f MB) in dynamic other\n", zoneBytes - (botlibBytes + rendererBytes), (zoneBytes - (botlibBytes + rendererBytes)) / Square(1024.f));
-	Com_Printf("        %9i bytes (%6.2f MB) in small Zone memory (%i) blocks\n", smallZoneBytes, smallZoneBytes / Square(1024.f), smallZoneBlocks);
+	Com_Printf("        %9i bytes (%6.2f MB) in dynamic botlib\n", zoneTagBytes[TAG_BOTLIB], zoneTagBytes[TAG_BOTLIB] / Square(1024.f));
+	Com_Printf("        %9i bytes (%6.2f MB) in dynamic renderer\n", zoneTagBytes[TAG_RENDERER], zoneTagBytes[TAG_RENDERER] / Square(1024.f));
+	Com_Printf("        %9i bytes (%6.2f MB) in dynamic other\n", zoneTagBytes[TAG_GENERAL], zoneTagBytes[TAG_GENERAL] / Square(1024.f));
+	Com_Printf("        %9i bytes (%6.2f MB) in small Zone memory (%i) blocks\n", zoneTagBytes[TAG_SMALL], zoneTagBytes[TAG_SMALL] / Square(1024.f), zoneTagBlocks[TAG_SMALL]);
+	Com_Printf("\n");
+	Com_MeminfoZone(mainzone, "main");
+	Com_MeminfoZone(smallzone, "small");
+	Com_Printf("\n");
+	for (i = TAG_GENERAL; i < TAG_STATIC; i++)
+	{
+		Com_Printf("%9i bytes (%6.2f MB) %s highwater, %i bytes in %i blocks now\n", zoneTagHighwater[i], zoneTagHighwater[i] / Square(1024.f), zoneTagNames[i],
+		           zoneTagBytes[i], zoneTagBlocks[i]);
+	}
 }
 
 /**
@@ -2766,6 +3297,90 @@ static void Com_DetectAltivec(void)
 }
 #endif
 
+#define FRAME_JITTER_BUCKETS 10
+
+/**
+ * @struct frameJitter_s
+ * @brief How late dedicated server frames start, see Com_FrameJitter_f
+ */
+static struct frameJitter_s
+{
+	int count[FRAME_JITTER_BUCKETS];
+	int samples;
+	int64_t total;
+	int64_t max;
+} frameJitter;
+
+/// upper bounds in usec, the last bucket takes the rest
+static const int frameJitterBounds[FRAME_JITTER_BUCKETS - 1] = { 10, 25, 50, 100, 250, 500, 1000, 2000, 5000 };
+
+/**
+ * @brief Com_AddFrameJitter
+ * @param[in] usec How long after its scheduled time the frame started
+ */
+static void Com_AddFrameJitter(int64_t usec)
+{
+	int i;
+
+	for (i = 0; i < FRAME_JITTER_BUCKETS - 1; i++)
+	{
+		if (usec < frameJitterBounds[i])
+		{
+			break;
+		}
+	}
+
+	frameJitter.count[i]++;
+	frameJitter.samples++;
+	frameJitter.total += usec;
+
+	if (usec > frameJitter.max)
+	{
+		frameJitter.max = usec;
+	}
+}
+
+/**
+ * @brief Prints a histogram of how late dedicated server frames started,
+ * "framejitter reset" clears it
+ */
+static void Com_FrameJitter_f(void)
+{
+	char bar[41];
+	int  i, len;
+
+	if (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "reset"))
+	{
+		Com_Memset(&frameJitter, 0, sizeof(frameJitter));
+		return;
+	}
+
+	if (!frameJitter.samples)
+	{
+		Com_Printf("No frames measured, only dedicated servers are tracked.\n");
+		return;
+	}
+
+	Com_Printf("Frame start jitter, %i frames, avg %.1f usec, max %i usec:\n", frameJitter.samples,
+	           (double)frameJitter.total / frameJitter.samples, (int)frameJitter.max);
+
+	for (i = 0; i < FRAME_JITTER_BUCKETS; i++)
+	{
+		len = (int)((int64_t)frameJitter.count[i] * (sizeof(bar) - 1) / frameJitter.samples);
+		Com_Memset(bar, '#', len);
+		bar[len] = '\0';
+
+		if (i < FRAME_JITTER_BUCKETS - 1)
+		{
+			Com_Printf("  < %5i usec: %7i %5.1f%% %s\n", frameJitterBounds[i], frameJitter.count[i], 100.0 * frameJitter.count[i] / frameJitter.samples, bar);
+		}
+		else
+		{
+			Com_Printf(" >= %5i usec: %7i %5.1f%% %s\n", frameJitterBounds[i - 1], frameJitter.count[i], 100.0 * frameJitter.count[i] / frameJitter.samples, bar);
+		}
+	}
+}
+
 /**
  * @brief Com_Init
  * @param[in] commandLine
@@ -3008,12 +3623,16 @@ void Com_Init(char *commandLine)
 
 	Cmd_AddCommand("quit", Com_Quit_f, "Quits the game.");
 	Cmd_AddCommand("changeVectors", MSG_ReportChangeVectors_f, "Prints out a table from the current statistics for copying to code.");
+	Cmd_AddCommand("huffbench", MSG_HuffmanBench_f, "Compares the table driven and the tree walking Huffman codec on a demo or random data.");
+	Cmd_AddCommand("tracebench", CM_TraceBench_f, "Times random traces through the loaded map with the brush plane blocks and per side. Usage: tracebench [traces] [iterations]");
+	Cmd_AddCommand("framejitter", Com_FrameJitter_f, "Prints a histogram of how late dedicated server frames start. Usage: framejitter [reset]");
 	Cmd_AddCommand("writeconfig", Com_WriteConfig_f, "Write the config file to a specific name.");
 	Cmd_AddCommand("update", Com_Update_f, "Updates the game to latest version.");
 	Cmd_AddCommand("download", Com_Download_f, "Downloads a pk3 from the URL set in cvar com_downloadURL.");
 
 #ifdef FEATURE_DBMS
 	Cmd_AddCommand("saveDB", DB_SaveMemDB_f, "Saves the internal memory database to disk.");
+	Cmd_AddCommand("saveDBStatus", DB_BackupStatus_f, "Prints the progress and timing of the periodic memory database backups.");
 	if (com_developer->integer)
 	{
 		Cmd_AddCommand("sql", DB_ExecSQLCommand_f, "Executes an sql command.");
@@ -3406,33 +4025,63 @@ void Com_Frame(void)
 		minMsec = 1;
 	}
 
-	do
+	if (com_dedicated->integer && !com_timedemo->integer)
 	{
-		if (com_sv_running->integer)
+		// wait on the microsecond clock so the frame starts right when
+		// Sys_Milliseconds() reaches com_frameTime + minMsec instead of up to 1 msec late
+		int64_t deadline = (int64_t)(com_frameTime + minMsec) * 1000;
+		int64_t usec;
+
+		do
 		{
-			timeValSV = SV_SendQueuedPackets();
-			timeVal   = Com_TimeVal(minMsec);
+			usec = deadline - Sys_Microseconds();
 
-			if (timeValSV < timeVal)
+			if (com_sv_running->integer)
 			{
-				timeVal = timeValSV;
+				timeValSV = SV_SendQueuedPackets();
+
+				if ((int64_t)timeValSV * 1000 < usec)
+				{
+					usec = (int64_t)timeValSV * 1000;
+				}
 			}
-		}
-		else
-		{
-			timeVal = Com_TimeVal(minMsec);
-		}
 
-		if (timeVal < 1)
-		{
-			NET_Sleep(0);
+			NET_SleepUsec(usec);
 		}
-		else
+		while (Sys_Microseconds() < deadline);
+
+		Com_AddFrameJitter(Sys_Microseconds() - deadline);
+	}
+	else
+	{
+		do
 		{
-			NET_Sleep(timeVal - 1);
+			if (com_sv_running->integer)
+			{
+				timeValSV = SV_SendQueuedPackets();
+				timeVal   = Com_TimeVal(minMsec);
+
+				if (timeValSV < timeVal)
+				{
+					timeVal = timeValSV;
+				}
+			}
+			else
+			{
+				timeVal = Com_TimeVal(minMsec);
+			}
+
+			if (timeVal < 1)
+			{
+				NET_Sleep(0);
+			}
+			else
+			{
+				NET_Sleep(timeVal - 1);
+			}
 		}
+		while (Com_TimeVal(minMsec));
 	}
-	while (Com_TimeVal(minMsec));
 
 #ifndef DEDICATED
 	IN_Frame();
@@ -3518,6 +4167,11 @@ void Com_Frame(void)
 		timeBeforeClient = timeAfter;
 	}
 
+#ifdef FEATURE_DBMS
+	// copy a part of the memory database to disk
+	DB_BackupFrame();
+#endif
+
 #ifdef DEDICATED
 	// watchdog
 	Com_WatchDog();
@@ -44,10 +44,35 @@ cvarFlags_t cvar_modifiedFlags;
 cvar_t cvar_indexes[MAX_CVARS];
 int    cvar_numIndexes;
 
+#define CVAR_CHANGE_LOG 1024            ///< power of two
+
+static qboolean cvar_vmRegistered[MAX_CVARS];       ///< cvars registered by the interpreted modules, the slot stays marked once set
+static int      cvar_changedAt[MAX_CVARS];          ///< sequence of the latest logged change of each cvar
+static int      cvar_changeLog[CVAR_CHANGE_LOG];    ///< handles of the changed module cvars, indexed by sequence
+static int      cvar_changeSequence;
+
 #define FILE_HASH_SIZE      512
 static cvar_t *hashTable[FILE_HASH_SIZE];
 #define generateHashValue(fname) Q_GenerateHashValue(fname, FILE_HASH_SIZE, qtrue, qtrue)
 
+/**
+ * @brief Logs a change of a cvar registered by a module, see Cvar_Changes()
+ * @param[in] var
+ */
+static void Cvar_LogChange(cvar_t *var)
+{
+	int index = var - cvar_indexes;
+
+	if (!cvar_vmRegistered[index])
+	{
+		return;
+	}
+
+	cvar_changeSequence++;
+	cvar_changeLog[cvar_changeSequence & (CVAR_CHANGE_LOG - 1)] = index;
+	cvar_changedAt[index]                                       = cvar_changeSequence;
+}
+
 /**
  * @brief Cvar_ValidateString
  * @param[in] s
@@ -588,6 +613,9 @@ cvar_t *Cvar_Get(const char *varName, const char *value, cvarFlags_t flags)
 	// note what types of cvars have been modified (userinfo, archive, serverinfo, systeminfo)
 	cvar_modifiedFlags |= var->flags;
 
+	// a module might still hold a handle to a cvar unset before
+	Cvar_LogChange(var);
+
 	hash           = generateHashValue(varName);
 	var->hashIndex = hash;
 
@@ -759,6 +787,7 @@ cvar_t *Cvar_Set2(const char *var_name, const char *value, qboolean force)
 			var->latchedString = CopyString(value);
 			var->modified      = qtrue;
 			var->modificationCount++;
+			Cvar_LogChange(var);
 			return var;
 		}
 	}
@@ -785,6 +814,8 @@ cvar_t *Cvar_Set2(const char *var_name, const char *value, qboolean force)
 	var->value   = Q_atof(var->string);
 	var->integer = Q_atoi(var->string);
 
+	Cvar_LogChange(var);
+
 	return var;
 }
 
@@ -1839,6 +1870,8 @@ void Cvar_Register(vmCvar_t *vmCvar, const char *varName, const char *defaultVal
 	vmCvar->handle            = cv - cvar_indexes;
 	vmCvar->modificationCount = -1;
 	Cvar_Update(vmCvar);
+
+	cvar_vmRegistered[vmCvar->handle] = qtrue;
 }
 
 /**
@@ -1878,6 +1911,50 @@ void Cvar_Update(vmCvar_t *vmCvar)
 	vmCvar->integer = cv->integer;
 }
 
+/**
+ * @brief Lists the module cvars changed since the caller's last call, so the
+ * modules don't have to Cvar_Update() all of their cvars each frame
+ *
+ * @param[in,out] sequence Change sequence the caller has seen, updated to the current one
+ * @param[out] handles
+ * @param[in] maxHandles
+ * @return Number of handles, each changed cvar is listed once. -1 if the
+ * caller has to update all of its cvars because sequence is unknown (e.g. -1
+ * on the first call) or too many changes happened since.
+ */
+int Cvar_Changes(int *sequence, int *handles, int maxHandles)
+{
+	int seq   = *sequence;
+	int count = 0;
+
+	*sequence = cvar_changeSequence;
+
+	if (seq < 0 || seq > cvar_changeSequence || cvar_changeSequence - seq > CVAR_CHANGE_LOG)
+	{
+		return -1;
+	}
+
+	for (seq++; seq <= cvar_changeSequence; seq++)
+	{
+		int index = cvar_changeLog[seq & (CVAR_CHANGE_LOG - 1)];
+
+		// changed again later on, list it only once
+		if (cvar_changedAt[index] != seq)
+		{
+			continue;
+		}
+
+		if (count == maxHandles)
+		{
+			return -1;
+		}
+
+		handles[count++] = index;
+	}
+
+	return count;
+}
+
 /**
  * @brief Cvar_CompleteCvarName
  * @param[in] args
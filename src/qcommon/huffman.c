@@ -38,6 +38,8 @@
 #include "q_shared.h"
 #include "qcommon.h"
 
+// cursor of the adaptive Huff_Compress()/Huff_Decompress() coder, the
+// offset based functions keep their cursor in the caller and are reentrant
 static int bloc = 0;
 
 /**
@@ -50,16 +52,14 @@ void Huff_putBit(int bit, byte *fout, int *offset)
 {
 	int x, y;
 
-	bloc = *offset;
-	x    = bloc >> 3;
-	y    = bloc & 7;
+	x = *offset >> 3;
+	y = *offset & 7;
 	if (!y)
 	{
 		fout[x] = 0;
 	}
 	fout[x] |= bit << y;
-	bloc++;
-	*offset = bloc;
+	(*offset)++;
 }
 
 /**
@@ -72,10 +72,8 @@ int Huff_getBit(byte *fin, int *offset)
 {
 	int t;
 
-	bloc = *offset;
-	t    = fin[bloc >> 3] >> (bloc & 7) & 0x1;
-	bloc++;
-	*offset = bloc;
+	t = fin[*offset >> 3] >> (*offset & 7) & 0x1;
+	(*offset)++;
 	return t;
 }
 
@@ -420,16 +418,19 @@ int Huff_Receive(node_t *node, int *ch, byte *fin)
  */
 void Huff_offsetReceive(node_t *node, int *ch, byte *fin, int *offset, int maxoffset)
 {
-	bloc = *offset;
+	// work on a local cursor instead of the shared bloc so that several
+	// messages can be coded at the same time (threaded snapshot building)
+	int cursor = *offset;
+
 	while (node && node->symbol == INTERNAL_NODE)
 	{
-		if (bloc >= maxoffset)
+		if (cursor >= maxoffset)
 		{
-			*ch = 0;
+			*ch     = 0;
 			*offset = maxoffset + 1;
 			return;
 		}
-		if (get_bit(fin))
+		if (Huff_getBit(fin, &cursor))
 		{
 			node = node->right;
 		}
@@ -445,7 +446,7 @@ void Huff_offsetReceive(node_t *node, int *ch, byte *fin, int *offset, int maxof
 		//Com_Error(ERR_DROP, "Illegal tree!");
 	}
 	*ch     = node->symbol;
-	*offset = bloc;
+	*offset = cursor;
 }
 
 /**
@@ -453,28 +454,29 @@ void Huff_offsetReceive(node_t *node, int *ch, byte *fin, int *offset, int maxof
  * @param[in] node
  * @param[in] child
  * @param[in] fout
+ * @param[in,out] offset
  * @param[in] maxoffset
  */
-static void send(node_t *node, node_t *child, byte *fout, int maxoffset)
+static void send(node_t *node, node_t *child, byte *fout, int *offset, int maxoffset)
 {
 	if (node->parent)
 	{
-		send(node->parent, node, fout, maxoffset);
+		send(node->parent, node, fout, offset, maxoffset);
 	}
 	if (child)
 	{
-		if (bloc >= maxoffset)
+		if (*offset >= maxoffset)
 		{
-			bloc = maxoffset + 1;
+			*offset = maxoffset + 1;
 			return;
 		}
 		if (node->right == child)
 		{
-			add_bit(1, fout);
+			Huff_putBit(1, fout, offset);
 		}
 		else
 		{
-			add_bit(0, fout);
+			Huff_putBit(0, fout, offset);
 		}
 	}
 }
@@ -501,7 +503,7 @@ void Huff_transmit(huff_t *huff, int ch, byte *fout, int maxoffset)
 	}
 	else
 	{
-		send(huff->loc[ch], NULL, fout, maxoffset);
+		send(huff->loc[ch], NULL, fout, &bloc, maxoffset);
 	}
 }
 
@@ -515,9 +517,149 @@ void Huff_transmit(huff_t *huff, int ch, byte *fout, int maxoffset)
  */
 void Huff_offsetTransmit(huff_t *huff, int ch, byte *fout, int *offset, int maxoffset)
 {
-	bloc = *offset;
-	send(huff->loc[ch], NULL, fout, maxoffset);
-	*offset = bloc;
+	send(huff->loc[ch], NULL, fout, offset, maxoffset);
+}
+
+/**
+ * @brief Builds the code of every symbol of a static tree as one integer,
+ * the first bit sent is bit 0.
+ * @param[in] huff
+ * @param[out] code
+ * @param[out] length 0 if the symbol isn't in the tree or its code doesn't fit
+ */
+static void Huff_tableCodes(const huff_t *huff, uint32_t *code, byte *length)
+{
+	node_t *node;
+	int    sym, len;
+
+	for (sym = 0; sym <= HMAX; sym++)
+	{
+		code[sym]   = 0;
+		length[sym] = 0;
+
+		if (!huff->loc[sym])
+		{
+			continue;
+		}
+
+		// walk up to the root, so the bit next to the root ends up lowest
+		for (len = 0, node = huff->loc[sym]; node->parent; node = node->parent, len++)
+		{
+			if (len == 32)
+			{
+				break;
+			}
+			code[sym] = (code[sym] << 1) | (node->parent->right == node ? 1 : 0);
+		}
+
+		length[sym] = node->parent ? 0 : len;
+	}
+}
+
+/**
+ * @brief Precomputes the codes of a tree that isn't updated anymore, so that
+ * a symbol can be sent and received with one table lookup
+ * @param[out] table
+ * @param[in] encoder Tree used by Huff_tableTransmit()
+ * @param[in] decoder Tree used by Huff_tableReceive()
+ */
+void Huff_InitTable(huffTable_t *table, const huff_t *encoder, const huff_t *decoder)
+{
+	uint32_t code[HMAX + 1];
+	byte     length[HMAX + 1];
+	int      sym, i;
+
+	Com_Memset(table, 0, sizeof(*table));
+
+	Huff_tableCodes(encoder, table->code, table->length);
+	Huff_tableCodes(decoder, code, length);
+
+	// every index starting with the code of a symbol decodes to that symbol,
+	// codes longer than the index are left to the tree walk
+	for (sym = 0; sym <= HMAX; sym++)
+	{
+		if (!length[sym] || length[sym] > HUFF_DECODE_BITS)
+		{
+			continue;
+		}
+
+		for (i = 0; i < (1 << (HUFF_DECODE_BITS - length[sym])); i++)
+		{
+			table->decode[code[sym] | (i << length[sym])] = (uint16_t)(sym | (length[sym] << 9));
+		}
+	}
+}
+
+/**
+ * @brief Same as Huff_offsetTransmit() for a tree passed to Huff_InitTable()
+ * @param[in] table
+ * @param[in] huff
+ * @param[in] ch
+ * @param[out] fout
+ * @param[in,out] offset
+ * @param[in] maxoffset
+ */
+void Huff_tableTransmit(const huffTable_t *table, huff_t *huff, int ch, byte *fout, int *offset, int maxoffset)
+{
+	uint32_t code  = table->code[ch];
+	int      count = table->length[ch];
+	int      x, y, written;
+
+	if (!count || *offset + count > maxoffset)
+	{
+		// the tree walk handles running out of space bit by bit
+		send(huff->loc[ch], NULL, fout, offset, maxoffset);
+		return;
+	}
+
+	x = *offset >> 3;
+	y = *offset & 7;
+
+	// like Huff_putBit() a byte is cleared when the first bit goes into it
+	if (!y)
+	{
+		fout[x] = 0;
+	}
+	fout[x] |= (byte)(code << y);
+
+	for (written = 8 - y; written < count; written += 8)
+	{
+		fout[++x] = (byte)(code >> written);
+	}
+
+	*offset += count;
+}
+
+/**
+ * @brief Same as Huff_offsetReceive() for a tree passed to Huff_InitTable()
+ * @param[in] table
+ * @param[in] node
+ * @param[out] ch
+ * @param[in] fin
+ * @param[in,out] offset
+ * @param[in] maxoffset
+ */
+void Huff_tableReceive(const huffTable_t *table, node_t *node, int *ch, byte *fin, int *offset, int maxoffset)
+{
+	int      x = *offset >> 3;
+	uint32_t bits;
+	int      entry;
+
+	// the lookup reads 3 bytes, near the end the tree walk does the bounds checks
+	if (x + 3 <= (maxoffset >> 3))
+	{
+		bits  = (fin[x] | (fin[x + 1] << 8) | (fin[x + 2] << 16)) >> (*offset & 7);
+		entry = table->decode[bits & ((1 << HUFF_DECODE_BITS) - 1)];
+
+		if (entry)
+		{
+			*ch      = entry & 0x1ff;
+			*offset += entry >> 9;
+			return;
+		}
+	}
+
+	Huff_offsetReceive(node, ch, fin, offset, maxoffset);
 }
 
 /**
@@ -35,6 +35,10 @@
 #include "q_shared.h"
 #include "qcommon.h"
 
+#ifdef ETL_SSE
+#include <immintrin.h>
+#endif
+
 // FIXME: necessary for entityShared_t management to work (since we need the definitions...),
 // which is a very necessary function for server-side demos recording. It would be better if this
 // functionality would be separated in an _ext.c file, but I could not find a way to make it work
@@ -42,8 +46,9 @@
 // redefined when included, producing a lot of recursive declarations errors...)
 #include "../game/g_public.h"
 
-static huffman_t msgHuff;
-static qboolean  msgInit = qfalse;
+static huffman_t   msgHuff;
+static huffTable_t msgHuffTable;   ///< lookup tables of msgHuff, its trees don't change after MSG_initHuffman
+static qboolean    msgInit = qfalse;
 
 int pcount[256];
 int wastedbits = 0;
@@ -276,7 +281,7 @@ void MSG_WriteBits(msg_t *msg, int value, int bits)
 		{
 			for (i = 0; i < bits; i += 8)
 			{
-				Huff_offsetTransmit(&msgHuff.compressor, (value & 0xff), msg->data, &msg->bit, msg->maxsize << 3);
+				Huff_tableTransmit(&msgHuffTable, &msgHuff.compressor, (value & 0xff), msg->data, &msg->bit, msg->maxsize << 3);
 				value = (value >> 8);
 
 				if (msg->bit >= msg->maxsize << 3)
@@ -290,6 +295,64 @@ void MSG_WriteBits(msg_t *msg, int value, int bits)
 	}
 }
 
+/**
+ * @brief Appends bits that were already Huffman coded by MSG_WriteBits into
+ * another bitstream message, at any bit offset.
+ *
+ * The static Huffman tree makes the coded bits independent of where they end
+ * up, so a coded chunk can be reused for several messages.
+ *
+ * @param[in,out] msg
+ * @param[in] data Coded bits starting at bit 0, unused bits of the last byte must be 0
+ * @param[in] bits
+ */
+void MSG_WriteHuffmanBits(msg_t *msg, const byte *data, int bits)
+{
+	int  shift, i;
+	byte *out;
+
+	if (msg->overflowed || bits <= 0)
+	{
+		return;
+	}
+
+	if (msg->oob)
+	{
+		Com_Error(ERR_DROP, "MSG_WriteHuffmanBits: not a bitstream message");
+	}
+
+	if (msg->bit + bits >= msg->maxsize << 3)
+	{
+		msg->overflowed = qtrue;
+		return;
+	}
+
+	shift = msg->bit & 7;
+	out   = msg->data + (msg->bit >> 3);
+
+	if (!shift)
+	{
+		Com_Memcpy(out, data, (bits + 7) >> 3);
+	}
+	else
+	{
+		// like Huff_putBit the partially written byte keeps its low bits
+		// and every byte started here is cleared first
+		for (i = 0; (i << 3) < bits; i++)
+		{
+			out[i] |= data[i] << shift;
+
+			if (((i + 1) << 3) - shift < bits)
+			{
+				out[i + 1] = data[i] >> (8 - shift);
+			}
+		}
+	}
+
+	msg->bit    += bits;
+	msg->cursize = (msg->bit >> 3) + 1;
+}
+
 /**
  * @brief MSG_ReadBits
  * @param[in,out] msg
@@ -380,7 +443,7 @@ int MSG_ReadBits(msg_t *msg, int bits)
 
 			for (i = 0; i < bits; i += 8)
 			{
-				Huff_offsetReceive(msgHuff.decompressor.tree, &get, msg->data, &msg->bit, msg->cursize << 3);
+				Huff_tableReceive(&msgHuffTable, msgHuff.decompressor.tree, &get, msg->data, &msg->bit, msg->cursize << 3);
 				value = (unsigned int)value | ((unsigned int)get << (i + nbits));
 
 				if (msg->bit > msg->cursize << 3)
@@ -1100,6 +1163,132 @@ typedef struct
 	int used;
 } netField_t;
 
+#define ENTITYSTATE_WORDS  (int)(sizeof(entityState_t) / 4)
+#define PLAYERSTATE_WORDS  (int)(sizeof(playerState_t) / 4)
+#define NO_NETFIELD        0xff         ///< word not sent as a netField_t
+
+/**
+ * @brief Compares two structs as 32 bit words
+ * @param[in] a
+ * @param[in] b
+ * @param[in] numWords
+ * @param[out] changed Bit n is set if word n differs, (numWords + 31) / 32 words
+ * @return qtrue if any word differs
+ */
+static qboolean MSG_ChangedWords(const void *a, const void *b, int numWords, uint32_t *changed)
+{
+	const int *wa  = (const int *)a;
+	const int *wb  = (const int *)b;
+	uint32_t  diff = 0;
+	int       i    = 0;
+
+	Com_Memset(changed, 0, ((numWords + 31) >> 5) * sizeof(uint32_t));
+
+#ifdef ETL_SSE
+	// 8 words per iteration never straddle a mask word
+	for ( ; i + 8 <= numWords; i += 8)
+	{
+		__m128i lo   = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(wa + i)), _mm_loadu_si128((const __m128i *)(wb + i)));
+		__m128i hi   = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(wa + i + 4)), _mm_loadu_si128((const __m128i *)(wb + i + 4)));
+		uint32_t bits = ~(_mm_movemask_ps(_mm_castsi128_ps(lo)) | (_mm_movemask_ps(_mm_castsi128_ps(hi)) << 4)) & 0xff;
+
+		changed[i >> 5] |= bits << (i & 31);
+		diff            |= bits;
+	}
+#endif
+
+	for ( ; i < numWords; i++)
+	{
+		if (wa[i] != wb[i])
+		{
+			changed[i >> 5] |= 1u << (i & 31);
+			diff             = 1;
+		}
+	}
+
+	return diff ? qtrue : qfalse;
+}
+
+/**
+ * @brief Index of the lowest set bit
+ * @param[in] bits Must not be 0
+ * @return
+ */
+static ID_INLINE int MSG_LowestBit(uint32_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctz(bits);
+#elif defined(_MSC_VER)
+	unsigned long index;
+
+	_BitScanForward(&index, bits);
+	return (int)index;
+#else
+	int index = 0;
+
+	while (!(bits & 1))
+	{
+		bits >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+
+/**
+ * @brief Finds the number of fields to send, visiting only the changed words
+ * @param[in] changed Word mask from MSG_ChangedWords()
+ * @param[in] numWords
+ * @param[in] fieldOfWord Field index of each word, NO_NETFIELD if it isn't a field
+ * @param[in,out] fields Use counters are updated for MSG_Prioritise*Fields
+ * @return Index of the last changed field + 1, 0 if no field changed
+ */
+static int MSG_LastChangedField(const uint32_t *changed, int numWords, const byte *fieldOfWord, netField_t *fields)
+{
+	uint32_t bits;
+	int      i, word, field, lc = 0;
+
+	for (i = 0; i < (numWords + 31) >> 5; i++)
+	{
+		for (bits = changed[i]; bits; bits &= bits - 1)
+		{
+			word  = (i << 5) + MSG_LowestBit(bits);
+			field = fieldOfWord[word];
+
+			if (field != NO_NETFIELD)
+			{
+				fields[field].used++;
+				lc = MAX(lc, field + 1);
+			}
+		}
+	}
+
+	return lc;
+}
+
+/**
+ * @brief Extracts the change bits of an int array inside a struct
+ * @param[in] changed Word mask from MSG_ChangedWords()
+ * @param[in] base The compared struct
+ * @param[in] array The array inside of base
+ * @param[in] count Array length, at most 32
+ * @return Bit n is set if element n changed
+ */
+static int MSG_ChangedArray(const uint32_t *changed, const void *base, const int *array, int count)
+{
+	int      word = (int)(array - (const int *)base);
+	uint64_t bits = changed[word >> 5];
+
+	if ((word & 31) + count > 32)
+	{
+		bits |= (uint64_t)changed[(word >> 5) + 1] << 32;
+	}
+
+	return (int)((bits >> (word & 31)) & ((1ull << count) - 1));
+}
+
+#define MSG_WordChanged(changed, offset) (((changed)[(offset) >> 7] >> (((offset) >> 2) & 31)) & 1)
+
 /**
  * @brief Using the stringizing operator to save typing...
  */
@@ -1180,6 +1369,8 @@ netField_t entityStateFields[] =
 	{ NETF(aiState),         2,               0 },
 };
 
+static byte entityFieldOfWord[ENTITYSTATE_WORDS];   ///< entityStateFields index of each word, see MSG_InitFieldWords
+
 /**
  * @brief qsort_entitystatefields
  * @param[in] a
@@ -1250,7 +1441,8 @@ void MSG_WriteDeltaEntity(msg_t *msg, entityState_t *from, entityState_t *to, qb
 	netField_t *field;
 	int        trunc;
 	float      fullFloat;
-	int        *fromF, *toF;
+	int        *toF;
+	uint32_t   changed[(ENTITYSTATE_WORDS + 31) >> 5];
 
 	// all fields should be 32 bits to avoid any compiler packing issues
 	// the "number" field is not part of the field list
@@ -1279,18 +1471,11 @@ void MSG_WriteDeltaEntity(msg_t *msg, entityState_t *from, entityState_t *to, qb
 		Com_Error(ERR_FATAL, "MSG_WriteDeltaEntity: Bad entity number: %i", to->number);
 	}
 
+	// compare the whole state at once, only the changed words are mapped to fields
 	lc = 0;
-	// build the change vector as bytes so it is endien independent
-	for (i = 0, field = entityStateFields ; i < numFields ; i++, field++)
+	if (MSG_ChangedWords(from, to, ENTITYSTATE_WORDS, changed))
 	{
-		fromF = ( int * )((byte *)from + field->offset);
-		toF   = ( int * )((byte *)to + field->offset);
-		if (*fromF != *toF)
-		{
-			lc = i + 1;
-
-			field->used++;
-		}
+		lc = MSG_LastChangedField(changed, ENTITYSTATE_WORDS, entityFieldOfWord, entityStateFields);
 	}
 
 	if (lc == 0)
@@ -1319,10 +1504,9 @@ void MSG_WriteDeltaEntity(msg_t *msg, entityState_t *from, entityState_t *to, qb
 
 	for (i = 0, field = entityStateFields ; i < lc ; i++, field++)
 	{
-		fromF = ( int * )((byte *)from + field->offset);
-		toF   = ( int * )((byte *)to + field->offset);
+		toF = ( int * )((byte *)to + field->offset);
 
-		if (*fromF == *toF)
+		if (!MSG_WordChanged(changed, field->offset))
 		{
 			MSG_WriteBits(msg, 0, 1);   // no change
 
@@ -2180,6 +2364,8 @@ netField_t playerStateFields[] =
 	{ PSF(aiState),              2,               0 },
 };
 
+static byte playerFieldOfWord[PLAYERSTATE_WORDS];   ///< playerStateFields index of each word, see MSG_InitFieldWords
+
 /**
  * @brief qsort_playerstatefields
  * @param[in] a
@@ -2245,11 +2431,12 @@ void MSG_WriteDeltaPlayerstate(msg_t *msg, struct playerState_s *from, struct pl
 	int           holdablebits;
 	int           numFields;
 	netField_t    *field;
-	int           *fromF, *toF;
+	int           *toF;
 	float         fullFloat;
 	int           trunc;
 	int           startBit, endBit;
 	int           print;
+	uint32_t      changed[(PLAYERSTATE_WORDS + 31) >> 5];
 
 	if (!from)
 	{
@@ -2280,17 +2467,11 @@ void MSG_WriteDeltaPlayerstate(msg_t *msg, struct playerState_s *from, struct pl
 
 	numFields = sizeof(playerStateFields) / sizeof(playerStateFields[0]);
 
+	// one pass over the whole state gives the changed fields and array elements
 	lc = 0;
-	for (i = 0, field = playerStateFields ; i < numFields ; i++, field++)
+	if (MSG_ChangedWords(from, to, PLAYERSTATE_WORDS, changed))
 	{
-		fromF = ( int * )((byte *)from + field->offset);
-		toF   = ( int * )((byte *)to + field->offset);
-		if (*fromF != *toF)
-		{
-			lc = i + 1;
-
-			field->used++;
-		}
+		lc = MSG_LastChangedField(changed, PLAYERSTATE_WORDS, playerFieldOfWord, playerStateFields);
 	}
 
 	MSG_WriteByte(msg, lc);     // # of changes
@@ -2299,10 +2480,9 @@ void MSG_WriteDeltaPlayerstate(msg_t *msg, struct playerState_s *from, struct pl
 
 	for (i = 0, field = playerStateFields ; i < lc ; i++, field++)
 	{
-		fromF = ( int * )((byte *)from + field->offset);
-		toF   = ( int * )((byte *)to + field->offset);
+		toF = ( int * )((byte *)to + field->offset);
 
-		if (*fromF == *toF)
+		if (!MSG_WordChanged(changed, field->offset))
 		{
 			wastedbits++;
 
@@ -2352,38 +2532,10 @@ void MSG_WriteDeltaPlayerstate(msg_t *msg, struct playerState_s *from, struct pl
 	//
 	// send the arrays
 	//
-	statsbits = 0;
-	for (i = 0 ; i < MAX_STATS ; i++)
-	{
-		if (to->stats[i] != from->stats[i])
-		{
-			statsbits |= 1 << i;
-		}
-	}
-	persistantbits = 0;
-	for (i = 0 ; i < MAX_PERSISTANT ; i++)
-	{
-		if (to->persistant[i] != from->persistant[i])
-		{
-			persistantbits |= 1 << i;
-		}
-	}
-	holdablebits = 0;
-	for (i = 0 ; i < MAX_HOLDABLE ; i++)
-	{
-		if (to->holdable[i] != from->holdable[i])
-		{
-			holdablebits |= 1 << i;
-		}
-	}
-	powerupbits = 0;
-	for (i = 0 ; i < MAX_POWERUPS ; i++)
-	{
-		if (to->powerups[i] != from->powerups[i])
-		{
-			powerupbits |= 1 << i;
-		}
-	}
+	statsbits      = MSG_ChangedArray(changed, to, to->stats, MAX_STATS);
+	persistantbits = MSG_ChangedArray(changed, to, to->persistant, MAX_PERSISTANT);
+	holdablebits   = MSG_ChangedArray(changed, to, to->holdable, MAX_HOLDABLE);
+	powerupbits    = MSG_ChangedArray(changed, to, to->powerups, MAX_POWERUPS);
 
 	if (statsbits || persistantbits || holdablebits || powerupbits)
 	{
@@ -2476,14 +2628,7 @@ void MSG_WriteDeltaPlayerstate(msg_t *msg, struct playerState_s *from, struct pl
 	// ammo stored
 	for (j = 0; j < 4; j++)      // modified for 64 weaps
 	{
-		ammobits[j] = 0;
-		for (i = 0 ; i < 16 ; i++)
-		{
-			if (to->ammo[i + (j * 16)] != from->ammo[i + (j * 16)])
-			{
-				ammobits[j] |= 1 << i;
-			}
-		}
+		ammobits[j] = MSG_ChangedArray(changed, to, to->ammo + j * 16, 16);
 	}
 
 	// also encapsulated ammo changes into one check. Clip values will change frequently,
@@ -2519,14 +2664,7 @@ void MSG_WriteDeltaPlayerstate(msg_t *msg, struct playerState_s *from, struct pl
 	// ammo in clip
 	for (j = 0; j < 4; j++)      // modified for 64 weaps
 	{
-		clipbits = 0;
-		for (i = 0 ; i < 16 ; i++)
-		{
-			if (to->ammoclip[i + (j * 16)] != from->ammoclip[i + (j * 16)])
-			{
-				clipbits |= 1 << i;
-			}
-		}
+		clipbits = MSG_ChangedArray(changed, to, to->ammoclip + j * 16, 16);
 		if (clipbits)
 		{
 			MSG_WriteBits(msg, 1, 1);   // changed
@@ -3055,6 +3193,28 @@ int msg_hData[256] =
 	13504,      // 255
 };
 
+/**
+ * @brief Maps the words of entityState_t and playerState_t to their netField_t,
+ * used by the delta writers to go from changed words to changed fields
+ */
+static void MSG_InitFieldWords(void)
+{
+	int i;
+
+	Com_Memset(entityFieldOfWord, NO_NETFIELD, sizeof(entityFieldOfWord));
+	Com_Memset(playerFieldOfWord, NO_NETFIELD, sizeof(playerFieldOfWord));
+
+	for (i = 0; i < ARRAY_LEN(entityStateFields); i++)
+	{
+		entityFieldOfWord[entityStateFields[i].offset >> 2] = (byte)i;
+	}
+
+	for (i = 0; i < ARRAY_LEN(playerStateFields); i++)
+	{
+		playerFieldOfWord[playerStateFields[i].offset >> 2] = (byte)i;
+	}
+}
+
 /**
  * @brief MSG_initHuffman
  */
@@ -3072,4 +3232,174 @@ void MSG_initHuffman(void)
 			Huff_addRef(&msgHuff.decompressor, (byte)i);  // Do update
 		}
 	}
+
+	Huff_InitTable(&msgHuffTable, &msgHuff.compressor, &msgHuff.decompressor);
+
+	MSG_InitFieldWords();
+}
+
+#define HUFFBENCH_MAXSYMBOLS 0x400000
+
+/**
+ * @brief Compares the table driven Huffman codec with the tree walk on the
+ * messages of a client demo, or on random bytes following msg_hData.
+ * Also verifies that both produce the same symbols and bits.
+ *
+ * Usage: huffbench [demo] [iterations]
+ */
+void MSG_HuffmanBench_f(void)
+{
+	byte    *file = NULL, *coded, *oldOut, *newOut;
+	int     *symbols;
+	int     fileLen = 0, codedBits = 0, numSymbols = 0, numMessages = 0, iterations;
+	int     i, j, pos, len, ch, offset, oldBits = 0, newBits = 0;
+	int64_t start, oldDecode = 0, newDecode = 0, oldEncode = 0, newEncode = 0;
+
+	if (!msgInit)
+	{
+		MSG_initHuffman();
+	}
+
+	iterations = Cmd_Argc() > 2 ? MAX(1, Q_atoi(Cmd_Argv(2))) : 10;
+
+	coded   = Com_Allocate(HUFFBENCH_MAXSYMBOLS * 4);
+	oldOut  = Com_Allocate(HUFFBENCH_MAXSYMBOLS * 4);
+	newOut  = Com_Allocate(HUFFBENCH_MAXSYMBOLS * 4);
+	symbols = Com_Allocate(HUFFBENCH_MAXSYMBOLS * sizeof(int));
+
+	if (!coded || !oldOut || !newOut || !symbols)
+	{
+		Com_Printf("huffbench: out of memory\n");
+		goto done;
+	}
+
+	if (Cmd_Argc() > 1)
+	{
+		// client demos store the coded messages as: sequence, length, data
+		fileLen = FS_ReadFile(Cmd_Argv(1), (void **)&file);
+		if (fileLen <= 0 || !file)
+		{
+			Com_Printf("huffbench: couldn't read %s\n", Cmd_Argv(1));
+			goto done;
+		}
+
+		for (pos = 0; pos + 8 <= fileLen; pos += 8 + len)
+		{
+			len = LittleLong(*(int *)(file + pos + 4));
+			if (len < 0 || pos + 8 + len > fileLen || numSymbols + len * 8 > HUFFBENCH_MAXSYMBOLS)
+			{
+				break;
+			}
+
+			// decode each message up to its end with the tree walk as reference
+			for (offset = 0; ;)
+			{
+				Huff_offsetReceive(msgHuff.decompressor.tree, &ch, file + pos + 8, &offset, len << 3);
+				if (offset > len << 3)
+				{
+					break;
+				}
+				symbols[numSymbols++] = ch;
+			}
+			numMessages++;
+		}
+	}
+	else
+	{
+		int total = 0, r;
+
+		for (i = 0; i < 256; i++)
+		{
+			total += msg_hData[i];
+		}
+
+		for (numSymbols = 0; numSymbols < 0x100000; numSymbols++)
+		{
+			r = (int)(((double)rand() / ((double)RAND_MAX + 1)) * total);
+			for (i = 0; r >= msg_hData[i]; i++)
+			{
+				r -= msg_hData[i];
+			}
+			symbols[numSymbols] = i;
+		}
+	}
+
+	if (!numSymbols)
+	{
+		Com_Printf("huffbench: no symbols to code\n");
+		goto done;
+	}
+
+	// a continuous reference stream of all symbols
+	for (i = 0; i < numSymbols; i++)
+	{
+		Huff_offsetTransmit(&msgHuff.compressor, symbols[i], coded, &codedBits, HUFFBENCH_MAXSYMBOLS * 32);
+	}
+
+	for (j = 0; j < iterations; j++)
+	{
+		start = Sys_Microseconds();
+		for (i = 0, oldBits = 0; i < numSymbols; i++)
+		{
+			Huff_offsetTransmit(&msgHuff.compressor, symbols[i], oldOut, &oldBits, HUFFBENCH_MAXSYMBOLS * 32);
+		}
+		oldEncode += Sys_Microseconds() - start;
+
+		start = Sys_Microseconds();
+		for (i = 0, newBits = 0; i < numSymbols; i++)
+		{
+			Huff_tableTransmit(&msgHuffTable, &msgHuff.compressor, symbols[i], newOut, &newBits, HUFFBENCH_MAXSYMBOLS * 32);
+		}
+		newEncode += Sys_Microseconds() - start;
+
+		start = Sys_Microseconds();
+		for (i = 0, offset = 0; i < numSymbols; i++)
+		{
+			Huff_offsetReceive(msgHuff.decompressor.tree, &ch, coded, &offset, codedBits);
+		}
+		oldDecode += Sys_Microseconds() - start;
+
+		start = Sys_Microseconds();
+		for (i = 0, offset = 0; i < numSymbols; i++)
+		{
+			Huff_tableReceive(&msgHuffTable, msgHuff.decompressor.tree, &ch, coded, &offset, codedBits);
+		}
+		newDecode += Sys_Microseconds() - start;
+	}
+
+	// verify outside of the timed loops
+	if (oldBits != newBits || memcmp(oldOut, newOut, (oldBits + 7) >> 3))
+	{
+		Com_Printf(S_COLOR_RED "huffbench: encoders differ (%i/%i bits)\n", oldBits, newBits);
+	}
+	for (i = 0, offset = 0; i < numSymbols; i++)
+	{
+		Huff_tableReceive(&msgHuffTable, msgHuff.decompressor.tree, &ch, coded, &offset, codedBits);
+		if (ch != symbols[i])
+		{
+			Com_Printf(S_COLOR_RED "huffbench: decoders differ at symbol %i\n", i);
+			break;
+		}
+	}
+
+	if (numMessages)
+	{
+		Com_Printf("%i symbols from %i demo messages, %i bits coded, %i iterations\n", numSymbols, numMessages, codedBits, iterations);
+	}
+	else
+	{
+		Com_Printf("%i random symbols, %i bits coded, %i iterations\n", numSymbols, codedBits, iterations);
+	}
+	Com_Printf("encode: tree %8.2f ns/symbol  table %8.2f ns/symbol\n", 1000.0 * oldEncode / ((double)numSymbols * iterations), 1000.0 * newEncode / ((double)numSymbols * iterations));
+	Com_Printf("decode: tree %8.2f ns/symbol  table %8.2f ns/symbol\n", 1000.0 * oldDecode / ((double)numSymbols * iterations), 1000.0 * newDecode / ((double)numSymbols * iterations));
+
+done:
+	if (file)
+	{
+		FS_FreeFile(file);
+	}
+	Com_Dealloc(coded);
+	Com_Dealloc(oldOut);
+	Com_Dealloc(newOut);
+	Com_Dealloc(symbols);
 }
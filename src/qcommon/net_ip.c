@@ -32,6 +32,15 @@
  * @file net_ip.c
  */
 
+#ifdef __linux__
+// recvmmsg() and sendmmsg()
+#   ifndef _GNU_SOURCE
+#       define _GNU_SOURCE
+#   endif
+#   define NET_USE_MMSG
+#   define NET_USE_EPOLL
+#endif
+
 #include "q_shared.h"
 #include "qcommon.h"
 
@@ -102,6 +111,11 @@ static qboolean winsockInitialized = qfalse;
 #       include <sys/filio.h>
 #   endif
 
+#   ifdef NET_USE_EPOLL
+#       include <sys/epoll.h>
+#       include <sys/timerfd.h>
+#   endif
+
 typedef int SOCKET;
 #   define INVALID_SOCKET       -1
 #   define SOCKET_ERROR         -1
@@ -134,6 +148,9 @@ static cvar_t *net_mcast6iface;
 
 static cvar_t *net_dropsim; // 0.0 to 1.0, simulated packet drops
 
+static cvar_t *net_batchSize;   // max packets per recvmmsg/sendmmsg call
+static cvar_t *net_syscalls;    // socket calls and packets of the last second
+
 static struct sockaddr socksRelayAddr;
 
 static SOCKET ip_socket    = INVALID_SOCKET;
@@ -171,6 +188,75 @@ typedef struct
 static nip_localaddr_t localIP[MAX_IPS];
 static int             numIP;
 
+#define NET_MAX_BATCH       64
+#define NET_RECV_BUFSIZE    (MAX_MSGLEN + 1)    ///< same as the NET_Event buffer
+#define NET_SEND_PACKETLEN  1400                ///< bigger packets are never queued
+
+/**
+ * @struct netRecvBatch_t
+ * @brief Packets read from a socket by one recvmmsg() call
+ */
+typedef struct
+{
+	int count;                          ///< packets received by the last call
+	int next;                           ///< next of them to hand out
+#ifdef NET_USE_MMSG
+	int size;                           ///< buffers allocated in data
+	byte *data;                         ///< size buffers of NET_RECV_BUFSIZE bytes
+	struct mmsghdr msgs[NET_MAX_BATCH];
+	struct iovec iov[NET_MAX_BATCH];
+	struct sockaddr_storage from[NET_MAX_BATCH];
+#endif
+} netRecvBatch_t;
+
+static netRecvBatch_t ip_recvBatch;
+#ifdef FEATURE_IPV6
+static netRecvBatch_t ip6_recvBatch;
+static netRecvBatch_t multicast6_recvBatch;
+#endif
+
+#ifdef NET_USE_MMSG
+/**
+ * @struct netSendPacket_t
+ * @brief A packet waiting for NET_FlushSendBatch()
+ */
+typedef struct
+{
+	SOCKET socket;
+	netadrtype_t type;
+	int length;
+	socklen_t addrlen;
+	struct sockaddr_storage addr;
+	byte data[NET_SEND_PACKETLEN];
+} netSendPacket_t;
+
+/**
+ * @struct netSendBatch_s
+ * @brief Packets queued between NET_BeginSendBatch() and NET_FlushSendBatch()
+ */
+static struct netSendBatch_s
+{
+	qboolean active;
+	int count;
+	netSendPacket_t packets[NET_MAX_BATCH];
+	struct mmsghdr msgs[NET_MAX_BATCH];
+	struct iovec iov[NET_MAX_BATCH];
+} sendBatch;
+#endif
+
+/**
+ * @struct netSyscallStats_s
+ * @brief Socket calls of the current second, shown by net_syscalls
+ */
+static struct netSyscallStats_s
+{
+	int time;
+	int recvCalls;
+	int recvPackets;
+	int sendCalls;
+	int sendPackets;
+} netStats;
+
 //=============================================================================
 
 /**
@@ -740,6 +826,133 @@ qboolean NET_IsLocalAddressString(const char *address)
 
 //=============================================================================
 
+#ifdef NET_USE_MMSG
+/**
+ * @brief Frees the buffers of a receive batch and drops the packets left in it
+ * @param[in,out] batch
+ */
+static void NET_FreeRecvBatch(netRecvBatch_t *batch)
+{
+	if (batch->data)
+	{
+		Com_Dealloc(batch->data);
+	}
+	Com_Memset(batch, 0, sizeof(*batch));
+}
+
+/**
+ * @brief Reads as many packets as net_batchSize allows from the socket
+ * @param[in] sock
+ * @param[in,out] batch
+ * @return SOCKET_ERROR if nothing could be read
+ */
+static int NET_FillRecvBatch(SOCKET sock, netRecvBatch_t *batch)
+{
+	int i, ret, size = net_batchSize->integer;
+
+	if (batch->size != size)
+	{
+		NET_FreeRecvBatch(batch);
+
+		batch->data = Com_Allocate(size * NET_RECV_BUFSIZE);
+		if (!batch->data)
+		{
+			Com_Error(ERR_FATAL, "NET_FillRecvBatch: failed to allocate %i packet buffers", size);
+		}
+		batch->size = size;
+	}
+
+	for (i = 0; i < size; i++)
+	{
+		batch->iov[i].iov_base = batch->data + i * NET_RECV_BUFSIZE;
+		batch->iov[i].iov_len  = NET_RECV_BUFSIZE;
+
+		Com_Memset(&batch->msgs[i], 0, sizeof(batch->msgs[i]));
+		batch->msgs[i].msg_hdr.msg_name    = &batch->from[i];
+		batch->msgs[i].msg_hdr.msg_namelen = sizeof(batch->from[i]);
+		batch->msgs[i].msg_hdr.msg_iov     = &batch->iov[i];
+		batch->msgs[i].msg_hdr.msg_iovlen  = 1;
+	}
+
+	ret = recvmmsg(sock, batch->msgs, size, MSG_DONTWAIT, NULL);
+
+	netStats.recvCalls++;
+
+	if (ret <= 0)
+	{
+		return SOCKET_ERROR;
+	}
+
+	netStats.recvPackets += ret;
+
+	batch->count = ret;
+	batch->next  = 0;
+
+	return ret;
+}
+#endif
+
+/**
+ * @brief Reads the next packet of a socket. With net_batchSize > 1 packets
+ * are read in batches and handed out one by one.
+ *
+ * @param[in] sock
+ * @param[in,out] batch
+ * @param[out] buf
+ * @param[in] len
+ * @param[out] from
+ * @param[in,out] fromlen
+ * @return Like recvfrom()
+ */
+static int NET_RecvFrom(SOCKET sock, netRecvBatch_t *batch, byte *buf, int len, struct sockaddr_storage *from, socklen_t *fromlen)
+{
+	int ret;
+
+#ifdef NET_USE_MMSG
+	if (batch->next >= batch->count && net_batchSize->integer > 1)
+	{
+		if (NET_FillRecvBatch(sock, batch) == SOCKET_ERROR)
+		{
+			return SOCKET_ERROR;
+		}
+	}
+
+	if (batch->next < batch->count)
+	{
+		struct mmsghdr *msg = &batch->msgs[batch->next];
+
+		// a packet too big for the buffer is truncated just like by recvfrom()
+		ret = MIN((int)msg->msg_len, len);
+		Com_Memcpy(buf, msg->msg_hdr.msg_iov->iov_base, ret);
+		Com_Memcpy(from, msg->msg_hdr.msg_name, msg->msg_hdr.msg_namelen);
+		*fromlen = msg->msg_hdr.msg_namelen;
+
+		batch->next++;
+		return ret;
+	}
+#endif
+
+	ret = recvfrom(sock, (void *)buf, len, 0, (struct sockaddr *) from, fromlen);
+
+	netStats.recvCalls++;
+	if (ret != SOCKET_ERROR)
+	{
+		netStats.recvPackets++;
+	}
+
+	return ret;
+}
+
+/**
+ * @brief NET_RecvPending
+ * @param[in] batch
+ * @return qtrue if packets of a previous batch are waiting to be handed out
+ */
+static ID_INLINE qboolean NET_RecvPending(netRecvBatch_t *batch)
+{
+	return batch->next < batch->count;
+}
+
 /**
  * @brief Receive one packet
  * @param[in,out] net_from
@@ -754,10 +967,10 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 	socklen_t               fromlen;
 	int                     err;
 
-	if (ip_socket != INVALID_SOCKET && FD_ISSET(ip_socket, fdr))
+	if (ip_socket != INVALID_SOCKET && (FD_ISSET(ip_socket, fdr) || NET_RecvPending(&ip_recvBatch)))
 	{
 		fromlen = sizeof(from);
-		ret     = recvfrom(ip_socket, (void *)net_message->data, net_message->maxsize, 0, (struct sockaddr *) &from, &fromlen);
+		ret     = NET_RecvFrom(ip_socket, &ip_recvBatch, net_message->data, net_message->maxsize, &from, &fromlen);
 
 		if (ret == SOCKET_ERROR)
 		{
@@ -804,10 +1017,10 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 	}
 
 #ifdef FEATURE_IPV6
-	if (ip6_socket != INVALID_SOCKET && FD_ISSET(ip6_socket, fdr))
+	if (ip6_socket != INVALID_SOCKET && (FD_ISSET(ip6_socket, fdr) || NET_RecvPending(&ip6_recvBatch)))
 	{
 		fromlen = sizeof(from);
-		ret     = recvfrom(ip6_socket, (void *)net_message->data, net_message->maxsize, 0, (struct sockaddr *) &from, &fromlen);
+		ret     = NET_RecvFrom(ip6_socket, &ip6_recvBatch, net_message->data, net_message->maxsize, &from, &fromlen);
 
 		if (ret == SOCKET_ERROR)
 		{
@@ -834,10 +1047,10 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 		}
 	}
 
-	if (multicast6_socket != INVALID_SOCKET && multicast6_socket != ip6_socket && FD_ISSET(multicast6_socket, fdr))
+	if (multicast6_socket != INVALID_SOCKET && multicast6_socket != ip6_socket && (FD_ISSET(multicast6_socket, fdr) || NET_RecvPending(&multicast6_recvBatch)))
 	{
 		fromlen = sizeof(from);
-		ret     = recvfrom(multicast6_socket, (void *)net_message->data, net_message->maxsize, 0, (struct sockaddr *) &from, &fromlen);
+		ret     = NET_RecvFrom(multicast6_socket, &multicast6_recvBatch, net_message->data, net_message->maxsize, &from, &fromlen);
 
 		if (ret == SOCKET_ERROR)
 		{
@@ -872,6 +1085,143 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 
 static char socksBuf[4096];
 
+/**
+ * @brief Reports a failed send, ignoring the expected errors
+ * @param[in] err
+ * @param[in] type
+ */
+static void Sys_SendPacketError(int err, netadrtype_t type)
+{
+	// wouldblock is silent
+	if (err == EAGAIN)
+	{
+		return;
+	}
+
+	// some PPP links do not allow broadcasts and return an error
+	if ((err == EADDRNOTAVAIL) && ((type == NA_BROADCAST)))
+	{
+		return;
+	}
+
+	Com_Printf("Sys_SendPacket: %s\n", NET_ErrorString());
+}
+
+/**
+ * @brief Starts queueing outgoing packets until NET_FlushSendBatch(), they
+ * are then sent with as few sendmmsg() calls as possible.
+ *
+ * @note Without sendmmsg() or with net_batchSize 1 packets are sent right away.
+ */
+void NET_BeginSendBatch(void)
+{
+#ifdef NET_USE_MMSG
+	sendBatch.active = net_batchSize && net_batchSize->integer > 1;
+#endif
+}
+
+/**
+ * @brief Sends all queued packets and stops queueing
+ */
+void NET_FlushSendBatch(void)
+{
+#ifdef NET_USE_MMSG
+	netSendPacket_t *packet;
+	int             i, start, ret;
+
+	for (i = 0; i < sendBatch.count; i++)
+	{
+		packet = &sendBatch.packets[i];
+
+		sendBatch.iov[i].iov_base = packet->data;
+		sendBatch.iov[i].iov_len  = packet->length;
+
+		Com_Memset(&sendBatch.msgs[i], 0, sizeof(sendBatch.msgs[i]));
+		sendBatch.msgs[i].msg_hdr.msg_name    = &packet->addr;
+		sendBatch.msgs[i].msg_hdr.msg_namelen = packet->addrlen;
+		sendBatch.msgs[i].msg_hdr.msg_iov     = &sendBatch.iov[i];
+		sendBatch.msgs[i].msg_hdr.msg_iovlen  = 1;
+	}
+
+	// one call per run of packets going out through the same socket
+	for (start = 0, i = 1; i <= sendBatch.count; i++)
+	{
+		if (i < sendBatch.count && sendBatch.packets[i].socket == sendBatch.packets[start].socket)
+		{
+			continue;
+		}
+
+		while (start < i)
+		{
+			ret = sendmmsg(sendBatch.packets[start].socket, &sendBatch.msgs[start], i - start, 0);
+
+			netStats.sendCalls++;
+
+			if (ret == SOCKET_ERROR)
+			{
+				// skip the packet that failed, the ones before it were sent
+				Sys_SendPacketError(socketError, sendBatch.packets[start].type);
+				start++;
+			}
+			else
+			{
+				netStats.sendPackets += ret;
+				start                += ret;
+			}
+		}
+	}
+
+	sendBatch.count  = 0;
+	sendBatch.active = qfalse;
+#endif
+}
+
+#ifdef NET_USE_MMSG
+/**
+ * @brief Queues a packet for NET_FlushSendBatch() if batching is active
+ * @param[in] sock
+ * @param[in] length
+ * @param[in] data
+ * @param[in] addr
+ * @param[in] addrlen
+ * @param[in] type
+ * @return qfalse if the packet has to be sent right away
+ */
+static qboolean NET_QueuePacket(SOCKET sock, int length, const void *data, const struct sockaddr_storage *addr, socklen_t addrlen, netadrtype_t type)
+{
+	netSendPacket_t *packet;
+
+	if (!sendBatch.active)
+	{
+		return qfalse;
+	}
+
+	if (length > NET_SEND_PACKETLEN)
+	{
+		// keep the order of the packets
+		NET_FlushSendBatch();
+		sendBatch.active = qtrue;
+		return qfalse;
+	}
+
+	if (sendBatch.count >= MIN(net_batchSize->integer, NET_MAX_BATCH))
+	{
+		NET_FlushSendBatch();
+		sendBatch.active = qtrue;
+	}
+
+	packet          = &sendBatch.packets[sendBatch.count++];
+	packet->socket  = sock;
+	packet->type    = type;
+	packet->length  = length;
+	packet->addrlen = addrlen;
+	Com_Memcpy(&packet->addr, addr, addrlen);
+	Com_Memcpy(packet->data, data, length);
+
+	return qtrue;
+}
+#endif
+
 /**
  * @brief Sys_SendPacket
  * @param[in] length
@@ -924,37 +1274,45 @@ void Sys_SendPacket(int length, const void *data, netadr_t to)
 		*(short *)&socksBuf[8] = ((struct sockaddr_in *)&addr)->sin_port;
 		Com_Memcpy(&socksBuf[10], data, length);
 		ret = sendto(ip_socket, socksBuf, length + 10, 0, &socksRelayAddr, sizeof(socksRelayAddr));
+		netStats.sendCalls++;
 	}
 	else
 	{
+		SOCKET    sock    = INVALID_SOCKET;
+		socklen_t addrlen = 0;
+
 		if (addr.ss_family == AF_INET)
 		{
-			ret = sendto(ip_socket, data, length, 0, (struct sockaddr *) &addr, sizeof(struct sockaddr_in));
+			sock    = ip_socket;
+			addrlen = sizeof(struct sockaddr_in);
 		}
 #ifdef FEATURE_IPV6
 		else if (addr.ss_family == AF_INET6)
 		{
-			ret = sendto(ip6_socket, data, length, 0, (struct sockaddr *) &addr, sizeof(struct sockaddr_in6));
+			sock    = ip6_socket;
+			addrlen = sizeof(struct sockaddr_in6);
 		}
 #endif
-	}
-	if (ret == SOCKET_ERROR)
-	{
-		int err = socketError;
-
-		// wouldblock is silent
-		if (err == EAGAIN)
-		{
-			return;
-		}
 
-		// some PPP links do not allow broadcasts and return an error
-		if ((err == EADDRNOTAVAIL) && ((to.type == NA_BROADCAST)))
+		if (sock != INVALID_SOCKET)
 		{
-			return;
+#ifdef NET_USE_MMSG
+			if (NET_QueuePacket(sock, length, data, &addr, addrlen, to.type))
+			{
+				return;
+			}
+#endif
+			ret = sendto(sock, data, length, 0, (struct sockaddr *) &addr, addrlen);
+			netStats.sendCalls++;
 		}
-
-		Com_Printf("Sys_SendPacket: %s\n", NET_ErrorString());
+	}
+	if (ret == SOCKET_ERROR)
+	{
+		Sys_SendPacketError(socketError, to.type);
+	}
+	else
+	{
+		netStats.sendPackets++;
 	}
 }
 
@@ -1927,9 +2285,125 @@ static qboolean NET_GetCvars(void)
 
 	net_dropsim = Cvar_Get("net_dropsim", "0", CVAR_TEMP | CVAR_CHEAT);
 
+	// only used with recvmmsg() and sendmmsg(), a change takes effect without a restart
+	net_batchSize = Cvar_Get("net_batchSize", "16", CVAR_ARCHIVE_ND);
+	Cvar_CheckRange(net_batchSize, 1, NET_MAX_BATCH, qtrue);
+
+	net_syscalls = Cvar_Get("net_syscalls", "", CVAR_ROM);
+
 	return modified ? qtrue : qfalse;
 }
 
+#ifdef NET_USE_EPOLL
+/**
+ * @struct netEpoll_s
+ * @brief Sockets stay registered with the epoll instance, the timer gives
+ * the wait a microsecond resolution.
+ */
+static struct netEpoll_s
+{
+	int fd;                             ///< epoll instance, -1 until the first wait
+	int timerfd;
+	qboolean failed;                    ///< fall back to select()
+	SOCKET sockets[2];                  ///< registered ip_socket and ip6_socket
+} netEpoll = { -1, -1, qfalse, { INVALID_SOCKET, INVALID_SOCKET } };
+
+/**
+ * @brief Closes the epoll instance, it is set up again by the next wait
+ *
+ * @note Needed whenever sockets are closed, a new socket can reuse the
+ * descriptor of a closed one which epoll silently dropped.
+ */
+static void NET_EpollShutdown(void)
+{
+	if (netEpoll.timerfd != -1)
+	{
+		close(netEpoll.timerfd);
+	}
+
+	if (netEpoll.fd != -1)
+	{
+		close(netEpoll.fd);
+	}
+
+	netEpoll.fd         = -1;
+	netEpoll.timerfd    = -1;
+	netEpoll.sockets[0] = INVALID_SOCKET;
+	netEpoll.sockets[1] = INVALID_SOCKET;
+}
+
+/**
+ * @brief Creates the epoll instance and registers the current sockets
+ * @return qfalse if epoll isn't usable
+ */
+static qboolean NET_EpollSync(void)
+{
+	struct epoll_event ev;
+	SOCKET             wanted[2] = { ip_socket, INVALID_SOCKET };
+	int                i;
+
+#ifdef FEATURE_IPV6
+	wanted[1] = ip6_socket;
+#endif
+
+	if (netEpoll.failed)
+	{
+		return qfalse;
+	}
+
+	if (netEpoll.fd == -1)
+	{
+		netEpoll.fd      = epoll_create1(EPOLL_CLOEXEC);
+		netEpoll.timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+		Com_Memset(&ev, 0, sizeof(ev));
+		ev.events  = EPOLLIN;
+		ev.data.fd = netEpoll.timerfd;
+
+		if (netEpoll.fd == -1 || netEpoll.timerfd == -1 || epoll_ctl(netEpoll.fd, EPOLL_CTL_ADD, netEpoll.timerfd, &ev) == -1)
+		{
+			Com_Printf(S_COLOR_YELLOW "WARNING: NET_EpollSync: %s, using select()\n", NET_ErrorString());
+			NET_EpollShutdown();
+			netEpoll.failed = qtrue;
+			return qfalse;
+		}
+	}
+
+	for (i = 0; i < ARRAY_LEN(wanted); i++)
+	{
+		if (netEpoll.sockets[i] == wanted[i])
+		{
+			continue;
+		}
+
+		if (netEpoll.sockets[i] != INVALID_SOCKET)
+		{
+			epoll_ctl(netEpoll.fd, EPOLL_CTL_DEL, netEpoll.sockets[i], NULL);
+		}
+
+		netEpoll.sockets[i] = wanted[i];
+
+		if (wanted[i] != INVALID_SOCKET)
+		{
+			Com_Memset(&ev, 0, sizeof(ev));
+			ev.events  = EPOLLIN;
+			ev.data.fd = wanted[i];
+
+			if (epoll_ctl(netEpoll.fd, EPOLL_CTL_ADD, wanted[i], &ev) == -1)
+			{
+				Com_Printf(S_COLOR_YELLOW "WARNING: NET_EpollSync: %s, using select()\n", NET_ErrorString());
+				NET_EpollShutdown();
+				netEpoll.failed = qtrue;
+				return qfalse;
+			}
+		}
+	}
+
+	return qtrue;
+}
+
+#endif
+
 /**
  * @brief NET_Config
  * @param[in] enableNetworking
@@ -1985,6 +2459,18 @@ static void NET_Config(qboolean enableNetworking)
 
 	if (stop)
 	{
+		NET_FlushSendBatch();
+#ifdef NET_USE_EPOLL
+		NET_EpollShutdown();
+#endif
+#ifdef NET_USE_MMSG
+		NET_FreeRecvBatch(&ip_recvBatch);
+#ifdef FEATURE_IPV6
+		NET_FreeRecvBatch(&ip6_recvBatch);
+		NET_FreeRecvBatch(&multicast6_recvBatch);
+#endif
+#endif
+
 		if (ip_socket != INVALID_SOCKET)
 		{
 			closesocket(ip_socket);
@@ -2114,22 +2600,115 @@ void NET_Event(fd_set *fdr)
 	}
 }
 
+#ifdef NET_USE_EPOLL
 /**
- * @brief Sleeps msec or until something happens on the network
- * @param[in] msec
+ * @brief Waits on the sockets with epoll, a timerfd ends the wait
+ * @param[in] usec
+ * @return qfalse if epoll isn't usable
  */
-void NET_Sleep(int msec)
+static qboolean NET_EpollSleep(int64_t usec)
+{
+	struct epoll_event events[4];
+	struct itimerspec  timer;
+	fd_set             fdset;
+	qboolean           readable = qfalse;
+	uint64_t           expirations;
+	int                i, ret;
+
+	if (!NET_EpollSync())
+	{
+		return qfalse;
+	}
+
+	// a zero value disarms the timer and clears a pending expiration
+	Com_Memset(&timer, 0, sizeof(timer));
+	timer.it_value.tv_sec  = usec / 1000000;
+	timer.it_value.tv_nsec = (usec % 1000000) * 1000;
+	timerfd_settime(netEpoll.timerfd, 0, &timer, NULL);
+
+	ret = epoll_wait(netEpoll.fd, events, ARRAY_LEN(events), usec > 0 ? -1 : 0);
+
+	if (ret == SOCKET_ERROR)
+	{
+		if (socketError != EINTR)
+		{
+			Com_Printf(S_COLOR_YELLOW "WARNING: epoll_wait() syscall failed: %s\n", NET_ErrorString());
+		}
+		return qtrue;
+	}
+
+	FD_ZERO(&fdset);
+
+	for (i = 0; i < ret; i++)
+	{
+		if (events[i].data.fd == netEpoll.timerfd)
+		{
+			if (read(netEpoll.timerfd, &expirations, sizeof(expirations)) < 0)
+			{
+				// nothing to do, the next settime resets it anyway
+			}
+			continue;
+		}
+
+		FD_SET(events[i].data.fd, &fdset);
+		readable = qtrue;
+	}
+
+	if (readable)
+	{
+		NET_Event(&fdset);
+	}
+
+	return qtrue;
+}
+#endif
+
+/**
+ * @brief Publishes the socket calls and packets of the last second in net_syscalls
+ */
+static void NET_UpdateSyscallStats(void)
+{
+	int now = Sys_Milliseconds();
+
+	if (now - netStats.time < 1000)
+	{
+		return;
+	}
+
+	Cvar_Set("net_syscalls", va("recv %i calls %i packets, send %i calls %i packets",
+	                            netStats.recvCalls, netStats.recvPackets, netStats.sendCalls, netStats.sendPackets));
+
+	Com_Memset(&netStats, 0, sizeof(netStats));
+	netStats.time = now;
+}
+
+/**
+ * @brief Sleeps usec or until something happens on the network
+ * @param[in] usec
+ */
+void NET_SleepUsec(int64_t usec)
 {
 	struct timeval timeout;
 	fd_set         fdset;
 	int            retval;
 	SOCKET         highestfd = INVALID_SOCKET;
 
-	if (msec < 0)
+	if (usec < 0)
 	{
-		msec = 0;
+		usec = 0;
 	}
 
+	// packets left queued by an aborted batch, e.g. after a Com_Error()
+	NET_FlushSendBatch();
+	NET_UpdateSyscallStats();
+
+#ifdef NET_USE_EPOLL
+	if (NET_EpollSleep(usec))
+	{
+		return;
+	}
+#endif
+
 	FD_ZERO(&fdset);
 
 	if (ip_socket != INVALID_SOCKET)
@@ -2152,13 +2731,13 @@ void NET_Sleep(int msec)
 	if (highestfd == INVALID_SOCKET)
 	{
 		// windows ain't happy when select is called without valid FDs
-		SleepEx(msec, 0);
+		SleepEx((DWORD)(usec / 1000), 0);
 		return;
 	}
 #endif
 
-	timeout.tv_sec  = msec / 1000;
-	timeout.tv_usec = (msec % 1000) * 1000;
+	timeout.tv_sec  = (long)(usec / 1000000);
+	timeout.tv_usec = (long)(usec % 1000000);
 	retval          = select(highestfd + 1, &fdset, NULL, NULL, &timeout);
 
 	if (retval == SOCKET_ERROR)
@@ -2171,6 +2750,15 @@ void NET_Sleep(int msec)
 	}
 }
 
+/**
+ * @brief Sleeps msec or until something happens on the network
+ * @param[in] msec
+ */
+void NET_Sleep(int msec)
+{
+	NET_SleepUsec((int64_t)msec * 1000);
+}
+
 /**
  * @brief NET_Restart_f
  */
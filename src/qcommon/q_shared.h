@@ -1071,6 +1071,35 @@ typedef struct
 	char string[MAX_CVAR_VALUE_STRING];
 } vmCvar_t;
 
+#define MAX_CVAR_CHANGES        64      ///< changed cvars the modules take per trap_Cvar_Changes() call
+
+/**
+ * @brief Checks a module cvar against the handles listed by trap_Cvar_Changes()
+ * @param[in] vmCvar
+ * @param[in] changes
+ * @param[in] numChanges -1 if every cvar has to be updated
+ * @return
+ */
+static ID_INLINE qboolean Q_CvarChanged(const vmCvar_t *vmCvar, const int *changes, int numChanges)
+{
+	int i;
+
+	if (numChanges < 0)
+	{
+		return qtrue;
+	}
+
+	for (i = 0; i < numChanges; i++)
+	{
+		if (changes[i] == vmCvar->handle)
+		{
+			return qtrue;
+		}
+	}
+
+	return qfalse;
+}
+
 /*
 ==============================================================
 COLLISION DETECTION
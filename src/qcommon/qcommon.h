@@ -80,6 +80,7 @@ struct entityState_s;
 struct playerState_s;
 
 void MSG_WriteBits(msg_t *msg, int value, int bits);
+void MSG_WriteHuffmanBits(msg_t *msg, const byte *data, int bits);
 
 void MSG_WriteChar(msg_t *msg, int c);
 void MSG_WriteByte(msg_t *msg, int c);
@@ -121,6 +122,7 @@ void MSG_WriteDeltaPlayerstate(msg_t *msg, struct playerState_s *from, struct pl
 void MSG_ReadDeltaPlayerstate(msg_t *msg, struct playerState_s *from, struct playerState_s *to);
 
 void MSG_ReportChangeVectors_f(void);
+void MSG_HuffmanBench_f(void);
 
 void MSG_ETTV_WriteDeltaSharedEntity(msg_t *msg, void *from, void *to, qboolean force);
 //void MSG_ETTV_ReadDeltaSharedEntity(msg_t *msg, void *from, void *to);
@@ -234,6 +236,9 @@ const char *NET_AdrToStringNoPort(netadr_t a);
 int NET_StringToAdr(const char *s, netadr_t *a, netadrtype_t family);
 qboolean NET_GetLoopPacket(netsrc_t sock, netadr_t *net_from, msg_t *net_message);
 void NET_Sleep(int msec);
+void NET_SleepUsec(int64_t usec);
+void NET_BeginSendBatch(void);
+void NET_FlushSendBatch(void);
 
 /**
  * @def MAX_MSGLEN
@@ -666,6 +671,9 @@ void Cvar_Register(vmCvar_t *vmCvar, const char *varName, const char *defaultVal
 void Cvar_Update(vmCvar_t *vmCvar);
 // updates an interpreted modules' version of a cvar
 
+int Cvar_Changes(int *sequence, int *handles, int maxHandles);
+// lists the cvars of the interpreted modules changed since the last call
+
 void Cvar_Set(const char *varName, const char *value);
 // will create the variable with no flags if it doesn't exist
 
@@ -1171,6 +1179,17 @@ void Com_Frame(void);
 void Com_CheckDefaultProfileDatExists(void);
 void Com_Shutdown(qboolean badProfile);
 
+// threads.c - worker pool for independent per-frame jobs
+
+#define MAX_JOB_THREADS 16
+
+typedef void (*jobFunc_t)(void *data, int index, int thread);
+
+void Com_InitJobs(int numThreads);
+void Com_ShutdownJobs(void);
+int Com_JobThreads(void);
+void Com_RunJobs(jobFunc_t func, void *data, int count);
+
 /*
 ==============================================================
 CLIENT / SERVER SYSTEMS
@@ -1370,6 +1389,8 @@ void Sys_Print(const char *msg);
 // Sys_Milliseconds should only be used for profiling purposes,
 // any game related timing information should come from event timestamps
 int Sys_Milliseconds(void);
+// same clock as Sys_Milliseconds, Sys_Microseconds() / 1000 == Sys_Milliseconds()
+int64_t Sys_Microseconds(void);
 
 int Sys_PID(void);
 qboolean Sys_WritePIDFile(void);
@@ -1540,6 +1561,19 @@ typedef struct
 	huff_t decompressor;
 } huffman_t;
 
+#define HUFF_DECODE_BITS 11         ///< bits decoded per table lookup, longer codes walk the tree
+
+/**
+ * @struct huffTable_t
+ * @brief Lookup tables of a static tree, see Huff_InitTable
+ */
+typedef struct
+{
+	uint32_t code[HMAX + 1];        ///< code of each symbol, first bit sent is bit 0
+	byte length[HMAX + 1];          ///< 0 if the symbol has to be sent by a tree walk
+	uint16_t decode[1 << HUFF_DECODE_BITS];  ///< symbol | code length << 9, 0 if the code is longer
+} huffTable_t;
+
 void Huff_Compress(msg_t *mbuf, int offset);
 void Huff_Decompress(msg_t *mbuf, int offset);
 void Huff_Init(huffman_t *huff);
@@ -1550,6 +1584,9 @@ void Huff_offsetReceive(node_t *node, int *ch, byte *fin, int *offset, int maxof
 void Huff_offsetTransmit(huff_t *huff, int ch, byte *fout, int *offset, int maxoffset);
 void Huff_putBit(int bit, byte *fout, int *offset);
 int Huff_getBit(byte *fin, int *offset);
+void Huff_InitTable(huffTable_t *table, const huff_t *encoder, const huff_t *decoder);
+void Huff_tableTransmit(const huffTable_t *table, huff_t *huff, int ch, byte *fout, int *offset, int maxoffset);
+void Huff_tableReceive(const huffTable_t *table, node_t *node, int *ch, byte *fin, int *offset, int maxoffset);
 
 extern huffman_t clientHuffTables;
 
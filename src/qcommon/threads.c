@@ -0,0 +1,364 @@
+/*
+ * ET: Legacy
+ * Copyright (C) 2012-2024 ET:Legacy team <mail@etlegacy.com>
+ *
+ * This file is part of ET: Legacy - http://www.etlegacy.com
+ *
+ * ET: Legacy is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ET: Legacy is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ET: Legacy. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file threads.c
+ * @brief Small worker pool used to spread independent per-frame jobs
+ *        (e.g. client snapshots) over several cores.
+ *
+ * The calling thread always takes part in the work as thread 0, so a pool
+ * without any worker threads simply runs every job in place.
+ *
+ * Jobs must not touch the VM, the console or anything else that is not
+ * thread safe - Com_Printf() and Com_Error() included.
+ */
+
+#include "q_shared.h"
+#include "qcommon.h"
+
+#ifdef _WIN32
+#   include <windows.h>
+typedef CRITICAL_SECTION jobMutex_t;
+typedef CONDITION_VARIABLE jobCond_t;
+typedef HANDLE jobThread_t;
+#else
+#   include <pthread.h>
+typedef pthread_mutex_t jobMutex_t;
+typedef pthread_cond_t jobCond_t;
+typedef pthread_t jobThread_t;
+#endif
+
+/**
+ * @struct jobPool_s
+ * @brief
+ */
+static struct jobPool_s
+{
+	qboolean initialized;
+	int numThreads;                     ///< worker threads, the calling thread is not counted
+	jobThread_t threads[MAX_JOB_THREADS];
+
+	jobMutex_t lock;
+	jobCond_t wake;                     ///< signalled when a new batch is posted
+	jobCond_t done;                     ///< signalled when the last job of a batch finished
+
+	jobFunc_t func;
+	void *data;
+	int count;
+	int next;                           ///< next job index to hand out
+	int pending;                        ///< jobs of the current batch not yet finished
+	int batch;                          ///< incremented for each posted batch
+	qboolean quit;
+} jobs;
+
+#ifdef _WIN32
+
+/****** THREAD HANDLING - WINDOWS VARIANT ******/
+
+#define Job_Lock()       EnterCriticalSection(&jobs.lock)
+#define Job_Unlock()     LeaveCriticalSection(&jobs.lock)
+#define Job_Wait(c)      SleepConditionVariableCS(c, &jobs.lock, INFINITE)
+#define Job_Signal(c)    WakeConditionVariable(c)
+#define Job_Broadcast(c) WakeAllConditionVariable(c)
+
+static void Job_WorkerLoop(int thread);
+
+/**
+ * @brief Job_SystemThreadProc
+ * @param[in] param
+ * @return
+ */
+static DWORD WINAPI Job_SystemThreadProc(LPVOID param)
+{
+	Job_WorkerLoop((int)(intptr_t)param);
+	return 0;
+}
+
+/**
+ * @brief Job_InitPrimitives
+ */
+static void Job_InitPrimitives(void)
+{
+	InitializeCriticalSection(&jobs.lock);
+	InitializeConditionVariable(&jobs.wake);
+	InitializeConditionVariable(&jobs.done);
+}
+
+/**
+ * @brief Job_DestroyPrimitives
+ */
+static void Job_DestroyPrimitives(void)
+{
+	DeleteCriticalSection(&jobs.lock);
+}
+
+/**
+ * @brief Job_StartThread
+ * @param[in] thread
+ * @return
+ */
+static qboolean Job_StartThread(int thread)
+{
+	jobs.threads[thread - 1] = CreateThread(NULL, 0, Job_SystemThreadProc, (LPVOID)(intptr_t)thread, 0, NULL);
+	return jobs.threads[thread - 1] != NULL;
+}
+
+/**
+ * @brief Job_JoinThread
+ * @param[in] thread
+ */
+static void Job_JoinThread(int thread)
+{
+	WaitForSingleObject(jobs.threads[thread - 1], INFINITE);
+	CloseHandle(jobs.threads[thread - 1]);
+}
+
+#else // defined __linux__ || defined __APPLE__ || defined __FreeBSD__
+
+/****** THREAD HANDLING - UNIX VARIANT ******/
+
+#define Job_Lock()       pthread_mutex_lock(&jobs.lock)
+#define Job_Unlock()     pthread_mutex_unlock(&jobs.lock)
+#define Job_Wait(c)      pthread_cond_wait(c, &jobs.lock)
+#define Job_Signal(c)    pthread_cond_signal(c)
+#define Job_Broadcast(c) pthread_cond_broadcast(c)
+
+static void Job_WorkerLoop(int thread);
+
+/**
+ * @brief Job_SystemThreadProc
+ * @param[in] param
+ * @return
+ */
+static void *Job_SystemThreadProc(void *param)
+{
+	Job_WorkerLoop((int)(intptr_t)param);
+	return NULL;
+}
+
+/**
+ * @brief Job_InitPrimitives
+ */
+static void Job_InitPrimitives(void)
+{
+	pthread_mutex_init(&jobs.lock, NULL);
+	pthread_cond_init(&jobs.wake, NULL);
+	pthread_cond_init(&jobs.done, NULL);
+}
+
+/**
+ * @brief Job_DestroyPrimitives
+ */
+static void Job_DestroyPrimitives(void)
+{
+	pthread_cond_destroy(&jobs.done);
+	pthread_cond_destroy(&jobs.wake);
+	pthread_mutex_destroy(&jobs.lock);
+}
+
+/**
+ * @brief Job_StartThread
+ * @param[in] thread
+ * @return
+ */
+static qboolean Job_StartThread(int thread)
+{
+	return pthread_create(&jobs.threads[thread - 1], NULL, Job_SystemThreadProc, (void *)(intptr_t)thread) == 0;
+}
+
+/**
+ * @brief Job_JoinThread
+ * @param[in] thread
+ */
+static void Job_JoinThread(int thread)
+{
+	pthread_join(jobs.threads[thread - 1], NULL);
+}
+
+#endif
+
+/**
+ * @brief Takes jobs of the current batch until none are left.
+ * @param[in] thread
+ *
+ * @note Must be called with the pool locked, returns with the pool locked.
+ */
+static void Job_Drain(int thread)
+{
+	while (jobs.next < jobs.count)
+	{
+		int index = jobs.next++;
+
+		Job_Unlock();
+		jobs.func(jobs.data, index, thread);
+		Job_Lock();
+
+		if (--jobs.pending == 0)
+		{
+			Job_Signal(&jobs.done);
+		}
+	}
+}
+
+/**
+ * @brief Job_WorkerLoop
+ * @param[in] thread
+ */
+static void Job_WorkerLoop(int thread)
+{
+	int batch = 0;
+
+	Job_Lock();
+	while (1)
+	{
+		while (!jobs.quit && batch == jobs.batch)
+		{
+			Job_Wait(&jobs.wake);
+		}
+
+		if (jobs.quit)
+		{
+			break;
+		}
+
+		batch = jobs.batch;
+		Job_Drain(thread);
+	}
+	Job_Unlock();
+}
+
+/**
+ * @brief Stops all worker threads. Jobs posted afterwards run on the calling thread.
+ */
+void Com_ShutdownJobs(void)
+{
+	int i;
+
+	if (!jobs.initialized)
+	{
+		return;
+	}
+
+	Job_Lock();
+	jobs.quit = qtrue;
+	Job_Broadcast(&jobs.wake);
+	Job_Unlock();
+
+	for (i = 1; i <= jobs.numThreads; i++)
+	{
+		Job_JoinThread(i);
+	}
+
+	Job_DestroyPrimitives();
+	Com_Memset(&jobs, 0, sizeof(jobs));
+}
+
+/**
+ * @brief (Re)starts the pool so that jobs are spread over the given number of threads.
+ * @param[in] numThreads Total number of threads including the calling one,
+ *                       values below 2 disable the worker threads.
+ */
+void Com_InitJobs(int numThreads)
+{
+	int i;
+
+	numThreads = MAX(1, MIN(numThreads, MAX_JOB_THREADS)) - 1;
+
+	if (jobs.initialized && jobs.numThreads == numThreads)
+	{
+		return;
+	}
+
+	Com_ShutdownJobs();
+
+	if (!numThreads)
+	{
+		return;
+	}
+
+	Job_InitPrimitives();
+	jobs.initialized = qtrue;
+
+	for (i = 1; i <= numThreads; i++)
+	{
+		if (!Job_StartThread(i))
+		{
+			Com_Printf(S_COLOR_YELLOW "WARNING: Com_InitJobs: could only start %i of %i worker threads\n", i - 1, numThreads);
+			break;
+		}
+		jobs.numThreads = i;
+	}
+}
+
+/**
+ * @brief Com_JobThreads
+ * @return The number of threads jobs are spread over, including the calling one
+ */
+int Com_JobThreads(void)
+{
+	return jobs.numThreads + 1;
+}
+
+/**
+ * @brief Runs func(data, index, thread) for every index in [0, count) and returns once all of them finished.
+ * @param[in] func
+ * @param[in] data
+ * @param[in] count
+ *
+ * @note thread is in [0, Com_JobThreads()) and can be used to pick per thread scratch data,
+ *       the calling thread always is thread 0.
+ */
+void Com_RunJobs(jobFunc_t func, void *data, int count)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	if (!jobs.numThreads || count == 1)
+	{
+		int i;
+
+		for (i = 0; i < count; i++)
+		{
+			func(data, i, 0);
+		}
+		return;
+	}
+
+	Job_Lock();
+	jobs.func    = func;
+	jobs.data    = data;
+	jobs.count   = count;
+	jobs.next    = 0;
+	jobs.pending = count;
+	jobs.batch++;
+	Job_Broadcast(&jobs.wake);
+
+	Job_Drain(0);
+
+	while (jobs.pending)
+	{
+		Job_Wait(&jobs.done);
+	}
+
+	jobs.func = NULL;
+	jobs.data = NULL;
+	Job_Unlock();
+}
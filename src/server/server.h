@@ -67,8 +67,10 @@
  */
 typedef struct svEntity_s
 {
-	struct worldSector_s *worldSector;
-	struct svEntity_s *nextEntityInWorldSector;
+	struct worldCell_s *worldCell;      ///< NULL if not linked
+	int worldLevel;                     ///< grid level of worldCell
+	struct svEntity_s *nextEntityInWorldCell;
+	struct svEntity_s *prevEntityInWorldCell;
 
 	entityState_t baseline;             ///< for delta compression of initial sighting
 	entityShared_t baselineShared;
@@ -76,10 +78,24 @@ typedef struct svEntity_s
 	int clusternums[MAX_ENT_CLUSTERS];
 	int lastCluster;                    ///< if all the clusters don't fit in clusternums
 	int areanum, areanum2;
-	int snapshotCounter;                ///< used to prevent double adding from portal views
 	int originCluster;                  ///< calced upon linking, for origin only bmodel vis checks
+
+	// clusters and areas the entity is currently set in, see SV_UpdateEntityVisibility
+	qboolean visIndexed;
+	int visNumClusters;
+	int visClusternums[MAX_ENT_CLUSTERS];
+	int visAreanum, visAreanum2;
 } svEntity_t;
 
+/**
+ * @struct entityBits_t
+ * @brief One bit per entity number
+ */
+typedef struct
+{
+	uint32_t bits[MAX_GENTITIES / 32];
+} entityBits_t;
+
 /**
  * @enum serverState_t
  */
@@ -104,6 +120,17 @@ typedef struct
 	/// the serverId associated with the current checksumFeed (always <= serverId)
 	int checksumFeedServerId;
 	int snapshotCounter;                ///< incremented for each snapshot built
+	/// per snapshot building thread: snapshotCounter an entity was last added to, prevents double adding from portal views
+	int snapshotMarks[MAX_JOB_THREADS][MAX_GENTITIES];
+
+	// linked entities by cluster and area for snapshot PVS culling, see SV_UpdateEntityVisibility
+	int numVisClusters;
+	entityBits_t *clusterEntities;      ///< [numVisClusters] on the hunk
+	byte *clusterOccupied;              ///< [numVisClusters] on the hunk
+	int *occupiedClusters;              ///< [numVisClusters] on the hunk, clusters with at least one entity
+	int numOccupiedClusters;
+	entityBits_t areaEntities[MAX_MAP_AREAS + 1]; ///< last one collects entities without area
+	entityBits_t entityVisibilityDirty; ///< entities linked since the last update
 	int timeResidual;                   ///< <= 1000 / sv_frame->value
 	int nextFrameTime;                  ///< when time > nextFrameTime, process world
 	char *configstrings[MAX_CONFIGSTRINGS];
@@ -448,6 +475,8 @@ extern cvar_t *sv_floodProtect;
 extern cvar_t *sv_userInfoFloodProtect;
 extern cvar_t *sv_lanForceRate;
 extern cvar_t *sv_onlyVisibleClients;
+extern cvar_t *sv_snapshotThreads;
+extern cvar_t *sv_deltaCache;
 
 extern cvar_t *sv_showAverageBPS;           ///< net debugging
 
@@ -480,6 +509,7 @@ extern cvar_t *sv_wh_active;
 extern cvar_t *sv_wh_bbox_horz;
 extern cvar_t *sv_wh_bbox_vert;
 extern cvar_t *sv_wh_check_fov;
+extern cvar_t *sv_wh_cache;
 #endif
 
 // server side demo recording
@@ -602,6 +632,14 @@ void SV_SendClientMessages(void);
 void SV_SendClientSnapshot(client_t *client);
 void SV_CheckClientUserinfoTimer(void);
 void SV_SendClientIdle(client_t *client);
+void SV_SnapshotBench_f(void);
+
+// sv_deltacache.c
+void SV_DeltaCacheBeginFrame(void);
+void SV_DeltaCacheShutdown(void);
+void SV_DeltaCacheWriteEntity(msg_t *msg, entityState_t *from, entityState_t *to, qboolean force, int thread);
+void SV_DeltaCacheCounters(int *hits, int *misses, int *full);
+void SV_DeltaCacheStats_f(void);
 
 // sv_game.c
 int SV_NumForGentity(sharedEntity_t *ent);
@@ -633,6 +671,8 @@ void SV_InitWallhack(void);
 void SV_RestorePos(int cli);
 int SV_CanSee(int player, int other);
 int SV_PositionChanged(int cli);
+void SV_PrepareWallhack(const int *clients, int numClients);
+void SV_WallhackStats_f(void);
 #endif
 
 //============================================================
@@ -656,6 +696,7 @@ void SV_LinkEntity(sharedEntity_t *gEnt);
 clipHandle_t SV_ClipHandleForEntity(const sharedEntity_t *ent);
 
 void SV_SectorList_f(void);
+void SV_AreaBench_f(void);
 
 int SV_AreaEntities(const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount);
 // fills in a table of entity numbers with entities that have bounding boxes
@@ -720,7 +720,13 @@ void SV_AddOperatorCommands(void)
 	Cmd_AddCommand("dumpuser", SV_DumpUser_f, "Dumps user info to disk.");
 	Cmd_AddCommand("map_restart", SV_MapRestart_f, "Restarts given map.");
 	Cmd_AddCommand("fieldinfo", SV_FieldInfo_f, "Prints field info.");
-	Cmd_AddCommand("sectorlist", SV_SectorList_f, "Prints sector list.");
+	Cmd_AddCommand("sectorlist", SV_SectorList_f, "Prints how the linked entities are spread over the world grid.");
+	Cmd_AddCommand("areabench", SV_AreaBench_f, "Records area queries and replays them against the world grid and the old sector tree. Usage: areabench record [queries] | areabench [iterations]");
+	Cmd_AddCommand("snapshotbench", SV_SnapshotBench_f, "Measures snapshot building and encoding time per frame for 1 to N threads. Bots only. Usage: snapshotbench [frames] [threads]");
+	Cmd_AddCommand("deltacachestats", SV_DeltaCacheStats_f, "Prints the hits and misses of the shared entity delta cache. Usage: deltacachestats [reset]");
+#ifdef FEATURE_ANTICHEAT
+	Cmd_AddCommand("wallhackstats", SV_WallhackStats_f, "Prints the visibility traces per frame of the anti-wallhack. Usage: wallhackstats [reset]");
+#endif
 	Cmd_AddCommand("gameCompleteStatus", SV_GameCompleteStatus_f, "Sends a game complete status message to all master servers.");
 	Cmd_AddCommand("map", SV_Map_f, "Loads a specific map.", SV_CompleteMapName);
 	Cmd_AddCommand("devmap", SV_Map_f, "Loads a specific map in developer mode.", SV_CompleteMapName);
@@ -758,6 +764,10 @@ void SV_RemoveOperatorCommands(void)
 	Cmd_RemoveCommand("dumpuser");
 	Cmd_RemoveCommand("map_restart");
 	Cmd_RemoveCommand("sectorlist");
+	Cmd_RemoveCommand("areabench");
+	Cmd_RemoveCommand("snapshotbench");
+	Cmd_RemoveCommand("deltacachestats");
+	Cmd_RemoveCommand("wallhackstats");
 	Cmd_RemoveCommand("say");
 #endif
 }
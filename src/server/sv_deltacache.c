@@ -0,0 +1,276 @@
+/*
+ * ET: Legacy
+ * Copyright (C) 2012-2024 ET:Legacy team <mail@etlegacy.com>
+ *
+ * This file is part of ET: Legacy - http://www.etlegacy.com
+ *
+ * ET: Legacy is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ET: Legacy is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ET: Legacy. If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file sv_deltacache.c
+ * @brief Shares encoded entity deltas between the snapshots of one frame
+ *
+ * Most clients delta an entity from the same previous state, so the Huffman
+ * coded output of MSG_WriteDeltaEntity() is the same for all of them. The
+ * first client pays for the encoding, the others get the coded bits spliced
+ * into their message.
+ *
+ * Entries are keyed by the full from and to states, a hit is therefore always
+ * bit identical to a fresh encoding. Every snapshot thread has a cache of its
+ * own so no locking is needed.
+ */
+
+#include "server.h"
+
+#define DELTA_CACHE_SIZE    0x80000     ///< bytes of records per thread and frame
+#define DELTA_CACHE_MAXBITS 0x2000      ///< deltas coding to more bits are not cached
+
+/**
+ * @struct deltaCacheRecord_t
+ * @brief An encoded delta, followed by (bits + 7) / 8 bytes of coded data
+ */
+typedef struct
+{
+	int next;                           ///< offset of the next record of the entity, -1 ends the chain
+	qboolean force;
+	int bits;                           ///< coded size
+	int uncompBits;                     ///< size before Huffman coding, for the net debugging stats
+	entityState_t from;
+	entityState_t to;
+} deltaCacheRecord_t;
+
+/**
+ * @struct deltaCache_t
+ * @brief The records of one snapshot thread
+ */
+typedef struct
+{
+	int frame;                          ///< svDeltaCacheFrame the records were written in
+	int used;                           ///< bytes of data in use
+	int head[MAX_GENTITIES];            ///< first record of each entity, only valid if headFrame matches
+	int headFrame[MAX_GENTITIES];
+
+	int hits;
+	int misses;
+	int full;                           ///< deltas not cached because the buffer was full
+
+	byte scratch[DELTA_CACHE_MAXBITS / 8];
+	byte data[DELTA_CACHE_SIZE];
+} deltaCache_t;
+
+static deltaCache_t *svDeltaCaches[MAX_JOB_THREADS];
+static int          svDeltaCacheFrame;
+
+/**
+ * @brief Starts a new snapshot frame, records of older frames are dropped.
+ * Allocates the caches of newly started snapshot threads.
+ *
+ * @note Must be called on the main thread before the snapshots are encoded.
+ */
+void SV_DeltaCacheBeginFrame(void)
+{
+	int i;
+
+	svDeltaCacheFrame++;
+
+	if (!sv_deltaCache->integer)
+	{
+		return;
+	}
+
+	for (i = 0; i < Com_JobThreads(); i++)
+	{
+		if (!svDeltaCaches[i])
+		{
+			svDeltaCaches[i] = Com_Allocate(sizeof(deltaCache_t));
+			if (!svDeltaCaches[i])
+			{
+				Com_Error(ERR_FATAL, "SV_DeltaCacheBeginFrame: failed to allocate %i bytes", (int)sizeof(deltaCache_t));
+			}
+
+			Com_Memset(svDeltaCaches[i], 0, sizeof(deltaCache_t));
+		}
+	}
+}
+
+/**
+ * @brief Frees the caches of all threads
+ */
+void SV_DeltaCacheShutdown(void)
+{
+	int i;
+
+	for (i = 0; i < MAX_JOB_THREADS; i++)
+	{
+		if (svDeltaCaches[i])
+		{
+			Com_Dealloc(svDeltaCaches[i]);
+			svDeltaCaches[i] = NULL;
+		}
+	}
+}
+
+/**
+ * @brief Writes the same bits as MSG_WriteDeltaEntity() for a non NULL to,
+ * reusing the encoding of an identical delta this thread wrote before in
+ * this frame.
+ *
+ * @param[in,out] msg
+ * @param[in] from
+ * @param[in] to
+ * @param[in] force
+ * @param[in] thread Snapshot thread the call is made from
+ */
+void SV_DeltaCacheWriteEntity(msg_t *msg, entityState_t *from, entityState_t *to, qboolean force, int thread)
+{
+	deltaCache_t       *cache = svDeltaCaches[thread];
+	deltaCacheRecord_t *rec;
+	msg_t              scratch;
+	int                num = to->number, offset, size;
+
+	// unchanged entities don't write anything, no need to encode or look them up
+	if (!force && !memcmp(from, to, sizeof(*to)))
+	{
+		return;
+	}
+
+	if (!cache || !sv_deltaCache->integer || num < 0 || num >= MAX_GENTITIES)
+	{
+		MSG_WriteDeltaEntity(msg, from, to, force);
+		return;
+	}
+
+	if (cache->frame != svDeltaCacheFrame)
+	{
+		cache->frame = svDeltaCacheFrame;
+		cache->used  = 0;
+	}
+
+	if (cache->headFrame[num] == svDeltaCacheFrame)
+	{
+		for (offset = cache->head[num]; offset >= 0; offset = rec->next)
+		{
+			rec = (deltaCacheRecord_t *)(cache->data + offset);
+
+			if (rec->force == force && !memcmp(&rec->to, to, sizeof(*to)) && !memcmp(&rec->from, from, sizeof(*from)))
+			{
+				cache->hits++;
+
+				msg->uncompsize += rec->uncompBits; // net debugging
+				MSG_WriteHuffmanBits(msg, (byte *)(rec + 1), rec->bits);
+				return;
+			}
+		}
+	}
+	else
+	{
+		cache->headFrame[num] = svDeltaCacheFrame;
+		cache->head[num]      = -1;
+	}
+
+	cache->misses++;
+
+	MSG_Init(&scratch, cache->scratch, sizeof(cache->scratch));
+	MSG_WriteDeltaEntity(&scratch, from, to, force);
+
+	if (scratch.overflowed)
+	{
+		// too big to be worth it, encode it in place
+		MSG_WriteDeltaEntity(msg, from, to, force);
+		return;
+	}
+
+	MSG_WriteHuffmanBits(msg, scratch.data, scratch.bit);
+	msg->uncompsize += scratch.uncompsize; // net debugging
+
+	size = PAD(sizeof(deltaCacheRecord_t) + ((scratch.bit + 7) >> 3), sizeof(int));
+
+	if (cache->used + size > DELTA_CACHE_SIZE)
+	{
+		cache->full++;
+		return;
+	}
+
+	rec             = (deltaCacheRecord_t *)(cache->data + cache->used);
+	rec->next       = cache->head[num];
+	rec->force      = force;
+	rec->bits       = scratch.bit;
+	rec->uncompBits = scratch.uncompsize;
+	rec->from       = *from;
+	rec->to         = *to;
+	Com_Memcpy(rec + 1, scratch.data, (scratch.bit + 7) >> 3);
+
+	cache->head[num] = cache->used;
+	cache->used     += size;
+}
+
+/**
+ * @brief Sums up the counters of all threads
+ * @param[out] hits
+ * @param[out] misses
+ * @param[out] full
+ */
+void SV_DeltaCacheCounters(int *hits, int *misses, int *full)
+{
+	int i;
+
+	*hits   = 0;
+	*misses = 0;
+	*full   = 0;
+
+	for (i = 0; i < MAX_JOB_THREADS; i++)
+	{
+		if (svDeltaCaches[i])
+		{
+			*hits   += svDeltaCaches[i]->hits;
+			*misses += svDeltaCaches[i]->misses;
+			*full   += svDeltaCaches[i]->full;
+		}
+	}
+}
+
+/**
+ * @brief Prints the delta cache counters, "deltacachestats reset" clears them
+ */
+void SV_DeltaCacheStats_f(void)
+{
+	int hits, misses, full, i;
+
+	if (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "reset"))
+	{
+		for (i = 0; i < MAX_JOB_THREADS; i++)
+		{
+			if (svDeltaCaches[i])
+			{
+				svDeltaCaches[i]->hits   = 0;
+				svDeltaCaches[i]->misses = 0;
+				svDeltaCaches[i]->full   = 0;
+			}
+		}
+		return;
+	}
+
+	if (!sv_deltaCache->integer)
+	{
+		Com_Printf("Delta cache is disabled (sv_deltaCache 0).\n");
+	}
+
+	SV_DeltaCacheCounters(&hits, &misses, &full);
+
+	Com_Printf("Entity delta cache:\n");
+	Com_Printf("hits    : %i\n", hits);
+	Com_Printf("misses  : %i\n", misses);
+	Com_Printf("uncached: %i (buffer full)\n", full);
+	Com_Printf("hit rate: %.1f%%\n", (hits + misses) ? 100.0 * hits / (hits + misses) : 0.0);
+}
@@ -47,8 +47,9 @@ botlib_export_t *botlib_export;
 
 static ext_trap_keys_t g_extensionTraps[] =
 {
-	{ "trap_DemoSupport_Legacy", G_DEMOSUPPORT, qfalse },
-	{ NULL,                      -1,            qfalse }
+	{ "trap_DemoSupport_Legacy", G_DEMOSUPPORT,  qfalse },
+	{ "trap_CvarChanges_Legacy", G_CVAR_CHANGES, qfalse },
+	{ NULL,                      -1,             qfalse }
 };
 
 /**
@@ -692,6 +693,9 @@ intptr_t SV_GameSystemCalls(intptr_t *args)
 		SV_DemoSupport(VMA(1));
 		return 0;
 
+	case G_CVAR_CHANGES:
+		return Cvar_Changes(VMA(1), VMA(2), args[3]);
+
 	case G_TRAP_GETVALUE:
 		return VM_Ext_GetValue(VMA(1), args[2], VMA(3));
 
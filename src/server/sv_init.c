@@ -1112,6 +1112,9 @@ void SV_Init(void)
 
 	sv_wh_check_fov = Cvar_Get("wh_check_fov", "0", CVAR_ARCHIVE);
 
+	// how long (msec) a visibility result is reused while neither player moved noticeably, 0 = one frame
+	sv_wh_cache = Cvar_Get("wh_cache", "100", CVAR_ARCHIVE);
+
 	SV_InitWallhack();
 #endif
 
@@ -1144,6 +1147,11 @@ void SV_Init(void)
 
 	sv_onlyVisibleClients = Cvar_Get("sv_onlyVisibleClients", "0", 0);
 
+	sv_snapshotThreads = Cvar_GetAndDescribe("sv_snapshotThreads", "0", CVAR_ARCHIVE_ND, "Number of threads building and encoding client snapshots, 0 and 1 build them on the main thread.");
+	Cvar_CheckRange(sv_snapshotThreads, 0, MAX_JOB_THREADS, qtrue);
+	sv_deltaCache = Cvar_GetAndDescribe("sv_deltaCache", "1", CVAR_ARCHIVE_ND, "Encode identical entity deltas of a frame once and share them between client snapshots.");
+	Cvar_CheckRange(sv_deltaCache, 0, 1, qtrue);
+
 	sv_showAverageBPS = Cvar_Get("sv_showAverageBPS", "0", 0); // net debugging
 
 	// create user set cvars
@@ -1292,6 +1300,11 @@ void SV_Shutdown(const char *finalmsg)
 
 	// SV_ShutdownGameProgs calls SV_DemoStopAll();
 
+	// stop the snapshot threads, restarted by the first snapshot of the next server
+	Com_ShutdownJobs();
+	sv_snapshotThreads->modified = qtrue;
+	SV_DeltaCacheShutdown();
+
 	// free current level
 	SV_ClearServer();
 
@@ -72,6 +72,8 @@ cvar_t *sv_floodProtect;
 cvar_t *sv_userInfoFloodProtect;
 cvar_t *sv_lanForceRate;        // dedicated 1 (LAN) server forces local client rates to 99999 (bug #491)
 cvar_t *sv_onlyVisibleClients;
+cvar_t *sv_snapshotThreads;     // number of threads building and encoding client snapshots
+cvar_t *sv_deltaCache;          // share encoded entity deltas between client snapshots
 cvar_t *sv_friendlyFire;
 cvar_t *sv_maxlives;
 cvar_t *sv_needpass;
@@ -113,6 +115,7 @@ cvar_t *sv_wh_active;
 cvar_t *sv_wh_bbox_horz;
 cvar_t *sv_wh_bbox_vert;
 cvar_t *sv_wh_check_fov;
+cvar_t *sv_wh_cache;
 #endif
 
 cvar_t *sv_demopath;
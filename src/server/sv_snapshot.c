@@ -34,6 +34,10 @@
 
 #include "server.h"
 
+#ifdef ETL_SSE
+#include <immintrin.h>
+#endif
+
 /*
 =============================================================================
 
@@ -61,8 +65,9 @@ A normal server packet will look like:
  * @param[in] from
  * @param[in] to
  * @param[in] msg
+ * @param[in] thread
  */
-static void SV_EmitPacketEntities(client_t *client, clientSnapshot_t *from, clientSnapshot_t *to, msg_t *msg)
+static void SV_EmitPacketEntities(client_t *client, clientSnapshot_t *from, clientSnapshot_t *to, msg_t *msg, int thread)
 {
 	entityState_t  *oldent = NULL, *newent = NULL;
 	entityShared_t *oldSharedent = NULL, *newSharedent = NULL;
@@ -112,7 +117,7 @@ static void SV_EmitPacketEntities(client_t *client, clientSnapshot_t *from, clie
 			// delta update from old position
 			// because the force parm is qfalse, this will not result
 			// in any bytes being emited if the entity has not changed at all
-			MSG_WriteDeltaEntity(msg, oldent, newent, qfalse);
+			SV_DeltaCacheWriteEntity(msg, oldent, newent, qfalse, thread);
 			if (client->ettvClient && messageSize != msg->cursize)
 			{
 				MSG_ETTV_WriteDeltaSharedEntity(msg, oldSharedent, newSharedent, qtrue);
@@ -131,7 +136,7 @@ static void SV_EmitPacketEntities(client_t *client, clientSnapshot_t *from, clie
 			}
 
 			// this is a new entity, send it from the baseline
-			MSG_WriteDeltaEntity(msg, &sv.svEntities[newnum].baseline, newent, qtrue);
+			SV_DeltaCacheWriteEntity(msg, &sv.svEntities[newnum].baseline, newent, qtrue, thread);
 			if (client->ettvClient)
 			{
 				MSG_ETTV_WriteDeltaSharedEntity(msg, &sv.svEntities[newnum].baselineShared, newSharedent, qtrue);
@@ -211,48 +216,68 @@ static void SV_ETTV_EmitPlayerstates(client_t *client, msg_t *msg)
 }
 
 /**
- * @brief SV_WriteSnapshotToClient
+ * @brief Picks the previous frame the new snapshot of the client is delta compressed against.
  * @param[in] client
- * @param[in] msg
+ * @param[out] oldframe NULL if a full snapshot has to be sent
+ * @return The frame number to write as the delta source, 0 for no delta
+ *
+ * @note Must be called after the snapshot entities of this frame were stored,
+ * entities of the old frame may have rolled off the buffer in the meantime.
  */
-static void SV_WriteSnapshotToClient(client_t *client, msg_t *msg)
+static int SV_SelectDeltaFrame(client_t *client, clientSnapshot_t **oldframe)
 {
-	clientSnapshot_t *frame, *oldframe;
-	int              lastframe;
-	int              snapFlags;
-
-	// this is the snapshot we are creating
-	frame = &client->frames[client->netchan.outgoingSequence & PACKET_MASK];
+	int lastframe;
 
 	// try to use a previous frame as the source for delta compressing the snapshot
 	if (client->deltaMessage <= 0 || client->state != CS_ACTIVE)
 	{
 		// client is asking for a retransmit
-		oldframe  = NULL;
+		*oldframe = NULL;
 		lastframe = 0;
 	}
 	else if (client->netchan.outgoingSequence - client->deltaMessage >= (PACKET_BACKUP - 3))
 	{
 		// client hasn't gotten a good message through in a long time
 		Com_DPrintf("%s: Delta request from out of date packet.\n", client->name);
-		oldframe  = NULL;
+		*oldframe = NULL;
 		lastframe = 0;
 	}
 	else
 	{
 		// we have a valid snapshot to delta from
-		oldframe  = &client->frames[client->deltaMessage & PACKET_MASK];
+		*oldframe = &client->frames[client->deltaMessage & PACKET_MASK];
 		lastframe = client->netchan.outgoingSequence - client->deltaMessage;
 
 		// the snapshot's entities may still have rolled off the buffer, though
-		if (oldframe->first_entity <= svs.nextSnapshotEntities - svs.numSnapshotEntities)
+		if ((*oldframe)->first_entity <= svs.nextSnapshotEntities - svs.numSnapshotEntities)
 		{
 			Com_DPrintf("%s: Delta request from out of date entities.\n", client->name);
-			oldframe  = NULL;
+			*oldframe = NULL;
 			lastframe = 0;
 		}
 	}
 
+	return lastframe;
+}
+
+/**
+ * @brief SV_WriteSnapshotToClient
+ * @param[in] client
+ * @param[in] msg
+ * @param[in] oldframe
+ * @param[in] lastframe
+ * @param[in] thread Snapshot thread, selects the entity delta cache
+ *
+ * @note Safe to run on a worker thread unless client is an ettv client.
+ */
+static void SV_WriteSnapshotToClient(client_t *client, msg_t *msg, clientSnapshot_t *oldframe, int lastframe, int thread)
+{
+	clientSnapshot_t *frame;
+	int              snapFlags;
+
+	// this is the snapshot we are creating
+	frame = &client->frames[client->netchan.outgoingSequence & PACKET_MASK];
+
 	MSG_WriteByte(msg, svc_snapshot);
 
 	// NOTE, MRE: now sent at the start of every message from server to client
@@ -300,7 +325,7 @@ static void SV_WriteSnapshotToClient(client_t *client, msg_t *msg)
 	//}
 
 	// delta encode the entities
-	SV_EmitPacketEntities(client, oldframe, frame, msg);
+	SV_EmitPacketEntities(client, oldframe, frame, msg, thread);
 
 	if (client->ettvClient && client->state > CS_ZOMBIE)
 	{
@@ -348,10 +373,19 @@ Build a client snapshot structure
 //#define   MAX_SNAPSHOT_ENTITIES   1024 // q3 uses this
 #define MAX_SNAPSHOT_ENTITIES   2048
 
+/**
+ * @struct snapshotEntityNumbers_t
+ * @brief
+ */
 typedef struct
 {
 	int numSnapshotEntities;
 	int snapshotEntities[MAX_SNAPSHOT_ENTITIES];
+
+	int *marks;                         ///< sv.snapshotMarks row of the thread building the snapshot
+	int snapshotCounter;                ///< sv.snapshotCounter value of this snapshot
+	qboolean deferCallbacks;            ///< built off the main thread, game snapshot callbacks are run by SV_FinishClientSnapshot
+	qboolean overflowed;
 } snapshotEntityNumbers_t;
 
 /**
@@ -383,27 +417,32 @@ static int QDECL SV_QsortEntityNumbers(const void *a, const void *b)
 /**
  * @brief SV_AddEntToSnapshot
  * @param[in] clientEnt
- * @param[in,out] svEnt
  * @param[in] gEnt
  * @param[in,out] eNums
  */
-static void SV_AddEntToSnapshot(sharedEntity_t *clientEnt, svEntity_t *svEnt, sharedEntity_t *gEnt, snapshotEntityNumbers_t *eNums)
+static void SV_AddEntToSnapshot(sharedEntity_t *clientEnt, sharedEntity_t *gEnt, snapshotEntityNumbers_t *eNums)
 {
 	// if we have already added this entity to this snapshot, don't add again
-	if (svEnt->snapshotCounter == sv.snapshotCounter)
+	if (eNums->marks[gEnt->s.number] == eNums->snapshotCounter)
 	{
 		return;
 	}
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	eNums->marks[gEnt->s.number] = eNums->snapshotCounter;
 
 	// if we are full, silently discard entities
 	if (eNums->numSnapshotEntities == MAX_SNAPSHOT_ENTITIES)
 	{
-		Com_Printf("Warning: MAX_SNAPSHOT_ENTITIES reached. Ignoring ent.\n");
+		if (!eNums->deferCallbacks)
+		{
+			Com_Printf("Warning: MAX_SNAPSHOT_ENTITIES reached. Ignoring ent.\n");
+		}
+		eNums->overflowed = qtrue;
 		return;
 	}
 
-	if (gEnt->r.snapshotCallback)
+	// the game module can't be called from worker threads, the
+	// entity is kept for now and filtered once the snapshot is finished
+	if (gEnt->r.snapshotCallback && !eNums->deferCallbacks)
 	{
 		if (!(qboolean)(VM_Call(gvm, GAME_SNAPSHOT_CALLBACK, gEnt->s.number, clientEnt->s.number)))
 		{
@@ -415,6 +454,183 @@ static void SV_AddEntToSnapshot(sharedEntity_t *clientEnt, svEntity_t *svEnt, sh
 	eNums->numSnapshotEntities++;
 }
 
+/**
+ * @brief SV_OrEntityBits
+ * @param[in,out] out
+ * @param[in] in
+ */
+static ID_INLINE void SV_OrEntityBits(entityBits_t *out, const entityBits_t *in)
+{
+	int i;
+
+#ifdef ETL_SSE
+	for (i = 0; i < MAX_GENTITIES / 32; i += 4)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i *)&out->bits[i]);
+		__m128i b = _mm_loadu_si128((const __m128i *)&in->bits[i]);
+
+		_mm_storeu_si128((__m128i *)&out->bits[i], _mm_or_si128(a, b));
+	}
+#else
+	for (i = 0; i < MAX_GENTITIES / 32; i++)
+	{
+		out->bits[i] |= in->bits[i];
+	}
+#endif
+}
+
+#define SV_EntityBitSet(eb, num) ((eb)->bits[(num) >> 5] & (1u << ((num) & 31)))
+
+/**
+ * @brief Sets or clears an entity in the cluster and area bits it is indexed under.
+ * @param[in,out] svEnt
+ * @param[in] e
+ * @param[in] set
+ */
+static void SV_IndexEntityVisibility(svEntity_t *svEnt, int e, qboolean set)
+{
+	entityBits_t *eb[2 + MAX_ENT_CLUSTERS];
+	int          num = 0, i, cluster;
+	uint32_t     bit = 1u << (e & 31);
+
+	// doors can legally straddle two areas
+	eb[num++] = &sv.areaEntities[svEnt->visAreanum < 0 ? MAX_MAP_AREAS : svEnt->visAreanum];
+	eb[num++] = &sv.areaEntities[svEnt->visAreanum2 < 0 ? MAX_MAP_AREAS : svEnt->visAreanum2];
+
+	for (i = 0; i < svEnt->visNumClusters; i++)
+	{
+		cluster = svEnt->visClusternums[i];
+
+		if (cluster < 0 || cluster >= sv.numVisClusters)
+		{
+			continue;
+		}
+
+		if (set && !sv.clusterOccupied[cluster])
+		{
+			sv.clusterOccupied[cluster]                   = 1;
+			sv.occupiedClusters[sv.numOccupiedClusters++] = cluster;
+		}
+
+		eb[num++] = &sv.clusterEntities[cluster];
+	}
+
+	for (i = 0; i < num; i++)
+	{
+		if (set)
+		{
+			eb[i]->bits[e >> 5] |= bit;
+		}
+		else
+		{
+			eb[i]->bits[e >> 5] &= ~bit;
+		}
+	}
+}
+
+/**
+ * @brief Moves the entities linked since the last call to their new cluster and area bits.
+ *
+ * Unlinked entities keep the clusters of their last link, which is harmless
+ * as the snapshot code skips them before looking at the bits. Clusters that
+ * were emptied again stay in the occupied list until the next map.
+ *
+ * @note Only called from the main thread, the job threads just read the result.
+ */
+static void SV_UpdateEntityVisibility(void)
+{
+	svEntity_t *svEnt;
+	int        w, e, numClusters;
+	uint32_t   dirty;
+
+	for (w = 0; w < MAX_GENTITIES / 32; w++)
+	{
+		dirty = sv.entityVisibilityDirty.bits[w];
+		if (!dirty)
+		{
+			continue;
+		}
+		sv.entityVisibilityDirty.bits[w] = 0;
+
+		for (e = w << 5; dirty; e++, dirty >>= 1)
+		{
+			if (!(dirty & 1))
+			{
+				continue;
+			}
+
+			svEnt       = &sv.svEntities[e];
+			numClusters = svEnt->numClusters > 0 ? svEnt->numClusters : 0;
+
+			// most relinks don't leave the clusters they were in
+			if (svEnt->visIndexed && svEnt->visAreanum == svEnt->areanum && svEnt->visAreanum2 == svEnt->areanum2
+			    && svEnt->visNumClusters == numClusters
+			    && !memcmp(svEnt->visClusternums, svEnt->clusternums, numClusters * sizeof(svEnt->clusternums[0])))
+			{
+				continue;
+			}
+
+			if (svEnt->visIndexed)
+			{
+				SV_IndexEntityVisibility(svEnt, e, qfalse);
+			}
+
+			svEnt->visIndexed     = qtrue;
+			svEnt->visAreanum     = svEnt->areanum;
+			svEnt->visAreanum2    = svEnt->areanum2;
+			svEnt->visNumClusters = numClusters;
+			Com_Memcpy(svEnt->visClusternums, svEnt->clusternums, numClusters * sizeof(svEnt->clusternums[0]));
+
+			SV_IndexEntityVisibility(svEnt, e, qtrue);
+		}
+	}
+}
+
+/**
+ * @brief Collects the entities in areas connected to the viewpoint area and
+ * the entities touching a cluster in the viewpoint PVS.
+ *
+ * @param[in] clientarea
+ * @param[in] clientpvs
+ * @param[out] areaVisible
+ * @param[out] clusterVisible
+ *
+ * @note Entities with clusters that didn't fit into svEntity_t::clusternums
+ * still need their overflow clusters checked.
+ */
+static void SV_VisibleEntityBits(int clientarea, const byte *clientpvs, entityBits_t *areaVisible, entityBits_t *clusterVisible)
+{
+	int numAreas = CM_NumAreas();
+	int i, cluster;
+
+	Com_Memset(areaVisible, 0, sizeof(*areaVisible));
+	Com_Memset(clusterVisible, 0, sizeof(*clusterVisible));
+
+	for (i = 0; i < numAreas; i++)
+	{
+		if (CM_AreasConnected(clientarea, i))
+		{
+			SV_OrEntityBits(areaVisible, &sv.areaEntities[i]);
+		}
+	}
+
+	// with cm_noAreas even entities outside of any area are connected
+	if (CM_AreasConnected(clientarea, -1))
+	{
+		SV_OrEntityBits(areaVisible, &sv.areaEntities[MAX_MAP_AREAS]);
+	}
+
+	for (i = 0; i < sv.numOccupiedClusters; i++)
+	{
+		cluster = sv.occupiedClusters[i];
+
+		if (clientpvs[cluster >> 3] & (1 << (cluster & 7)))
+		{
+			SV_OrEntityBits(clusterVisible, &sv.clusterEntities[cluster]);
+		}
+	}
+}
+
 #ifdef FEATURE_ANTICHEAT
 /**
  * @brief SV_AddEntitiesVisibleFromPoint
@@ -434,17 +650,18 @@ static void SV_AddEntitiesVisibleFromPoint(client_t *cl, vec3_t origin, clientSn
 static void SV_AddEntitiesVisibleFromPoint(client_t *cl, vec3_t origin, clientSnapshot_t *frame, snapshotEntityNumbers_t *eNums)
 #endif
 {
-	int            e, i;
+	int            e;
 	sharedEntity_t *ent, *playerEnt, *ment;
 #ifdef FEATURE_ANTICHEAT
 	sharedEntity_t *client;
 #endif
-	svEntity_t *svEnt;
-	int        l;
-	int        clientarea, clientcluster;
-	int        leafnum;
-	byte       *clientpvs;
-	byte       *bitvector;
+	svEntity_t   *svEnt;
+	int          l;
+	int          clientarea, clientcluster;
+	int          leafnum;
+	byte         *clientpvs;
+	byte         *bitvector;
+	entityBits_t areaVisible, clusterVisible;
 
 	// during an error shutdown message we may need to transmit
 	// the shutdown message after the server has shutdown, so
@@ -463,6 +680,8 @@ static void SV_AddEntitiesVisibleFromPoint(client_t *cl, vec3_t origin, clientSn
 
 	clientpvs = CM_ClusterPVS(clientcluster);
 
+	SV_VisibleEntityBits(clientarea, clientpvs, &areaVisible, &clusterVisible);
+
 	playerEnt = SV_GentityNum(frame->ps.clientNum);
 	if (playerEnt->r.svFlags & SVF_SELF_PORTAL)
 	{
@@ -512,24 +731,24 @@ static void SV_AddEntitiesVisibleFromPoint(client_t *cl, vec3_t origin, clientSn
 			}
 		}
 
-		svEnt = SV_SvEntityForGentity(ent);
-
 		// don't double add an entity through portals
-		if (svEnt->snapshotCounter == sv.snapshotCounter)
+		if (eNums->marks[e] == eNums->snapshotCounter)
 		{
 			continue;
 		}
 
+		svEnt = SV_SvEntityForGentity(ent);
+
 		// broadcast entities are always sent
 		if (ent->r.svFlags & SVF_BROADCAST)
 		{
-			SV_AddEntToSnapshot(playerEnt, svEnt, ent, eNums);
+			SV_AddEntToSnapshot(playerEnt, ent, eNums);
 			continue;
 		}
 
 		if (cl->ettvClient)
 		{
-			SV_AddEntToSnapshot(playerEnt, svEnt, ent, eNums);
+			SV_AddEntToSnapshot(playerEnt, ent, eNums);
 			continue;
 		}
 
@@ -540,46 +759,27 @@ static void SV_AddEntitiesVisibleFromPoint(client_t *cl, vec3_t origin, clientSn
 		{
 			if (bitvector[svEnt->originCluster >> 3] & (1 << (svEnt->originCluster & 7)))
 			{
-				SV_AddEntToSnapshot(playerEnt, svEnt, ent, eNums);
+				SV_AddEntToSnapshot(playerEnt, ent, eNums);
 			}
 
 			continue;
 		}
 
 		// ignore if not touching a PV leaf
-		// check area
-		if (!CM_AreasConnected(clientarea, svEnt->areanum))
-		{
-			// doors can legally straddle two areas, so
-			// we may need to check another one
-			if (!CM_AreasConnected(clientarea, svEnt->areanum2))
-			{
-				continue;
-			}
-		}
-
-		// check individual leafs
-		if (!svEnt->numClusters)
+		// check area (doors can legally straddle two areas)
+		if (!SV_EntityBitSet(&areaVisible, e))
 		{
 			continue;
 		}
-		l = 0;
-		for (i = 0 ; i < svEnt->numClusters ; i++)
-		{
-			l = svEnt->clusternums[i];
-			if (bitvector[l >> 3] & (1 << (l & 7)))
-			{
-				break;
-			}
-		}
 
-		// if we haven't found it to be visible,
-		// check overflow clusters that coudln't be stored
-		if (i == svEnt->numClusters)
+		// check individual leafs
+		if (!SV_EntityBitSet(&clusterVisible, e))
 		{
+			// if we haven't found it to be visible,
+			// check overflow clusters that coudln't be stored
 			if (svEnt->lastCluster)
 			{
-				for ( ; l <= svEnt->lastCluster ; l++)
+				for (l = svEnt->clusternums[svEnt->numClusters - 1] ; l <= svEnt->lastCluster ; l++)
 				{
 					if (bitvector[l >> 3] & (1 << (l & 7)))
 					{
@@ -605,38 +805,25 @@ static void SV_AddEntitiesVisibleFromPoint(client_t *cl, vec3_t origin, clientSn
 
 			if (ment)
 			{
-				svEntity_t *master = 0;
-				master = SV_SvEntityForGentity(ment);
-
-				if (master->snapshotCounter == sv.snapshotCounter || !ment->r.linked)
+				if (eNums->marks[ment->s.number] == eNums->snapshotCounter || !ment->r.linked)
 				{
 					continue;
 				}
 
-				SV_AddEntToSnapshot(playerEnt, master, ment, eNums);
+				SV_AddEntToSnapshot(playerEnt, ment, eNums);
 			}
 
 			continue;   // master needs to be added, but not this dummy ent
 		}
 		else if (ent->r.svFlags & SVF_VISDUMMY_MULTIPLE)
 		{
-			int        h;
-			svEntity_t *master = 0;
+			int h;
 
 			for (h = 0; h < sv.num_entities; h++)
 			{
 				ment = SV_GentityNum(h);
 
-				if (ment == ent)
-				{
-					continue;
-				}
-
-				if (ment)
-				{
-					master = SV_SvEntityForGentity(ment);
-				}
-				else
+				if (ment == ent || !ment)
 				{
 					continue;
 				}
@@ -657,14 +844,14 @@ static void SV_AddEntitiesVisibleFromPoint(client_t *cl, vec3_t origin, clientSn
 					continue;
 				}
 
-				if (master->snapshotCounter == sv.snapshotCounter)
+				if (eNums->marks[h] == eNums->snapshotCounter)
 				{
 					continue;
 				}
 
 				if (ment->s.otherEntityNum == ent->s.number)
 				{
-					SV_AddEntToSnapshot(playerEnt, master, ment, eNums);
+					SV_AddEntToSnapshot(playerEnt, ment, eNums);
 				}
 			}
 
@@ -689,7 +876,7 @@ static void SV_AddEntitiesVisibleFromPoint(client_t *cl, vec3_t origin, clientSn
 				if (!SV_CanSee(frame->ps.clientNum, e))
 				{
 					SV_RandomizePos(frame->ps.clientNum, e);
-					SV_AddEntToSnapshot(client, svEnt, ent, eNums);
+					SV_AddEntToSnapshot(client, ent, eNums);
 					continue;
 				}
 			}
@@ -697,7 +884,7 @@ static void SV_AddEntitiesVisibleFromPoint(client_t *cl, vec3_t origin, clientSn
 #endif
 
 		// add it
-		SV_AddEntToSnapshot(playerEnt, svEnt, ent, eNums);
+		SV_AddEntToSnapshot(playerEnt, ent, eNums);
 
 		// if its a portal entity, add everything visible from its camera position
 		if (ent->r.svFlags & SVF_PORTAL)
@@ -714,29 +901,19 @@ static void SV_AddEntitiesVisibleFromPoint(client_t *cl, vec3_t origin, clientSn
 }
 
 /**
- * @brief Decides which entities are going to be visible to the client, and
- * copies off the playerstate and areabits.
- *
- * This properly handles multiple recursive portals, but the render
- * currently doesn't.
- *
- * For viewing through other player's eyes, clent can be something other than client->gentity
+ * @brief Prepares the frame of a new client snapshot and grabs its playerstate.
  *
  * @param[in,out] client
+ * @param[out] eNums
+ * @param[in] deferCallbacks qtrue if the entities are collected by a worker thread
+ *
+ * @return qfalse if there is nothing to collect for this client
  */
-static void SV_BuildClientSnapshot(client_t *client)
+static qboolean SV_BeginClientSnapshot(client_t *client, snapshotEntityNumbers_t *eNums, qboolean deferCallbacks)
 {
-	vec3_t                  org;
-	clientSnapshot_t        *frame;
-	snapshotEntityNumbers_t entityNumbers;
-	int                     i;
-	sharedEntity_t          *ent;
-	entityState_t           *state;
-	entityShared_t          *stateShared;
-	svEntity_t              *svEnt;
-	sharedEntity_t          *clent;
-	int                     clientNum;
-	playerState_t           *ps;
+	clientSnapshot_t *frame;
+	sharedEntity_t   *clent;
+	int              clientNum;
 
 	// bump the counter used to prevent double adding
 	sv.snapshotCounter++;
@@ -745,7 +922,11 @@ static void SV_BuildClientSnapshot(client_t *client)
 	frame = &client->frames[client->netchan.outgoingSequence & PACKET_MASK];
 
 	// clear everything in this snapshot
-	entityNumbers.numSnapshotEntities = 0;
+	eNums->numSnapshotEntities = 0;
+	eNums->marks               = sv.snapshotMarks[0];
+	eNums->snapshotCounter     = sv.snapshotCounter;
+	eNums->deferCallbacks      = deferCallbacks;
+	eNums->overflowed          = qfalse;
 	Com_Memset(frame->areabits, 0, sizeof(frame->areabits));
 
 	frame->num_entities = 0;
@@ -753,12 +934,14 @@ static void SV_BuildClientSnapshot(client_t *client)
 	clent = client->gentity;
 	if (!clent || client->state == CS_ZOMBIE)
 	{
-		return;
+		return qfalse;
 	}
 
 	// grab the current playerState_t
-	ps        = SV_GameClientNum(client - svs.clients);
-	frame->ps = *ps;
+	frame->ps = *SV_GameClientNum(client - svs.clients);
+
+	// the worker threads only read the visibility bits, refresh them up front
+	SV_UpdateEntityVisibility();
 
 	// never send client's own entity, because it can
 	// be regenerated from the playerstate
@@ -767,9 +950,35 @@ static void SV_BuildClientSnapshot(client_t *client)
 	{
 		Com_Error(ERR_DROP, "SV_BuildClientSnapshot: bad gEnt");
 	}
-	svEnt = &sv.svEntities[clientNum];
 
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	return qtrue;
+}
+
+/**
+ * @brief Decides which entities are going to be visible to the client and
+ * collects the areabits.
+ *
+ * This properly handles multiple recursive portals, but the render
+ * currently doesn't.
+ *
+ * For viewing through other player's eyes, clent can be something other than client->gentity
+ *
+ * @param[in,out] client
+ * @param[in,out] eNums
+ *
+ * @note Safe to run on a worker thread if eNums->deferCallbacks is set
+ * and the anti-wallhack is disabled.
+ */
+static void SV_CollectSnapshotEntities(client_t *client, snapshotEntityNumbers_t *eNums)
+{
+	vec3_t           org;
+	clientSnapshot_t *frame;
+	sharedEntity_t   *clent = client->gentity;
+	playerState_t    *ps    = SV_GameClientNum(client - svs.clients);
+
+	frame = &client->frames[client->netchan.outgoingSequence & PACKET_MASK];
+
+	eNums->marks[frame->ps.clientNum] = eNums->snapshotCounter;
 
 	if (clent->r.svFlags & SVF_SELF_PORTAL_EXCLUSIVE)
 	{
@@ -796,17 +1005,57 @@ static void SV_BuildClientSnapshot(client_t *client)
 	// add all the entities directly visible to the eye, which
 	// may include portal entities that merge other viewpoints
 #ifdef FEATURE_ANTICHEAT
-	SV_AddEntitiesVisibleFromPoint(client, org, frame, &entityNumbers, qfalse /*client->netchan.remoteAddress.type == NA_LOOPBACK*/);
+	SV_AddEntitiesVisibleFromPoint(client, org, frame, eNums, qfalse /*client->netchan.remoteAddress.type == NA_LOOPBACK*/);
 #else
-	SV_AddEntitiesVisibleFromPoint(client, org, frame, &entityNumbers /*, qfalse, client->netchan.remoteAddress.type == NA_LOOPBACK*/);
+	SV_AddEntitiesVisibleFromPoint(client, org, frame, eNums /*, qfalse, client->netchan.remoteAddress.type == NA_LOOPBACK*/);
 #endif
+}
+
+/**
+ * @brief Runs the deferred game snapshot callbacks, sorts the collected entities
+ * and reserves their slots in the snapshot entity buffer.
+ *
+ * @param[in,out] client
+ * @param[in,out] eNums
+ */
+static void SV_FinishClientSnapshot(client_t *client, snapshotEntityNumbers_t *eNums)
+{
+	clientSnapshot_t *frame;
+	int              i;
+
+	frame = &client->frames[client->netchan.outgoingSequence & PACKET_MASK];
+
+	if (eNums->deferCallbacks)
+	{
+		sharedEntity_t *ent;
+		int            num = 0;
+
+		if (eNums->overflowed)
+		{
+			Com_Printf("Warning: MAX_SNAPSHOT_ENTITIES reached. Ignoring ents.\n");
+		}
+
+		for (i = 0 ; i < eNums->numSnapshotEntities ; i++)
+		{
+			ent = SV_GentityNum(eNums->snapshotEntities[i]);
+
+			if (ent->r.snapshotCallback && !(qboolean)(VM_Call(gvm, GAME_SNAPSHOT_CALLBACK, ent->s.number, frame->ps.clientNum)))
+			{
+				continue;
+			}
+
+			eNums->snapshotEntities[num++] = eNums->snapshotEntities[i];
+		}
+
+		eNums->numSnapshotEntities = num;
+	}
 
 	// if there were portals visible, there may be out of order entities
 	// in the list which will need to be resorted for the delta compression
 	// to work correctly.  This also catches the error condition
 	// of an entity being included twice.
-	qsort(entityNumbers.snapshotEntities, entityNumbers.numSnapshotEntities,
-	      sizeof(entityNumbers.snapshotEntities[0]), SV_QsortEntityNumbers);
+	qsort(eNums->snapshotEntities, eNums->numSnapshotEntities,
+	      sizeof(eNums->snapshotEntities[0]), SV_QsortEntityNumbers);
 
 	// now that all viewpoint's areabits have been OR'd together, invert
 	// all of them to make it a mask vector, which is what the renderer wants
@@ -815,40 +1064,79 @@ static void SV_BuildClientSnapshot(client_t *client)
 		((int *)frame->areabits)[i] = ((int *)frame->areabits)[i] ^ -1;
 	}
 
-	// copy the entity states out
-	frame->num_entities = 0;
+	// reserve the entity states
+	frame->num_entities = eNums->numSnapshotEntities;
 	frame->first_entity = svs.nextSnapshotEntities;
-	for (i = 0 ; i < entityNumbers.numSnapshotEntities ; i++)
+
+	svs.nextSnapshotEntities += eNums->numSnapshotEntities;
+	// this should never hit, map should always be restarted first in SV_Frame
+	if (svs.nextSnapshotEntities >= 0x7FFFFFFE)
+	{
+		Com_Error(ERR_FATAL, "SV_BuildClientSnapshot: svs.nextSnapshotEntities wrapped");
+	}
+}
+
+/**
+ * @brief Copies the entity states out into the slots reserved by SV_FinishClientSnapshot
+ *
+ * @param[in] client
+ * @param[in] eNums
+ *
+ * @note Safe to run on a worker thread unless the anti-wallhack is enabled.
+ */
+static void SV_CopySnapshotEntities(client_t *client, snapshotEntityNumbers_t *eNums)
+{
+	clientSnapshot_t *frame;
+	sharedEntity_t   *ent;
+	entityState_t    *state;
+	entityShared_t   *stateShared;
+	int              i, index;
+
+	frame = &client->frames[client->netchan.outgoingSequence & PACKET_MASK];
+
+	for (i = 0 ; i < eNums->numSnapshotEntities ; i++)
 	{
-		ent    = SV_GentityNum(entityNumbers.snapshotEntities[i]);
-		state  = &svs.snapshotEntities[svs.nextSnapshotEntities % svs.numSnapshotEntities];
+		index  = (frame->first_entity + i) % svs.numSnapshotEntities;
+		ent    = SV_GentityNum(eNums->snapshotEntities[i]);
+		state  = &svs.snapshotEntities[index];
 		*state = ent->s;
 
 		if (client->ettvClient)
 		{
-			stateShared  = &svs.snapshotSharedEntities[svs.nextSnapshotEntities % svs.numSnapshotEntities];
+			stateShared  = &svs.snapshotSharedEntities[index];
 			*stateShared = ent->r;
 		}
 
 #ifdef FEATURE_ANTICHEAT
-		if (sv_wh_active->integer && entityNumbers.snapshotEntities[i] < sv_maxclients->integer)
+		if (sv_wh_active->integer && eNums->snapshotEntities[i] < sv_maxclients->integer)
 		{
-			if (SV_PositionChanged(entityNumbers.snapshotEntities[i]))
+			if (SV_PositionChanged(eNums->snapshotEntities[i]))
 			{
-				SV_RestorePos(entityNumbers.snapshotEntities[i]);
+				SV_RestorePos(eNums->snapshotEntities[i]);
 			}
 		}
 #endif
+	}
+}
 
-		svs.nextSnapshotEntities++;
-		// this should never hit, map should always be restarted first in SV_Frame
-		if (svs.nextSnapshotEntities >= 0x7FFFFFFE)
-		{
-			Com_Error(ERR_FATAL, "SV_BuildClientSnapshot: svs.nextSnapshotEntities wrapped");
-		}
+/**
+ * @brief Decides which entities are going to be visible to the client, and
+ * copies off the playerstate and areabits.
+ *
+ * @param[in,out] client
+ */
+static void SV_BuildClientSnapshot(client_t *client)
+{
+	snapshotEntityNumbers_t entityNumbers;
 
-		frame->num_entities++;
+	if (!SV_BeginClientSnapshot(client, &entityNumbers, qfalse))
+	{
+		return;
 	}
+
+	SV_CollectSnapshotEntities(client, &entityNumbers);
+	SV_FinishClientSnapshot(client, &entityNumbers);
+	SV_CopySnapshotEntities(client, &entityNumbers);
 }
 
 #define UDPIP_HEADER_SIZE 28
@@ -994,8 +1282,10 @@ void SV_SendClientIdle(client_t *client)
  */
 void SV_SendClientSnapshot(client_t *client)
 {
-	byte  msg_buf[MAX_MSGLEN];
-	msg_t msg;
+	byte             msg_buf[MAX_MSGLEN];
+	msg_t            msg;
+	clientSnapshot_t *oldframe;
+	int              lastframe;
 
 	if (client->state < CS_ACTIVE)
 	{
@@ -1035,7 +1325,8 @@ void SV_SendClientSnapshot(client_t *client)
 
 	// send over all the relevant entityState_t
 	// and the playerState_t
-	SV_WriteSnapshotToClient(client, &msg);
+	lastframe = SV_SelectDeltaFrame(client, &oldframe);
+	SV_WriteSnapshotToClient(client, &msg, oldframe, lastframe, 0);
 
 	if (SV_CheckForMsgOverflow(client, &msg))
 	{
@@ -1048,6 +1339,283 @@ void SV_SendClientSnapshot(client_t *client)
 	sv.ubpsTotalBytes += msg.uncompsize / 8;    // net debugging
 }
 
+/*
+=============================================================================
+Threaded snapshot building (sv_snapshotThreads)
+
+The snapshots of all clients due this frame are built and delta encoded on
+the job threads. Everything calling into the game module, printing or
+touching the network stays on the main thread:
+
+1. SV_BeginClientSnapshot       main thread
+2. SV_CollectSnapshotEntities   job threads, game snapshot callbacks are deferred
+3. SV_FinishClientSnapshot      main thread, snapshot callbacks and entity buffer slots
+4. SV_EncodeSnapshotJob         job threads, entity copy and delta encoding
+5. SV_SendMessageToClient       main thread
+=============================================================================
+*/
+
+/**
+ * @struct snapshotJob_t
+ * @brief
+ */
+typedef struct
+{
+	client_t *client;
+	qboolean collect;                   ///< entities are collected and copied by the job threads
+	clientSnapshot_t *oldframe;
+	int lastframe;
+	snapshotEntityNumbers_t entityNumbers;
+	msg_t msg;
+	byte msgBuf[MAX_MSGLEN];
+} snapshotJob_t;
+
+static snapshotJob_t svSnapshotJobs[MAX_CLIENTS];
+
+/**
+ * @brief SV_CollectSnapshotJob
+ * @param[in,out] data
+ * @param[in] index
+ * @param[in] thread
+ */
+static void SV_CollectSnapshotJob(void *data, int index, int thread)
+{
+	snapshotJob_t *job = (snapshotJob_t *)data + index;
+
+	if (job->collect)
+	{
+		job->entityNumbers.marks = sv.snapshotMarks[thread];
+		SV_CollectSnapshotEntities(job->client, &job->entityNumbers);
+	}
+}
+
+/**
+ * @brief SV_EncodeSnapshotJob
+ * @param[in,out] data
+ * @param[in] index
+ * @param[in] thread
+ */
+static void SV_EncodeSnapshotJob(void *data, int index, int thread)
+{
+	snapshotJob_t *job    = (snapshotJob_t *)data + index;
+	client_t      *client = job->client;
+
+	if (job->collect)
+	{
+		SV_CopySnapshotEntities(client, &job->entityNumbers);
+	}
+
+	MSG_Init(&job->msg, job->msgBuf, sizeof(job->msgBuf));
+	job->msg.allowoverflow = qtrue;
+
+	if (!Com_IsCompatible(&client->agent, 0x1))
+	{
+		MSG_EnableCharStrip(&job->msg);
+	}
+
+	// NOTE, MRE: all server->client messages now acknowledge
+	// let the client know which reliable clientCommands we have received
+	MSG_WriteLong(&job->msg, client->lastClientCommand);
+
+	// (re)send any reliable server commands
+	SV_UpdateServerCommandsToClient(client, &job->msg);
+
+	// send over all the relevant entityState_t
+	// and the playerState_t
+	SV_WriteSnapshotToClient(client, &job->msg, job->oldframe, job->lastframe, thread);
+}
+
+/**
+ * @brief Fixes bad entity numbers on the main thread, SV_AddEntitiesVisibleFromPoint
+ * doesn't get to it then while running on the job threads.
+ */
+static void SV_CheckSnapshotEntityNumbers(void)
+{
+	sharedEntity_t *ent;
+	int            e;
+
+	for (e = 0 ; e < sv.num_entities ; e++)
+	{
+		ent = SV_GentityNum(e);
+
+		if (ent->r.linked && ent->s.number != e)
+		{
+			Com_DPrintf("FIXING ENT->S.NUMBER!!!\n");
+			ent->s.number = e;
+		}
+	}
+}
+
+/**
+ * @brief Builds and encodes the snapshots of the given clients, spread over the job threads.
+ * The messages are left in the jobs for the caller to send.
+ *
+ * @param[in,out] jobs
+ * @param[in] numJobs
+ */
+static void SV_BuildClientSnapshots(snapshotJob_t *jobs, int numJobs)
+{
+	qboolean threaded = qtrue;
+	int      i;
+
+#ifdef FEATURE_ANTICHEAT
+	// the anti-wallhack moves players around while the entities are collected,
+	// only its traces can run on the job threads beforehand
+	if (sv_wh_active->integer)
+	{
+		int clients[MAX_CLIENTS];
+
+		for (i = 0; i < numJobs; i++)
+		{
+			clients[i] = (int)(jobs[i].client - svs.clients);
+		}
+
+		SV_PrepareWallhack(clients, numJobs);
+		threaded = qfalse;
+	}
+#endif
+
+	if (threaded)
+	{
+		SV_CheckSnapshotEntityNumbers();
+
+		for (i = 0; i < numJobs; i++)
+		{
+			jobs[i].collect = SV_BeginClientSnapshot(jobs[i].client, &jobs[i].entityNumbers, qtrue);
+		}
+
+		Com_RunJobs(SV_CollectSnapshotJob, jobs, numJobs);
+
+		for (i = 0; i < numJobs; i++)
+		{
+			if (jobs[i].collect)
+			{
+				SV_FinishClientSnapshot(jobs[i].client, &jobs[i].entityNumbers);
+			}
+		}
+	}
+	else
+	{
+		for (i = 0; i < numJobs; i++)
+		{
+			jobs[i].collect = qfalse;
+			SV_BuildClientSnapshot(jobs[i].client);
+		}
+	}
+
+	// the entity buffer slots of all snapshots are taken now,
+	// so any delta source about to be overwritten is known
+	for (i = 0; i < numJobs; i++)
+	{
+		jobs[i].lastframe = SV_SelectDeltaFrame(jobs[i].client, &jobs[i].oldframe);
+	}
+
+	Com_RunJobs(SV_EncodeSnapshotJob, jobs, numJobs);
+}
+
+/**
+ * @brief Updates the job threads after sv_snapshotThreads changed
+ */
+static void SV_CheckSnapshotThreads(void)
+{
+	if (sv_snapshotThreads->modified)
+	{
+		Com_InitJobs(sv_snapshotThreads->integer);
+		sv_snapshotThreads->modified = qfalse;
+	}
+}
+
+/**
+ * @brief Measures how long building and encoding the snapshots of all active
+ * clients takes with 1 up to the given number of threads. Nothing is sent.
+ *
+ * @note The snapshots are built for real, they advance the snapshot entity
+ * buffer and the reliable commands sent. So the benchmark only runs with
+ * bots, and not with the anti-wallhack which builds all snapshots serially.
+ */
+void SV_SnapshotBench_f(void)
+{
+	client_t *c;
+	int      frames, maxThreads, threads, numJobs = 0;
+	int      i, j, start, msec;
+
+	if (!com_sv_running->integer || sv.state != SS_GAME)
+	{
+		Com_Printf("Server is not running.\n");
+		return;
+	}
+
+	for (i = 0, c = svs.clients; i < sv_maxclients->integer; i++, c++)
+	{
+		if (c->state >= CS_CONNECTED && !c->demoClient && c->netchan.remoteAddress.type != NA_BOT)
+		{
+			Com_Printf("Players are connected, the benchmark runs with bots only.\n");
+			return;
+		}
+	}
+
+#ifdef FEATURE_ANTICHEAT
+	if (sv_wh_active->integer)
+	{
+		Com_Printf("The benchmark doesn't run with the anti-wallhack enabled (sv_wh_active 1).\n");
+		return;
+	}
+#endif
+
+	frames     = Cmd_Argc() > 1 ? Q_atoi(Cmd_Argv(1)) : 100;
+	maxThreads = Cmd_Argc() > 2 ? Q_atoi(Cmd_Argv(2)) : MAX(sv_snapshotThreads->integer, 4);
+	frames     = MAX(1, frames);
+	maxThreads = MAX(1, MIN(maxThreads, MAX_JOB_THREADS));
+
+	// bots make a full server easy to set up
+	for (i = 0, c = svs.clients; i < sv_maxclients->integer; i++, c++)
+	{
+		if (c->state == CS_ACTIVE && c->gentity && !c->demoClient && !c->ettvClient)
+		{
+			svSnapshotJobs[numJobs++].client = c;
+		}
+	}
+
+	if (!numJobs)
+	{
+		Com_Printf("No active clients.\n");
+		return;
+	}
+
+	Com_Printf("Building and encoding %i snapshots, %i frames:\n", numJobs, frames);
+
+	for (threads = 1; threads <= maxThreads; threads++)
+	{
+		int bytes = 0, hits, misses, full, oldHits, oldMisses;
+
+		Com_InitJobs(threads);
+		SV_DeltaCacheCounters(&oldHits, &oldMisses, &full);
+
+		start = Sys_Milliseconds();
+		for (j = 0; j < frames; j++)
+		{
+			SV_DeltaCacheBeginFrame();
+			SV_BuildClientSnapshots(svSnapshotJobs, numJobs);
+		}
+		msec = Sys_Milliseconds() - start;
+
+		for (i = 0; i < numJobs; i++)
+		{
+			bytes += svSnapshotJobs[i].msg.cursize;
+		}
+
+		SV_DeltaCacheCounters(&hits, &misses, &full);
+		hits   -= oldHits;
+		misses -= oldMisses;
+
+		Com_Printf("%2i thread(s): %8.3f msec/frame %6i bytes/frame %5.1f%% delta cache hits\n", Com_JobThreads(), (double)(msec / (float)frames), bytes,
+		           (hits + misses) ? 100.0 * hits / (hits + misses) : 0.0);
+	}
+
+	sv_snapshotThreads->modified = qtrue;
+	SV_CheckSnapshotThreads();
+}
+
 /**
  * @brief SV_SendClientMessages
  */
@@ -1056,6 +1624,8 @@ void SV_SendClientMessages(void)
 	int      i;
 	client_t *c;
 	int      numclients = 0;    // net debugging
+	int      numJobs    = 0;
+	qboolean batched;
 
 	sv.bpsTotalBytes  = 0;      // net debugging
 	sv.ubpsTotalBytes = 0;      // net debugging
@@ -1063,6 +1633,22 @@ void SV_SendClientMessages(void)
 	// update any changed configstrings from this frame
 	SV_UpdateConfigStrings();
 
+	SV_CheckSnapshotThreads();
+	SV_DeltaCacheBeginFrame();
+
+	batched = Com_JobThreads() > 1;
+#ifdef FEATURE_ANTICHEAT
+	// the anti-wallhack traces of all snapshots are batched up front,
+	// without job threads they simply run on the main thread
+	if (sv_wh_active->integer)
+	{
+		batched = qtrue;
+	}
+#endif
+
+	// queue the packets and send them with a few syscalls at the end
+	NET_BeginSendBatch();
+
 	// send a message to each connected client
 	for (i = 0; i < sv_maxclients->integer; i++)
 	{
@@ -1123,12 +1709,43 @@ void SV_SendClientMessages(void)
 
 		numclients++; // net debugging
 
+		// leave the snapshot to the job threads, loading and ettv clients
+		// are rare and are kept on the main thread
+		if (batched && c->state == CS_ACTIVE && !c->ettvClient)
+		{
+			svSnapshotJobs[numJobs++].client = c;
+			continue;
+		}
+
 		// generate and send a new message
 		SV_SendClientSnapshot(c);
 		c->lastSnapshotTime = svs.time;
 		c->rateDelayed      = qfalse;
 	}
 
+	if (numJobs)
+	{
+		SV_BuildClientSnapshots(svSnapshotJobs, numJobs);
+
+		for (i = 0; i < numJobs; i++)
+		{
+			c = svSnapshotJobs[i].client;
+
+			if (!SV_CheckForMsgOverflow(c, &svSnapshotJobs[i].msg))
+			{
+				SV_SendMessageToClient(&svSnapshotJobs[i].msg, c);
+
+				sv.bpsTotalBytes  += svSnapshotJobs[i].msg.cursize;           // net debugging
+				sv.ubpsTotalBytes += svSnapshotJobs[i].msg.uncompsize / 8;    // net debugging
+			}
+
+			c->lastSnapshotTime = svs.time;
+			c->rateDelayed      = qfalse;
+		}
+	}
+
+	NET_FlushSendBatch();
+
 	// net debugging
 	if (sv_showAverageBPS->integer && numclients > 0)
 	{
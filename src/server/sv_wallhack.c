@@ -19,8 +19,6 @@
 
 //======================================================================
 
-static vec3_t       pred_ppos, pred_opos;
-static trajectory_t traject;
 static vec3_t       old_origin[MAX_CLIENTS];
 static int          origin_changed[MAX_CLIENTS];
 static float        delta_sign[8][3] =
@@ -363,7 +361,7 @@ static void calc_viewpoint(playerState_t *ps, vec3_t org, vec3_t vp)
 		VectorCopy(ps->viewangles, v3ViewAngles);
 		v3ViewAngles[2] += ps->leanf / 2.0f;
 		angles_vectors(v3ViewAngles, NULL, right, NULL);
-		VectorMA(org, ps->leanf, right, org);
+		VectorMA(vp, ps->leanf, right, vp);
 	}
 
 	if (ps->pm_flags & PMF_DUCKED)
@@ -439,28 +437,6 @@ static void copy_trajectory(trajectory_t *src, trajectory_t *dst)
 
 //======================================================================
 
-/**
- * @brief is_visible
- * @param[in] start
- * @param[in] end
- * @return
- */
-static int is_visible(vec3_t start, vec3_t end)
-{
-	trace_t trace;
-
-	CM_BoxTrace(&trace, start, end, NULL, NULL, 0, CONTENTS_SOLID, 0);
-
-	if (trace.contents & CONTENTS_SOLID)
-	{
-		return 0;
-	}
-
-	return 1;
-}
-
-//======================================================================
-
 /**
  * @brief init_horz_delta
  */
@@ -495,22 +471,154 @@ static void init_vert_delta(void)
 }
 
 //======================================================================
-// public functions
+// visibility cache
 //======================================================================
 
+#define PREDICT_TIME      0.1f
+#define VOFS              6
+
+#define WH_POS_GRID       2.0f      ///< position quantization of the cache keys
+#define WH_VEL_GRID       8.0f      ///< velocity quantization of the cache keys
+#define WH_KEY_SIZE       11
+
 /**
- * @brief SV_InitWallhack
+ * @struct whClient_t
+ * @brief Positions of a client used by the visibility checks, computed once per frame
  */
-void SV_InitWallhack(void)
+typedef struct
 {
-	init_horz_delta();
-	init_vert_delta();
+	qboolean valid;
+	int time;                       ///< svs.time the data was computed at
+	int key[WH_KEY_SIZE];           ///< quantized inputs of the checks
+	vec3_t origin;
+	vec3_t viewpoint;
+	vec3_t pred_origin;             ///< origin PREDICT_TIME seconds ahead
+	vec3_t pred_viewpoint;
+	vec3_t viewangles;
+} whClient_t;
+
+/**
+ * @struct whPair_t
+ * @brief Cached result of a (viewer, target) check
+ */
+typedef struct
+{
+	int time;                       ///< svs.time the result was computed at
+	int checked;                    ///< svs.time the result was last validated at
+	int key[2][WH_KEY_SIZE];        ///< viewer and target keys the result belongs to
+	int result;
+} whPair_t;
+
+/**
+ * @struct whStats_t
+ * @brief Counters printed by wallhackstats
+ */
+typedef struct
+{
+	int frames;                     ///< visibility passes
+	int pairs;                      ///< pairs checked in the passes
+	int cached;                     ///< pairs taken from the cache
+	int traces;                     ///< traces run in the passes
+	int syncTraces;                 ///< traces run on demand while building snapshots
+	int lastTraces;                 ///< traces of the last pass
+	int maxTraces;                  ///< most traces of one pass
+} whStats_t;
+
+static whClient_t wh_clients[MAX_CLIENTS];
+static whPair_t   wh_pairs[MAX_CLIENTS][MAX_CLIENTS];
+static byte       wh_targets[MAX_CLIENTS][MAX_CLIENTS];   ///< targets of each viewer to be traced in the pass
+static int        wh_numTargets[MAX_CLIENTS];
+static int        wh_viewers[MAX_CLIENTS];
+static int        wh_threadTraces[MAX_JOB_THREADS];
+static whStats_t  wh_stats;
+
+/**
+ * @brief is_visible
+ * @param[in] start
+ * @param[in] end
+ * @param[in] thread Job thread, -1 for the main thread outside of jobs
+ * @return
+ */
+static int is_visible(vec3_t start, vec3_t end, int thread)
+{
+	trace_t trace;
+
+	if (thread < 0)
+	{
+		CM_BoxTrace(&trace, start, end, NULL, NULL, 0, CONTENTS_SOLID, 0);
+	}
+	else
+	{
+		CM_BoxTraceOnThread(&trace, start, end, NULL, NULL, 0, CONTENTS_SOLID, 0, thread);
+	}
+
+	if (trace.contents & CONTENTS_SOLID)
+	{
+		return 0;
+	}
+
+	return 1;
 }
 
-//======================================================================
+/**
+ * @brief Quantizes a value for the cache keys
+ * @param[in] value
+ * @param[in] grid
+ * @return
+ */
+static int wh_quantize(float value, float grid)
+{
+	return (int)floor(value / grid);
+}
 
-#define PREDICT_TIME      0.1f
-#define VOFS              6
+/**
+ * @brief Computes the current and predicted positions of a client,
+ * unless that was done in this frame already
+ *
+ * @param[in] cli
+ * @return
+ *
+ * @note Must be called on the main thread, the prediction clips against entities.
+ */
+static whClient_t *wh_update_client(int cli)
+{
+	whClient_t     *wc = &wh_clients[cli];
+	sharedEntity_t *ent;
+	playerState_t  *ps;
+	trajectory_t   traject;
+
+	if (wc->valid && wc->time == svs.time)
+	{
+		return wc;
+	}
+
+	ent = SV_GentityNum(cli);
+	ps  = SV_GameClientNum(cli);
+
+	wc->valid = qtrue;
+	wc->time  = svs.time;
+	VectorCopy(ent->s.pos.trBase, wc->origin);
+	VectorCopy(ent->s.apos.trBase, wc->viewangles);
+	calc_viewpoint(ps, wc->origin, wc->viewpoint);
+
+	copy_trajectory(&ent->s.pos, &traject);
+	predict_move(ent, PREDICT_TIME, &traject, wc->pred_origin);
+	calc_viewpoint(ps, wc->pred_origin, wc->pred_viewpoint);
+
+	wc->key[0]  = wh_quantize(ent->s.pos.trBase[0], WH_POS_GRID);
+	wc->key[1]  = wh_quantize(ent->s.pos.trBase[1], WH_POS_GRID);
+	wc->key[2]  = wh_quantize(ent->s.pos.trBase[2], WH_POS_GRID);
+	wc->key[3]  = wh_quantize(ent->s.pos.trDelta[0], WH_VEL_GRID);
+	wc->key[4]  = wh_quantize(ent->s.pos.trDelta[1], WH_VEL_GRID);
+	wc->key[5]  = wh_quantize(ent->s.pos.trDelta[2], WH_VEL_GRID);
+	wc->key[6]  = ps->pm_flags & PMF_DUCKED;
+	wc->key[7]  = wh_quantize(ps->leanf, 1.0f);
+	wc->key[8]  = (ps->leanf != 0.f) ? wh_quantize(ps->viewangles[YAW], 1.0f) : 0;
+	wc->key[9]  = (sv_wh_check_fov->integer > 0) ? wh_quantize(ent->s.apos.trBase[YAW], 1.0f) : 0;
+	wc->key[10] = (sv_wh_check_fov->integer > 0) ? wh_quantize(ent->s.apos.trBase[PITCH], 1.0f) : 0;
+
+	return wc;
+}
 
 /**
  * @brief Checks if 'player' can see 'other' or not.
@@ -522,94 +630,68 @@ void SV_InitWallhack(void)
  * traces are successful (i.e. nothing solid is between the start
  * and end positions) then non-zero is returned.
  *
- * Otherwise the expected positions of the two players are calculated,
- * by extrapolating their movements for PREDICT_TIME seconds and the above
- * tests are carried out again. The result is reported by returning non-zero
- * (expected to become visible) or zero (not expected to become visible
- * in the next frame).
- *
- * @param[in] player
- * @param[in] other
+ * Otherwise the expected positions of the two players, extrapolated by
+ * PREDICT_TIME seconds, are tested the same way. The result is reported
+ * by returning non-zero (expected to become visible) or zero (not expected
+ * to become visible in the next frame).
  *
+ * @param[in] p Data of 'player'
+ * @param[in] o Data of 'other'
+ * @param[in] thread Job thread, -1 for the main thread outside of jobs
+ * @param[out] traces Number of traces run
  * @return
  */
-int SV_CanSee(int player, int other)
+static int wh_check_pair(whClient_t *p, whClient_t *o, int thread, int *traces)
 {
-	sharedEntity_t *pent, *oent;
-	playerState_t  *ps;
-	vec3_t         viewpoint, tmp;
-	int            i;
-
-	// check if bounding box has been changed
-	if (sv_wh_bbox_horz->integer != bbox_horz)
-	{
-		init_horz_delta();
-	}
-
-	if (sv_wh_bbox_vert->integer != bbox_vert)
-	{
-		init_vert_delta();
-	}
-
-	ps   = SV_GameClientNum(player);
-	pent = SV_GentityNum(player);
-	oent = SV_GentityNum(other);
+	vec3_t tmp;
+	int    i;
 
 	// check if 'other' is in the maximum fov allowed
 	if (sv_wh_check_fov->integer > 0)
 	{
-		if (!player_in_fov(pent->s.apos.trBase, pent->s.pos.trBase, oent->s.pos.trBase))
+		if (!player_in_fov(p->viewangles, p->origin, o->origin))
 		{
 			return 0;
 		}
 	}
 
 	// check if visible in this frame
-	calc_viewpoint(ps, pent->s.pos.trBase, viewpoint);
-
 	for (i = 0; i < 8; i++)
 	{
-		VectorCopy(oent->s.pos.trBase, tmp);
+		VectorCopy(o->origin, tmp);
 		tmp[0] += delta[i][0];
 		tmp[1] += delta[i][1];
 		tmp[2] += delta[i][2] + VOFS;
 
-		if (is_visible(viewpoint, tmp))
+		(*traces)++;
+		if (is_visible(p->viewpoint, tmp, thread))
 		{
 			return 1;
 		}
 	}
 
-	// predict player positions
-	copy_trajectory(&pent->s.pos, &traject);
-	predict_move(pent, PREDICT_TIME, &traject, pred_ppos);
-
-	copy_trajectory(&oent->s.pos, &traject);
-	predict_move(oent, PREDICT_TIME, &traject, pred_opos);
-
 	// Check again if 'other' is in the maximum fov allowed.
 	// FIXME: We use the original viewangle that may have
 	// changed during the move. This could introduce some
 	// errors.
 	if (sv_wh_check_fov->integer > 0)
 	{
-		if (!player_in_fov(pent->s.apos.trBase, pred_ppos, pred_opos))
+		if (!player_in_fov(p->viewangles, p->pred_origin, o->pred_origin))
 		{
 			return 0;
 		}
 	}
 
 	// check if expected to be visible in the next frame
-	calc_viewpoint(ps, pred_ppos, viewpoint);
-
 	for (i = 0; i < 8; i++)
 	{
-		VectorCopy(pred_opos, tmp);
+		VectorCopy(o->pred_origin, tmp);
 		tmp[0] += delta[i][0];
 		tmp[1] += delta[i][1];
 		tmp[2] += delta[i][2] + VOFS;
 
-		if (is_visible(viewpoint, tmp))
+		(*traces)++;
+		if (is_visible(p->pred_viewpoint, tmp, thread))
 		{
 			return 1;
 		}
@@ -618,6 +700,270 @@ int SV_CanSee(int player, int other)
 	return 0;
 }
 
+/**
+ * @brief Looks up a pair in the cache
+ * @param[in] pair
+ * @param[in] p
+ * @param[in] o
+ * @return qtrue if the cached result was computed from the same quantized
+ * positions recently enough
+ */
+static qboolean wh_cached(whPair_t *pair, whClient_t *p, whClient_t *o)
+{
+	if (pair->time == svs.time)
+	{
+		// computed in this frame, e.g. by an earlier snapshot
+		return !memcmp(pair->key[0], p->key, sizeof(p->key)) && !memcmp(pair->key[1], o->key, sizeof(o->key));
+	}
+
+	if (sv_wh_cache->integer <= 0 || svs.time - pair->time > sv_wh_cache->integer || svs.time < pair->time)
+	{
+		return qfalse;
+	}
+
+	return !memcmp(pair->key[0], p->key, sizeof(p->key)) && !memcmp(pair->key[1], o->key, sizeof(o->key));
+}
+
+/**
+ * @brief Checks the queued targets of one viewer, runs on the job threads
+ * @param[in] data Unused
+ * @param[in] index Index into wh_viewers
+ * @param[in] thread
+ */
+static void wh_trace_job(void *data, int index, int thread)
+{
+	int      player = wh_viewers[index];
+	whPair_t *pair;
+	int      i, other;
+
+	for (i = 0; i < wh_numTargets[player]; i++)
+	{
+		other = wh_targets[player][i];
+		pair  = &wh_pairs[player][other];
+
+		pair->result = wh_check_pair(&wh_clients[player], &wh_clients[other], thread, &wh_threadTraces[thread]);
+	}
+}
+
+/**
+ * @brief Tells if an entity may be in the PVS
+ * @param[in] ent
+ * @param[in] pvs
+ * @return
+ */
+static qboolean wh_in_pvs(sharedEntity_t *ent, byte *pvs)
+{
+	svEntity_t *svEnt = SV_SvEntityForGentity(ent);
+	int        i;
+
+	if (svEnt->numClusters < 0 || svEnt->lastCluster)
+	{
+		// big or unusual entities, let the snapshot decide
+		return qtrue;
+	}
+
+	for (i = 0; i < svEnt->numClusters; i++)
+	{
+		if (pvs[svEnt->clusternums[i] >> 3] & (1 << (svEnt->clusternums[i] & 7)))
+		{
+			return qtrue;
+		}
+	}
+
+	return qfalse;
+}
+
+//======================================================================
+// public functions
+//======================================================================
+
+/**
+ * @brief SV_InitWallhack
+ */
+void SV_InitWallhack(void)
+{
+	init_horz_delta();
+	init_vert_delta();
+
+	// the cached results depend on the bounding box
+	Com_Memset(wh_pairs, 0, sizeof(wh_pairs));
+	Com_Memset(wh_clients, 0, sizeof(wh_clients));
+}
+
+/**
+ * @brief Runs the visibility checks the snapshots of the given clients are
+ * going to need, spread over the job threads. Results of unchanged pairs are
+ * taken from the cache.
+ *
+ * @param[in] clients Client numbers of the snapshots about to be built
+ * @param[in] numClients
+ */
+void SV_PrepareWallhack(const int *clients, int numClients)
+{
+	sharedEntity_t *pent, *oent;
+	playerState_t  *ps;
+	whClient_t     *p, *o;
+	whPair_t       *pair;
+	vec3_t         org;
+	byte           *pvs;
+	int            i, other, player, numViewers = 0, traces = 0;
+
+	// check if bounding box has been changed
+	if (sv_wh_bbox_horz->integer != bbox_horz || sv_wh_bbox_vert->integer != bbox_vert)
+	{
+		SV_InitWallhack();
+	}
+
+	for (i = 0; i < numClients; i++)
+	{
+		player = clients[i];
+		pent   = SV_GentityNum(player);
+		ps     = SV_GameClientNum(player);
+
+		wh_numTargets[player] = 0;
+
+		// same exclusions as the snapshot: bots, free flying specs and followers
+		if ((pent->r.svFlags & SVF_BOT) || ps->persistant[PERS_TEAM] == TEAM_SPECTATOR || (ps->pm_flags & PMF_FOLLOW))
+		{
+			continue;
+		}
+
+		p = wh_update_client(player);
+
+		// the snapshot only asks for clients in the PVS of its origin
+		VectorCopy(ps->origin, org);
+		org[2] += ps->viewheight;
+		pvs     = CM_ClusterPVS(CM_LeafCluster(CM_PointLeafnum(org)));
+
+		for (other = 0; other < sv_maxclients->integer; other++)
+		{
+			if (other == player || svs.clients[other].state != CS_ACTIVE)
+			{
+				continue;
+			}
+
+			oent = SV_GentityNum(other);
+			if (!oent->r.linked || !wh_in_pvs(oent, pvs))
+			{
+				continue;
+			}
+
+			o    = wh_update_client(other);
+			pair = &wh_pairs[player][other];
+
+			wh_stats.pairs++;
+
+			if (wh_cached(pair, p, o))
+			{
+				pair->checked = svs.time;
+				wh_stats.cached++;
+				continue;
+			}
+
+			Com_Memcpy(pair->key[0], p->key, sizeof(p->key));
+			Com_Memcpy(pair->key[1], o->key, sizeof(o->key));
+			pair->time    = svs.time;
+			pair->checked = svs.time;
+
+			wh_targets[player][wh_numTargets[player]++] = (byte)other;
+		}
+
+		if (wh_numTargets[player])
+		{
+			wh_viewers[numViewers++] = player;
+		}
+	}
+
+	if (numViewers)
+	{
+		Com_Memset(wh_threadTraces, 0, sizeof(wh_threadTraces));
+
+		CM_PrepareThreadTraces();
+		Com_RunJobs(wh_trace_job, NULL, numViewers);
+
+		for (i = 0; i < MAX_JOB_THREADS; i++)
+		{
+			traces += wh_threadTraces[i];
+		}
+	}
+
+	wh_stats.frames++;
+	wh_stats.traces    += traces;
+	wh_stats.lastTraces = traces;
+	wh_stats.maxTraces  = MAX(wh_stats.maxTraces, traces);
+}
+
+/**
+ * @brief Checks if 'player' can see 'other' or not, see wh_check_pair().
+ *
+ * @details The result usually comes from SV_PrepareWallhack(), pairs it
+ * didn't expect are checked on demand.
+ *
+ * @param[in] player
+ * @param[in] other
+ *
+ * @return
+ */
+int SV_CanSee(int player, int other)
+{
+	whPair_t   *pair = &wh_pairs[player][other];
+	whClient_t *p, *o;
+	int        traces = 0;
+
+	if (pair->checked == svs.time && pair->time)
+	{
+		return pair->result;
+	}
+
+	// check if bounding box has been changed
+	if (sv_wh_bbox_horz->integer != bbox_horz || sv_wh_bbox_vert->integer != bbox_vert)
+	{
+		SV_InitWallhack();
+	}
+
+	p = wh_update_client(player);
+	o = wh_update_client(other);
+
+	pair->checked = svs.time;
+
+	if (wh_cached(pair, p, o))
+	{
+		return pair->result;
+	}
+
+	Com_Memcpy(pair->key[0], p->key, sizeof(p->key));
+	Com_Memcpy(pair->key[1], o->key, sizeof(o->key));
+	pair->time   = svs.time;
+	pair->result = wh_check_pair(p, o, -1, &traces);
+
+	wh_stats.syncTraces += traces;
+
+	return pair->result;
+}
+
+/**
+ * @brief Prints the trace counters of the anti-wallhack, "wallhackstats reset" clears them
+ */
+void SV_WallhackStats_f(void)
+{
+	if (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "reset"))
+	{
+		Com_Memset(&wh_stats, 0, sizeof(wh_stats));
+		return;
+	}
+
+	if (!sv_wh_active->integer)
+	{
+		Com_Printf("Anti-wallhack is disabled (sv_wh_active 0).\n");
+	}
+
+	Com_Printf("Anti-wallhack visibility checks:\n");
+	Com_Printf("frames          : %i\n", wh_stats.frames);
+	Com_Printf("pairs           : %i (%.1f%% cached)\n", wh_stats.pairs, wh_stats.pairs ? 100.0 * wh_stats.cached / wh_stats.pairs : 0.0);
+	Com_Printf("traces/frame    : %.1f (last %i, max %i)\n", wh_stats.frames ? (double)wh_stats.traces / wh_stats.frames : 0.0, wh_stats.lastTraces, wh_stats.maxTraces);
+	Com_Printf("on demand traces: %i\n", wh_stats.syncTraces);
+}
+
 //======================================================================
 
 /**
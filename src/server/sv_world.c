@@ -66,93 +66,154 @@ clipHandle_t SV_ClipHandleForEntity(const sharedEntity_t *ent)
 ENTITY CHECKING
 
 To avoid linearly searching through lists of entities during environment testing,
-the world is carved up with an evenly spaced, axially aligned bsp tree.  Entities
-are kept in chains either at the final leafs, or at the first node that splits
-them, which prevents having to deal with multiple fragments of a single entity.
+the world is covered by a stack of loose grids over the x/y plane, each level
+with twice the cell size of the one below. An entity is kept in one cell only:
+the cell of its center on the finest level whose cells are at least as large
+as the entity. As the bounds of a cell are loosened by half a cell on each side,
+the entity always fits in them, so neither splitting nor straddling entities
+end up in long shared lists.
 ===============================================================================
 */
 
-typedef struct worldSector_s
+#define WORLD_CELL_SIZE   128.f     ///< cell size of the finest level
+#define WORLD_MAX_CELLS   256       ///< cells per axis of the finest level at most
+#define WORLD_MAX_LEVELS  16
+
+/**
+ * @struct worldCell_s
+ * @brief Entities whose center is in the cell
+ */
+typedef struct worldCell_s
 {
-	int axis;                         // -1 = leaf node
-	float dist;
-	struct     worldSector_s *children[2];
 	svEntity_t *entities;
-} worldSector_t;
+} worldCell_t;
 
-#define AREA_DEPTH  4
-#define AREA_NODES  64
+/**
+ * @struct worldLevel_t
+ * @brief One grid of the stack
+ */
+typedef struct
+{
+	float cellSize;
+	int dims[2];
+	int numEntities;                    ///< entities linked on this level, empty levels are skipped
+	worldCell_t *cells;                 ///< [dims[1]][dims[0]]
+} worldLevel_t;
+
+/**
+ * @struct worldGrid_t
+ * @brief
+ */
+typedef struct
+{
+	float origin[2];                    ///< world mins
+	int numLevels;
+	worldLevel_t levels[WORLD_MAX_LEVELS];
+} worldGrid_t;
 
-worldSector_t sv_worldSectors[AREA_NODES];
-int           sv_numworldSectors;
+static worldGrid_t sv_worldGrid;
 
 /**
- * @brief SV_SectorList_f
+ * @brief Cell index of a coordinate, out of the world coordinates stay on the border cells
+ * @param[in] level
+ * @param[in] axis
+ * @param[in] value
+ * @return
+ */
+static ID_INLINE int SV_WorldCellCoord(const worldLevel_t *level, int axis, float value)
+{
+	int c = (int)floor((value - sv_worldGrid.origin[axis]) / level->cellSize);
+
+	if (c < 0)
+	{
+		return 0;
+	}
+	if (c >= level->dims[axis])
+	{
+		return level->dims[axis] - 1;
+	}
+	return c;
+}
+
+/**
+ * @brief Prints how the linked entities are spread over the world grid
  */
 void SV_SectorList_f(void)
 {
-	int           i, c;
-	worldSector_t *sec;
-	svEntity_t    *ent;
+	worldLevel_t *level;
+	svEntity_t   *ent;
+	int          i, j, c, occupied, most, total = 0;
 
-	for (i = 0 ; i < AREA_NODES ; i++)
+	for (i = 0 ; i < sv_worldGrid.numLevels ; i++)
 	{
-		sec = &sv_worldSectors[i];
+		level    = &sv_worldGrid.levels[i];
+		occupied = 0;
+		most     = 0;
 
-		c = 0;
-		for (ent = sec->entities ; ent ; ent = ent->nextEntityInWorldSector)
+		for (j = 0 ; j < level->dims[0] * level->dims[1] ; j++)
 		{
-			c++;
+			c = 0;
+			for (ent = level->cells[j].entities ; ent ; ent = ent->nextEntityInWorldCell)
+			{
+				c++;
+			}
+
+			if (c)
+			{
+				occupied++;
+				most = MAX(most, c);
+			}
 		}
 
-		Com_Printf("sector %i: %i entities\n", i, c);
+		Com_Printf("level %i: %4.0f units, %3i x %3i cells, %4i entities in %4i cells, at most %i per cell\n",
+		           i, (double)level->cellSize, level->dims[0], level->dims[1], level->numEntities, occupied, most);
+
+		total += level->numEntities;
 	}
+
+	Com_Printf("%i entities linked\n", total);
 }
 
 /**
- * @brief Builds a uniformly subdivided tree for the given world size
- * @param[in] depth
+ * @brief Sets up the grid levels for the given world size
  * @param[in] mins
  * @param[in] maxs
- * @return
  */
-worldSector_t *SV_CreateworldSector(int depth, vec3_t mins, vec3_t maxs)
+static void SV_CreateWorldGrid(vec3_t mins, vec3_t maxs)
 {
-	worldSector_t *anode = &sv_worldSectors[sv_numworldSectors];
-	vec3_t        size;
-	vec3_t        mins1, maxs1, mins2, maxs2;
+	worldLevel_t *level;
+	float        cellSize = WORLD_CELL_SIZE;
+	vec3_t       size;
+	int          i;
 
-	sv_numworldSectors++;
-
-	if (depth == AREA_DEPTH)
-	{
-		anode->axis        = -1;
-		anode->children[0] = anode->children[1] = NULL;
-		return anode;
-	}
+	Com_Memset(&sv_worldGrid, 0, sizeof(sv_worldGrid));
 
 	VectorSubtract(maxs, mins, size);
-	if (size[0] > size[1])
-	{
-		anode->axis = 0;
-	}
-	else
+	sv_worldGrid.origin[0] = mins[0];
+	sv_worldGrid.origin[1] = mins[1];
+
+	// keep the finest level at a sane size on huge maps
+	while (size[0] / cellSize > WORLD_MAX_CELLS || size[1] / cellSize > WORLD_MAX_CELLS)
 	{
-		anode->axis = 1;
+		cellSize *= 2;
 	}
 
-	anode->dist = 0.5f * (maxs[anode->axis] + mins[anode->axis]);
-	VectorCopy(mins, mins1);
-	VectorCopy(mins, mins2);
-	VectorCopy(maxs, maxs1);
-	VectorCopy(maxs, maxs2);
-
-	maxs1[anode->axis] = mins2[anode->axis] = anode->dist;
+	for (i = 0 ; i < WORLD_MAX_LEVELS ; i++, cellSize *= 2)
+	{
+		level           = &sv_worldGrid.levels[i];
+		level->cellSize = cellSize;
+		level->dims[0]  = MAX(1, (int)ceil(size[0] / cellSize));
+		level->dims[1]  = MAX(1, (int)ceil(size[1] / cellSize));
+		level->cells    = Hunk_Alloc(level->dims[0] * level->dims[1] * sizeof(*level->cells), h_high);
 
-	anode->children[0] = SV_CreateworldSector(depth + 1, mins2, maxs2);
-	anode->children[1] = SV_CreateworldSector(depth + 1, mins1, maxs1);
+		sv_worldGrid.numLevels++;
 
-	return anode;
+		// the top level is a single cell taking everything that is left
+		if (level->dims[0] == 1 && level->dims[1] == 1)
+		{
+			break;
+		}
+	}
 }
 
 /**
@@ -162,14 +223,26 @@ void SV_ClearWorld(void)
 {
 	clipHandle_t h;
 	vec3_t       mins, maxs;
-
-	Com_Memset(sv_worldSectors, 0, sizeof(sv_worldSectors));
-	sv_numworldSectors = 0;
+	int          i;
 
 	// get world map bounds
 	h = CM_InlineModel(0);
 	CM_ModelBounds(h, mins, maxs);
-	SV_CreateworldSector(0, mins, maxs);
+	SV_CreateWorldGrid(mins, maxs);
+
+	// entities by cluster for the snapshot PVS culling
+	sv.numVisClusters        = CM_NumClusters();
+	sv.clusterEntities       = Hunk_Alloc(sv.numVisClusters * sizeof(*sv.clusterEntities), h_high);
+	sv.clusterOccupied       = Hunk_Alloc(sv.numVisClusters * sizeof(*sv.clusterOccupied), h_high);
+	sv.occupiedClusters      = Hunk_Alloc(sv.numVisClusters * sizeof(*sv.occupiedClusters), h_high);
+	sv.numOccupiedClusters   = 0;
+
+	Com_Memset(sv.areaEntities, 0, sizeof(sv.areaEntities));
+	Com_Memset(&sv.entityVisibilityDirty, 0, sizeof(sv.entityVisibilityDirty));
+	for (i = 0; i < MAX_GENTITIES; i++)
+	{
+		sv.svEntities[i].visIndexed = qfalse;
+	}
 }
 
 /**
@@ -178,37 +251,38 @@ void SV_ClearWorld(void)
  */
 void SV_UnlinkEntity(sharedEntity_t *gEnt)
 {
-	svEntity_t    *ent;
-	svEntity_t    *scan;
-	worldSector_t *ws;
+	svEntity_t  *ent;
+	worldCell_t *cell;
 
 	ent = SV_SvEntityForGentity(gEnt);
 
 	gEnt->r.linked = qfalse;
 
-	ws = ent->worldSector;
-	if (!ws)
+	cell = ent->worldCell;
+	if (!cell)
 	{
 		return;     // not linked in anywhere
 	}
-	ent->worldSector = NULL;
+	ent->worldCell = NULL;
 
-	if (ws->entities == ent)
+	if (ent->prevEntityInWorldCell)
 	{
-		ws->entities = ent->nextEntityInWorldSector;
-		return;
+		ent->prevEntityInWorldCell->nextEntityInWorldCell = ent->nextEntityInWorldCell;
+	}
+	else
+	{
+		cell->entities = ent->nextEntityInWorldCell;
 	}
 
-	for (scan = ws->entities ; scan ; scan = scan->nextEntityInWorldSector)
+	if (ent->nextEntityInWorldCell)
 	{
-		if (scan->nextEntityInWorldSector == ent)
-		{
-			scan->nextEntityInWorldSector = ent->nextEntityInWorldSector;
-			return;
-		}
+		ent->nextEntityInWorldCell->prevEntityInWorldCell = ent->prevEntityInWorldCell;
 	}
 
-	Com_Printf("WARNING: SV_UnlinkEntity: not found in worldSector\n");
+	ent->nextEntityInWorldCell = NULL;
+	ent->prevEntityInWorldCell = NULL;
+
+	sv_worldGrid.levels[ent->worldLevel].numEntities--;
 }
 
 #define MAX_TOTAL_ENT_LEAFS     128
@@ -219,18 +293,22 @@ void SV_UnlinkEntity(sharedEntity_t *gEnt)
  */
 void SV_LinkEntity(sharedEntity_t *gEnt)
 {
-	worldSector_t *node;
-	int           leafs[MAX_TOTAL_ENT_LEAFS];
-	int           cluster;
-	int           num_leafs;
-	int           i, j, k;
-	int           area;
-	int           lastLeaf;
-	float         *origin, *angles;
-	svEntity_t    *ent;
+	worldLevel_t *level;
+	worldCell_t  *cell;
+	int          leafs[MAX_TOTAL_ENT_LEAFS];
+	int          cluster;
+	int          num_leafs;
+	int          i, j, k;
+	int          area;
+	int          lastLeaf;
+	float        *origin, *angles;
+	svEntity_t   *ent;
 
 	ent = SV_SvEntityForGentity(gEnt);
 
+	// only the relinked entities are reindexed for the snapshot PVS culling
+	sv.entityVisibilityDirty.bits[gEnt->s.number >> 5] |= 1u << (gEnt->s.number & 31);
+
 	// sanity check for possible currentOrigin being reset bug
 	if (!gEnt->r.bmodel && vec3_compare(gEnt->r.currentOrigin, vec3_origin))
 	{
@@ -240,7 +318,7 @@ void SV_LinkEntity(sharedEntity_t *gEnt)
 		Com_DPrintf("WARNING: BBOX entity %i (type: %i) is being linked at world origin, this is probably a bug - see /entitylist cmd\n", gEnt->s.number, gEnt->s.eType);
 	}
 
-	if (ent->worldSector)
+	if (ent->worldCell)
 	{
 		SV_UnlinkEntity(gEnt);      // unlink from old position
 	}
@@ -394,32 +472,31 @@ void SV_LinkEntity(sharedEntity_t *gEnt)
 
 	gEnt->r.linkcount++;
 
-	// find the first world sector node that the ent's box crosses
-	node = sv_worldSectors;
-	while (1)
+	// find the finest level whose (loose) cells can take the ent's box
+	for (i = 0 ; i < sv_worldGrid.numLevels - 1 ; i++)
 	{
-		if (node->axis == -1)
+		if (gEnt->r.absmax[0] - gEnt->r.absmin[0] <= sv_worldGrid.levels[i].cellSize
+		    && gEnt->r.absmax[1] - gEnt->r.absmin[1] <= sv_worldGrid.levels[i].cellSize)
 		{
 			break;
 		}
-		if (gEnt->r.absmin[node->axis] > node->dist)
-		{
-			node = node->children[0];
-		}
-		else if (gEnt->r.absmax[node->axis] < node->dist)
-		{
-			node = node->children[1];
-		}
-		else
-		{
-			break;      // crosses the node
-		}
 	}
 
+	level = &sv_worldGrid.levels[i];
+	cell  = &level->cells[SV_WorldCellCoord(level, 1, 0.5f * (gEnt->r.absmin[1] + gEnt->r.absmax[1])) * level->dims[0]
+	                      + SV_WorldCellCoord(level, 0, 0.5f * (gEnt->r.absmin[0] + gEnt->r.absmax[0]))];
+
 	// link it in
-	ent->worldSector             = node;
-	ent->nextEntityInWorldSector = node->entities;
-	node->entities               = ent;
+	ent->worldCell             = cell;
+	ent->worldLevel            = i;
+	ent->prevEntityInWorldCell = NULL;
+	ent->nextEntityInWorldCell = cell->entities;
+	if (cell->entities)
+	{
+		cell->entities->prevEntityInWorldCell = ent;
+	}
+	cell->entities = ent;
+	level->numEntities++;
 
 	gEnt->r.linked = qtrue;
 }
@@ -433,30 +510,35 @@ bounds.  This does NOT mean that they actually touch in the case of bmodels.
 ============================================================================
 */
 
+/**
+ * @struct areaParms_t
+ * @brief
+ */
 typedef struct
 {
 	const float *mins;
 	const float *maxs;
 	int *list;
 	int count, maxcount;
+	int tested;                         ///< entity boxes compared, for the area benchmark
 } areaParms_t;
 
 /**
- * @brief SV_AreaEntities_r
- * @param[in] node
+ * @brief Adds the entities of a chain that touch the query bounds
+ * @param[in] check First entity of the chain
  * @param[in,out] ap
+ * @return qfalse if the list is full
  */
-void SV_AreaEntities_r(worldSector_t *node, areaParms_t *ap)
+static qboolean SV_AreaEntitiesInChain(svEntity_t *check, areaParms_t *ap)
 {
-	svEntity_t     *check, *next;
 	sharedEntity_t *gcheck;
 
-	for (check = node->entities  ; check ; check = next)
+	for ( ; check ; check = check->nextEntityInWorldCell)
 	{
-		next = check->nextEntityInWorldSector;
-
 		gcheck = SV_GEntityForSvEntity(check);
 
+		ap->tested++;
+
 		if (!gcheck->r.linked)
 		{
 			continue;
@@ -475,29 +557,70 @@ void SV_AreaEntities_r(worldSector_t *node, areaParms_t *ap)
 		if (ap->count == ap->maxcount)
 		{
 			Com_Printf("SV_AreaEntities: MAXCOUNT\n");
-			return;
+			return qfalse;
 		}
 
 		ap->list[ap->count] = check - sv.svEntities;
 		ap->count++;
 	}
 
-	if (node->axis == -1)
-	{
-		return;     // terminal node
-	}
+	return qtrue;
+}
 
-	// recurse down both sides
-	if (ap->maxs[node->axis] > node->dist)
-	{
-		SV_AreaEntities_r(node->children[0], ap);
-	}
-	if (ap->mins[node->axis] < node->dist)
+/**
+ * @brief Walks the cells of every level the query bounds can reach
+ * @param[in,out] ap
+ */
+static void SV_AreaEntities_r(areaParms_t *ap)
+{
+	worldLevel_t *level;
+	float        margin;
+	int          i, x, y, x0, x1, y0, y1;
+
+	for (i = 0 ; i < sv_worldGrid.numLevels ; i++)
 	{
-		SV_AreaEntities_r(node->children[1], ap);
+		level = &sv_worldGrid.levels[i];
+
+		if (!level->numEntities)
+		{
+			continue;
+		}
+
+		// cells are loose by half their size
+		margin = 0.5f * level->cellSize;
+		x0     = SV_WorldCellCoord(level, 0, ap->mins[0] - margin);
+		x1     = SV_WorldCellCoord(level, 0, ap->maxs[0] + margin);
+		y0     = SV_WorldCellCoord(level, 1, ap->mins[1] - margin);
+		y1     = SV_WorldCellCoord(level, 1, ap->maxs[1] + margin);
+
+		for (y = y0 ; y <= y1 ; y++)
+		{
+			for (x = x0 ; x <= x1 ; x++)
+			{
+				if (!SV_AreaEntitiesInChain(level->cells[y * level->dims[0] + x].entities, ap))
+				{
+					return;
+				}
+			}
+		}
 	}
 }
 
+#define AREA_RECORD_MAX 65536
+
+/**
+ * @struct areaRecord_t
+ * @brief Query bounds recorded for the area benchmark
+ */
+typedef struct
+{
+	int count;
+	int max;
+	vec3_t (*bounds)[2];
+} areaRecord_t;
+
+static areaRecord_t sv_areaRecord;
+
 /**
  * @brief SV_AreaEntities
  * @param[in] mins
@@ -510,17 +633,344 @@ int SV_AreaEntities(const vec3_t mins, const vec3_t maxs, int *entityList, int m
 {
 	areaParms_t ap;
 
+	if (sv_areaRecord.count < sv_areaRecord.max)
+	{
+		VectorCopy(mins, sv_areaRecord.bounds[sv_areaRecord.count][0]);
+		VectorCopy(maxs, sv_areaRecord.bounds[sv_areaRecord.count][1]);
+		sv_areaRecord.count++;
+	}
+
 	ap.mins     = mins;
 	ap.maxs     = maxs;
 	ap.list     = entityList;
 	ap.count    = 0;
 	ap.maxcount = maxcount;
+	ap.tested   = 0;
 
-	SV_AreaEntities_r(sv_worldSectors, &ap);
+	SV_AreaEntities_r(&ap);
 
 	return ap.count;
 }
 
+/*
+============================================================================
+AREA BENCHMARK
+
+The fixed depth sector tree the world grid replaced, rebuilt from the linked
+entities to replay recorded queries against both.
+============================================================================
+*/
+
+#define AREA_DEPTH  4
+#define AREA_NODES  64
+
+/**
+ * @struct worldSector_s
+ * @brief
+ */
+typedef struct worldSector_s
+{
+	int axis;                         ///< -1 = leaf node
+	float dist;
+	struct     worldSector_s *children[2];
+	int entities;                     ///< first entity number, -1 if none
+} worldSector_t;
+
+/**
+ * @struct sectorTree_t
+ * @brief
+ */
+typedef struct
+{
+	worldSector_t sectors[AREA_NODES];
+	int numSectors;
+	int next[MAX_GENTITIES];          ///< next entity in the same sector
+} sectorTree_t;
+
+/**
+ * @brief Builds a uniformly subdivided tree for the given world size
+ * @param[in,out] tree
+ * @param[in] depth
+ * @param[in] mins
+ * @param[in] maxs
+ * @return
+ */
+static worldSector_t *SV_CreateworldSector(sectorTree_t *tree, int depth, vec3_t mins, vec3_t maxs)
+{
+	worldSector_t *anode = &tree->sectors[tree->numSectors];
+	vec3_t        size;
+	vec3_t        mins1, maxs1, mins2, maxs2;
+
+	tree->numSectors++;
+	anode->entities = -1;
+
+	if (depth == AREA_DEPTH)
+	{
+		anode->axis        = -1;
+		anode->children[0] = anode->children[1] = NULL;
+		return anode;
+	}
+
+	VectorSubtract(maxs, mins, size);
+	if (size[0] > size[1])
+	{
+		anode->axis = 0;
+	}
+	else
+	{
+		anode->axis = 1;
+	}
+
+	anode->dist = 0.5f * (maxs[anode->axis] + mins[anode->axis]);
+	VectorCopy(mins, mins1);
+	VectorCopy(mins, mins2);
+	VectorCopy(maxs, maxs1);
+	VectorCopy(maxs, maxs2);
+
+	maxs1[anode->axis] = mins2[anode->axis] = anode->dist;
+
+	anode->children[0] = SV_CreateworldSector(tree, depth + 1, mins2, maxs2);
+	anode->children[1] = SV_CreateworldSector(tree, depth + 1, mins1, maxs1);
+
+	return anode;
+}
+
+/**
+ * @brief Links an entity into the first sector node its box crosses
+ * @param[in,out] tree
+ * @param[in] num
+ */
+static void SV_SectorLinkEntity(sectorTree_t *tree, int num)
+{
+	sharedEntity_t *gEnt = SV_GentityNum(num);
+	worldSector_t  *node = tree->sectors;
+
+	while (node->axis != -1)
+	{
+		if (gEnt->r.absmin[node->axis] > node->dist)
+		{
+			node = node->children[0];
+		}
+		else if (gEnt->r.absmax[node->axis] < node->dist)
+		{
+			node = node->children[1];
+		}
+		else
+		{
+			break;      // crosses the node
+		}
+	}
+
+	tree->next[num] = node->entities;
+	node->entities  = num;
+}
+
+/**
+ * @brief Same as SV_AreaEntities_r() on the sector tree
+ * @param[in] tree
+ * @param[in] node
+ * @param[in,out] ap
+ */
+static void SV_SectorAreaEntities_r(sectorTree_t *tree, worldSector_t *node, areaParms_t *ap)
+{
+	sharedEntity_t *gcheck;
+	int            num;
+
+	for (num = node->entities ; num != -1 ; num = tree->next[num])
+	{
+		gcheck = SV_GentityNum(num);
+
+		ap->tested++;
+
+		if (gcheck->r.absmin[0] > ap->maxs[0]
+		    || gcheck->r.absmin[1] > ap->maxs[1]
+		    || gcheck->r.absmin[2] > ap->maxs[2]
+		    || gcheck->r.absmax[0] < ap->mins[0]
+		    || gcheck->r.absmax[1] < ap->mins[1]
+		    || gcheck->r.absmax[2] < ap->mins[2])
+		{
+			continue;
+		}
+
+		if (ap->count == ap->maxcount)
+		{
+			return;
+		}
+
+		ap->list[ap->count++] = num;
+	}
+
+	if (node->axis == -1)
+	{
+		return;     // terminal node
+	}
+
+	// recurse down both sides
+	if (ap->maxs[node->axis] > node->dist)
+	{
+		SV_SectorAreaEntities_r(tree, node->children[0], ap);
+	}
+	if (ap->mins[node->axis] < node->dist)
+	{
+		SV_SectorAreaEntities_r(tree, node->children[1], ap);
+	}
+}
+
+/**
+ * @brief qsort_ints
+ * @param[in] a
+ * @param[in] b
+ * @return
+ */
+static int QDECL qsort_ints(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+/**
+ * @brief Records the area queries of the running game or replays them against
+ * the world grid and the old sector tree, checking that both find the same entities.
+ *
+ * Usage: areabench record [queries] | areabench [iterations]
+ */
+void SV_AreaBench_f(void)
+{
+	sectorTree_t *tree;
+	areaParms_t  ap;
+	clipHandle_t h;
+	vec3_t       mins, maxs;
+	int          *gridList, *treeList;
+	int          i, j, iterations, gridCount, mismatches = 0;
+	int64_t      start, gridTime = 0, treeTime = 0;
+	int64_t      gridTested = 0, treeTested = 0, found = 0;
+
+	if (!com_sv_running->integer || sv.state != SS_GAME)
+	{
+		Com_Printf("Server is not running.\n");
+		return;
+	}
+
+	if (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "record"))
+	{
+		int max = Cmd_Argc() > 2 ? Q_atoi(Cmd_Argv(2)) : 4096;
+
+		max = MAX(1, MIN(max, AREA_RECORD_MAX));
+
+		Com_Dealloc(sv_areaRecord.bounds);
+		sv_areaRecord.bounds = Com_Allocate(max * sizeof(*sv_areaRecord.bounds));
+		sv_areaRecord.count  = 0;
+		sv_areaRecord.max    = sv_areaRecord.bounds ? max : 0;
+
+		Com_Printf("Recording the next %i area queries.\n", sv_areaRecord.max);
+		return;
+	}
+
+	if (!sv_areaRecord.count)
+	{
+		Com_Printf("No area queries recorded, use 'areabench record [queries]' first.\n");
+		return;
+	}
+
+	// stop recording, the replay goes through SV_AreaEntities_r
+	sv_areaRecord.max = sv_areaRecord.count;
+
+	iterations = Cmd_Argc() > 1 ? MAX(1, Q_atoi(Cmd_Argv(1))) : 10;
+
+	tree     = Com_Allocate(sizeof(*tree));
+	gridList = Com_Allocate(2 * MAX_GENTITIES * sizeof(int));
+	if (!tree || !gridList)
+	{
+		Com_Dealloc(tree);
+		Com_Dealloc(gridList);
+		Com_Printf("areabench: out of memory\n");
+		return;
+	}
+	treeList = gridList + MAX_GENTITIES;
+
+	// rebuild the old tree from what is linked right now
+	Com_Memset(tree, 0, sizeof(*tree));
+	h = CM_InlineModel(0);
+	CM_ModelBounds(h, mins, maxs);
+	SV_CreateworldSector(tree, 0, mins, maxs);
+
+	for (i = 0 ; i < sv.num_entities ; i++)
+	{
+		if (sv.svEntities[i].worldCell && SV_GentityNum(i)->r.linked)
+		{
+			SV_SectorLinkEntity(tree, i);
+		}
+	}
+
+	// verify
+	for (i = 0 ; i < sv_areaRecord.count ; i++)
+	{
+		ap.mins     = sv_areaRecord.bounds[i][0];
+		ap.maxs     = sv_areaRecord.bounds[i][1];
+		ap.maxcount = MAX_GENTITIES;
+
+		ap.list   = gridList;
+		ap.count  = 0;
+		ap.tested = 0;
+		SV_AreaEntities_r(&ap);
+		gridCount   = ap.count;
+		gridTested += ap.tested;
+
+		ap.list   = treeList;
+		ap.count  = 0;
+		ap.tested = 0;
+		SV_SectorAreaEntities_r(tree, tree->sectors, &ap);
+		treeTested += ap.tested;
+		found      += ap.count;
+
+		qsort(gridList, gridCount, sizeof(int), qsort_ints);
+		qsort(treeList, ap.count, sizeof(int), qsort_ints);
+
+		if (gridCount != ap.count || memcmp(gridList, treeList, gridCount * sizeof(int)))
+		{
+			mismatches++;
+		}
+	}
+
+	// time
+	for (j = 0 ; j < iterations ; j++)
+	{
+		start = Sys_Microseconds();
+		for (i = 0 ; i < sv_areaRecord.count ; i++)
+		{
+			ap.mins     = sv_areaRecord.bounds[i][0];
+			ap.maxs     = sv_areaRecord.bounds[i][1];
+			ap.list     = gridList;
+			ap.count    = 0;
+			ap.maxcount = MAX_GENTITIES;
+			SV_AreaEntities_r(&ap);
+		}
+		gridTime += Sys_Microseconds() - start;
+
+		start = Sys_Microseconds();
+		for (i = 0 ; i < sv_areaRecord.count ; i++)
+		{
+			ap.mins     = sv_areaRecord.bounds[i][0];
+			ap.maxs     = sv_areaRecord.bounds[i][1];
+			ap.list     = treeList;
+			ap.count    = 0;
+			ap.maxcount = MAX_GENTITIES;
+			SV_SectorAreaEntities_r(tree, tree->sectors, &ap);
+		}
+		treeTime += Sys_Microseconds() - start;
+	}
+
+	Com_Printf("%i queries, %i iterations, %.1f entities found per query\n", sv_areaRecord.count, iterations, (double)found / sv_areaRecord.count);
+	Com_Printf("world grid : %8.3f usec/query, %6.1f boxes tested/query\n", (double)gridTime / ((double)sv_areaRecord.count * iterations), (double)gridTested / sv_areaRecord.count);
+	Com_Printf("sector tree: %8.3f usec/query, %6.1f boxes tested/query\n", (double)treeTime / ((double)sv_areaRecord.count * iterations), (double)treeTested / sv_areaRecord.count);
+	if (mismatches)
+	{
+		Com_Printf(S_COLOR_RED "%i queries returned different entities\n", mismatches);
+	}
+
+	Com_Dealloc(tree);
+	Com_Dealloc(gridList);
+}
+
 //===========================================================================
 
 typedef struct
@@ -205,6 +205,25 @@ int Sys_Milliseconds(void)
 	return curtime;
 }
 
+/**
+ * @brief Sys_Microseconds
+ * @return current system time in usec since server/client was started,
+ * on the same clock and base as Sys_Milliseconds()
+ */
+int64_t Sys_Microseconds(void)
+{
+	struct timespec time;
+
+	if (!sys_timeBase)
+	{
+		Sys_Milliseconds();
+	}
+
+	clock_gettime(clockid, &time);
+
+	return ((int64_t)time.tv_sec * 1000000 + time.tv_nsec / 1000) - (int64_t)sys_timeBase * 1000;
+}
+
 /**
  * @param[in,out] v Vector
  */
@@ -140,26 +140,39 @@ char *Sys_DefaultHomePath(void)
 	return homePath;
 }
 
-int sys_timeBase;
+static LARGE_INTEGER sys_timeBase;
+static LARGE_INTEGER sys_timeFrequency;
 
 /**
- * @brief Sys_Milliseconds
- * @return
+ * @brief Sys_Microseconds
+ * @return current system time in usec since server/client was started
  */
-int Sys_Milliseconds(void)
+int64_t Sys_Microseconds(void)
 {
-	int             sys_curtime;
-	static qboolean initialized = qfalse;
+	LARGE_INTEGER now;
+	int64_t       ticks;
 
-	if (!initialized)
+	if (!sys_timeFrequency.QuadPart)
 	{
-		sys_timeBase = timeGetTime();
-		initialized  = qtrue;
+		QueryPerformanceFrequency(&sys_timeFrequency);
+		QueryPerformanceCounter(&sys_timeBase);
 	}
 
-	sys_curtime = timeGetTime() - sys_timeBase;
+	QueryPerformanceCounter(&now);
+
+	// split up so the multiplication doesn't overflow on long uptimes
+	ticks = now.QuadPart - sys_timeBase.QuadPart;
+
+	return (ticks / sys_timeFrequency.QuadPart) * 1000000 + ((ticks % sys_timeFrequency.QuadPart) * 1000000) / sys_timeFrequency.QuadPart;
+}
 
-	return sys_curtime;
+/**
+ * @brief Sys_Milliseconds
+ * @return current system time in ms, on the same clock as Sys_Microseconds()
+ */
+int Sys_Milliseconds(void)
+{
+	return (int)(Sys_Microseconds() / 1000);
 }
 
 /**
@@ -735,8 +735,10 @@ void QDECL G_Error(const char *fmt, ...) _attribute((noreturn, format(printf, 1,
 // extension interface
 qboolean trap_GetValue(char *value, int valueSize, const char *key);
 void trap_DemoSupport(const char *commands);
+int trap_Cvar_Changes(int *sequence, int *changes, int maxChanges);
 extern int dll_com_trapGetValue;
 extern int dll_trap_DemoSupport;
+extern int dll_trap_CvarChanges;
 
 int trap_ETTV_GetPlayerstate(int clientNum, playerState_t *ps);
 
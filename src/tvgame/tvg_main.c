@@ -616,6 +616,12 @@ cvarTable_t gameCvarTable[] =
  */
 static int gameCvarTableSize = sizeof(gameCvarTable) / sizeof(gameCvarTable[0]);
 
+/**
+ * @var gameCvarChanges
+ * @brief Change sequence of trap_Cvar_Changes(), -1 updates all cvars
+ */
+static int gameCvarChanges = -1;
+
 /**
  * @var fActions
  * @brief Flag to store executed final auto-actions
@@ -660,6 +666,7 @@ qboolean TVG_SnapshotCallback(int entityNum, int clientNum)
 
 int dll_com_trapGetValue;
 int dll_trap_DemoSupport;
+int dll_trap_CvarChanges;
 
 static void TVG_ETTV_ConfigstringPassthrough(int index)
 {
@@ -839,6 +846,8 @@ void TVG_RegisterCvars(void)
 
 	G_Printf("%d cvars in use\n", gameCvarTableSize);
 
+	gameCvarChanges = -1;
+
 	for (i = 0, cv = gameCvarTable; i < gameCvarTableSize; i++, cv++)
 	{
 		trap_Cvar_Register(cv->vmCvar, cv->cvarName, cv->defaultString, cv->cvarFlags);
@@ -861,10 +870,19 @@ void TVG_UpdateCvars(void)
 	qboolean    chargetimechanged  = qfalse;
 	qboolean    clsweaprestriction = qfalse;
 	qboolean    skillLevelPoints   = qfalse;
+	int         changes[MAX_CVAR_CHANGES];
+	int         numChanges;
+
+	// only the cvars the engine reports as changed need an update
+	numChanges = trap_Cvar_Changes(&gameCvarChanges, changes, MAX_CVAR_CHANGES);
+	if (!numChanges)
+	{
+		return;
+	}
 
 	for (i = 0, cv = gameCvarTable ; i < gameCvarTableSize ; i++, cv++)
 	{
-		if (cv->vmCvar)
+		if (cv->vmCvar && Q_CvarChanged(cv->vmCvar, changes, numChanges))
 		{
 			trap_Cvar_Update(cv->vmCvar);
 
@@ -909,6 +927,7 @@ static ID_INLINE void TVG_SetupExtensions(void)
 		dll_com_trapGetValue = Q_atoi(value);
 
 		TVG_SetupExtensionTrap(value, MAX_CVAR_VALUE_STRING, &dll_trap_DemoSupport, "trap_DemoSupport_Legacy");
+		TVG_SetupExtensionTrap(value, MAX_CVAR_VALUE_STRING, &dll_trap_CvarChanges, "trap_CvarChanges_Legacy");
 	}
 }
 
@@ -804,6 +804,12 @@ void trap_GetAutoUpdate(void);
 void trap_openURL(const char *url);
 void trap_GetHunkData(int *hunkused, int *hunkexpected);
 
+// extension interface
+qboolean trap_GetValue(char *value, int valueSize, const char *key);
+int trap_Cvar_Changes(int *sequence, int *changes, int maxChanges);
+extern int dll_com_trapGetValue;
+extern int dll_trap_CvarChanges;
+
 // localization functions
 const char *UI_TranslateString(const char *string);
 void trap_TranslateString(const char *fmt, char *buffer);
@@ -8553,6 +8553,34 @@ static void UI_RunCinematicFrame(int handle)
 	trap_CIN_RunCinematic(handle);
 }
 
+int dll_com_trapGetValue;
+int dll_trap_CvarChanges;
+
+static ID_INLINE void UI_SetupExtensionTrap(char *value, int valueSize, int *trap, const char *name)
+{
+	if (trap_GetValue(value, valueSize, name))
+	{
+		*trap = Q_atoi(value);
+	}
+	else
+	{
+		*trap = qfalse;
+	}
+}
+
+static ID_INLINE void UI_SetupExtensions(void)
+{
+	char value[MAX_CVAR_VALUE_STRING];
+
+	trap_Cvar_VariableStringBuffer("//trap_GetValue", value, sizeof(value));
+	if (value[0])
+	{
+		dll_com_trapGetValue = Q_atoi(value);
+
+		UI_SetupExtensionTrap(value, MAX_CVAR_VALUE_STRING, &dll_trap_CvarChanges, "trap_CvarChanges_Legacy");
+	}
+}
+
 /**
  * @brief _UI_Init
  * @param[in] etLegacyClient
@@ -8563,6 +8591,7 @@ void UI_Init(int etLegacyClient, int clientVersion)
 	int x;
 	Com_Printf(S_COLOR_MDGREY "Initializing %s ui " S_COLOR_GREEN ETLEGACY_VERSION "\n", MODNAME);
 
+	UI_SetupExtensions();
 	UI_RegisterCvars();
 	UI_InitMemory();
 	trap_PC_RemoveAllGlobalDefines();
@@ -9400,6 +9429,7 @@ static cvarTable_t cvarTable[] =
 };
 
 static const unsigned int cvarTableSize = sizeof(cvarTable) / sizeof(cvarTable[0]);
+static int                cvarChanges   = -1;   ///< change sequence of trap_Cvar_Changes(), -1 updates all cvars
 
 /**
  * @brief UI_RegisterCvars
@@ -9411,6 +9441,8 @@ void UI_RegisterCvars(void)
 
 	Com_Printf("%u UI cvars in use\n", cvarTableSize);
 
+	cvarChanges = -1;
+
 	for (i = 0, cv = cvarTable ; i < cvarTableSize ; i++, cv++)
 	{
 		trap_Cvar_Register(cv->vmCvar, cv->cvarName, cv->defaultString, cv->cvarFlags);
@@ -9437,10 +9469,15 @@ void UI_UpdateCvars(void)
 {
 	size_t      i;
 	cvarTable_t *cv;
+	int         changes[MAX_CVAR_CHANGES];
+	int         numChanges;
 
-	for (i = 0, cv = cvarTable ; i < cvarTableSize ; i++, cv++)
+	// only the cvars the engine reports as changed need an update
+	numChanges = trap_Cvar_Changes(&cvarChanges, changes, MAX_CVAR_CHANGES);
+
+	for (i = 0, cv = cvarTable ; i < cvarTableSize && numChanges ; i++, cv++)
 	{
-		if (cv->vmCvar)
+		if (cv->vmCvar && Q_CvarChanged(cv->vmCvar, changes, numChanges))
 		{
 			trap_Cvar_Update(cv->vmCvar);
 			if (cv->modificationCount != cv->vmCvar->modificationCount)
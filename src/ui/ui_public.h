@@ -186,6 +186,8 @@ typedef enum
 	///< engine extensions padding
 	UI_TRAP_GETVALUE = COM_TRAP_GETVALUE,
 
+	UI_CVAR_CHANGES,    ///< ( int *sequence, int *handles, int maxHandles );
+
 } uiImport_t;
 
 // Number of columns in the server list
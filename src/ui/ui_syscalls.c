@@ -1158,3 +1158,35 @@ void trap_GetHunkData(int *hunkused, int *hunkexpected)
 {
 	SystemCall(UI_GETHUNKDATA, hunkused, hunkexpected);
 }
+
+// extension interface
+
+/**
+ * @brief Entry point for additional system calls without breaking compatibility with other engines
+ * @param[out] value
+ * @param[in] valueSize
+ * @param[in] key
+ * @return
+ */
+qboolean trap_GetValue(char *value, int valueSize, const char *key)
+{
+	return (qboolean)(SystemCall(dll_com_trapGetValue, value, valueSize, key));
+}
+
+/**
+ * @brief Extension listing the cvars changed since the last call, so that
+ * UI_UpdateCvars() only has to update those
+ * @param[in,out] sequence
+ * @param[out] changes Handles of the changed cvars
+ * @param[in] maxChanges
+ * @return Number of changed cvars, -1 if all cvars have to be updated
+ */
+int trap_Cvar_Changes(int *sequence, int *changes, int maxChanges)
+{
+	if (dll_trap_CvarChanges)
+	{
+		return SystemCall(dll_trap_CvarChanges, sequence, changes, maxChanges);
+	}
+
+	return -1;
+}